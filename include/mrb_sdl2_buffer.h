@@ -0,0 +1,33 @@
+#ifndef MRB_SDL2_BUFFER_H
+#define MRB_SDL2_BUFFER_H
+
+/*
+ * C level access to SDL2::Buffer and its subclasses for other gems.
+ * The memory belongs to the buffer object; keep the object reachable
+ * while the pointer is in use.
+ */
+
+#include <stddef.h>
+#include "mruby.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* true when 'value' is an SDL2::Buffer (or a subclass instance). */
+extern mrb_bool mrb_sdl2_buffer_p(mrb_state *mrb, mrb_value value);
+
+/*
+ * returns the first byte of the buffer and stores its length in bytes to
+ * 'size' unless it is NULL. raises TypeError for anything but a buffer.
+ */
+extern void *mrb_sdl2_buffer_get_ptr(mrb_state *mrb, mrb_value value, size_t *size);
+
+/* size in bytes of one element; 1 for SDL2::Buffer and ByteBuffer. */
+extern size_t mrb_sdl2_buffer_get_element_size(mrb_state *mrb, mrb_value value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRB_SDL2_BUFFER_H */
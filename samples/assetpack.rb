@@ -0,0 +1,33 @@
+# usage: assetpack.rb <asset directory> [pack file]
+dir  = ARGV[0] || 'assets'
+pack = ARGV[1] || 'assets.pack'
+
+SDL2::init
+
+def measure(label)
+  freq  = SDL2::Timer.perf_freq
+  start = SDL2::Timer.perf_counter
+  count = yield
+  msec  = (SDL2::Timer.perf_counter - start) * 1000.0 / freq
+  puts "#{label}: #{count} assets in #{msec} ms"
+end
+
+begin
+  # building the pack reads every file, so both runs below start from a
+  # warm page cache and compare the cost of opening and parsing only.
+  entries = SDL2::AssetPack.build_from_directory pack, dir
+  bmps = entries.keys.select { |name| name.end_with? '.bmp' }
+
+  measure 'files' do
+    bmps.each { |name| SDL2::Video::Surface.load_bmp(entries[name]).destroy }
+    bmps.size
+  end
+
+  measure 'pack' do
+    assets = SDL2::AssetPack.new pack
+    bmps.each { |name| assets.load_bmp(name).destroy }
+    bmps.size
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,698 @@
+#include "float_kernels.h"
+#include "simd.h"
+#include <SDL2/SDL_stdinc.h>
+
+/*
+ * Native kernels over packed float arrays, used by SDL2::FloatBuffer.
+ *
+ * Reductions keep four partial lanes and combine them in the same order
+ * on every backend, so results only differ for NaN input. Multiply-adds
+ * may be contracted by the compiler and can differ in the last bit.
+ */
+
+typedef struct float_kernel_table_t {
+  char const *name;
+  void (*scale)(float *dst, size_t count, float k);
+  void (*offset)(float *dst, size_t count, float k);
+  void (*add)(float *dst, float const *src, size_t count);
+  void (*mul)(float *dst, float const *src, size_t count);
+  void (*madd)(float *dst, float const *src, size_t count, float k);
+  void (*clamp)(float *dst, size_t count, float lo, float hi);
+  void (*min_max)(float const *src, size_t count, float *min, float *max);
+  float (*sum)(float const *src, size_t count);
+  float (*dot)(float const *a, float const *b, size_t count);
+  void (*transform2d)(float *v, size_t count, size_t stride, float const m[6]);
+  void (*transform3d)(float *v, size_t count, size_t stride, float const m[12]);
+} float_kernel_table_t;
+
+/* same selection as minps/maxps: the second operand wins unless the first is strictly better. */
+#define LANE_MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define LANE_MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+/***************************************************************************
+*
+* scalar kernels
+*
+***************************************************************************/
+
+static void
+scale_tail(float *dst, size_t count, float k, size_t i)
+{
+  for (; i < count; ++i) {
+    dst[i] *= k;
+  }
+}
+
+static void
+offset_tail(float *dst, size_t count, float k, size_t i)
+{
+  for (; i < count; ++i) {
+    dst[i] += k;
+  }
+}
+
+static void
+add_tail(float *dst, float const *src, size_t count, size_t i)
+{
+  for (; i < count; ++i) {
+    dst[i] += src[i];
+  }
+}
+
+static void
+mul_tail(float *dst, float const *src, size_t count, size_t i)
+{
+  for (; i < count; ++i) {
+    dst[i] *= src[i];
+  }
+}
+
+static void
+madd_tail(float *dst, float const *src, size_t count, float k, size_t i)
+{
+  for (; i < count; ++i) {
+    dst[i] += src[i] * k;
+  }
+}
+
+static void
+clamp_tail(float *dst, size_t count, float lo, float hi, size_t i)
+{
+  for (; i < count; ++i) {
+    float const v = LANE_MAX(dst[i], lo);
+    dst[i] = LANE_MIN(v, hi);
+  }
+}
+
+/* folds lanes (0, 2) and (1, 3), then the two results, then the tail. */
+static void
+min_max_finish(float const lmin[4], float const lmax[4], float const *src, size_t count, size_t i, float *min, float *max)
+{
+  float const min02 = LANE_MIN(lmin[0], lmin[2]);
+  float const min13 = LANE_MIN(lmin[1], lmin[3]);
+  float const max02 = LANE_MAX(lmax[0], lmax[2]);
+  float const max13 = LANE_MAX(lmax[1], lmax[3]);
+  float mn = LANE_MIN(min02, min13);
+  float mx = LANE_MAX(max02, max13);
+  for (; i < count; ++i) {
+    mn = LANE_MIN(src[i], mn);
+    mx = LANE_MAX(src[i], mx);
+  }
+  *min = mn;
+  *max = mx;
+}
+
+static float
+sum_finish(float const lanes[4], float const *src, size_t count, size_t i)
+{
+  float s = (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+  for (; i < count; ++i) {
+    s += src[i];
+  }
+  return s;
+}
+
+static float
+dot_finish(float const lanes[4], float const *a, float const *b, size_t count, size_t i)
+{
+  float s = (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+  for (; i < count; ++i) {
+    s += a[i] * b[i];
+  }
+  return s;
+}
+
+static void
+transform2d_tail(float *v, size_t count, size_t stride, float const m[6], size_t i)
+{
+  for (; i < count; ++i) {
+    float *p = v + i * stride;
+    float const x = p[0];
+    float const y = p[1];
+    p[0] = m[0] * x + m[1] * y + m[2];
+    p[1] = m[3] * x + m[4] * y + m[5];
+  }
+}
+
+static void
+transform3d_tail(float *v, size_t count, size_t stride, float const m[12], size_t i)
+{
+  for (; i < count; ++i) {
+    float *p = v + i * stride;
+    float const x = p[0];
+    float const y = p[1];
+    float const z = p[2];
+    p[0] = m[0] * x + m[1] * y + m[2]  * z + m[3];
+    p[1] = m[4] * x + m[5] * y + m[6]  * z + m[7];
+    p[2] = m[8] * x + m[9] * y + m[10] * z + m[11];
+  }
+}
+
+static void
+scale_scalar(float *dst, size_t count, float k)
+{
+  scale_tail(dst, count, k, 0);
+}
+
+static void
+offset_scalar(float *dst, size_t count, float k)
+{
+  offset_tail(dst, count, k, 0);
+}
+
+static void
+add_scalar(float *dst, float const *src, size_t count)
+{
+  add_tail(dst, src, count, 0);
+}
+
+static void
+mul_scalar(float *dst, float const *src, size_t count)
+{
+  mul_tail(dst, src, count, 0);
+}
+
+static void
+madd_scalar(float *dst, float const *src, size_t count, float k)
+{
+  madd_tail(dst, src, count, k, 0);
+}
+
+static void
+clamp_scalar(float *dst, size_t count, float lo, float hi)
+{
+  clamp_tail(dst, count, lo, hi, 0);
+}
+
+static void
+min_max_scalar(float const *src, size_t count, float *min, float *max)
+{
+  float lmin[4] = { src[0], src[0], src[0], src[0] };
+  float lmax[4] = { src[0], src[0], src[0], src[0] };
+  size_t i = 0;
+  int k;
+  for (; i + 4 <= count; i += 4) {
+    for (k = 0; k < 4; ++k) {
+      lmin[k] = LANE_MIN(src[i + k], lmin[k]);
+      lmax[k] = LANE_MAX(src[i + k], lmax[k]);
+    }
+  }
+  min_max_finish(lmin, lmax, src, count, i, min, max);
+}
+
+static float
+sum_scalar(float const *src, size_t count)
+{
+  float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  size_t i = 0;
+  int k;
+  for (; i + 4 <= count; i += 4) {
+    for (k = 0; k < 4; ++k) {
+      lanes[k] += src[i + k];
+    }
+  }
+  return sum_finish(lanes, src, count, i);
+}
+
+static float
+dot_scalar(float const *a, float const *b, size_t count)
+{
+  float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  size_t i = 0;
+  int k;
+  for (; i + 4 <= count; i += 4) {
+    for (k = 0; k < 4; ++k) {
+      lanes[k] += a[i + k] * b[i + k];
+    }
+  }
+  return dot_finish(lanes, a, b, count, i);
+}
+
+static void
+transform2d_scalar(float *v, size_t count, size_t stride, float const m[6])
+{
+  transform2d_tail(v, count, stride, m, 0);
+}
+
+static void
+transform3d_scalar(float *v, size_t count, size_t stride, float const m[12])
+{
+  transform3d_tail(v, count, stride, m, 0);
+}
+
+static float_kernel_table_t const scalar_kernels = {
+  "scalar",
+  scale_scalar,
+  offset_scalar,
+  add_scalar,
+  mul_scalar,
+  madd_scalar,
+  clamp_scalar,
+  min_max_scalar,
+  sum_scalar,
+  dot_scalar,
+  transform2d_scalar,
+  transform3d_scalar,
+};
+
+/***************************************************************************
+*
+* SSE2 kernels
+*
+***************************************************************************/
+
+#ifdef MRB_SDL2_HAVE_SSE2
+
+static void
+scale_sse2(float *dst, size_t count, float k)
+{
+  __m128 const vk = _mm_set1_ps(k);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), vk));
+  }
+  scale_tail(dst, count, k, i);
+}
+
+static void
+offset_sse2(float *dst, size_t count, float k)
+{
+  __m128 const vk = _mm_set1_ps(k);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), vk));
+  }
+  offset_tail(dst, count, k, i);
+}
+
+static void
+add_sse2(float *dst, float const *src, size_t count)
+{
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+  add_tail(dst, src, count, i);
+}
+
+static void
+mul_sse2(float *dst, float const *src, size_t count)
+{
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+  }
+  mul_tail(dst, src, count, i);
+}
+
+static void
+madd_sse2(float *dst, float const *src, size_t count, float k)
+{
+  __m128 const vk = _mm_set1_ps(k);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), vk)));
+  }
+  madd_tail(dst, src, count, k, i);
+}
+
+static void
+clamp_sse2(float *dst, size_t count, float lo, float hi)
+{
+  __m128 const vlo = _mm_set1_ps(lo);
+  __m128 const vhi = _mm_set1_ps(hi);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(dst + i), vlo), vhi));
+  }
+  clamp_tail(dst, count, lo, hi, i);
+}
+
+static void
+min_max_sse2(float const *src, size_t count, float *min, float *max)
+{
+  __m128 vmin = _mm_set1_ps(src[0]);
+  __m128 vmax = vmin;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 const v = _mm_loadu_ps(src + i);
+    vmin = _mm_min_ps(v, vmin);
+    vmax = _mm_max_ps(v, vmax);
+  }
+  float lmin[4], lmax[4];
+  _mm_storeu_ps(lmin, vmin);
+  _mm_storeu_ps(lmax, vmax);
+  min_max_finish(lmin, lmax, src, count, i, min, max);
+}
+
+static float
+sum_sse2(float const *src, size_t count)
+{
+  __m128 acc = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    acc = _mm_add_ps(acc, _mm_loadu_ps(src + i));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, acc);
+  return sum_finish(lanes, src, count, i);
+}
+
+static float
+dot_sse2(float const *a, float const *b, size_t count)
+{
+  __m128 acc = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+  }
+  float lanes[4];
+  _mm_storeu_ps(lanes, acc);
+  return dot_finish(lanes, a, b, count, i);
+}
+
+static void
+transform2d_sse2(float *v, size_t count, size_t stride, float const m[6])
+{
+  size_t i = 0;
+  if (2 != stride) {
+    transform2d_tail(v, count, stride, m, 0);
+    return;
+  }
+  /* two interleaved vertices per register: x0 y0 x1 y1. */
+  __m128 const cx = _mm_setr_ps(m[0], m[3], m[0], m[3]);
+  __m128 const cy = _mm_setr_ps(m[1], m[4], m[1], m[4]);
+  __m128 const ct = _mm_setr_ps(m[2], m[5], m[2], m[5]);
+  for (; i + 2 <= count; i += 2) {
+    __m128 const p = _mm_loadu_ps(v + i * 2);
+    __m128 const x = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 const y = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+    _mm_storeu_ps(v + i * 2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, x), _mm_mul_ps(cy, y)), ct));
+  }
+  transform2d_tail(v, count, stride, m, i);
+}
+
+static void
+transform3d_sse2(float *v, size_t count, size_t stride, float const m[12])
+{
+  /* one vertex per register; the matrix columns are kept in registers. */
+  __m128 const c0 = _mm_setr_ps(m[0], m[4], m[8],  0.0f);
+  __m128 const c1 = _mm_setr_ps(m[1], m[5], m[9],  0.0f);
+  __m128 const c2 = _mm_setr_ps(m[2], m[6], m[10], 0.0f);
+  __m128 const c3 = _mm_setr_ps(m[3], m[7], m[11], 0.0f);
+  size_t i;
+  for (i = 0; i < count; ++i) {
+    float *p = v + i * stride;
+    __m128 const r = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_load1_ps(p)),
+                                                      _mm_mul_ps(c1, _mm_load1_ps(p + 1))),
+                                           _mm_mul_ps(c2, _mm_load1_ps(p + 2))),
+                                c3);
+    _mm_storel_pi((__m64*)p, r);
+    _mm_store_ss(p + 2, _mm_movehl_ps(r, r));
+  }
+}
+
+static float_kernel_table_t const sse2_kernels = {
+  "sse2",
+  scale_sse2,
+  offset_sse2,
+  add_sse2,
+  mul_sse2,
+  madd_sse2,
+  clamp_sse2,
+  min_max_sse2,
+  sum_sse2,
+  dot_sse2,
+  transform2d_sse2,
+  transform3d_sse2,
+};
+
+#endif /* MRB_SDL2_HAVE_SSE2 */
+
+/***************************************************************************
+*
+* NEON kernels
+*
+***************************************************************************/
+
+#ifdef MRB_SDL2_HAVE_NEON
+
+static void
+scale_neon(float *dst, size_t count, float k)
+{
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(dst + i), k));
+  }
+  scale_tail(dst, count, k, i);
+}
+
+static void
+offset_neon(float *dst, size_t count, float k)
+{
+  float32x4_t const vk = vdupq_n_f32(k);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vk));
+  }
+  offset_tail(dst, count, k, i);
+}
+
+static void
+add_neon(float *dst, float const *src, size_t count)
+{
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+  }
+  add_tail(dst, src, count, i);
+}
+
+static void
+mul_neon(float *dst, float const *src, size_t count)
+{
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vmulq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+  }
+  mul_tail(dst, src, count, i);
+}
+
+static void
+madd_neon(float *dst, float const *src, size_t count, float k)
+{
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), k));
+  }
+  madd_tail(dst, src, count, k, i);
+}
+
+static void
+clamp_neon(float *dst, size_t count, float lo, float hi)
+{
+  float32x4_t const vlo = vdupq_n_f32(lo);
+  float32x4_t const vhi = vdupq_n_f32(hi);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vminq_f32(vmaxq_f32(vld1q_f32(dst + i), vlo), vhi));
+  }
+  clamp_tail(dst, count, lo, hi, i);
+}
+
+static void
+min_max_neon(float const *src, size_t count, float *min, float *max)
+{
+  float32x4_t vmin = vdupq_n_f32(src[0]);
+  float32x4_t vmax = vmin;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    float32x4_t const v = vld1q_f32(src + i);
+    vmin = vminq_f32(v, vmin);
+    vmax = vmaxq_f32(v, vmax);
+  }
+  float lmin[4], lmax[4];
+  vst1q_f32(lmin, vmin);
+  vst1q_f32(lmax, vmax);
+  min_max_finish(lmin, lmax, src, count, i, min, max);
+}
+
+static float
+sum_neon(float const *src, size_t count)
+{
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    acc = vaddq_f32(acc, vld1q_f32(src + i));
+  }
+  float lanes[4];
+  vst1q_f32(lanes, acc);
+  return sum_finish(lanes, src, count, i);
+}
+
+static float
+dot_neon(float const *a, float const *b, size_t count)
+{
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+  }
+  float lanes[4];
+  vst1q_f32(lanes, acc);
+  return dot_finish(lanes, a, b, count, i);
+}
+
+static void
+transform2d_neon(float *v, size_t count, size_t stride, float const m[6])
+{
+  size_t i = 0;
+  if (2 != stride) {
+    transform2d_tail(v, count, stride, m, 0);
+    return;
+  }
+  for (; i + 4 <= count; i += 4) {
+    float32x4x2_t p = vld2q_f32(v + i * 2);
+    float32x4_t const x = p.val[0];
+    float32x4_t const y = p.val[1];
+    p.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[2]), x, m[0]), y, m[1]);
+    p.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[5]), x, m[3]), y, m[4]);
+    vst2q_f32(v + i * 2, p);
+  }
+  transform2d_tail(v, count, stride, m, i);
+}
+
+static void
+transform3d_neon(float *v, size_t count, size_t stride, float const m[12])
+{
+  size_t i = 0;
+  if (3 != stride) {
+    transform3d_tail(v, count, stride, m, 0);
+    return;
+  }
+  for (; i + 4 <= count; i += 4) {
+    float32x4x3_t p = vld3q_f32(v + i * 3);
+    float32x4_t const x = p.val[0];
+    float32x4_t const y = p.val[1];
+    float32x4_t const z = p.val[2];
+    p.val[0] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[3]),  x, m[0]), y, m[1]), z, m[2]);
+    p.val[1] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[7]),  x, m[4]), y, m[5]), z, m[6]);
+    p.val[2] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m[11]), x, m[8]), y, m[9]), z, m[10]);
+    vst3q_f32(v + i * 3, p);
+  }
+  transform3d_tail(v, count, stride, m, i);
+}
+
+static float_kernel_table_t const neon_kernels = {
+  "neon",
+  scale_neon,
+  offset_neon,
+  add_neon,
+  mul_neon,
+  madd_neon,
+  clamp_neon,
+  min_max_neon,
+  sum_neon,
+  dot_neon,
+  transform2d_neon,
+  transform3d_neon,
+};
+
+#endif /* MRB_SDL2_HAVE_NEON */
+
+/***************************************************************************
+*
+* dispatch
+*
+***************************************************************************/
+
+static float_kernel_table_t const *kernels = &scalar_kernels;
+
+void
+mrb_sdl2_float_kernels_init(void)
+{
+  kernels = &scalar_kernels;
+#if defined(MRB_SDL2_HAVE_SSE2)
+  if (SDL_HasSSE2()) {
+    kernels = &sse2_kernels;
+  }
+#elif defined(MRB_SDL2_HAVE_NEON)
+  kernels = &neon_kernels;
+#endif
+}
+
+char const *
+mrb_sdl2_float_kernels_backend(void)
+{
+  return kernels->name;
+}
+
+void
+mrb_sdl2_float_kernels_scale(float *dst, size_t count, float k)
+{
+  kernels->scale(dst, count, k);
+}
+
+void
+mrb_sdl2_float_kernels_offset(float *dst, size_t count, float k)
+{
+  kernels->offset(dst, count, k);
+}
+
+void
+mrb_sdl2_float_kernels_add(float *dst, float const *src, size_t count)
+{
+  kernels->add(dst, src, count);
+}
+
+void
+mrb_sdl2_float_kernels_mul(float *dst, float const *src, size_t count)
+{
+  kernels->mul(dst, src, count);
+}
+
+void
+mrb_sdl2_float_kernels_madd(float *dst, float const *src, size_t count, float k)
+{
+  kernels->madd(dst, src, count, k);
+}
+
+void
+mrb_sdl2_float_kernels_clamp(float *dst, size_t count, float lo, float hi)
+{
+  kernels->clamp(dst, count, lo, hi);
+}
+
+bool
+mrb_sdl2_float_kernels_min_max(float const *src, size_t count, float *min, float *max)
+{
+  if (0 == count) {
+    return false;
+  }
+  kernels->min_max(src, count, min, max);
+  return true;
+}
+
+float
+mrb_sdl2_float_kernels_sum(float const *src, size_t count)
+{
+  return kernels->sum(src, count);
+}
+
+float
+mrb_sdl2_float_kernels_dot(float const *a, float const *b, size_t count)
+{
+  return kernels->dot(a, b, count);
+}
+
+void
+mrb_sdl2_float_kernels_transform2d(float *v, size_t count, size_t stride, float const m[6])
+{
+  kernels->transform2d(v, count, stride, m);
+}
+
+void
+mrb_sdl2_float_kernels_transform3d(float *v, size_t count, size_t stride, float const m[12])
+{
+  kernels->transform3d(v, count, stride, m);
+}
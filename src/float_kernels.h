@@ -0,0 +1,39 @@
+#ifndef MRUBY_SDL2_FLOAT_KERNELS_H
+#define MRUBY_SDL2_FLOAT_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void        mrb_sdl2_float_kernels_init(void);
+extern char const *mrb_sdl2_float_kernels_backend(void);
+
+/* in-place element-wise operations over 'count' floats. */
+extern void mrb_sdl2_float_kernels_scale(float *dst, size_t count, float k);
+extern void mrb_sdl2_float_kernels_offset(float *dst, size_t count, float k);
+extern void mrb_sdl2_float_kernels_add(float *dst, float const *src, size_t count);
+extern void mrb_sdl2_float_kernels_mul(float *dst, float const *src, size_t count);
+/* dst += src * k */
+extern void mrb_sdl2_float_kernels_madd(float *dst, float const *src, size_t count, float k);
+extern void mrb_sdl2_float_kernels_clamp(float *dst, size_t count, float lo, float hi);
+
+/* reductions; min_max returns false for an empty range. */
+extern bool  mrb_sdl2_float_kernels_min_max(float const *src, size_t count, float *min, float *max);
+extern float mrb_sdl2_float_kernels_sum(float const *src, size_t count);
+extern float mrb_sdl2_float_kernels_dot(float const *a, float const *b, size_t count);
+
+/*
+ * affine transforms of 'count' vertices placed 'stride' floats apart.
+ * 'm' is a row-major 2x3 (x' = m0 x + m1 y + m2) or 3x4 matrix.
+ */
+extern void mrb_sdl2_float_kernels_transform2d(float *v, size_t count, size_t stride, float const m[6]);
+extern void mrb_sdl2_float_kernels_transform3d(float *v, size_t count, size_t stride, float const m[12]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_FLOAT_KERNELS_H */
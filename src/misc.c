@@ -1,25 +1,222 @@
 #include "misc.h"
+#include "mrb_sdl2_buffer.h"
+#include "float_kernels.h"
 #include "mruby/class.h"
 #include "mruby/value.h"
 #include "mruby/data.h"
 #include "mruby/array.h"
+#include "mruby/string.h"
+#include "mruby/variable.h"
+#include <SDL2/SDL_stdinc.h>
+
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_error.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#if defined(_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 static struct RClass *class_Buffer = NULL;
 static struct RClass *class_FloatBuffer = NULL;
 static struct RClass *class_ByteBuffer = NULL;
+static struct RClass *class_Int16Buffer = NULL;
+static struct RClass *class_UInt16Buffer = NULL;
+static struct RClass *class_Int32Buffer = NULL;
+static struct RClass *class_UInt32Buffer = NULL;
+static struct RClass *class_DoubleBuffer = NULL;
+
+/* element type of a buffer. SDL2::Buffer itself is addressed in bytes. */
+typedef enum mrb_sdl2_misc_buffer_type_t {
+  MRB_SDL2_BUFFER_RAW,
+  MRB_SDL2_BUFFER_UINT8,
+  MRB_SDL2_BUFFER_INT16,
+  MRB_SDL2_BUFFER_UINT16,
+  MRB_SDL2_BUFFER_INT32,
+  MRB_SDL2_BUFFER_UINT32,
+  MRB_SDL2_BUFFER_FLOAT,
+  MRB_SDL2_BUFFER_DOUBLE,
+} mrb_sdl2_misc_buffer_type_t;
+
+/* modes of SDL2::Buffer::map. */
+typedef enum mrb_sdl2_misc_buffer_map_mode_t {
+  MRB_SDL2_BUFFER_MAP_READ,  /* private copy-on-write pages; writes never reach the file. */
+  MRB_SDL2_BUFFER_MAP_WRITE, /* shared pages; writes go through to the file. */
+} mrb_sdl2_misc_buffer_map_mode_t;
+
+static size_t const mrb_sdl2_misc_buffer_element_size[] = {
+  1, 1, 2, 2, 4, 4, 4, 8
+};
 
 typedef struct mrb_sdl2_misc_buffer_data_t {
-  void  *buffer;
-  size_t size;
+  void                       *buffer;
+  size_t                      size;
+  mrb_sdl2_misc_buffer_type_t type;
+  bool                        owned;  /* false for views created by slice. */
+  bool                        locked; /* pinned into physical memory. */
+  void                       *block;  /* the allocation 'buffer' was aligned within. */
+  size_t                      mapped; /* length of the file mapping at 'block', 0 for heap storage. */
+  bool                        shared; /* the mapping writes through to the file. */
+  bool                        sliced; /* slice() handed out views into the storage. */
 } mrb_sdl2_misc_buffer_data_t;
 
+/* per element type (and so per buffer class) allocation counters. */
+static size_t mrb_sdl2_misc_buffer_allocations[MRB_SDL2_BUFFER_DOUBLE + 1];
+static size_t mrb_sdl2_misc_buffer_allocated_bytes[MRB_SDL2_BUFFER_DOUBLE + 1];
+
+static bool
+mrb_sdl2_misc_buffer_lock(void *p, size_t size)
+{
+#if defined(_WIN32)
+  return FALSE != VirtualLock(p, size);
+#else
+  return 0 == mlock(p, size);
+#endif
+}
+
+/* locked storage is padded to whole pages, as mlock()/munlock() do not nest per page. */
+static size_t
+mrb_sdl2_misc_buffer_page_size(void)
+{
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (size_t)info.dwPageSize;
+#else
+  long const page = sysconf(_SC_PAGESIZE);
+  return (0 < page) ? (size_t)page : 4096;
+#endif
+}
+
+static void
+mrb_sdl2_misc_buffer_unlock(void *p, size_t size)
+{
+#if defined(_WIN32)
+  VirtualUnlock(p, size);
+#else
+  munlock(p, size);
+#endif
+}
+
+/* releases the storage owned by 'data' and leaves it empty. */
+static void
+mrb_sdl2_misc_buffer_release_storage(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t *data)
+{
+  if (data->owned) {
+    if (data->locked) {
+      mrb_sdl2_misc_buffer_unlock(data->buffer, data->size);
+    }
+    if (0 < data->mapped) {
+#ifndef _WIN32
+      if (data->shared) {
+        msync(data->block, data->mapped, MS_SYNC);
+      }
+      munmap(data->block, data->mapped);
+#endif
+    } else {
+      mrb_sdl2_misc_buffer_allocated_bytes[data->type] -= data->size;
+      mrb_free(mrb, data->block);
+    }
+  }
+  data->buffer = NULL;
+  data->block  = NULL;
+  data->size   = 0;
+  data->mapped = 0;
+  data->owned  = false;
+  data->locked = false;
+  data->shared = false;
+}
+
+/*
+ * Releases the storage of a buffer being reinitialized. Views do not keep
+ * the storage itself alive, so a buffer that was ever sliced refuses.
+ */
+static void
+mrb_sdl2_misc_buffer_reset(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t *data)
+{
+  if (data->sliced) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "cannot reinitialize a buffer that has been sliced.");
+  }
+  mrb_sdl2_misc_buffer_release_storage(mrb, data);
+}
+
+/*
+ * Allocates 'size' bytes for 'data', aligned to 'align' bytes (a power of
+ * two, 0 for the allocator default) and, if 'lock' is set, pinned into
+ * memory when the platform allows it. Locked storage gets pages of its
+ * own, so unlocking one buffer never unpins another's page. Returns false
+ * when out of memory.
+ */
+static bool
+mrb_sdl2_misc_buffer_alloc_storage(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t *data,
+                                   mrb_sdl2_misc_buffer_type_t type, size_t size, size_t align, bool lock)
+{
+  size_t length = (0 < size) ? size : 1;
+  if (lock) {
+    size_t const page = mrb_sdl2_misc_buffer_page_size();
+    if (length > SIZE_MAX - (page - 1)) {
+      return false;
+    }
+    length = (length + page - 1) & ~(page - 1);
+    align  = SDL_max(align, page);
+  }
+  size_t const extra = (1 < align) ? (align - 1) : 0;
+  if (length > SIZE_MAX - extra) {
+    return false;
+  }
+  void *block = mrb_malloc(mrb, length + extra);
+  if (NULL == block) {
+    return false;
+  }
+  data->block  = block;
+  data->buffer = (void*)(((uintptr_t)block + extra) & ~(uintptr_t)extra);
+  data->size   = size;
+  data->type   = type;
+  data->owned  = true;
+  data->locked = lock && (0 < size) && mrb_sdl2_misc_buffer_lock(data->buffer, size);
+  ++mrb_sdl2_misc_buffer_allocations[type];
+  mrb_sdl2_misc_buffer_allocated_bytes[type] += size;
+  return true;
+}
+
+/* validates the 'align' argument of the initializers. */
+static size_t
+mrb_sdl2_misc_buffer_alignment(mrb_state *mrb, mrb_int align)
+{
+  if ((0 > align) || (0 != (align & (align - 1))) || (4096 < align)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "alignment must be a power of two up to 4096.");
+  }
+  return (size_t)align;
+}
+
+/* validates a size argument of the initializers; returns it in bytes. */
+static size_t
+mrb_sdl2_misc_buffer_byte_size(mrb_state *mrb, double count, size_t element_size)
+{
+  if (!(0.0 <= count)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative size.");
+  }
+  if ((double)(SIZE_MAX / element_size) <= count) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "buffer size out of range.");
+  }
+  return (size_t)count * element_size;
+}
+
 static void
 mrb_sdl2_misc_buffer_data_free(mrb_state *mrb, void *p)
 {
   mrb_sdl2_misc_buffer_data_t *data =
     (mrb_sdl2_misc_buffer_data_t*)p;
   if (NULL != data) {
-    mrb_free(mrb, data->buffer);
+    mrb_sdl2_misc_buffer_release_storage(mrb, data);
     mrb_free(mrb, p);
   }
 }
@@ -28,34 +225,83 @@ static struct mrb_data_type const mrb_sdl2_misc_buffer_data_type = {
   "Buffer", &mrb_sdl2_misc_buffer_data_free
 };
 
-static mrb_value
-mrb_sdl2_misc_buffer_initialize(mrb_state *mrb, mrb_value self)
+void *
+mrb_sdl2_misc_buffer_get_ptr(mrb_state *mrb, mrb_value buffer, size_t *size)
 {
-  mrb_value arg;
-  mrb_get_args(mrb, "o", &arg);
+  mrb_sdl2_misc_buffer_data_t *data =
+    (mrb_sdl2_misc_buffer_data_t*)mrb_data_get_ptr(mrb, buffer, &mrb_sdl2_misc_buffer_data_type);
+  if (NULL != size) {
+    *size = data->size;
+  }
+  return data->buffer;
+}
+
+mrb_bool
+mrb_sdl2_buffer_p(mrb_state *mrb, mrb_value value)
+{
+  return (MRB_TT_DATA == mrb_type(value)) && (&mrb_sdl2_misc_buffer_data_type == DATA_TYPE(value));
+}
 
+void *
+mrb_sdl2_buffer_get_ptr(mrb_state *mrb, mrb_value value, size_t *size)
+{
+  return mrb_sdl2_misc_buffer_get_ptr(mrb, value, size);
+}
+
+size_t
+mrb_sdl2_buffer_get_element_size(mrb_state *mrb, mrb_value value)
+{
   mrb_sdl2_misc_buffer_data_t *data =
-    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
+    (mrb_sdl2_misc_buffer_data_t*)mrb_data_get_ptr(mrb, value, &mrb_sdl2_misc_buffer_data_type);
+  return mrb_sdl2_misc_buffer_element_size[data->type];
+}
 
-  if (NULL == data) {
-    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
-    if (NULL == data) {
-      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+/* numeric value of an Array item; non-numeric items go through to_f/to_i. */
+static double
+mrb_sdl2_misc_buffer_item_value(mrb_state *mrb, mrb_value item)
+{
+  switch (mrb_type(item)) {
+  case MRB_TT_FIXNUM:
+    return (double)mrb_fixnum(item);
+  case MRB_TT_FLOAT:
+    return (double)mrb_float(item);
+  default:
+    if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_f", 4))) {
+      return (double)mrb_float(mrb_funcall(mrb, item, "to_f", 0));
+    } else if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_i", 4))) {
+      return (double)mrb_fixnum(mrb_funcall(mrb, item, "to_i", 0));
     }
-    data->buffer = NULL;
-    data->size   = 0;
+    mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String or convertible type");
+    break;
   }
+  return 0;
+}
+
+static mrb_value
+mrb_sdl2_misc_buffer_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value arg;
+  mrb_bool zero = true;
+  mrb_int align = 0;
+  mrb_bool lock = false;
+  mrb_get_args(mrb, "o|bib", &arg, &zero, &align, &lock);
+  size_t const alignment = mrb_sdl2_misc_buffer_alignment(mrb, align);
+
+  /* the size is worked out before anything is allocated, as it may raise. */
+  size_t size = 0;
 
+  /* an Array is stored as 32bit integers when its first item is a Fixnum, as floats otherwise. */
+  bool as_int32 = false;
   enum mrb_vtype const arg_type = mrb_type(arg);
   switch (arg_type) {
   case MRB_TT_FIXNUM:
-    data->size = (size_t)mrb_fixnum(arg);
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)mrb_fixnum(arg), 1);
     break;
   case MRB_TT_FLOAT:
-    data->size = (size_t)mrb_float(arg);
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(arg), 1);
     break;
   case MRB_TT_STRING:
-    data->size = (size_t)mrb_float(mrb_funcall(mrb, arg, "to_f", 0));
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(mrb_funcall(mrb, arg, "to_f", 0)), 1);
     break;
   case MRB_TT_ARRAY:
     {
@@ -64,112 +310,92 @@ mrb_sdl2_misc_buffer_initialize(mrb_state *mrb, mrb_value self)
         mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot accept empty array.");
       }
       mrb_value const item = mrb_ary_ref(mrb, arg, 0);
-      enum mrb_vtype const item_vtype = mrb_type(item);
-      switch (item_vtype) {
+      switch (mrb_type(item)) {
       case MRB_TT_FIXNUM:
-        data->size = n * sizeof(int32_t);
+        as_int32 = true;
         break;
       case MRB_TT_FLOAT:
-        data->size = n * sizeof(float);
-        break;
       case MRB_TT_STRING:
-        data->size = n * sizeof(float);
         break;
       default:
         if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_f", 4))) {
-          data->size = n * sizeof(float);
+          as_int32 = false;
         } else if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_i", 4))) {
-          data->size = n * sizeof(int32_t);
+          as_int32 = true;
         } else {
           mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String or convertible type");
         }
         break;
       }
+      size = n * (as_int32 ? sizeof(int32_t) : sizeof(float));
     }
     break;
   default:
     if (mrb_respond_to(mrb, arg, mrb_intern(mrb, "to_f", 4))) {
-      data->size = (size_t)mrb_float(mrb_funcall(mrb, arg, "to_f", 0));
+      size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(mrb_funcall(mrb, arg, "to_f", 0)), 1);
     } else if (mrb_respond_to(mrb, arg, mrb_intern(mrb, "to_i", 4))) {
-      data->size = (size_t)mrb_fixnum(mrb_funcall(mrb, arg, "to_i", 0));
+      size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)mrb_fixnum(mrb_funcall(mrb, arg, "to_i", 0)), 1);
     } else {
       mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String/Array or comvertible type");
     }
     break;
   }
 
-  data->buffer = mrb_malloc(mrb, data->size);
-  if (NULL == data->buffer) {
-    mrb_free(mrb, data);
+  mrb_sdl2_misc_buffer_data_t *data =
+    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
+
+  if (NULL == data) {
+    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->buffer = NULL;
+    data->block  = NULL;
+    data->size   = 0;
+    data->owned  = false;
+    data->locked = false;
+    data->mapped = 0;
+    data->shared = false;
+    data->sliced = false;
+  } else {
+    mrb_sdl2_misc_buffer_reset(mrb, data);
+  }
+
+  data->size = size;
+
+  if (!mrb_sdl2_misc_buffer_alloc_storage(mrb, data, MRB_SDL2_BUFFER_RAW, data->size, alignment, lock)) {
+    if (data != DATA_PTR(self)) {
+      mrb_free(mrb, data);
+    }
     mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
   }
 
+  DATA_PTR(self) = data;
+  DATA_TYPE(self) = &mrb_sdl2_misc_buffer_data_type;
+
   if (arg_type == MRB_TT_ARRAY) {
     mrb_int const n = mrb_ary_len(mrb, arg);
     mrb_int i;
-    enum mrb_vtype item_type = MRB_TT_MAXDEFINE;
     for (i = 0; i < n; ++i) {
-      mrb_value const item = mrb_ary_ref(mrb, arg, i);
-      switch (mrb_type(item)) {
-      case MRB_TT_FIXNUM:
-        if (item_type == MRB_TT_FIXNUM) {
-          ((int32_t*)data->buffer)[i] = mrb_fixnum(item);
-        } else if (item_type == MRB_TT_FLOAT) {
-          ((float*)data->buffer)[i] = (mrb_float)mrb_fixnum(item);
-        } else {
-          ((int32_t*)data->buffer)[i] = mrb_fixnum(item);
-          item_type = MRB_TT_FIXNUM;
-        }
-        break;
-      case MRB_TT_FLOAT:
-        if (item_type == MRB_TT_FLOAT) {
-          ((float*)data->buffer)[i] = mrb_float(item);
-        } else if (item_type == MRB_TT_FLOAT) {
-          ((int32_t*)data->buffer)[i] = (mrb_int)mrb_float(item);
-        } else {
-          ((float*)data->buffer)[i] = mrb_float(item);
-          item_type = MRB_TT_FLOAT;
-        }
-        break;
-      case MRB_TT_STRING:
-        if (item_type == MRB_TT_FLOAT) {
-          ((float*)data->buffer)[i] = mrb_float(mrb_funcall(mrb, item, "to_f", 0));
-        } else if (item_type == MRB_TT_FLOAT) {
-          ((int32_t*)data->buffer)[i] = mrb_fixnum(mrb_funcall(mrb, item, "to_i", 0));
-        } else {
-          ((float*)data->buffer)[i] = mrb_float(mrb_funcall(mrb, item, "to_f", 0));
-          item_type = MRB_TT_FLOAT;
-        }
-        break;
-      default:
-        if (item_type == MRB_TT_FLOAT) {
-          ((float*)data->buffer)[i] = mrb_float(mrb_funcall(mrb, item, "to_f", 0));
-        } else if (item_type == MRB_TT_FLOAT) {
-          ((int32_t*)data->buffer)[i] = mrb_fixnum(mrb_funcall(mrb, item, "to_i", 0));
-        } else {
-          if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_f", 4))) {
-            ((float*)data->buffer)[i] = mrb_float(mrb_funcall(mrb, item, "to_f", 0));
-            item_type = MRB_TT_FLOAT;
-          } else if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_i", 4))) {
-            ((int32_t*)data->buffer)[i] = mrb_fixnum(mrb_funcall(mrb, item, "to_i", 0));
-            item_type = MRB_TT_FIXNUM;
-          } else {
-            mrb_free(mrb, data->buffer);
-            mrb_free(mrb, data);
-            mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String or convertible type");
-          }
-        }
-        break;
+      double const value = mrb_sdl2_misc_buffer_item_value(mrb, mrb_ary_ref(mrb, arg, i));
+      if (as_int32) {
+        ((int32_t*)data->buffer)[i] = (int32_t)value;
+      } else {
+        ((float*)data->buffer)[i] = (float)value;
       }
     }
+  } else if (zero) {
+    SDL_memset(data->buffer, 0, data->size);
   }
 
-  DATA_PTR(self) = data;
-  DATA_TYPE(self) = &mrb_sdl2_misc_buffer_data_type;
-
   return self;
 }
 
+/*
+ * SDL2::Buffer#address
+ * The address as a Float, which is exact only below 2^53; native code
+ * should take the buffer itself or SDL2::Buffer#cptr instead.
+ */
 static mrb_value
 mrb_sdl2_misc_buffer_get_address(mrb_state *mrb, mrb_value self)
 {
@@ -199,30 +425,23 @@ static mrb_value
 mrb_sdl2_misc_floatbuffer_initialize(mrb_state *mrb, mrb_value self)
 {
   mrb_value arg;
-  mrb_get_args(mrb, "o", &arg);
-
-  mrb_sdl2_misc_buffer_data_t *data =
-    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
-
-  if (NULL == data) {
-    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
-    if (NULL == data) {
-      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-    }
-    data->buffer = NULL;
-    data->size   = 0;
-  }
+  mrb_bool zero = true;
+  mrb_int align = 0;
+  mrb_bool lock = false;
+  mrb_get_args(mrb, "o|bib", &arg, &zero, &align, &lock);
+  size_t const alignment = mrb_sdl2_misc_buffer_alignment(mrb, align);
 
+  size_t size = 0;
   enum mrb_vtype const arg_type = mrb_type(arg);
   switch (arg_type) {
   case MRB_TT_FIXNUM:
-    data->size = sizeof(float) * (size_t)mrb_fixnum(arg);
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)mrb_fixnum(arg), sizeof(float));
     break;
   case MRB_TT_FLOAT:
-    data->size = sizeof(float) * (size_t)mrb_float(arg);
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(arg), sizeof(float));
     break;
   case MRB_TT_STRING:
-    data->size = sizeof(float) * (size_t)mrb_float(mrb_funcall(mrb, arg, "to_f", 0));
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(mrb_funcall(mrb, arg, "to_f", 0)), sizeof(float));
     break;
   case MRB_TT_ARRAY:
     {
@@ -230,29 +449,52 @@ mrb_sdl2_misc_floatbuffer_initialize(mrb_state *mrb, mrb_value self)
       if (0 == n) {
         mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot accept empty array.");
       }
-      data->size = sizeof(float) * n;
+      size = sizeof(float) * n;
     }
     break;
   default:
     if (mrb_respond_to(mrb, arg, mrb_intern(mrb, "to_f", 4))) {
-      data->size = sizeof(float) * (size_t)mrb_float(mrb_funcall(mrb, arg, "to_f", 0));
+      size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(mrb_funcall(mrb, arg, "to_f", 0)), sizeof(float));
     } else if (mrb_respond_to(mrb, arg, mrb_intern(mrb, "to_i", 4))) {
-      data->size = sizeof(float) * (size_t)mrb_fixnum(mrb_funcall(mrb, arg, "to_i", 0));
+      size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)mrb_fixnum(mrb_funcall(mrb, arg, "to_i", 0)), sizeof(float));
     } else {
       mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String/Array or comvertible type");
     }
     break;
   }
 
-  data->buffer = mrb_malloc(mrb, data->size);
-  if (NULL == data->buffer) {
-    mrb_free(mrb, data);
+  mrb_sdl2_misc_buffer_data_t *data =
+    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
+
+  if (NULL == data) {
+    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->buffer = NULL;
+    data->block  = NULL;
+    data->size   = 0;
+    data->owned  = false;
+    data->locked = false;
+    data->mapped = 0;
+    data->shared = false;
+    data->sliced = false;
+  } else {
+    mrb_sdl2_misc_buffer_reset(mrb, data);
+  }
+
+  data->size = size;
+
+  if (!mrb_sdl2_misc_buffer_alloc_storage(mrb, data, MRB_SDL2_BUFFER_FLOAT, data->size, alignment, lock)) {
+    if (data != DATA_PTR(self)) {
+      mrb_free(mrb, data);
+    }
     mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
   }
 
-  size_t i = 0;
-  for (i = 0; i < data->size/sizeof(float); ++i) {
-    ((float*)data->buffer)[i] = 0;
+  /* an Array covers the whole allocation, so only a sized buffer needs clearing. */
+  if ((arg_type != MRB_TT_ARRAY) && zero) {
+    SDL_memset(data->buffer, 0, data->size);
   }
 
   if (arg_type == MRB_TT_ARRAY) {
@@ -276,8 +518,10 @@ mrb_sdl2_misc_floatbuffer_initialize(mrb_state *mrb, mrb_value self)
         } else if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_i", 4))) {
           ((float*)data->buffer)[i] = (float)mrb_fixnum(mrb_funcall(mrb, item, "to_i", 0));
         } else {
-          mrb_free(mrb, data->buffer);
-          mrb_free(mrb, data);
+          mrb_sdl2_misc_buffer_release_storage(mrb, data);
+          if (data != DATA_PTR(self)) {
+            mrb_free(mrb, data);
+          }
           mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String or convertible type");
         }
         break;
@@ -332,30 +576,23 @@ static mrb_value
 mrb_sdl2_misc_bytebuffer_initialize(mrb_state *mrb, mrb_value self)
 {
   mrb_value arg;
-  mrb_get_args(mrb, "o", &arg);
-
-  mrb_sdl2_misc_buffer_data_t *data =
-    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
-
-  if (NULL == data) {
-    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
-    if (NULL == data) {
-      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-    }
-    data->buffer = NULL;
-    data->size   = 0;
-  }
+  mrb_bool zero = true;
+  mrb_int align = 0;
+  mrb_bool lock = false;
+  mrb_get_args(mrb, "o|bib", &arg, &zero, &align, &lock);
+  size_t const alignment = mrb_sdl2_misc_buffer_alignment(mrb, align);
 
+  size_t size = 0;
   enum mrb_vtype const arg_type = mrb_type(arg);
   switch (arg_type) {
   case MRB_TT_FIXNUM:
-    data->size = (size_t)mrb_fixnum(arg);
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)mrb_fixnum(arg), 1);
     break;
   case MRB_TT_FLOAT:
-    data->size = (size_t)mrb_float(arg);
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(arg), 1);
     break;
   case MRB_TT_STRING:
-    data->size = (size_t)mrb_float(mrb_funcall(mrb, arg, "to_f", 0));
+    size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(mrb_funcall(mrb, arg, "to_f", 0)), 1);
     break;
   case MRB_TT_ARRAY:
     {
@@ -363,29 +600,52 @@ mrb_sdl2_misc_bytebuffer_initialize(mrb_state *mrb, mrb_value self)
       if (0 == n) {
         mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot accept empty array.");
       }
-      data->size = n * sizeof(uint8_t);
+      size = n * sizeof(uint8_t);
     }
     break;
   default:
     if (mrb_respond_to(mrb, arg, mrb_intern(mrb, "to_f", 4))) {
-      data->size = (size_t)mrb_float(mrb_funcall(mrb, arg, "to_f", 0));
+      size = mrb_sdl2_misc_buffer_byte_size(mrb, mrb_float(mrb_funcall(mrb, arg, "to_f", 0)), 1);
     } else if (mrb_respond_to(mrb, arg, mrb_intern(mrb, "to_i", 4))) {
-      data->size = (size_t)mrb_fixnum(mrb_funcall(mrb, arg, "to_i", 0));
+      size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)mrb_fixnum(mrb_funcall(mrb, arg, "to_i", 0)), 1);
     } else {
       mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String/Array or comvertible type");
     }
     break;
   }
 
-  data->buffer = mrb_malloc(mrb, data->size);
-  if (NULL == data->buffer) {
-    mrb_free(mrb, data);
+  mrb_sdl2_misc_buffer_data_t *data =
+    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
+
+  if (NULL == data) {
+    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->buffer = NULL;
+    data->block  = NULL;
+    data->size   = 0;
+    data->owned  = false;
+    data->locked = false;
+    data->mapped = 0;
+    data->shared = false;
+    data->sliced = false;
+  } else {
+    mrb_sdl2_misc_buffer_reset(mrb, data);
+  }
+
+  data->size = size;
+
+  if (!mrb_sdl2_misc_buffer_alloc_storage(mrb, data, MRB_SDL2_BUFFER_UINT8, data->size, alignment, lock)) {
+    if (data != DATA_PTR(self)) {
+      mrb_free(mrb, data);
+    }
     mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
   }
 
-  size_t i = 0;
-  for (i = 0; i < data->size/sizeof(uint8_t); ++i) {
-    ((uint8_t*)data->buffer)[i] = 0;
+  /* an Array covers the whole allocation, so only a sized buffer needs clearing. */
+  if ((arg_type != MRB_TT_ARRAY) && zero) {
+    SDL_memset(data->buffer, 0, data->size);
   }
 
   if (arg_type == MRB_TT_ARRAY) {
@@ -409,8 +669,10 @@ mrb_sdl2_misc_bytebuffer_initialize(mrb_state *mrb, mrb_value self)
         } else if (mrb_respond_to(mrb, item, mrb_intern(mrb, "to_i", 4))) {
           ((uint8_t*)data->buffer)[i] = (uint8_t)(mrb_fixnum(mrb_funcall(mrb, item, "to_i", 0)) & 0xffu);
         } else {
-          mrb_free(mrb, data->buffer);
-          mrb_free(mrb, data);
+          mrb_sdl2_misc_buffer_release_storage(mrb, data);
+          if (data != DATA_PTR(self)) {
+            mrb_free(mrb, data);
+          }
           mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/String or convertible type");
         }
         break;
@@ -452,30 +714,1003 @@ mrb_sdl2_misc_bytebuffer_set_at(mrb_state *mrb, mrb_value self)
   return self;
 }
 
-void
-mruby_sdl2_misc_init(mrb_state *mrb)
+/***************************************************************************
+*
+* typed element access
+*
+***************************************************************************/
+
+static mrb_sdl2_misc_buffer_data_t *
+mrb_sdl2_misc_buffer_get_data(mrb_state *mrb, mrb_value buffer)
+{
+  return (mrb_sdl2_misc_buffer_data_t*)mrb_data_get_ptr(mrb, buffer, &mrb_sdl2_misc_buffer_data_type);
+}
+
+static size_t
+mrb_sdl2_misc_buffer_count(mrb_sdl2_misc_buffer_data_t const *data)
+{
+  return data->size / mrb_sdl2_misc_buffer_element_size[data->type];
+}
+
+static double
+mrb_sdl2_misc_buffer_get_element(mrb_sdl2_misc_buffer_type_t type, void const *buffer, size_t index)
 {
-  class_Buffer      = mrb_define_class_under(mrb, mod_SDL2, "Buffer",      mrb->object_class);
-  class_FloatBuffer = mrb_define_class_under(mrb, mod_SDL2, "FloatBuffer", class_Buffer);
-  class_ByteBuffer  = mrb_define_class_under(mrb, mod_SDL2, "ByteBuffer",  class_Buffer);
+  switch (type) {
+  case MRB_SDL2_BUFFER_INT16:  return ((Sint16 const*)buffer)[index];
+  case MRB_SDL2_BUFFER_UINT16: return ((Uint16 const*)buffer)[index];
+  case MRB_SDL2_BUFFER_INT32:  return ((Sint32 const*)buffer)[index];
+  case MRB_SDL2_BUFFER_UINT32: return ((Uint32 const*)buffer)[index];
+  case MRB_SDL2_BUFFER_FLOAT:  return ((float const*)buffer)[index];
+  case MRB_SDL2_BUFFER_DOUBLE: return ((double const*)buffer)[index];
+  default:                     return ((Uint8 const*)buffer)[index];
+  }
+}
+
+/* integer types wrap around like ByteBuffer#[]= always did. */
+static void
+mrb_sdl2_misc_buffer_set_element(mrb_sdl2_misc_buffer_type_t type, void *buffer, size_t index, double value)
+{
+  switch (type) {
+  case MRB_SDL2_BUFFER_INT16:  ((Sint16*)buffer)[index] = (Sint16)(Sint64)value; break;
+  case MRB_SDL2_BUFFER_UINT16: ((Uint16*)buffer)[index] = (Uint16)(Sint64)value; break;
+  case MRB_SDL2_BUFFER_INT32:  ((Sint32*)buffer)[index] = (Sint32)(Sint64)value; break;
+  case MRB_SDL2_BUFFER_UINT32: ((Uint32*)buffer)[index] = (Uint32)(Sint64)value; break;
+  case MRB_SDL2_BUFFER_FLOAT:  ((float*)buffer)[index]  = (float)value;          break;
+  case MRB_SDL2_BUFFER_DOUBLE: ((double*)buffer)[index] = value;                 break;
+  default:                     ((Uint8*)buffer)[index]  = (Uint8)(Sint64)value;  break;
+  }
+}
+
+static mrb_value
+mrb_sdl2_misc_buffer_load(mrb_state *mrb, mrb_sdl2_misc_buffer_type_t type, void const *buffer, size_t index)
+{
+  switch (type) {
+  case MRB_SDL2_BUFFER_FLOAT:
+  case MRB_SDL2_BUFFER_DOUBLE:
+    return mrb_float_value(mrb, mrb_sdl2_misc_buffer_get_element(type, buffer, index));
+  default:
+    return mrb_fixnum_value((mrb_int)mrb_sdl2_misc_buffer_get_element(type, buffer, index));
+  }
+}
 
-  MRB_SET_INSTANCE_TT(class_Buffer,      MRB_TT_DATA);
-  MRB_SET_INSTANCE_TT(class_FloatBuffer, MRB_TT_DATA);
-  MRB_SET_INSTANCE_TT(class_ByteBuffer,  MRB_TT_DATA);
+static void
+mrb_sdl2_misc_buffer_store(mrb_state *mrb, mrb_sdl2_misc_buffer_type_t type, void *buffer, size_t index, mrb_value value)
+{
+  switch (mrb_type(value)) {
+  case MRB_TT_FIXNUM:
+    mrb_sdl2_misc_buffer_set_element(type, buffer, index, (double)mrb_fixnum(value));
+    break;
+  case MRB_TT_FLOAT:
+    mrb_sdl2_misc_buffer_set_element(type, buffer, index, (double)mrb_float(value));
+    break;
+  default:
+    mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum or Float.");
+    break;
+  }
+}
 
-  mrb_define_method(mrb, class_Buffer, "initialize", mrb_sdl2_misc_buffer_initialize,  MRB_ARGS_REQ(1));
-  mrb_define_method(mrb, class_Buffer, "address",    mrb_sdl2_misc_buffer_get_address, MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_Buffer, "size",       mrb_sdl2_misc_buffer_get_size,    MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_Buffer, "cptr",       mrb_sdl2_misc_buffer_get_cptr,    MRB_ARGS_NONE());
+/* checks 'offset' and 'length' (in elements) against the buffer; a negative length means the rest. */
+static void
+mrb_sdl2_misc_buffer_check_range(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t const *data, mrb_int offset, mrb_int *length)
+{
+  mrb_int const count = (mrb_int)mrb_sdl2_misc_buffer_count(data);
+  if ((0 > offset) || (count < offset)) {
+    mrb_raise(mrb, E_INDEX_ERROR, "offset out of bounds.");
+  }
+  if (0 > *length) {
+    *length = count - offset;
+  }
+  if (count - offset < *length) {
+    mrb_raise(mrb, E_INDEX_ERROR, "length out of bounds.");
+  }
+}
 
-  mrb_define_method(mrb, class_FloatBuffer, "initialize", mrb_sdl2_misc_floatbuffer_initialize, MRB_ARGS_REQ(1));
-  mrb_define_method(mrb, class_FloatBuffer, "size",       mrb_sdl2_misc_floatbuffer_get_size,   MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_FloatBuffer, "[]",         mrb_sdl2_misc_floatbuffer_get_at,     MRB_ARGS_REQ(1));
-  mrb_define_method(mrb, class_FloatBuffer, "[]=",        mrb_sdl2_misc_floatbuffer_set_at,     MRB_ARGS_REQ(2));
+/*
+ * (Re)allocates storage for 'count' elements of 'type' on 'self'.
+ * The storage is returned uncleared.
+ */
+static void *
+mrb_sdl2_misc_buffer_allocate(mrb_state *mrb, mrb_value self, mrb_sdl2_misc_buffer_type_t type, mrb_int count,
+                              size_t align, bool lock)
+{
+  size_t const size = mrb_sdl2_misc_buffer_byte_size(mrb, (double)count, mrb_sdl2_misc_buffer_element_size[type]);
 
-  mrb_define_method(mrb, class_ByteBuffer, "initialize", mrb_sdl2_misc_bytebuffer_initialize, MRB_ARGS_REQ(1));
-  mrb_define_method(mrb, class_ByteBuffer, "[]",         mrb_sdl2_misc_bytebuffer_get_at,     MRB_ARGS_REQ(1));
-  mrb_define_method(mrb, class_ByteBuffer, "[]=",        mrb_sdl2_misc_bytebuffer_set_at,     MRB_ARGS_REQ(2));
+  mrb_sdl2_misc_buffer_data_t *data =
+    (mrb_sdl2_misc_buffer_data_t*)DATA_PTR(self);
+  if (NULL == data) {
+    data = (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->buffer = NULL;
+    data->block  = NULL;
+    data->size   = 0;
+    data->owned  = false;
+    data->locked = false;
+    data->mapped = 0;
+    data->shared = false;
+    data->sliced = false;
+    DATA_PTR(self)  = data;
+    DATA_TYPE(self) = &mrb_sdl2_misc_buffer_data_type;
+  } else {
+    mrb_sdl2_misc_buffer_reset(mrb, data);
+  }
+  if (!mrb_sdl2_misc_buffer_alloc_storage(mrb, data, type, size, align, lock)) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  return data->buffer;
+}
+
+/* converts every item of 'ary' into 'buffer' in a single pass. */
+static void
+mrb_sdl2_misc_buffer_store_array(mrb_state *mrb, mrb_sdl2_misc_buffer_type_t type, void *buffer, mrb_value ary)
+{
+  mrb_int const n = mrb_ary_len(mrb, ary);
+  mrb_value const *items = RARRAY_PTR(ary);
+  mrb_int i;
+  for (i = 0; i < n; ++i) {
+    mrb_sdl2_misc_buffer_store(mrb, type, buffer, (size_t)i, items[i]);
+  }
+}
+
+/*
+ * initialize(size_or_array, zero = true, align = 0, lock = false)
+ * Allocates storage for 'count' elements and, for an Array, converts
+ * every item in a single pass. 'zero' false leaves a sized buffer uncleared.
+ * 'align' is in bytes; 'lock' pins the storage into memory (see #locked?).
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_init_typed(mrb_state *mrb, mrb_value self, mrb_sdl2_misc_buffer_type_t type)
+{
+  mrb_value arg;
+  mrb_bool zero = true;
+  mrb_int align = 0;
+  mrb_bool lock = false;
+  mrb_get_args(mrb, "o|bib", &arg, &zero, &align, &lock);
+  size_t const alignment = mrb_sdl2_misc_buffer_alignment(mrb, align);
+
+  mrb_int count;
+  switch (mrb_type(arg)) {
+  case MRB_TT_FIXNUM:
+    count = mrb_fixnum(arg);
+    break;
+  case MRB_TT_FLOAT:
+    if (!isfinite(mrb_float(arg))) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "size must be finite.");
+    }
+    if (!(0.0 <= mrb_float(arg))) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "negative size.");
+    }
+    if ((double)MRB_INT_MAX <= mrb_float(arg)) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "buffer size out of range.");
+    }
+    count = (mrb_int)mrb_float(arg);
+    break;
+  case MRB_TT_ARRAY:
+    count = mrb_ary_len(mrb, arg);
+    break;
+  default:
+    mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum/Float/Array.");
+    break;
+  }
+  void *buffer = mrb_sdl2_misc_buffer_allocate(mrb, self, type, count, alignment, lock);
+  if (MRB_TT_ARRAY == mrb_type(arg)) {
+    mrb_sdl2_misc_buffer_store_array(mrb, type, buffer, arg);
+  } else if (zero) {
+    SDL_memset(buffer, 0, mrb_sdl2_misc_buffer_element_size[type] * (size_t)count);
+  }
+  return self;
+}
+
+/*
+ * SDL2::Buffer#slice(offset, length)
+ * Returns a view on the same memory; it keeps this buffer alive, and this
+ * buffer can no longer be reinitialized.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_slice(mrb_state *mrb, mrb_value self)
+{
+  mrb_int offset, length;
+  mrb_get_args(mrb, "ii", &offset, &length);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  if (0 > length) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative length.");
+  }
+  mrb_sdl2_misc_buffer_check_range(mrb, data, offset, &length);
+  mrb_sdl2_misc_buffer_data_t *view =
+    (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
+  if (NULL == view) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  size_t const element_size = mrb_sdl2_misc_buffer_element_size[data->type];
+  view->buffer = (Uint8*)data->buffer + element_size * (size_t)offset;
+  view->size   = element_size * (size_t)length;
+  view->type   = data->type;
+  view->owned  = false;
+  view->locked = false;
+  view->block  = NULL;
+  view->mapped = 0;
+  view->shared = false;
+  view->sliced = false;
+  mrb_value const result =
+    mrb_obj_value(Data_Wrap_Struct(mrb, mrb_obj_class(mrb, self), &mrb_sdl2_misc_buffer_data_type, view));
+  mrb_iv_set(mrb, result, mrb_intern(mrb, "parent", 6), self);
+  data->sliced = true;
+  return result;
+}
+
+/*
+ * SDL2::Buffer#copy_from(src, src_offset = 0, dst_offset = 0, length = nil)
+ * Offsets and length are in elements. Buffers of different element types
+ * are converted element by element.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_copy_from(mrb_state *mrb, mrb_value self)
+{
+  mrb_value src;
+  mrb_int src_offset = 0, dst_offset = 0, length = -1;
+  mrb_get_args(mrb, "o|iii", &src, &src_offset, &dst_offset, &length);
+  mrb_sdl2_misc_buffer_data_t *dst_data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  mrb_sdl2_misc_buffer_data_t *src_data = mrb_sdl2_misc_buffer_get_data(mrb, src);
+  if (0 > length) {
+    mrb_int const src_rest = (mrb_int)mrb_sdl2_misc_buffer_count(src_data) - src_offset;
+    mrb_int const dst_rest = (mrb_int)mrb_sdl2_misc_buffer_count(dst_data) - dst_offset;
+    length = SDL_max(SDL_min(src_rest, dst_rest), 0);
+  }
+  mrb_sdl2_misc_buffer_check_range(mrb, src_data, src_offset, &length);
+  mrb_sdl2_misc_buffer_check_range(mrb, dst_data, dst_offset, &length);
+  size_t const src_size = mrb_sdl2_misc_buffer_element_size[src_data->type];
+  size_t const dst_size = mrb_sdl2_misc_buffer_element_size[dst_data->type];
+  Uint8 const *s = (Uint8 const*)src_data->buffer + src_size * (size_t)src_offset;
+  Uint8 *d = (Uint8*)dst_data->buffer + dst_size * (size_t)dst_offset;
+  if ((src_data->type == dst_data->type) || ((1 == src_size) && (1 == dst_size))) {
+    SDL_memmove(d, s, dst_size * (size_t)length);
+  } else if ((d + dst_size * (size_t)length <= s) || (s + src_size * (size_t)length <= d)) {
+    mrb_int i;
+    for (i = 0; i < length; ++i) {
+      mrb_sdl2_misc_buffer_set_element(dst_data->type, d, (size_t)i,
+        mrb_sdl2_misc_buffer_get_element(src_data->type, s, (size_t)i));
+    }
+  } else {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot convert between overlapping views.");
+  }
+  return self;
+}
+
+/*
+ * SDL2::Buffer#fill(value, offset = 0, length = nil)
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_fill(mrb_state *mrb, mrb_value self)
+{
+  mrb_value value;
+  mrb_int offset = 0, length = -1;
+  mrb_get_args(mrb, "o|ii", &value, &offset, &length);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  mrb_sdl2_misc_buffer_check_range(mrb, data, offset, &length);
+  if (0 == length) {
+    return self;
+  }
+  size_t const element_size = mrb_sdl2_misc_buffer_element_size[data->type];
+  Uint8 *p = (Uint8*)data->buffer + element_size * (size_t)offset;
+  size_t const total = element_size * (size_t)length;
+  mrb_sdl2_misc_buffer_store(mrb, data->type, p, 0, value);
+  if (1 == element_size) {
+    SDL_memset(p + 1, p[0], total - 1);
+    return self;
+  }
+  /* doubles the filled prefix until the range is covered. */
+  size_t filled = element_size;
+  while (filled < total) {
+    size_t const n = SDL_min(filled, total - filled);
+    SDL_memcpy(p + filled, p, n);
+    filled += n;
+  }
+  return self;
+}
+
+/*
+ * SDL2::Buffer#to_s
+ * Returns a copy of the raw bytes.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_to_s(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  return mrb_str_new(mrb, (char const*)data->buffer, data->size);
+}
+
+/* buffer class of every element type, in mrb_sdl2_misc_buffer_type_t order. */
+static struct RClass **const mrb_sdl2_misc_buffer_classes[] = {
+  &class_Buffer,
+  &class_ByteBuffer,
+  &class_Int16Buffer,
+  &class_UInt16Buffer,
+  &class_Int32Buffer,
+  &class_UInt32Buffer,
+  &class_FloatBuffer,
+  &class_DoubleBuffer,
+};
+
+/* element type of buffer class 'c' or of its nearest builtin ancestor; -1 for none. */
+static mrb_int
+mrb_sdl2_misc_buffer_class_type(struct RClass *c)
+{
+  for (; NULL != c; c = c->super) {
+    mrb_int i;
+    for (i = 0; i <= MRB_SDL2_BUFFER_DOUBLE; ++i) {
+      if (*mrb_sdl2_misc_buffer_classes[i] == c) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+/*
+ * SDL2::Buffer::from_string(str)
+ * Creates a buffer of the receiver class holding a copy of the bytes of 'str'.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_s_from_string(mrb_state *mrb, mrb_value klass)
+{
+  mrb_value str;
+  mrb_get_args(mrb, "S", &str);
+  mrb_int const type = mrb_sdl2_misc_buffer_class_type(mrb_class_ptr(klass));
+  if (0 > type) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown buffer class.");
+  }
+  size_t const size = (size_t)RSTRING_LEN(str);
+  size_t const element_size = mrb_sdl2_misc_buffer_element_size[type];
+  if (0 != (size % element_size)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "string length is not a multiple of the element size.");
+  }
+  mrb_value const result =
+    mrb_obj_value(Data_Wrap_Struct(mrb, mrb_class_ptr(klass), &mrb_sdl2_misc_buffer_data_type, NULL));
+  void *buffer = mrb_sdl2_misc_buffer_allocate(mrb, result, (mrb_sdl2_misc_buffer_type_t)type,
+                                               (mrb_int)(size / element_size), 0, false);
+  SDL_memcpy(buffer, RSTRING_PTR(str), size);
+  return result;
+}
+
+/*
+ * checks 'offset' and 'length' (in bytes) against a file of 'file_size'
+ * bytes. a negative length means the rest of the file in whole elements.
+ */
+static bool
+mrb_sdl2_misc_buffer_map_range(char const *path, Sint64 file_size, Sint64 offset, Sint64 *length, size_t element_size)
+{
+  if ((0 > offset) || (file_size < offset)) {
+    SDL_SetError("%s: offset out of range", path);
+    return false;
+  }
+  if (0 > *length) {
+    *length = file_size - offset;
+    *length -= *length % (Sint64)element_size;
+  } else if ((file_size - offset < *length) || (0 != (*length % (Sint64)element_size))) {
+    SDL_SetError("%s: length out of range", path);
+    return false;
+  }
+  if (0 == *length) {
+    SDL_SetError("%s: cannot map an empty range", path);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Maps a range of 'path' into 'data'. Platforms without mmap read the range
+ * into memory instead and cannot write through to the file.
+ * Returns false with the SDL error set.
+ */
+static bool
+mrb_sdl2_misc_buffer_map_file(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t *data, mrb_sdl2_misc_buffer_type_t type,
+                              char const *path, Sint64 offset, Sint64 length, mrb_int mode)
+{
+  size_t const element_size = mrb_sdl2_misc_buffer_element_size[type];
+#ifndef _WIN32
+  bool const shared = (MRB_SDL2_BUFFER_MAP_WRITE == mode);
+  int const fd = open(path, shared ? O_RDWR : O_RDONLY);
+  if (0 > fd) {
+    SDL_SetError("%s: %s", path, strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (0 != fstat(fd, &st)) {
+    SDL_SetError("%s: %s", path, strerror(errno));
+    close(fd);
+    return false;
+  }
+  if (!mrb_sdl2_misc_buffer_map_range(path, (Sint64)st.st_size, offset, &length, element_size)) {
+    close(fd);
+    return false;
+  }
+  /* mmap wants a page aligned file offset. */
+  Sint64 const page  = (Sint64)sysconf(_SC_PAGESIZE);
+  Sint64 const base  = offset - (offset % page);
+  size_t const delta = (size_t)(offset - base);
+  void *p = mmap(NULL, (size_t)length + delta, PROT_READ | PROT_WRITE,
+                 shared ? MAP_SHARED : MAP_PRIVATE, fd, (off_t)base);
+  close(fd);
+  if (MAP_FAILED == p) {
+    SDL_SetError("%s: %s", path, strerror(errno));
+    return false;
+  }
+  data->block  = p;
+  data->mapped = (size_t)length + delta;
+  data->buffer = (Uint8*)p + delta;
+  data->size   = (size_t)length;
+  data->type   = type;
+  data->owned  = true;
+  data->locked = false;
+  data->shared = shared;
+  return true;
+#else
+  if (MRB_SDL2_BUFFER_MAP_WRITE == mode) {
+    SDL_SetError("%s: writable mappings are not supported on this platform", path);
+    return false;
+  }
+  SDL_RWops *rw = SDL_RWFromFile(path, "rb");
+  if (NULL == rw) {
+    return false;
+  }
+  if (!mrb_sdl2_misc_buffer_map_range(path, SDL_RWsize(rw), offset, &length, element_size)) {
+    SDL_RWclose(rw);
+    return false;
+  }
+  if (!mrb_sdl2_misc_buffer_alloc_storage(mrb, data, type, (size_t)length, 0, false)) {
+    SDL_RWclose(rw);
+    SDL_SetError("insufficient memory");
+    return false;
+  }
+  if ((0 > SDL_RWseek(rw, offset, RW_SEEK_SET)) || (1 != SDL_RWread(rw, data->buffer, (size_t)length, 1))) {
+    mrb_sdl2_misc_buffer_release_storage(mrb, data);
+    SDL_RWclose(rw);
+    return false;
+  }
+  SDL_RWclose(rw);
+  return true;
+#endif
+}
+
+/*
+ * SDL2::Buffer::map(path, offset = 0, length = nil, mode = SDL2::Buffer::MAP_READ)
+ * Creates a buffer of the receiver class backed by a memory mapping of
+ * the file. 'offset' and 'length' are in bytes; 'offset' must be a
+ * multiple of the element size. MAP_READ pages are private
+ * copy-on-write; MAP_WRITE pages are written back to the file.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_s_map(mrb_state *mrb, mrb_value klass)
+{
+  char *path;
+  mrb_int offset = 0, mode = MRB_SDL2_BUFFER_MAP_READ;
+  mrb_value length = mrb_nil_value();
+  mrb_get_args(mrb, "z|ioi", &path, &offset, &length, &mode);
+  mrb_int const type = mrb_sdl2_misc_buffer_class_type(mrb_class_ptr(klass));
+  if (0 > type) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown buffer class.");
+  }
+  if ((MRB_SDL2_BUFFER_MAP_READ != mode) && (MRB_SDL2_BUFFER_MAP_WRITE != mode)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown map mode.");
+  }
+  Sint64 size = -1;
+  if (!mrb_nil_p(length)) {
+    if (MRB_TT_FIXNUM != mrb_type(length)) {
+      mrb_raise(mrb, E_TYPE_ERROR, "expected Fixnum or nil.");
+    }
+    size = (Sint64)mrb_fixnum(length);
+    if (0 > size) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "negative length.");
+    }
+  }
+  if (0 != offset % (mrb_int)mrb_sdl2_misc_buffer_element_size[type]) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "offset is not a multiple of the element size.");
+  }
+  mrb_sdl2_misc_buffer_data_t *data =
+    (mrb_sdl2_misc_buffer_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_misc_buffer_data_t));
+  if (NULL == data) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  data->buffer = NULL;
+  data->block  = NULL;
+  data->size   = 0;
+  data->owned  = false;
+  data->locked = false;
+  data->mapped = 0;
+  data->shared = false;
+  data->sliced = false;
+  if (!mrb_sdl2_misc_buffer_map_file(mrb, data, (mrb_sdl2_misc_buffer_type_t)type, path, (Sint64)offset, size, mode)) {
+    mrb_free(mrb, data);
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_obj_value(Data_Wrap_Struct(mrb, mrb_class_ptr(klass), &mrb_sdl2_misc_buffer_data_type, data));
+}
+
+/*
+ * SDL2::Buffer#sync
+ * Flushes a MAP_WRITE buffer to its file; does nothing for other buffers.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_sync(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+#ifndef _WIN32
+  if (data->shared && (0 != msync(data->block, data->mapped, MS_SYNC))) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, strerror(errno));
+  }
+#endif
+  return self;
+}
+
+/*
+ * SDL2::Buffer::from_array(ary, type = nil)
+ * Creates a buffer of 'type' (one of the SDL2::Buffer type constants)
+ * converting every item of 'ary' in a single pass. Without 'type' the
+ * element type of the receiver class is used. Items must be Fixnum or Float.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_s_from_array(mrb_state *mrb, mrb_value klass)
+{
+  mrb_value ary;
+  mrb_int type = -1;
+  struct RClass *c = mrb_class_ptr(klass);
+  if (1 < mrb_get_args(mrb, "A|i", &ary, &type)) {
+    if ((0 > type) || (MRB_SDL2_BUFFER_DOUBLE < type)) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown buffer type.");
+    }
+    c = *mrb_sdl2_misc_buffer_classes[type];
+  } else {
+    type = mrb_sdl2_misc_buffer_class_type(c);
+    if (0 > type) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "buffer type is required.");
+    }
+  }
+  mrb_value const result =
+    mrb_obj_value(Data_Wrap_Struct(mrb, c, &mrb_sdl2_misc_buffer_data_type, NULL));
+  void *buffer =
+    mrb_sdl2_misc_buffer_allocate(mrb, result, (mrb_sdl2_misc_buffer_type_t)type, mrb_ary_len(mrb, ary), 0, false);
+  mrb_sdl2_misc_buffer_store_array(mrb, (mrb_sdl2_misc_buffer_type_t)type, buffer, ary);
+  return result;
+}
+
+/*
+ * SDL2::Buffer#locked?
+ * true when the storage was pinned into memory by the 'lock' option.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_locked_p(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  return mrb_bool_value(data->locked);
+}
+
+static mrb_int
+mrb_sdl2_misc_buffer_receiver_type(mrb_state *mrb, mrb_value klass)
+{
+  mrb_int const type = mrb_sdl2_misc_buffer_class_type(mrb_class_ptr(klass));
+  if (0 > type) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown buffer class.");
+  }
+  return type;
+}
+
+/*
+ * SDL2::Buffer::allocations
+ * Number of storage allocations made for the receiver class so far.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_s_allocations(mrb_state *mrb, mrb_value klass)
+{
+  mrb_int const type = mrb_sdl2_misc_buffer_receiver_type(mrb, klass);
+  return mrb_float_value(mrb, (mrb_float)mrb_sdl2_misc_buffer_allocations[type]);
+}
+
+/*
+ * SDL2::Buffer::allocated_bytes
+ * Bytes currently held by live buffers of the receiver class; views are not counted.
+ */
+static mrb_value
+mrb_sdl2_misc_buffer_s_allocated_bytes(mrb_state *mrb, mrb_value klass)
+{
+  mrb_int const type = mrb_sdl2_misc_buffer_receiver_type(mrb, klass);
+  return mrb_float_value(mrb, (mrb_float)mrb_sdl2_misc_buffer_allocated_bytes[type]);
+}
+
+static mrb_value
+mrb_sdl2_misc_buffer_get_element_size(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  return mrb_fixnum_value((mrb_int)mrb_sdl2_misc_buffer_element_size[data->type]);
+}
+
+static mrb_value
+mrb_sdl2_misc_typedbuffer_get_size(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  return mrb_float_value(mrb, (mrb_float)mrb_sdl2_misc_buffer_count(data));
+}
+
+static mrb_value
+mrb_sdl2_misc_typedbuffer_get_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_get_args(mrb, "i", &index);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  if ((index < 0) || ((size_t)index >= mrb_sdl2_misc_buffer_count(data))) {
+    mrb_raise(mrb, E_INDEX_ERROR, "index out of bounds.");
+  }
+  return mrb_sdl2_misc_buffer_load(mrb, data->type, data->buffer, (size_t)index);
+}
+
+static mrb_value
+mrb_sdl2_misc_typedbuffer_set_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_value value;
+  mrb_get_args(mrb, "io", &index, &value);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, self);
+  if ((index < 0) || ((size_t)index >= mrb_sdl2_misc_buffer_count(data))) {
+    mrb_raise(mrb, E_INDEX_ERROR, "index out of bounds.");
+  }
+  mrb_sdl2_misc_buffer_store(mrb, data->type, data->buffer, (size_t)index, value);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_misc_int16buffer_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_misc_buffer_init_typed(mrb, self, MRB_SDL2_BUFFER_INT16);
+}
+
+static mrb_value
+mrb_sdl2_misc_uint16buffer_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_misc_buffer_init_typed(mrb, self, MRB_SDL2_BUFFER_UINT16);
+}
+
+static mrb_value
+mrb_sdl2_misc_int32buffer_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_misc_buffer_init_typed(mrb, self, MRB_SDL2_BUFFER_INT32);
+}
+
+static mrb_value
+mrb_sdl2_misc_uint32buffer_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_misc_buffer_init_typed(mrb, self, MRB_SDL2_BUFFER_UINT32);
+}
+
+static mrb_value
+mrb_sdl2_misc_doublebuffer_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_misc_buffer_init_typed(mrb, self, MRB_SDL2_BUFFER_DOUBLE);
+}
+
+
+/***************************************************************************
+*
+* FloatBuffer numeric kernels
+*
+***************************************************************************/
+
+static mrb_sdl2_misc_buffer_data_t *
+mrb_sdl2_misc_floatbuffer_get_data(mrb_state *mrb, mrb_value buffer)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_buffer_get_data(mrb, buffer);
+  if (MRB_SDL2_BUFFER_FLOAT != data->type) {
+    mrb_raise(mrb, E_TYPE_ERROR, "expected FloatBuffer.");
+  }
+  return data;
+}
+
+float *
+mrb_sdl2_misc_floatbuffer_get_ptr(mrb_state *mrb, mrb_value buffer, size_t *count)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, buffer);
+  if (NULL != count) {
+    *count = mrb_sdl2_misc_buffer_count(data);
+  }
+  return (float*)data->buffer;
+}
+
+/* 'other' must be a FloatBuffer holding as many elements as 'data'. */
+static float const *
+mrb_sdl2_misc_floatbuffer_operand(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t const *data, mrb_value other)
+{
+  mrb_sdl2_misc_buffer_data_t *src = mrb_sdl2_misc_floatbuffer_get_data(mrb, other);
+  if (src->size != data->size) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "buffer size mismatch.");
+  }
+  return (float const*)src->buffer;
+}
+
+/* reads 'count' matrix elements from an Array or FloatBuffer holding at least that many. */
+static void
+mrb_sdl2_misc_floatbuffer_matrix(mrb_state *mrb, mrb_value arg, float *m, size_t count)
+{
+  size_t i;
+  if (mrb_array_p(arg)) {
+    if ((size_t)mrb_ary_len(mrb, arg) < count) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "too few matrix elements.");
+    }
+    for (i = 0; i < count; ++i) {
+      mrb_sdl2_misc_buffer_store(mrb, MRB_SDL2_BUFFER_FLOAT, m, i, mrb_ary_ref(mrb, arg, i));
+    }
+  } else {
+    mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, arg);
+    if (mrb_sdl2_misc_buffer_count(data) < count) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "too few matrix elements.");
+    }
+    SDL_memcpy(m, data->buffer, sizeof(float) * count);
+  }
+}
+
+/* number of 'dim'-component vertices placed 'stride' floats apart. */
+static size_t
+mrb_sdl2_misc_floatbuffer_vertices(mrb_state *mrb, mrb_sdl2_misc_buffer_data_t const *data, mrb_int stride, size_t dim)
+{
+  size_t const count = mrb_sdl2_misc_buffer_count(data);
+  if ((mrb_int)dim > stride) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "stride too small.");
+  }
+  if (count < dim) {
+    return 0;
+  }
+  return (count - dim) / (size_t)stride + 1;
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_scale(mrb_state *mrb, mrb_value self)
+{
+  mrb_float k;
+  mrb_get_args(mrb, "f", &k);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  mrb_sdl2_float_kernels_scale((float*)data->buffer, mrb_sdl2_misc_buffer_count(data), (float)k);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_add(mrb_state *mrb, mrb_value self)
+{
+  mrb_value arg;
+  mrb_get_args(mrb, "o", &arg);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  size_t const count = mrb_sdl2_misc_buffer_count(data);
+  switch (mrb_type(arg)) {
+  case MRB_TT_FIXNUM:
+    mrb_sdl2_float_kernels_offset((float*)data->buffer, count, (float)mrb_fixnum(arg));
+    break;
+  case MRB_TT_FLOAT:
+    mrb_sdl2_float_kernels_offset((float*)data->buffer, count, (float)mrb_float(arg));
+    break;
+  default:
+    mrb_sdl2_float_kernels_add((float*)data->buffer, mrb_sdl2_misc_floatbuffer_operand(mrb, data, arg), count);
+    break;
+  }
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_mul(mrb_state *mrb, mrb_value self)
+{
+  mrb_value arg;
+  mrb_get_args(mrb, "o", &arg);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  size_t const count = mrb_sdl2_misc_buffer_count(data);
+  switch (mrb_type(arg)) {
+  case MRB_TT_FIXNUM:
+    mrb_sdl2_float_kernels_scale((float*)data->buffer, count, (float)mrb_fixnum(arg));
+    break;
+  case MRB_TT_FLOAT:
+    mrb_sdl2_float_kernels_scale((float*)data->buffer, count, (float)mrb_float(arg));
+    break;
+  default:
+    mrb_sdl2_float_kernels_mul((float*)data->buffer, mrb_sdl2_misc_floatbuffer_operand(mrb, data, arg), count);
+    break;
+  }
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_madd(mrb_state *mrb, mrb_value self)
+{
+  mrb_value other;
+  mrb_float k;
+  mrb_get_args(mrb, "of", &other, &k);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  float const *src = mrb_sdl2_misc_floatbuffer_operand(mrb, data, other);
+  mrb_sdl2_float_kernels_madd((float*)data->buffer, src, mrb_sdl2_misc_buffer_count(data), (float)k);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_clamp(mrb_state *mrb, mrb_value self)
+{
+  mrb_float lo, hi;
+  mrb_get_args(mrb, "ff", &lo, &hi);
+  if (lo > hi) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "min is greater than max.");
+  }
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  mrb_sdl2_float_kernels_clamp((float*)data->buffer, mrb_sdl2_misc_buffer_count(data), (float)lo, (float)hi);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_min(mrb_state *mrb, mrb_value self)
+{
+  float min, max;
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  if (!mrb_sdl2_float_kernels_min_max((float const*)data->buffer, mrb_sdl2_misc_buffer_count(data), &min, &max)) {
+    return mrb_nil_value();
+  }
+  return mrb_float_value(mrb, min);
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_max(mrb_state *mrb, mrb_value self)
+{
+  float min, max;
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  if (!mrb_sdl2_float_kernels_min_max((float const*)data->buffer, mrb_sdl2_misc_buffer_count(data), &min, &max)) {
+    return mrb_nil_value();
+  }
+  return mrb_float_value(mrb, max);
+}
+
+static mrb_value
+mrb_sdl2_misc_floatbuffer_sum(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  return mrb_float_value(mrb, mrb_sdl2_float_kernels_sum((float const*)data->buffer, mrb_sdl2_misc_buffer_count(data)));
+}
+
+/*
+ * transform2d(matrix[, stride = 2])
+ * 'matrix' is a row-major 2x3 (or 3x3, the last row is ignored) given as
+ * an Array or FloatBuffer.
+ */
+static mrb_value
+mrb_sdl2_misc_floatbuffer_transform2d(mrb_state *mrb, mrb_value self)
+{
+  mrb_value matrix;
+  mrb_int stride = 2;
+  float m[6];
+  mrb_get_args(mrb, "o|i", &matrix, &stride);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  size_t const count = mrb_sdl2_misc_floatbuffer_vertices(mrb, data, stride, 2);
+  mrb_sdl2_misc_floatbuffer_matrix(mrb, matrix, m, 6);
+  mrb_sdl2_float_kernels_transform2d((float*)data->buffer, count, (size_t)stride, m);
+  return self;
+}
+
+/*
+ * transform3d(matrix[, stride = 3])
+ * 'matrix' is a row-major 3x4 (or 4x4, the last row is ignored).
+ */
+static mrb_value
+mrb_sdl2_misc_floatbuffer_transform3d(mrb_state *mrb, mrb_value self)
+{
+  mrb_value matrix;
+  mrb_int stride = 3;
+  float m[12];
+  mrb_get_args(mrb, "o|i", &matrix, &stride);
+  mrb_sdl2_misc_buffer_data_t *data = mrb_sdl2_misc_floatbuffer_get_data(mrb, self);
+  size_t const count = mrb_sdl2_misc_floatbuffer_vertices(mrb, data, stride, 3);
+  mrb_sdl2_misc_floatbuffer_matrix(mrb, matrix, m, 12);
+  mrb_sdl2_float_kernels_transform3d((float*)data->buffer, count, (size_t)stride, m);
+  return self;
+}
+
+/*
+ * SDL2::FloatBuffer::simd_backend
+ */
+static mrb_value
+mrb_sdl2_misc_floatbuffer_s_simd_backend(mrb_state *mrb, mrb_value self)
+{
+  return mrb_str_new_cstr(mrb, mrb_sdl2_float_kernels_backend());
+}
+
+
+void
+mruby_sdl2_misc_init(mrb_state *mrb)
+{
+  mrb_sdl2_float_kernels_init();
+
+  class_Buffer       = mrb_define_class_under(mrb, mod_SDL2, "Buffer",       mrb->object_class);
+  class_FloatBuffer  = mrb_define_class_under(mrb, mod_SDL2, "FloatBuffer",  class_Buffer);
+  class_ByteBuffer   = mrb_define_class_under(mrb, mod_SDL2, "ByteBuffer",   class_Buffer);
+  class_Int16Buffer  = mrb_define_class_under(mrb, mod_SDL2, "Int16Buffer",  class_Buffer);
+  class_UInt16Buffer = mrb_define_class_under(mrb, mod_SDL2, "UInt16Buffer", class_Buffer);
+  class_Int32Buffer  = mrb_define_class_under(mrb, mod_SDL2, "Int32Buffer",  class_Buffer);
+  class_UInt32Buffer = mrb_define_class_under(mrb, mod_SDL2, "UInt32Buffer", class_Buffer);
+  class_DoubleBuffer = mrb_define_class_under(mrb, mod_SDL2, "DoubleBuffer", class_Buffer);
+
+  MRB_SET_INSTANCE_TT(class_Buffer,       MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_FloatBuffer,  MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_ByteBuffer,   MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_Int16Buffer,  MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_UInt16Buffer, MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_Int32Buffer,  MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_UInt32Buffer, MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_DoubleBuffer, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_Buffer, "initialize",   mrb_sdl2_misc_buffer_initialize,       MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_Buffer, "address",      mrb_sdl2_misc_buffer_get_address,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Buffer, "size",         mrb_sdl2_misc_buffer_get_size,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Buffer, "cptr",         mrb_sdl2_misc_buffer_get_cptr,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Buffer, "element_size", mrb_sdl2_misc_buffer_get_element_size, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Buffer, "slice",        mrb_sdl2_misc_buffer_slice,            MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_Buffer, "copy_from",    mrb_sdl2_misc_buffer_copy_from,        MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_Buffer, "fill",         mrb_sdl2_misc_buffer_fill,             MRB_ARGS_REQ(1) | MRB_ARGS_OPT(2));
+  mrb_define_method(mrb, class_Buffer, "to_s",         mrb_sdl2_misc_buffer_to_s,             MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Buffer, "locked?",      mrb_sdl2_misc_buffer_locked_p,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Buffer, "sync",         mrb_sdl2_misc_buffer_sync,             MRB_ARGS_NONE());
+
+  mrb_define_class_method(mrb, class_Buffer, "from_string",     mrb_sdl2_misc_buffer_s_from_string,     MRB_ARGS_REQ(1));
+  mrb_define_class_method(mrb, class_Buffer, "from_array",      mrb_sdl2_misc_buffer_s_from_array,      MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_class_method(mrb, class_Buffer, "allocations",     mrb_sdl2_misc_buffer_s_allocations,     MRB_ARGS_NONE());
+  mrb_define_class_method(mrb, class_Buffer, "allocated_bytes", mrb_sdl2_misc_buffer_s_allocated_bytes, MRB_ARGS_NONE());
+  mrb_define_class_method(mrb, class_Buffer, "map",             mrb_sdl2_misc_buffer_s_map,             MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+
+  mrb_define_const(mrb, class_Buffer, "RAW",    mrb_fixnum_value(MRB_SDL2_BUFFER_RAW));
+  mrb_define_const(mrb, class_Buffer, "UINT8",  mrb_fixnum_value(MRB_SDL2_BUFFER_UINT8));
+  mrb_define_const(mrb, class_Buffer, "INT16",  mrb_fixnum_value(MRB_SDL2_BUFFER_INT16));
+  mrb_define_const(mrb, class_Buffer, "UINT16", mrb_fixnum_value(MRB_SDL2_BUFFER_UINT16));
+  mrb_define_const(mrb, class_Buffer, "INT32",  mrb_fixnum_value(MRB_SDL2_BUFFER_INT32));
+  mrb_define_const(mrb, class_Buffer, "UINT32", mrb_fixnum_value(MRB_SDL2_BUFFER_UINT32));
+  mrb_define_const(mrb, class_Buffer, "FLOAT",  mrb_fixnum_value(MRB_SDL2_BUFFER_FLOAT));
+  mrb_define_const(mrb, class_Buffer, "DOUBLE", mrb_fixnum_value(MRB_SDL2_BUFFER_DOUBLE));
+
+  mrb_define_const(mrb, class_Buffer, "MAP_READ",  mrb_fixnum_value(MRB_SDL2_BUFFER_MAP_READ));
+  mrb_define_const(mrb, class_Buffer, "MAP_WRITE", mrb_fixnum_value(MRB_SDL2_BUFFER_MAP_WRITE));
+
+  mrb_define_method(mrb, class_FloatBuffer, "initialize",  mrb_sdl2_misc_floatbuffer_initialize,  MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_FloatBuffer, "size",        mrb_sdl2_misc_floatbuffer_get_size,    MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FloatBuffer, "[]",          mrb_sdl2_misc_floatbuffer_get_at,      MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_FloatBuffer, "[]=",         mrb_sdl2_misc_floatbuffer_set_at,      MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_FloatBuffer, "scale",       mrb_sdl2_misc_floatbuffer_scale,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_FloatBuffer, "add",         mrb_sdl2_misc_floatbuffer_add,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_FloatBuffer, "mul",         mrb_sdl2_misc_floatbuffer_mul,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_FloatBuffer, "madd",        mrb_sdl2_misc_floatbuffer_madd,        MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_FloatBuffer, "clamp",       mrb_sdl2_misc_floatbuffer_clamp,       MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_FloatBuffer, "min",         mrb_sdl2_misc_floatbuffer_min,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FloatBuffer, "max",         mrb_sdl2_misc_floatbuffer_max,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FloatBuffer, "sum",         mrb_sdl2_misc_floatbuffer_sum,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FloatBuffer, "transform2d", mrb_sdl2_misc_floatbuffer_transform2d, MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_FloatBuffer, "transform3d", mrb_sdl2_misc_floatbuffer_transform3d, MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+
+  mrb_define_class_method(mrb, class_FloatBuffer, "simd_backend", mrb_sdl2_misc_floatbuffer_s_simd_backend, MRB_ARGS_NONE());
+
+  mrb_define_method(mrb, class_ByteBuffer, "initialize", mrb_sdl2_misc_bytebuffer_initialize, MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_ByteBuffer, "[]",         mrb_sdl2_misc_bytebuffer_get_at,     MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_ByteBuffer, "[]=",        mrb_sdl2_misc_bytebuffer_set_at,     MRB_ARGS_REQ(2));
+
+  mrb_define_method(mrb, class_Int16Buffer,  "initialize", mrb_sdl2_misc_int16buffer_initialize,   MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_Int16Buffer,  "size",       mrb_sdl2_misc_typedbuffer_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Int16Buffer,  "[]",         mrb_sdl2_misc_typedbuffer_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_Int16Buffer,  "[]=",        mrb_sdl2_misc_typedbuffer_set_at,       MRB_ARGS_REQ(2));
+
+  mrb_define_method(mrb, class_UInt16Buffer, "initialize", mrb_sdl2_misc_uint16buffer_initialize,  MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_UInt16Buffer, "size",       mrb_sdl2_misc_typedbuffer_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_UInt16Buffer, "[]",         mrb_sdl2_misc_typedbuffer_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_UInt16Buffer, "[]=",        mrb_sdl2_misc_typedbuffer_set_at,       MRB_ARGS_REQ(2));
+
+  mrb_define_method(mrb, class_Int32Buffer,  "initialize", mrb_sdl2_misc_int32buffer_initialize,   MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_Int32Buffer,  "size",       mrb_sdl2_misc_typedbuffer_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Int32Buffer,  "[]",         mrb_sdl2_misc_typedbuffer_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_Int32Buffer,  "[]=",        mrb_sdl2_misc_typedbuffer_set_at,       MRB_ARGS_REQ(2));
+
+  mrb_define_method(mrb, class_UInt32Buffer, "initialize", mrb_sdl2_misc_uint32buffer_initialize,  MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_UInt32Buffer, "size",       mrb_sdl2_misc_typedbuffer_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_UInt32Buffer, "[]",         mrb_sdl2_misc_typedbuffer_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_UInt32Buffer, "[]=",        mrb_sdl2_misc_typedbuffer_set_at,       MRB_ARGS_REQ(2));
+
+  mrb_define_method(mrb, class_DoubleBuffer, "initialize", mrb_sdl2_misc_doublebuffer_initialize,  MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_DoubleBuffer, "size",       mrb_sdl2_misc_typedbuffer_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_DoubleBuffer, "[]",         mrb_sdl2_misc_typedbuffer_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_DoubleBuffer, "[]=",        mrb_sdl2_misc_typedbuffer_set_at,       MRB_ARGS_REQ(2));
 }
 
 void
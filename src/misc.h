@@ -10,7 +10,11 @@ extern "C" {
 extern void mruby_sdl2_misc_init(mrb_state *mrb);
 extern void mruby_sdl2_misc_final(mrb_state *mrb);
 
-#ifdef __cplusplu
+extern void *mrb_sdl2_misc_buffer_get_ptr(mrb_state *mrb, mrb_value buffer, size_t *size);
+/* raises TypeError unless 'buffer' is a FloatBuffer; 'count' is in floats. */
+extern float *mrb_sdl2_misc_floatbuffer_get_ptr(mrb_state *mrb, mrb_value buffer, size_t *count);
+
+#ifdef __cplusplus
 }
 #endif
 
@@ -0,0 +1,786 @@
+#include "pixel_kernels.h"
+#include "simd.h"
+#include <SDL2/SDL_stdinc.h>
+
+/*
+ * Native row kernels for the common 24/32-bit pixel formats.
+ *
+ * Every backend produces bit-identical results; the scalar kernels are
+ * the reference and also handle the tail of each row.
+ */
+
+/* x / 255 rounded to nearest, exact for 0 <= x <= 255 * 255. */
+#define DIV255(x) ((((x) + 128) + (((x) + 128) >> 8)) >> 8)
+
+#define ALPHA_MASK 0xFF000000u
+
+typedef struct pixel_kernel_table_t {
+  char const             *name;
+  mrb_sdl2_pixel_row_func expand24_lo;
+  mrb_sdl2_pixel_row_func expand24_hi;
+  mrb_sdl2_pixel_row_func swap32;
+  mrb_sdl2_pixel_row_func swap32_opaque;
+  mrb_sdl2_pixel_row_func copy32_opaque;
+  void (*blend)(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod);
+  void (*blend_premultiplied)(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod);
+  void (*premultiply)(Uint32 *pixels, int width);
+  void (*downsample32)(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width);
+} pixel_kernel_table_t;
+
+/***************************************************************************
+*
+* scalar kernels
+*
+***************************************************************************/
+
+static inline Uint32
+swap_rb(Uint32 p)
+{
+  return (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+}
+
+static inline Uint32
+blend_pixel(Uint32 s, Uint32 d, Uint8 alpha_mod)
+{
+  Uint32 a = s >> 24;
+  if (255 != alpha_mod) {
+    a = DIV255(a * alpha_mod);
+  }
+  if (0 == a) {
+    return d;
+  }
+  if (255 == a) {
+    return s | ALPHA_MASK;
+  }
+  Uint32 const inv = 255 - a;
+  Uint32 const c0 = DIV255(( s        & 0xFF) * a + ( d        & 0xFF) * inv);
+  Uint32 const c1 = DIV255(((s >>  8) & 0xFF) * a + ((d >>  8) & 0xFF) * inv);
+  Uint32 const c2 = DIV255(((s >> 16) & 0xFF) * a + ((d >> 16) & 0xFF) * inv);
+  Uint32 const ca = DIV255(255 * a + (d >> 24) * inv);
+  return c0 | (c1 << 8) | (c2 << 16) | (ca << 24);
+}
+
+/* channels of invalid sources with color above alpha saturate at 255. */
+static inline Uint32
+blend_premultiplied_pixel(Uint32 s, Uint32 d, Uint8 alpha_mod)
+{
+  if (255 != alpha_mod) {
+    s = DIV255(( s        & 0xFF) * alpha_mod)        |
+        (DIV255(((s >>  8) & 0xFF) * alpha_mod) <<  8) |
+        (DIV255(((s >> 16) & 0xFF) * alpha_mod) << 16) |
+        (DIV255(( s >> 24        ) * alpha_mod) << 24);
+  }
+  if (0 == s) {
+    return d;
+  }
+  Uint32 const inv = 255 - (s >> 24);
+  if (0 == inv) {
+    return s;
+  }
+  Uint32 const c0 = SDL_min(( s        & 0xFF) + DIV255(( d        & 0xFF) * inv), 255u);
+  Uint32 const c1 = SDL_min(((s >>  8) & 0xFF) + DIV255(((d >>  8) & 0xFF) * inv), 255u);
+  Uint32 const c2 = SDL_min(((s >> 16) & 0xFF) + DIV255(((d >> 16) & 0xFF) * inv), 255u);
+  Uint32 const ca = (s >> 24) + DIV255((d >> 24) * inv);
+  return c0 | (c1 << 8) | (c2 << 16) | (ca << 24);
+}
+
+static inline Uint32
+premultiply_pixel(Uint32 p)
+{
+  Uint32 const a = p >> 24;
+  Uint32 const c0 = DIV255(( p        & 0xFF) * a);
+  Uint32 const c1 = DIV255(((p >>  8) & 0xFF) * a);
+  Uint32 const c2 = DIV255(((p >> 16) & 0xFF) * a);
+  return c0 | (c1 << 8) | (c2 << 16) | (a << 24);
+}
+
+/* first byte of each 24-bit pixel becomes the low byte of the result. */
+static void
+expand24_lo_scalar(Uint8 *dst, Uint8 const *src, int width)
+{
+  Uint32 *d = (Uint32*)dst;
+  int i;
+  for (i = 0; i < width; ++i, src += 3) {
+    d[i] = ALPHA_MASK | ((Uint32)src[2] << 16) | ((Uint32)src[1] << 8) | src[0];
+  }
+}
+
+/* first byte of each 24-bit pixel becomes bits 16-23 of the result. */
+static void
+expand24_hi_scalar(Uint8 *dst, Uint8 const *src, int width)
+{
+  Uint32 *d = (Uint32*)dst;
+  int i;
+  for (i = 0; i < width; ++i, src += 3) {
+    d[i] = ALPHA_MASK | ((Uint32)src[0] << 16) | ((Uint32)src[1] << 8) | src[2];
+  }
+}
+
+static void
+swap32_scalar(Uint8 *dst, Uint8 const *src, int width)
+{
+  Uint32 *d = (Uint32*)dst;
+  Uint32 const *s = (Uint32 const*)src;
+  int i;
+  for (i = 0; i < width; ++i) {
+    d[i] = swap_rb(s[i]);
+  }
+}
+
+static void
+swap32_opaque_scalar(Uint8 *dst, Uint8 const *src, int width)
+{
+  Uint32 *d = (Uint32*)dst;
+  Uint32 const *s = (Uint32 const*)src;
+  int i;
+  for (i = 0; i < width; ++i) {
+    d[i] = swap_rb(s[i]) | ALPHA_MASK;
+  }
+}
+
+static void
+copy32_opaque_scalar(Uint8 *dst, Uint8 const *src, int width)
+{
+  Uint32 *d = (Uint32*)dst;
+  Uint32 const *s = (Uint32 const*)src;
+  int i;
+  for (i = 0; i < width; ++i) {
+    d[i] = s[i] | ALPHA_MASK;
+  }
+}
+
+static void
+blend_scalar(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod)
+{
+  int i;
+  for (i = 0; i < width; ++i) {
+    dst[i] = blend_pixel(src[i], dst[i], alpha_mod);
+  }
+}
+
+static void
+blend_premultiplied_scalar(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod)
+{
+  int i;
+  for (i = 0; i < width; ++i) {
+    dst[i] = blend_premultiplied_pixel(src[i], dst[i], alpha_mod);
+  }
+}
+
+static void
+premultiply_scalar(Uint32 *pixels, int width)
+{
+  int i;
+  for (i = 0; i < width; ++i) {
+    pixels[i] = premultiply_pixel(pixels[i]);
+  }
+}
+
+/*
+ * Averages 2x2 blocks of any layout with 8-bit channels, starting at
+ * destination pixel 'i'. The last column is repeated for 1 pixel wide
+ * sources; an odd trailing column is dropped otherwise.
+ */
+static void
+downsample_tail(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width, int bpp, int i)
+{
+  int const width = SDL_max(src_width / 2, 1);
+  int c;
+  for (; i < width; ++i) {
+    int const x0 = i * 2 * bpp;
+    int const x1 = SDL_min(i * 2 + 1, src_width - 1) * bpp;
+    for (c = 0; c < bpp; ++c) {
+      dst[i * bpp + c] = (Uint8)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+    }
+  }
+}
+
+static void
+downsample32_scalar(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width)
+{
+  downsample_tail(dst, row0, row1, src_width, 4, 0);
+}
+
+static pixel_kernel_table_t const scalar_kernels = {
+  "scalar",
+  expand24_lo_scalar,
+  expand24_hi_scalar,
+  swap32_scalar,
+  swap32_opaque_scalar,
+  copy32_opaque_scalar,
+  blend_scalar,
+  blend_premultiplied_scalar,
+  premultiply_scalar,
+  downsample32_scalar,
+};
+
+/***************************************************************************
+*
+* SSE2 kernels
+*
+***************************************************************************/
+
+#ifdef MRB_SDL2_HAVE_SSE2
+
+static inline __m128i
+swap_rb_sse2(__m128i p)
+{
+  __m128i const ga = _mm_set1_epi32((int)0xFF00FF00u);
+  __m128i const lo = _mm_set1_epi32(0xFF);
+  return _mm_or_si128(_mm_and_si128(p, ga),
+                      _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), lo),
+                                   _mm_slli_epi32(_mm_and_si128(p, lo), 16)));
+}
+
+/* gathers 4 packed 24-bit pixels (12 of the 16 loaded bytes) into 32-bit lanes. */
+static inline __m128i
+gather24_sse2(Uint8 const *src)
+{
+  __m128i const v  = _mm_loadu_si128((__m128i const*)src);
+  __m128i const m0 = _mm_set_epi32(0, 0, 0, 0x00FFFFFF);
+  __m128i const m1 = _mm_set_epi32(0, 0, 0x00FFFFFF, 0);
+  __m128i const m2 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0);
+  __m128i const m3 = _mm_set_epi32(0x00FFFFFF, 0, 0, 0);
+  return _mm_or_si128(_mm_or_si128(_mm_and_si128(v, m0),
+                                   _mm_and_si128(_mm_slli_si128(v, 1), m1)),
+                      _mm_or_si128(_mm_and_si128(_mm_slli_si128(v, 2), m2),
+                                   _mm_and_si128(_mm_slli_si128(v, 3), m3)));
+}
+
+static void
+expand24_lo_sse2(Uint8 *dst, Uint8 const *src, int width)
+{
+  __m128i const alpha = _mm_set1_epi32((int)ALPHA_MASK);
+  int i = 0;
+  /* each step reads 16 bytes but consumes 12, so keep 2 pixels of slack. */
+  for (; i + 6 <= width; i += 4, src += 12) {
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(gather24_sse2(src), alpha));
+  }
+  expand24_lo_scalar(dst + i * 4, src, width - i);
+}
+
+static void
+expand24_hi_sse2(Uint8 *dst, Uint8 const *src, int width)
+{
+  __m128i const alpha = _mm_set1_epi32((int)ALPHA_MASK);
+  int i = 0;
+  for (; i + 6 <= width; i += 4, src += 12) {
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(swap_rb_sse2(gather24_sse2(src)), alpha));
+  }
+  expand24_hi_scalar(dst + i * 4, src, width - i);
+}
+
+static void
+swap32_sse2(Uint8 *dst, Uint8 const *src, int width)
+{
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    __m128i const p = _mm_loadu_si128((__m128i const*)(src + i * 4));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), swap_rb_sse2(p));
+  }
+  swap32_scalar(dst + i * 4, src + i * 4, width - i);
+}
+
+static void
+swap32_opaque_sse2(Uint8 *dst, Uint8 const *src, int width)
+{
+  __m128i const alpha = _mm_set1_epi32((int)ALPHA_MASK);
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    __m128i const p = _mm_loadu_si128((__m128i const*)(src + i * 4));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(swap_rb_sse2(p), alpha));
+  }
+  swap32_opaque_scalar(dst + i * 4, src + i * 4, width - i);
+}
+
+static void
+copy32_opaque_sse2(Uint8 *dst, Uint8 const *src, int width)
+{
+  __m128i const alpha = _mm_set1_epi32((int)ALPHA_MASK);
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    __m128i const p = _mm_loadu_si128((__m128i const*)(src + i * 4));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(p, alpha));
+  }
+  copy32_opaque_scalar(dst + i * 4, src + i * 4, width - i);
+}
+
+static inline __m128i
+div255_sse2(__m128i x)
+{
+  return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+}
+
+/* blends 2 pixels unpacked to 16-bit lanes (alpha in lanes 3 and 7). */
+static inline __m128i
+blend2_sse2(__m128i s, __m128i d, __m128i mod, bool modulate)
+{
+  __m128i const amask = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  if (modulate) {
+    a = div255_sse2(_mm_mullo_epi16(a, mod));
+  }
+  /* the alpha lane blends a source value of 255: dA' = a + dA * (1 - a). */
+  s = _mm_or_si128(s, amask);
+  __m128i const inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+  return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, inv)));
+}
+
+static void
+blend_sse2(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod)
+{
+  __m128i const zero  = _mm_setzero_si128();
+  __m128i const alpha = _mm_set1_epi32((int)ALPHA_MASK);
+  __m128i const mod   = _mm_set1_epi16(alpha_mod);
+  bool const modulate = (255 != alpha_mod);
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    __m128i const s  = _mm_loadu_si128((__m128i const*)(src + i));
+    __m128i const sa = _mm_and_si128(s, alpha);
+    if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(sa, zero))) {
+      continue; /* fully transparent */
+    }
+    if (!modulate && (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(sa, alpha)))) {
+      _mm_storeu_si128((__m128i*)(dst + i), s);
+      continue; /* fully opaque */
+    }
+    __m128i const d  = _mm_loadu_si128((__m128i const*)(dst + i));
+    __m128i const lo = blend2_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), mod, modulate);
+    __m128i const hi = blend2_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), mod, modulate);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  blend_scalar(dst + i, src + i, width - i, alpha_mod);
+}
+
+/* blends 2 premultiplied pixels unpacked to 16-bit lanes. */
+static inline __m128i
+blend_premultiplied2_sse2(__m128i s, __m128i d, __m128i mod, bool modulate)
+{
+  if (modulate) {
+    s = div255_sse2(_mm_mullo_epi16(s, mod));
+  }
+  __m128i const a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+  __m128i const inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+  return _mm_add_epi16(s, div255_sse2(_mm_mullo_epi16(d, inv)));
+}
+
+static void
+blend_premultiplied_sse2(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod)
+{
+  __m128i const zero  = _mm_setzero_si128();
+  __m128i const alpha = _mm_set1_epi32((int)ALPHA_MASK);
+  __m128i const mod   = _mm_set1_epi16(alpha_mod);
+  bool const modulate = (255 != alpha_mod);
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    __m128i const s = _mm_loadu_si128((__m128i const*)(src + i));
+    if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(s, zero))) {
+      continue; /* nothing to add */
+    }
+    if (!modulate && (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha), alpha)))) {
+      _mm_storeu_si128((__m128i*)(dst + i), s);
+      continue; /* fully opaque */
+    }
+    __m128i const d  = _mm_loadu_si128((__m128i const*)(dst + i));
+    __m128i const lo = blend_premultiplied2_sse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), mod, modulate);
+    __m128i const hi = blend_premultiplied2_sse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), mod, modulate);
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+  blend_premultiplied_scalar(dst + i, src + i, width - i, alpha_mod);
+}
+
+static void
+premultiply_sse2(Uint32 *pixels, int width)
+{
+  __m128i const zero  = _mm_setzero_si128();
+  __m128i const amask = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    __m128i const p  = _mm_loadu_si128((__m128i const*)(pixels + i));
+    __m128i const lo = _mm_unpacklo_epi8(p, zero);
+    __m128i const hi = _mm_unpackhi_epi8(p, zero);
+    /* alpha lanes are multiplied by 255 so that they are kept as is. */
+    __m128i const alo = _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), amask);
+    __m128i const ahi = _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)), amask);
+    _mm_storeu_si128((__m128i*)(pixels + i),
+                     _mm_packus_epi16(div255_sse2(_mm_mullo_epi16(lo, alo)),
+                                      div255_sse2(_mm_mullo_epi16(hi, ahi))));
+  }
+  premultiply_scalar(pixels + i, width - i);
+}
+
+static void
+downsample32_sse2(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width)
+{
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const two  = _mm_set1_epi16(2);
+  int i = 0;
+  for (; (i + 4) * 2 <= src_width; i += 4) {
+    __m128i const a = _mm_loadu_si128((__m128i const*)(row0 + i * 8));
+    __m128i const b = _mm_loadu_si128((__m128i const*)(row0 + i * 8 + 16));
+    __m128i const c = _mm_loadu_si128((__m128i const*)(row1 + i * 8));
+    __m128i const d = _mm_loadu_si128((__m128i const*)(row1 + i * 8 + 16));
+    /* vertical sums of source pixels 0-1, 2-3, 4-5 and 6-7. */
+    __m128i const s0 = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(c, zero));
+    __m128i const s1 = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(c, zero));
+    __m128i const s2 = _mm_add_epi16(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(d, zero));
+    __m128i const s3 = _mm_add_epi16(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(d, zero));
+    /* horizontal sums of neighbouring pixels. */
+    __m128i const lo = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+    __m128i const hi = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+    _mm_storeu_si128((__m128i*)(dst + i * 4),
+                     _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, two), 2),
+                                      _mm_srli_epi16(_mm_add_epi16(hi, two), 2)));
+  }
+  downsample_tail(dst, row0, row1, src_width, 4, i);
+}
+
+static pixel_kernel_table_t const sse2_kernels = {
+  "sse2",
+  expand24_lo_sse2,
+  expand24_hi_sse2,
+  swap32_sse2,
+  swap32_opaque_sse2,
+  copy32_opaque_sse2,
+  blend_sse2,
+  blend_premultiplied_sse2,
+  premultiply_sse2,
+  downsample32_sse2,
+};
+
+#endif /* MRB_SDL2_HAVE_SSE2 */
+
+/***************************************************************************
+*
+* NEON kernels
+*
+***************************************************************************/
+
+#ifdef MRB_SDL2_HAVE_NEON
+
+/* vld4/vst4 lanes are the bytes of a little-endian pixel: val[3] is the top byte. */
+
+static void
+expand24_lo_neon(Uint8 *dst, Uint8 const *src, int width)
+{
+  int i = 0;
+  for (; i + 8 <= width; i += 8, src += 24) {
+    uint8x8x3_t const s = vld3_u8(src);
+    uint8x8x4_t d;
+    d.val[0] = s.val[0];
+    d.val[1] = s.val[1];
+    d.val[2] = s.val[2];
+    d.val[3] = vdup_n_u8(0xFF);
+    vst4_u8(dst + i * 4, d);
+  }
+  expand24_lo_scalar(dst + i * 4, src, width - i);
+}
+
+static void
+expand24_hi_neon(Uint8 *dst, Uint8 const *src, int width)
+{
+  int i = 0;
+  for (; i + 8 <= width; i += 8, src += 24) {
+    uint8x8x3_t const s = vld3_u8(src);
+    uint8x8x4_t d;
+    d.val[0] = s.val[2];
+    d.val[1] = s.val[1];
+    d.val[2] = s.val[0];
+    d.val[3] = vdup_n_u8(0xFF);
+    vst4_u8(dst + i * 4, d);
+  }
+  expand24_hi_scalar(dst + i * 4, src, width - i);
+}
+
+static void
+swap32_neon(Uint8 *dst, Uint8 const *src, int width)
+{
+  int i = 0;
+  for (; i + 8 <= width; i += 8) {
+    uint8x8x4_t p = vld4_u8(src + i * 4);
+    uint8x8_t const t = p.val[0];
+    p.val[0] = p.val[2];
+    p.val[2] = t;
+    vst4_u8(dst + i * 4, p);
+  }
+  swap32_scalar(dst + i * 4, src + i * 4, width - i);
+}
+
+static void
+swap32_opaque_neon(Uint8 *dst, Uint8 const *src, int width)
+{
+  int i = 0;
+  for (; i + 8 <= width; i += 8) {
+    uint8x8x4_t p = vld4_u8(src + i * 4);
+    uint8x8_t const t = p.val[0];
+    p.val[0] = p.val[2];
+    p.val[2] = t;
+    p.val[3] = vdup_n_u8(0xFF);
+    vst4_u8(dst + i * 4, p);
+  }
+  swap32_opaque_scalar(dst + i * 4, src + i * 4, width - i);
+}
+
+static void
+copy32_opaque_neon(Uint8 *dst, Uint8 const *src, int width)
+{
+  uint32x4_t const alpha = vdupq_n_u32(ALPHA_MASK);
+  int i = 0;
+  for (; i + 4 <= width; i += 4) {
+    vst1q_u32((uint32_t*)(dst + i * 4), vorrq_u32(vld1q_u32((uint32_t const*)(src + i * 4)), alpha));
+  }
+  copy32_opaque_scalar(dst + i * 4, src + i * 4, width - i);
+}
+
+static inline uint8x8_t
+div255_neon(uint16x8_t x)
+{
+  x = vaddq_u16(x, vdupq_n_u16(128));
+  return vshrn_n_u16(vsraq_n_u16(x, x, 8), 8);
+}
+
+static void
+blend_neon(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod)
+{
+  uint8x8_t const mod = vdup_n_u8(alpha_mod);
+  uint8x8_t const max = vdup_n_u8(255);
+  int i = 0;
+  for (; i + 8 <= width; i += 8) {
+    uint8x8x4_t const s = vld4_u8((Uint8 const*)(src + i));
+    uint8x8x4_t d = vld4_u8((Uint8 const*)(dst + i));
+    uint8x8_t a = s.val[3];
+    if (255 != alpha_mod) {
+      a = div255_neon(vmull_u8(a, mod));
+    }
+    uint8x8_t const inv = vmvn_u8(a);
+    d.val[0] = div255_neon(vmlal_u8(vmull_u8(s.val[0], a), d.val[0], inv));
+    d.val[1] = div255_neon(vmlal_u8(vmull_u8(s.val[1], a), d.val[1], inv));
+    d.val[2] = div255_neon(vmlal_u8(vmull_u8(s.val[2], a), d.val[2], inv));
+    d.val[3] = div255_neon(vmlal_u8(vmull_u8(max, a), d.val[3], inv));
+    vst4_u8((Uint8*)(dst + i), d);
+  }
+  blend_scalar(dst + i, src + i, width - i, alpha_mod);
+}
+
+static void
+blend_premultiplied_neon(Uint32 *dst, Uint32 const *src, int width, Uint8 alpha_mod)
+{
+  uint8x8_t const mod = vdup_n_u8(alpha_mod);
+  int i = 0, c;
+  for (; i + 8 <= width; i += 8) {
+    uint8x8x4_t s = vld4_u8((Uint8 const*)(src + i));
+    uint8x8x4_t d = vld4_u8((Uint8 const*)(dst + i));
+    if (255 != alpha_mod) {
+      for (c = 0; c < 4; ++c) {
+        s.val[c] = div255_neon(vmull_u8(s.val[c], mod));
+      }
+    }
+    uint8x8_t const inv = vmvn_u8(s.val[3]);
+    for (c = 0; c < 4; ++c) {
+      d.val[c] = vqadd_u8(s.val[c], div255_neon(vmull_u8(d.val[c], inv)));
+    }
+    vst4_u8((Uint8*)(dst + i), d);
+  }
+  blend_premultiplied_scalar(dst + i, src + i, width - i, alpha_mod);
+}
+
+static void
+premultiply_neon(Uint32 *pixels, int width)
+{
+  int i = 0;
+  for (; i + 8 <= width; i += 8) {
+    uint8x8x4_t p = vld4_u8((Uint8 const*)(pixels + i));
+    p.val[0] = div255_neon(vmull_u8(p.val[0], p.val[3]));
+    p.val[1] = div255_neon(vmull_u8(p.val[1], p.val[3]));
+    p.val[2] = div255_neon(vmull_u8(p.val[2], p.val[3]));
+    vst4_u8((Uint8*)(pixels + i), p);
+  }
+  premultiply_scalar(pixels + i, width - i);
+}
+
+static void
+downsample32_neon(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width)
+{
+  int i = 0;
+  for (; (i + 8) * 2 <= src_width; i += 8) {
+    uint8x16x4_t const a = vld4q_u8(row0 + i * 8);
+    uint8x16x4_t const b = vld4q_u8(row1 + i * 8);
+    uint8x8x4_t d;
+    d.val[0] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[0]), b.val[0]), 2);
+    d.val[1] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[1]), b.val[1]), 2);
+    d.val[2] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[2]), b.val[2]), 2);
+    d.val[3] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[3]), b.val[3]), 2);
+    vst4_u8(dst + i * 4, d);
+  }
+  downsample_tail(dst, row0, row1, src_width, 4, i);
+}
+
+static pixel_kernel_table_t const neon_kernels = {
+  "neon",
+  expand24_lo_neon,
+  expand24_hi_neon,
+  swap32_neon,
+  swap32_opaque_neon,
+  copy32_opaque_neon,
+  blend_neon,
+  blend_premultiplied_neon,
+  premultiply_neon,
+  downsample32_neon,
+};
+
+#endif /* MRB_SDL2_HAVE_NEON */
+
+/***************************************************************************
+*
+* dispatch
+*
+***************************************************************************/
+
+static pixel_kernel_table_t const *kernels = &scalar_kernels;
+
+void
+mrb_sdl2_pixel_kernels_init(void)
+{
+  kernels = &scalar_kernels;
+#if defined(MRB_SDL2_HAVE_SSE2)
+  if (SDL_HasSSE2()) {
+    kernels = &sse2_kernels;
+  }
+#elif defined(MRB_SDL2_HAVE_NEON)
+  kernels = &neon_kernels;
+#endif
+}
+
+char const *
+mrb_sdl2_pixel_kernels_backend(void)
+{
+  return kernels->name;
+}
+
+static bool
+is_argb_layout(Uint32 format)
+{
+  return (SDL_PIXELFORMAT_ARGB8888 == format) || (SDL_PIXELFORMAT_RGB888 == format);
+}
+
+static bool
+is_abgr_layout(Uint32 format)
+{
+  return (SDL_PIXELFORMAT_ABGR8888 == format) || (SDL_PIXELFORMAT_BGR888 == format);
+}
+
+mrb_sdl2_pixel_row_func
+mrb_sdl2_pixel_kernels_converter(Uint32 src_format, Uint32 dst_format)
+{
+  if (src_format == dst_format) {
+    return NULL;
+  }
+  bool const dst_argb = is_argb_layout(dst_format);
+  bool const dst_abgr = is_abgr_layout(dst_format);
+  if (!dst_argb && !dst_abgr) {
+    return NULL;
+  }
+  switch (src_format) {
+  case SDL_PIXELFORMAT_RGB24:
+    return dst_argb ? kernels->expand24_hi : kernels->expand24_lo;
+  case SDL_PIXELFORMAT_BGR24:
+    return dst_argb ? kernels->expand24_lo : kernels->expand24_hi;
+  case SDL_PIXELFORMAT_ARGB8888:
+  case SDL_PIXELFORMAT_ABGR8888:
+    if (is_argb_layout(src_format) == dst_argb) {
+      /* alpha is dropped. */
+      return kernels->copy32_opaque;
+    }
+    return ((SDL_PIXELFORMAT_ARGB8888 == dst_format) || (SDL_PIXELFORMAT_ABGR8888 == dst_format)) ?
+      kernels->swap32 : kernels->swap32_opaque;
+  case SDL_PIXELFORMAT_RGB888:
+  case SDL_PIXELFORMAT_BGR888:
+    if (is_argb_layout(src_format) == dst_argb) {
+      return kernels->copy32_opaque;
+    }
+    return kernels->swap32_opaque;
+  default:
+    return NULL;
+  }
+}
+
+void
+mrb_sdl2_pixel_kernels_convert(mrb_sdl2_pixel_row_func func, Uint8 *dst, int dst_pitch, Uint8 const *src, int src_pitch, int width, int height)
+{
+  int y;
+  for (y = 0; y < height; ++y) {
+    func(dst + y * dst_pitch, src + y * src_pitch, width);
+  }
+}
+
+bool
+mrb_sdl2_pixel_kernels_can_blend(Uint32 src_format, Uint32 dst_format)
+{
+  if (SDL_PIXELFORMAT_ARGB8888 == src_format) {
+    return is_argb_layout(dst_format);
+  }
+  if (SDL_PIXELFORMAT_ABGR8888 == src_format) {
+    return is_abgr_layout(dst_format);
+  }
+  return false;
+}
+
+void
+mrb_sdl2_pixel_kernels_blend(Uint8 *dst, int dst_pitch, Uint8 const *src, int src_pitch, int width, int height, Uint8 alpha_mod)
+{
+  int y;
+  for (y = 0; y < height; ++y) {
+    kernels->blend((Uint32*)(dst + y * dst_pitch), (Uint32 const*)(src + y * src_pitch), width, alpha_mod);
+  }
+}
+
+void
+mrb_sdl2_pixel_kernels_blend_premultiplied(Uint8 *dst, int dst_pitch, Uint8 const *src, int src_pitch, int width, int height, Uint8 alpha_mod)
+{
+  int y;
+  for (y = 0; y < height; ++y) {
+    kernels->blend_premultiplied((Uint32*)(dst + y * dst_pitch), (Uint32 const*)(src + y * src_pitch), width, alpha_mod);
+  }
+}
+
+void
+mrb_sdl2_pixel_kernels_premultiply(Uint8 *pixels, int pitch, int width, int height)
+{
+  int y;
+  for (y = 0; y < height; ++y) {
+    kernels->premultiply((Uint32*)(pixels + y * pitch), width);
+  }
+}
+
+bool
+mrb_sdl2_pixel_kernels_can_filter(Uint32 format)
+{
+  if (SDL_ISPIXELFORMAT_INDEXED(format) || (SDL_PIXELFORMAT_ARGB2101010 == format)) {
+    return false;
+  }
+  return (3 == SDL_BYTESPERPIXEL(format)) || (4 == SDL_BYTESPERPIXEL(format));
+}
+
+void
+mrb_sdl2_pixel_kernels_downsample_row(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width, int bpp)
+{
+  if (4 == bpp) {
+    kernels->downsample32(dst, row0, row1, src_width);
+  } else {
+    downsample_tail(dst, row0, row1, src_width, bpp, 0);
+  }
+}
+
+void
+mrb_sdl2_pixel_kernels_bilinear_row(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int fy, int const *x0, int const *x1, int const *fx, int width, int bpp)
+{
+  int i, c;
+  for (i = 0; i < width; ++i) {
+    int const wx = fx[i];
+    for (c = 0; c < bpp; ++c) {
+      Uint32 const top    = row0[x0[i] + c] * (256 - wx) + row0[x1[i] + c] * wx;
+      Uint32 const bottom = row1[x0[i] + c] * (256 - wx) + row1[x1[i] + c] * wx;
+      dst[i * bpp + c] = (Uint8)((top * (256 - fy) + bottom * fy + 32768) >> 16);
+    }
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef MRUBY_SDL2_PIXEL_KERNELS_H
+#define MRUBY_SDL2_PIXEL_KERNELS_H
+
+#include <stdbool.h>
+#include <SDL2/SDL_pixels.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* converts 'width' pixels of a single row. */
+typedef void (*mrb_sdl2_pixel_row_func)(Uint8 *dst, Uint8 const *src, int width);
+
+extern void        mrb_sdl2_pixel_kernels_init(void);
+extern char const *mrb_sdl2_pixel_kernels_backend(void);
+
+/* returns NULL when there is no native converter for the pair. */
+extern mrb_sdl2_pixel_row_func mrb_sdl2_pixel_kernels_converter(Uint32 src_format, Uint32 dst_format);
+extern void mrb_sdl2_pixel_kernels_convert(mrb_sdl2_pixel_row_func func, Uint8 *dst, int dst_pitch, Uint8 const *src, int src_pitch, int width, int height);
+
+/* SDL_BLENDMODE_BLEND of 32bpp pixels whose alpha is in the top byte. */
+extern bool mrb_sdl2_pixel_kernels_can_blend(Uint32 src_format, Uint32 dst_format);
+extern void mrb_sdl2_pixel_kernels_blend(Uint8 *dst, int dst_pitch, Uint8 const *src, int src_pitch, int width, int height, Uint8 alpha_mod);
+/* dst = src + dst * (1 - srcA) for sources with premultiplied alpha; same formats as above. */
+extern void mrb_sdl2_pixel_kernels_blend_premultiplied(Uint8 *dst, int dst_pitch, Uint8 const *src, int src_pitch, int width, int height, Uint8 alpha_mod);
+
+extern void mrb_sdl2_pixel_kernels_premultiply(Uint8 *pixels, int pitch, int width, int height);
+
+/* filters work on any 24/32-bit format with 8-bit channels. */
+extern bool mrb_sdl2_pixel_kernels_can_filter(Uint32 format);
+
+/* averages the 2x2 blocks of two source rows into max(src_width / 2, 1) pixels. */
+extern void mrb_sdl2_pixel_kernels_downsample_row(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int src_width, int bpp);
+
+/*
+ * interpolates 'width' pixels between two source rows. 'x0' and 'x1' are
+ * byte offsets of the left and right samples, 'fx' and 'fy' are weights
+ * of the right and bottom samples in 1/256.
+ */
+extern void mrb_sdl2_pixel_kernels_bilinear_row(Uint8 *dst, Uint8 const *row0, Uint8 const *row1, int fy, int const *x0, int const *x1, int const *fx, int width, int bpp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_PIXEL_KERNELS_H */
@@ -0,0 +1,492 @@
+#include "rect_kernels.h"
+#include "simd.h"
+#include <SDL2/SDL_stdinc.h>
+
+/*
+ * Batch kernels over packed SDL_Rect arrays.
+ *
+ * The vector kernels load four rects at a time and transpose them into
+ * x, y, w and h lanes. Every backend produces identical results; the
+ * scalar kernels are the reference and also handle the tail.
+ */
+
+typedef struct rect_bounds_t {
+  int  x0, y0, x1, y1;
+  bool found;
+} rect_bounds_t;
+
+typedef struct rect_kernel_table_t {
+  char const *name;
+  int  (*clip)(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip);
+  int  (*overlaps)(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect);
+  void (*bounds)(rect_bounds_t *b, SDL_Rect const *rects, int count);
+  int  (*find_last)(SDL_Rect const *rects, int count, int x, int y);
+} rect_kernel_table_t;
+
+/* number of set bits in a 4-bit lane mask. */
+static int const lane_count[16] = {
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+};
+
+/***************************************************************************
+*
+* scalar kernels
+*
+***************************************************************************/
+
+static int
+clip_tail(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip, int i)
+{
+  int n = 0;
+  for (; i < count; ++i) {
+    int const x0 = SDL_max(src[i].x, clip->x);
+    int const y0 = SDL_max(src[i].y, clip->y);
+    int const x1 = SDL_min(src[i].x + src[i].w, clip->x + clip->w);
+    int const y1 = SDL_min(src[i].y + src[i].h, clip->y + clip->h);
+    if ((x0 < x1) && (y0 < y1)) {
+      dst[i] = (SDL_Rect){ x0, y0, x1 - x0, y1 - y0 };
+      ++n;
+    } else {
+      dst[i] = (SDL_Rect){ 0, 0, 0, 0 };
+    }
+  }
+  return n;
+}
+
+static int
+overlaps_tail(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect, int i)
+{
+  int n = 0;
+  for (; i < count; ++i) {
+    int const x0 = SDL_max(rects[i].x, rect->x);
+    int const y0 = SDL_max(rects[i].y, rect->y);
+    int const x1 = SDL_min(rects[i].x + rects[i].w, rect->x + rect->w);
+    int const y1 = SDL_min(rects[i].y + rects[i].h, rect->y + rect->h);
+    mask[i] = ((x0 < x1) && (y0 < y1)) ? 1 : 0;
+    n += mask[i];
+  }
+  return n;
+}
+
+static void
+bounds_tail(rect_bounds_t *b, SDL_Rect const *rects, int count, int i)
+{
+  for (; i < count; ++i) {
+    if ((0 >= rects[i].w) || (0 >= rects[i].h)) {
+      continue;
+    }
+    b->x0 = SDL_min(b->x0, rects[i].x);
+    b->y0 = SDL_min(b->y0, rects[i].y);
+    b->x1 = SDL_max(b->x1, rects[i].x + rects[i].w);
+    b->y1 = SDL_max(b->y1, rects[i].y + rects[i].h);
+    b->found = true;
+  }
+}
+
+/* searches [0, end) backwards. */
+static int
+find_last_tail(SDL_Rect const *rects, int end, int x, int y)
+{
+  int i;
+  for (i = end - 1; i >= 0; --i) {
+    SDL_Rect const *r = &rects[i];
+    if ((r->x <= x) && (x < r->x + r->w) && (r->y <= y) && (y < r->y + r->h)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int
+clip_scalar(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip)
+{
+  return clip_tail(dst, src, count, clip, 0);
+}
+
+static int
+overlaps_scalar(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect)
+{
+  return overlaps_tail(mask, rects, count, rect, 0);
+}
+
+static void
+bounds_scalar(rect_bounds_t *b, SDL_Rect const *rects, int count)
+{
+  bounds_tail(b, rects, count, 0);
+}
+
+static int
+find_last_scalar(SDL_Rect const *rects, int count, int x, int y)
+{
+  return find_last_tail(rects, count, x, y);
+}
+
+static rect_kernel_table_t const scalar_kernels = {
+  "scalar",
+  clip_scalar,
+  overlaps_scalar,
+  bounds_scalar,
+  find_last_scalar,
+};
+
+/***************************************************************************
+*
+* SSE2 kernels
+*
+***************************************************************************/
+
+#ifdef MRB_SDL2_HAVE_SSE2
+
+/* SSE2 has no 32-bit min/max; select through a compare mask. */
+static inline __m128i
+max_sse2(__m128i a, __m128i b)
+{
+  __m128i const m = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+static inline __m128i
+min_sse2(__m128i a, __m128i b)
+{
+  __m128i const m = _mm_cmpgt_epi32(a, b);
+  return _mm_or_si128(_mm_and_si128(m, b), _mm_andnot_si128(m, a));
+}
+
+static inline int
+lanes_sse2(__m128i m)
+{
+  return _mm_movemask_ps(_mm_castsi128_ps(m));
+}
+
+static inline void
+load4_sse2(SDL_Rect const *r, __m128i *x, __m128i *y, __m128i *w, __m128i *h)
+{
+  __m128i const r0 = _mm_loadu_si128((__m128i const*)(r + 0));
+  __m128i const r1 = _mm_loadu_si128((__m128i const*)(r + 1));
+  __m128i const r2 = _mm_loadu_si128((__m128i const*)(r + 2));
+  __m128i const r3 = _mm_loadu_si128((__m128i const*)(r + 3));
+  __m128i const t0 = _mm_unpacklo_epi32(r0, r1);
+  __m128i const t1 = _mm_unpacklo_epi32(r2, r3);
+  __m128i const t2 = _mm_unpackhi_epi32(r0, r1);
+  __m128i const t3 = _mm_unpackhi_epi32(r2, r3);
+  *x = _mm_unpacklo_epi64(t0, t1);
+  *y = _mm_unpackhi_epi64(t0, t1);
+  *w = _mm_unpacklo_epi64(t2, t3);
+  *h = _mm_unpackhi_epi64(t2, t3);
+}
+
+static inline void
+store4_sse2(SDL_Rect *r, __m128i x, __m128i y, __m128i w, __m128i h)
+{
+  __m128i const t0 = _mm_unpacklo_epi32(x, y);
+  __m128i const t1 = _mm_unpacklo_epi32(w, h);
+  __m128i const t2 = _mm_unpackhi_epi32(x, y);
+  __m128i const t3 = _mm_unpackhi_epi32(w, h);
+  _mm_storeu_si128((__m128i*)(r + 0), _mm_unpacklo_epi64(t0, t1));
+  _mm_storeu_si128((__m128i*)(r + 1), _mm_unpackhi_epi64(t0, t1));
+  _mm_storeu_si128((__m128i*)(r + 2), _mm_unpacklo_epi64(t2, t3));
+  _mm_storeu_si128((__m128i*)(r + 3), _mm_unpackhi_epi64(t2, t3));
+}
+
+static int
+clip_sse2(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip)
+{
+  __m128i const cx0 = _mm_set1_epi32(clip->x);
+  __m128i const cy0 = _mm_set1_epi32(clip->y);
+  __m128i const cx1 = _mm_set1_epi32(clip->x + clip->w);
+  __m128i const cy1 = _mm_set1_epi32(clip->y + clip->h);
+  int i = 0, n = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i x, y, w, h;
+    load4_sse2(src + i, &x, &y, &w, &h);
+    __m128i const x0 = max_sse2(x, cx0);
+    __m128i const y0 = max_sse2(y, cy0);
+    __m128i const x1 = min_sse2(_mm_add_epi32(x, w), cx1);
+    __m128i const y1 = min_sse2(_mm_add_epi32(y, h), cy1);
+    __m128i const keep = _mm_and_si128(_mm_cmpgt_epi32(x1, x0), _mm_cmpgt_epi32(y1, y0));
+    store4_sse2(dst + i,
+                _mm_and_si128(x0, keep),
+                _mm_and_si128(y0, keep),
+                _mm_and_si128(_mm_sub_epi32(x1, x0), keep),
+                _mm_and_si128(_mm_sub_epi32(y1, y0), keep));
+    n += lane_count[lanes_sse2(keep)];
+  }
+  return n + clip_tail(dst, src, count, clip, i);
+}
+
+static int
+overlaps_sse2(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect)
+{
+  __m128i const rx0 = _mm_set1_epi32(rect->x);
+  __m128i const ry0 = _mm_set1_epi32(rect->y);
+  __m128i const rx1 = _mm_set1_epi32(rect->x + rect->w);
+  __m128i const ry1 = _mm_set1_epi32(rect->y + rect->h);
+  int i = 0, n = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i x, y, w, h;
+    load4_sse2(rects + i, &x, &y, &w, &h);
+    __m128i const x0 = max_sse2(x, rx0);
+    __m128i const y0 = max_sse2(y, ry0);
+    __m128i const x1 = min_sse2(_mm_add_epi32(x, w), rx1);
+    __m128i const y1 = min_sse2(_mm_add_epi32(y, h), ry1);
+    int const m = lanes_sse2(_mm_and_si128(_mm_cmpgt_epi32(x1, x0), _mm_cmpgt_epi32(y1, y0)));
+    mask[i + 0] = (Uint8)(m & 1);
+    mask[i + 1] = (Uint8)((m >> 1) & 1);
+    mask[i + 2] = (Uint8)((m >> 2) & 1);
+    mask[i + 3] = (Uint8)((m >> 3) & 1);
+    n += lane_count[m];
+  }
+  return n + overlaps_tail(mask, rects, count, rect, i);
+}
+
+static void
+bounds_sse2(rect_bounds_t *b, SDL_Rect const *rects, int count)
+{
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const lo   = _mm_set1_epi32((int)0x80000000);
+  __m128i const hi   = _mm_set1_epi32(0x7FFFFFFF);
+  __m128i mx0 = hi, my0 = hi, mx1 = lo, my1 = lo;
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i x, y, w, h;
+    load4_sse2(rects + i, &x, &y, &w, &h);
+    __m128i const live = _mm_and_si128(_mm_cmpgt_epi32(w, zero), _mm_cmpgt_epi32(h, zero));
+    /* empty rects are replaced by values which never win. */
+    mx0 = min_sse2(mx0, _mm_or_si128(_mm_and_si128(live, x), _mm_andnot_si128(live, hi)));
+    my0 = min_sse2(my0, _mm_or_si128(_mm_and_si128(live, y), _mm_andnot_si128(live, hi)));
+    mx1 = max_sse2(mx1, _mm_or_si128(_mm_and_si128(live, _mm_add_epi32(x, w)), _mm_andnot_si128(live, lo)));
+    my1 = max_sse2(my1, _mm_or_si128(_mm_and_si128(live, _mm_add_epi32(y, h)), _mm_andnot_si128(live, lo)));
+    b->found = b->found || (0 != lanes_sse2(live));
+  }
+  int v[4][4];
+  _mm_storeu_si128((__m128i*)v[0], mx0);
+  _mm_storeu_si128((__m128i*)v[1], my0);
+  _mm_storeu_si128((__m128i*)v[2], mx1);
+  _mm_storeu_si128((__m128i*)v[3], my1);
+  int k;
+  for (k = 0; k < 4; ++k) {
+    b->x0 = SDL_min(b->x0, v[0][k]);
+    b->y0 = SDL_min(b->y0, v[1][k]);
+    b->x1 = SDL_max(b->x1, v[2][k]);
+    b->y1 = SDL_max(b->y1, v[3][k]);
+  }
+  bounds_tail(b, rects, count, i);
+}
+
+static int
+find_last_sse2(SDL_Rect const *rects, int count, int x, int y)
+{
+  __m128i const px = _mm_set1_epi32(x);
+  __m128i const py = _mm_set1_epi32(y);
+  int end = count;
+  for (; end >= 4; end -= 4) {
+    __m128i rx, ry, rw, rh;
+    load4_sse2(rects + end - 4, &rx, &ry, &rw, &rh);
+    /* rx <= x < rx + rw and ry <= y < ry + rh */
+    __m128i const in = _mm_andnot_si128(
+      _mm_or_si128(_mm_cmpgt_epi32(rx, px), _mm_cmpgt_epi32(ry, py)),
+      _mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(rx, rw), px),
+                    _mm_cmpgt_epi32(_mm_add_epi32(ry, rh), py)));
+    int const m = lanes_sse2(in);
+    if (0 != m) {
+      return end - 4 + ((m & 8) ? 3 : (m & 4) ? 2 : (m & 2) ? 1 : 0);
+    }
+  }
+  return find_last_tail(rects, end, x, y);
+}
+
+static rect_kernel_table_t const sse2_kernels = {
+  "sse2",
+  clip_sse2,
+  overlaps_sse2,
+  bounds_sse2,
+  find_last_sse2,
+};
+
+#endif /* MRB_SDL2_HAVE_SSE2 */
+
+/***************************************************************************
+*
+* NEON kernels
+*
+***************************************************************************/
+
+#ifdef MRB_SDL2_HAVE_NEON
+
+/* vld4q_s32 splits four SDL_Rects into x, y, w and h lanes. */
+
+static inline int
+lanes_neon(uint32x4_t m)
+{
+  return (int)((vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) |
+               (vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8));
+}
+
+static int
+clip_neon(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip)
+{
+  int32x4_t const cx0 = vdupq_n_s32(clip->x);
+  int32x4_t const cy0 = vdupq_n_s32(clip->y);
+  int32x4_t const cx1 = vdupq_n_s32(clip->x + clip->w);
+  int32x4_t const cy1 = vdupq_n_s32(clip->y + clip->h);
+  int i = 0, n = 0;
+  for (; i + 4 <= count; i += 4) {
+    int32x4x4_t r = vld4q_s32((int32_t const*)(src + i));
+    int32x4_t const x0 = vmaxq_s32(r.val[0], cx0);
+    int32x4_t const y0 = vmaxq_s32(r.val[1], cy0);
+    int32x4_t const x1 = vminq_s32(vaddq_s32(r.val[0], r.val[2]), cx1);
+    int32x4_t const y1 = vminq_s32(vaddq_s32(r.val[1], r.val[3]), cy1);
+    uint32x4_t const keep = vandq_u32(vcgtq_s32(x1, x0), vcgtq_s32(y1, y0));
+    r.val[0] = vreinterpretq_s32_u32(vandq_u32(vreinterpretq_u32_s32(x0), keep));
+    r.val[1] = vreinterpretq_s32_u32(vandq_u32(vreinterpretq_u32_s32(y0), keep));
+    r.val[2] = vreinterpretq_s32_u32(vandq_u32(vreinterpretq_u32_s32(vsubq_s32(x1, x0)), keep));
+    r.val[3] = vreinterpretq_s32_u32(vandq_u32(vreinterpretq_u32_s32(vsubq_s32(y1, y0)), keep));
+    vst4q_s32((int32_t*)(dst + i), r);
+    n += lane_count[lanes_neon(keep)];
+  }
+  return n + clip_tail(dst, src, count, clip, i);
+}
+
+static int
+overlaps_neon(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect)
+{
+  int32x4_t const rx0 = vdupq_n_s32(rect->x);
+  int32x4_t const ry0 = vdupq_n_s32(rect->y);
+  int32x4_t const rx1 = vdupq_n_s32(rect->x + rect->w);
+  int32x4_t const ry1 = vdupq_n_s32(rect->y + rect->h);
+  int i = 0, n = 0;
+  for (; i + 4 <= count; i += 4) {
+    int32x4x4_t const r = vld4q_s32((int32_t const*)(rects + i));
+    int32x4_t const x0 = vmaxq_s32(r.val[0], rx0);
+    int32x4_t const y0 = vmaxq_s32(r.val[1], ry0);
+    int32x4_t const x1 = vminq_s32(vaddq_s32(r.val[0], r.val[2]), rx1);
+    int32x4_t const y1 = vminq_s32(vaddq_s32(r.val[1], r.val[3]), ry1);
+    int const m = lanes_neon(vandq_u32(vcgtq_s32(x1, x0), vcgtq_s32(y1, y0)));
+    mask[i + 0] = (Uint8)(m & 1);
+    mask[i + 1] = (Uint8)((m >> 1) & 1);
+    mask[i + 2] = (Uint8)((m >> 2) & 1);
+    mask[i + 3] = (Uint8)((m >> 3) & 1);
+    n += lane_count[m];
+  }
+  return n + overlaps_tail(mask, rects, count, rect, i);
+}
+
+static void
+bounds_neon(rect_bounds_t *b, SDL_Rect const *rects, int count)
+{
+  int32x4_t const zero = vdupq_n_s32(0);
+  int32x4_t const lo   = vdupq_n_s32((int)0x80000000);
+  int32x4_t const hi   = vdupq_n_s32(0x7FFFFFFF);
+  int32x4_t mx0 = hi, my0 = hi, mx1 = lo, my1 = lo;
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    int32x4x4_t const r = vld4q_s32((int32_t const*)(rects + i));
+    uint32x4_t const live = vandq_u32(vcgtq_s32(r.val[2], zero), vcgtq_s32(r.val[3], zero));
+    /* empty rects are replaced by values which never win. */
+    mx0 = vminq_s32(mx0, vbslq_s32(live, r.val[0], hi));
+    my0 = vminq_s32(my0, vbslq_s32(live, r.val[1], hi));
+    mx1 = vmaxq_s32(mx1, vbslq_s32(live, vaddq_s32(r.val[0], r.val[2]), lo));
+    my1 = vmaxq_s32(my1, vbslq_s32(live, vaddq_s32(r.val[1], r.val[3]), lo));
+    b->found = b->found || (0 != lanes_neon(live));
+  }
+  int v[4][4];
+  vst1q_s32(v[0], mx0);
+  vst1q_s32(v[1], my0);
+  vst1q_s32(v[2], mx1);
+  vst1q_s32(v[3], my1);
+  int k;
+  for (k = 0; k < 4; ++k) {
+    b->x0 = SDL_min(b->x0, v[0][k]);
+    b->y0 = SDL_min(b->y0, v[1][k]);
+    b->x1 = SDL_max(b->x1, v[2][k]);
+    b->y1 = SDL_max(b->y1, v[3][k]);
+  }
+  bounds_tail(b, rects, count, i);
+}
+
+static int
+find_last_neon(SDL_Rect const *rects, int count, int x, int y)
+{
+  int32x4_t const px = vdupq_n_s32(x);
+  int32x4_t const py = vdupq_n_s32(y);
+  int end = count;
+  for (; end >= 4; end -= 4) {
+    int32x4x4_t const r = vld4q_s32((int32_t const*)(rects + end - 4));
+    uint32x4_t const in = vandq_u32(
+      vandq_u32(vcleq_s32(r.val[0], px), vcleq_s32(r.val[1], py)),
+      vandq_u32(vcgtq_s32(vaddq_s32(r.val[0], r.val[2]), px),
+                vcgtq_s32(vaddq_s32(r.val[1], r.val[3]), py)));
+    int const m = lanes_neon(in);
+    if (0 != m) {
+      return end - 4 + ((m & 8) ? 3 : (m & 4) ? 2 : (m & 2) ? 1 : 0);
+    }
+  }
+  return find_last_tail(rects, end, x, y);
+}
+
+static rect_kernel_table_t const neon_kernels = {
+  "neon",
+  clip_neon,
+  overlaps_neon,
+  bounds_neon,
+  find_last_neon,
+};
+
+#endif /* MRB_SDL2_HAVE_NEON */
+
+/***************************************************************************
+*
+* dispatch
+*
+***************************************************************************/
+
+static rect_kernel_table_t const *kernels = &scalar_kernels;
+
+void
+mrb_sdl2_rect_kernels_init(void)
+{
+  kernels = &scalar_kernels;
+#if defined(MRB_SDL2_HAVE_SSE2)
+  if (SDL_HasSSE2()) {
+    kernels = &sse2_kernels;
+  }
+#elif defined(MRB_SDL2_HAVE_NEON)
+  kernels = &neon_kernels;
+#endif
+}
+
+char const *
+mrb_sdl2_rect_kernels_backend(void)
+{
+  return kernels->name;
+}
+
+int
+mrb_sdl2_rect_kernels_clip(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip)
+{
+  return kernels->clip(dst, src, count, clip);
+}
+
+int
+mrb_sdl2_rect_kernels_overlaps(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect)
+{
+  return kernels->overlaps(mask, rects, count, rect);
+}
+
+bool
+mrb_sdl2_rect_kernels_bounds(SDL_Rect *result, SDL_Rect const *rects, int count)
+{
+  rect_bounds_t b = { 0x7FFFFFFF, 0x7FFFFFFF, (int)0x80000000, (int)0x80000000, false };
+  kernels->bounds(&b, rects, count);
+  if (!b.found) {
+    return false;
+  }
+  *result = (SDL_Rect){ b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0 };
+  return true;
+}
+
+int
+mrb_sdl2_rect_kernels_find_last(SDL_Rect const *rects, int count, int x, int y)
+{
+  return kernels->find_last(rects, count, x, y);
+}
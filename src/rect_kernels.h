@@ -0,0 +1,33 @@
+#ifndef MRUBY_SDL2_RECT_KERNELS_H
+#define MRUBY_SDL2_RECT_KERNELS_H
+
+#include <stdbool.h>
+#include <SDL2/SDL_rect.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void        mrb_sdl2_rect_kernels_init(void);
+extern char const *mrb_sdl2_rect_kernels_backend(void);
+
+/*
+ * intersects every rect with 'clip'. rects which do not intersect become
+ * (0, 0, 0, 0). 'dst' may be 'src'. returns the number of non-empty results.
+ */
+extern int mrb_sdl2_rect_kernels_clip(SDL_Rect *dst, SDL_Rect const *src, int count, SDL_Rect const *clip);
+
+/* sets mask[i] to 1 when rects[i] intersects 'rect', 0 otherwise. returns the number of hits. */
+extern int mrb_sdl2_rect_kernels_overlaps(Uint8 *mask, SDL_Rect const *rects, int count, SDL_Rect const *rect);
+
+/* bounding box of the non-empty rects. returns false when there is none. */
+extern bool mrb_sdl2_rect_kernels_bounds(SDL_Rect *result, SDL_Rect const *rects, int count);
+
+/* index of the last rect containing the point, or -1. */
+extern int mrb_sdl2_rect_kernels_find_last(SDL_Rect const *rects, int count, int x, int y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_RECT_KERNELS_H */
@@ -3,13 +3,21 @@
 #include "sdl2_version.h"
 #include "sdl2_video.h"
 #include "sdl2_rect.h"
+#include "sdl2_rectarray.h"
+#include "sdl2_spatialindex.h"
 #include "sdl2_audio.h"
+#include "sdl2_audiostream.h"
+#include "sdl2_resampler.h"
+#include "sdl2_clipcache.h"
+#include "sdl2_effectchain.h"
 #include "sdl2_events.h"
 #include "sdl2_keyboard.h"
 #include "sdl2_mouse.h"
 #include "sdl2_thread.h"
 #include "sdl2_mutex.h"
 #include "sdl2_timer.h"
+#include "sdl2_rwops.h"
+#include "sdl2_assetpack.h"
 #include "misc.h"
 #include "mruby/string.h"
 #include <SDL2/SDL.h>
@@ -158,10 +166,34 @@ mrb_mruby_sdl2_gem_init(mrb_state *mrb)
   mruby_sdl2_rect_init(mrb);
   mrb_gc_arena_restore(mrb, arena_size);
 
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_rectarray_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_spatialindex_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
   arena_size = mrb_gc_arena_save(mrb);
   mruby_sdl2_audio_init(mrb);
   mrb_gc_arena_restore(mrb, arena_size);
 
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_audiostream_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_resampler_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_clipcache_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_effectchain_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
   arena_size = mrb_gc_arena_save(mrb);
   mruby_sdl2_events_init(mrb);
   mrb_gc_arena_restore(mrb, arena_size);
@@ -189,11 +221,21 @@ mrb_mruby_sdl2_gem_init(mrb_state *mrb)
   arena_size = mrb_gc_arena_save(mrb);
   mruby_sdl2_misc_init(mrb);
   mrb_gc_arena_restore(mrb, arena_size);
+
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_rwops_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
+
+  arena_size = mrb_gc_arena_save(mrb);
+  mruby_sdl2_assetpack_init(mrb);
+  mrb_gc_arena_restore(mrb, arena_size);
 }
 
 void
 mrb_mruby_sdl2_gem_final(mrb_state *mrb)
 {
+  mruby_sdl2_assetpack_final(mrb);
+  mruby_sdl2_rwops_final(mrb);
   mruby_sdl2_misc_final(mrb);
   mruby_sdl2_timer_final(mrb);
   mruby_sdl2_mutex_final(mrb);
@@ -201,7 +243,13 @@ mrb_mruby_sdl2_gem_final(mrb_state *mrb)
   mruby_sdl2_mouse_final(mrb);
   mruby_sdl2_keyboard_final(mrb);
   mruby_sdl2_events_final(mrb);
+  mruby_sdl2_effectchain_final(mrb);
+  mruby_sdl2_clipcache_final(mrb);
+  mruby_sdl2_resampler_final(mrb);
+  mruby_sdl2_audiostream_final(mrb);
   mruby_sdl2_audio_final(mrb);
+  mruby_sdl2_spatialindex_final(mrb);
+  mruby_sdl2_rectarray_final(mrb);
   mruby_sdl2_rect_final(mrb);
   mruby_sdl2_video_final(mrb);
   mruby_sdl2_version_final(mrb);
@@ -0,0 +1,763 @@
+#include "sdl2_assetpack.h"
+#include "sdl2_rwops.h"
+#include "sdl2_surface.h"
+#include "sdl2_audio.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/string.h"
+#include "mruby/array.h"
+#include "mruby/hash.h"
+#include "mruby/variable.h"
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_error.h>
+#include <errno.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#endif
+
+/*
+ * Asset pack layout (all integers are little-endian):
+ *
+ *   header   magic "MSAP", version, entry count, bucket count and the
+ *            offsets of the entry table, the bucket table and the names,
+ *            followed by the size of the names
+ *   entries  data offset, data length, name offset, name length, name hash
+ *   buckets  open addressing hash table of (entry index + 1), 0 is empty
+ *   names    entry names, not terminated
+ *   data     entry contents, each aligned to ASSETPACK_DATA_ALIGN bytes
+ */
+#define ASSETPACK_MAGIC       "MSAP"
+#define ASSETPACK_VERSION     1
+#define ASSETPACK_HEADER_SIZE 48
+#define ASSETPACK_ENTRY_SIZE  32
+#define ASSETPACK_DATA_ALIGN  16
+#define ASSETPACK_COPY_CHUNK  (64 * 1024)
+/* keeps the bucket count, twice the entry count, within 32 bits. */
+#define ASSETPACK_MAX_ENTRIES 0x40000000u
+
+static struct RClass *class_AssetPack = NULL;
+
+typedef struct mrb_sdl2_assetpack_data_t {
+  Uint8 const *base;
+  size_t       size;
+  bool         is_mapped;
+  Uint32       count;
+  Uint32       bucket_count;
+  Uint8 const *entries;
+  Uint8 const *buckets;
+  Uint8 const *names;
+  bool         shared;  /* rwops() handed out RWops reading the mapping. */
+} mrb_sdl2_assetpack_data_t;
+
+static Uint32
+mrb_sdl2_assetpack_read32(Uint8 const *p)
+{
+  return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+static Uint64
+mrb_sdl2_assetpack_read64(Uint8 const *p)
+{
+  return (Uint64)mrb_sdl2_assetpack_read32(p) | ((Uint64)mrb_sdl2_assetpack_read32(p + 4) << 32);
+}
+
+static void
+mrb_sdl2_assetpack_write32(Uint8 *p, Uint32 value)
+{
+  p[0] = (Uint8)(value);
+  p[1] = (Uint8)(value >> 8);
+  p[2] = (Uint8)(value >> 16);
+  p[3] = (Uint8)(value >> 24);
+}
+
+static void
+mrb_sdl2_assetpack_write64(Uint8 *p, Uint64 value)
+{
+  mrb_sdl2_assetpack_write32(p, (Uint32)value);
+  mrb_sdl2_assetpack_write32(p + 4, (Uint32)(value >> 32));
+}
+
+/* 32-bit FNV-1a. */
+static Uint32
+mrb_sdl2_assetpack_hash(char const *name, size_t len)
+{
+  Uint32 h = 2166136261u;
+  size_t i;
+  for (i = 0; i < len; ++i) {
+    h ^= (Uint8)name[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static void
+mrb_sdl2_assetpack_unmap(mrb_sdl2_assetpack_data_t *data)
+{
+  if (NULL == data->base) {
+    return;
+  }
+#ifndef _WIN32
+  if (data->is_mapped) {
+    munmap((void*)data->base, data->size);
+  } else {
+    SDL_free((void*)data->base);
+  }
+#else
+  SDL_free((void*)data->base);
+#endif
+  data->base = NULL;
+  data->size = 0;
+}
+
+static void
+mrb_sdl2_assetpack_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_assetpack_data_t *data =
+    (mrb_sdl2_assetpack_data_t*)p;
+  if (NULL != data) {
+    mrb_sdl2_assetpack_unmap(data);
+    mrb_free(mrb, data);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_assetpack_data_type = {
+  "AssetPack", mrb_sdl2_assetpack_data_free
+};
+
+/*
+ * Maps the whole file read-only. Platforms without mmap read it into
+ * memory instead. Returns false with the SDL error set.
+ */
+static bool
+mrb_sdl2_assetpack_map(mrb_sdl2_assetpack_data_t *data, char const *path)
+{
+#ifndef _WIN32
+  int const fd = open(path, O_RDONLY);
+  if (0 > fd) {
+    SDL_SetError("%s: %s", path, strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (0 != fstat(fd, &st)) {
+    SDL_SetError("%s: %s", path, strerror(errno));
+    close(fd);
+    return false;
+  }
+  if (ASSETPACK_HEADER_SIZE > st.st_size) {
+    SDL_SetError("%s: not an asset pack", path);
+    close(fd);
+    return false;
+  }
+  void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (MAP_FAILED == p) {
+    SDL_SetError("%s: %s", path, strerror(errno));
+    return false;
+  }
+  data->base      = (Uint8 const*)p;
+  data->size      = (size_t)st.st_size;
+  data->is_mapped = true;
+  return true;
+#else
+  SDL_RWops *rw = SDL_RWFromFile(path, "rb");
+  if (NULL == rw) {
+    return false;
+  }
+  Sint64 const size = SDL_RWsize(rw);
+  if (ASSETPACK_HEADER_SIZE > size) {
+    SDL_RWclose(rw);
+    SDL_SetError("%s: not an asset pack", path);
+    return false;
+  }
+  void *p = SDL_malloc((size_t)size);
+  if (NULL == p) {
+    SDL_RWclose(rw);
+    SDL_OutOfMemory();
+    return false;
+  }
+  if (1 != SDL_RWread(rw, p, (size_t)size, 1)) {
+    SDL_free(p);
+    SDL_RWclose(rw);
+    return false;
+  }
+  SDL_RWclose(rw);
+  data->base      = (Uint8 const*)p;
+  data->size      = (size_t)size;
+  data->is_mapped = false;
+  return true;
+#endif
+}
+
+static bool
+mrb_sdl2_assetpack_in_range(Uint64 offset, Uint64 length, Uint64 size)
+{
+  return (offset <= size) && (length <= size - offset);
+}
+
+/*
+ * Checks the whole directory once so that lookups can trust it.
+ */
+static bool
+mrb_sdl2_assetpack_validate(mrb_sdl2_assetpack_data_t *data)
+{
+  Uint8 const *h = data->base;
+  if ((0 != SDL_memcmp(h, ASSETPACK_MAGIC, 4)) || (ASSETPACK_VERSION != mrb_sdl2_assetpack_read32(h + 4))) {
+    SDL_SetError("not an asset pack");
+    return false;
+  }
+  Uint32 const count          = mrb_sdl2_assetpack_read32(h + 8);
+  Uint32 const bucket_count   = mrb_sdl2_assetpack_read32(h + 12);
+  Uint64 const entries_offset = mrb_sdl2_assetpack_read64(h + 16);
+  Uint64 const buckets_offset = mrb_sdl2_assetpack_read64(h + 24);
+  Uint64 const names_offset   = mrb_sdl2_assetpack_read64(h + 32);
+  Uint64 const names_size     = mrb_sdl2_assetpack_read64(h + 40);
+  if ((0 == bucket_count) || (0 != (bucket_count & (bucket_count - 1))) || (bucket_count <= count) ||
+      !mrb_sdl2_assetpack_in_range(entries_offset, (Uint64)count * ASSETPACK_ENTRY_SIZE, data->size) ||
+      !mrb_sdl2_assetpack_in_range(buckets_offset, (Uint64)bucket_count * 4, data->size) ||
+      !mrb_sdl2_assetpack_in_range(names_offset, names_size, data->size)) {
+    SDL_SetError("broken asset pack directory");
+    return false;
+  }
+  Uint32 i;
+  for (i = 0; i < count; ++i) {
+    Uint8 const *e = data->base + entries_offset + (Uint64)i * ASSETPACK_ENTRY_SIZE;
+    if (!mrb_sdl2_assetpack_in_range(mrb_sdl2_assetpack_read64(e), mrb_sdl2_assetpack_read64(e + 8), data->size) ||
+        !mrb_sdl2_assetpack_in_range(mrb_sdl2_assetpack_read32(e + 16), mrb_sdl2_assetpack_read32(e + 20), names_size)) {
+      SDL_SetError("broken asset pack entry");
+      return false;
+    }
+  }
+  for (i = 0; i < bucket_count; ++i) {
+    if (count < mrb_sdl2_assetpack_read32(data->base + buckets_offset + (Uint64)i * 4)) {
+      SDL_SetError("broken asset pack bucket");
+      return false;
+    }
+  }
+  data->count        = count;
+  data->bucket_count = bucket_count;
+  data->entries      = data->base + entries_offset;
+  data->buckets      = data->base + buckets_offset;
+  data->names        = data->base + names_offset;
+  return true;
+}
+
+static Uint8 const *
+mrb_sdl2_assetpack_find(mrb_sdl2_assetpack_data_t const *data, char const *name, size_t len)
+{
+  Uint32 const h    = mrb_sdl2_assetpack_hash(name, len);
+  Uint32 const mask = data->bucket_count - 1;
+  Uint32 i = h & mask;
+  Uint32 n;
+  for (n = 0; n < data->bucket_count; ++n, i = (i + 1) & mask) {
+    Uint32 const index = mrb_sdl2_assetpack_read32(data->buckets + i * 4);
+    if (0 == index) {
+      return NULL;
+    }
+    Uint8 const *e = data->entries + (index - 1) * ASSETPACK_ENTRY_SIZE;
+    if ((h == mrb_sdl2_assetpack_read32(e + 24)) &&
+        (len == mrb_sdl2_assetpack_read32(e + 20)) &&
+        (0 == SDL_memcmp(data->names + mrb_sdl2_assetpack_read32(e + 16), name, len))) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static mrb_sdl2_assetpack_data_t *
+mrb_sdl2_assetpack_get_ptr(mrb_state *mrb, mrb_value pack)
+{
+  mrb_sdl2_assetpack_data_t *data =
+    (mrb_sdl2_assetpack_data_t*)mrb_data_get_ptr(mrb, pack, &mrb_sdl2_assetpack_data_type);
+  if ((NULL == data) || (NULL == data->base)) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "asset pack is not opened.");
+  }
+  return data;
+}
+
+/*
+ * Returns the contents of the named entry; raises if there is none.
+ */
+static Uint8 const *
+mrb_sdl2_assetpack_get_entry(mrb_state *mrb, mrb_value self, mrb_value name, size_t *length)
+{
+  mrb_sdl2_assetpack_data_t *data = mrb_sdl2_assetpack_get_ptr(mrb, self);
+  Uint8 const *e = mrb_sdl2_assetpack_find(data, RSTRING_PTR(name), RSTRING_LEN(name));
+  if (NULL == e) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "asset not found.");
+  }
+  *length = (size_t)mrb_sdl2_assetpack_read64(e + 8);
+  return data->base + mrb_sdl2_assetpack_read64(e);
+}
+
+/*
+ * Returns a read-only RWops over the named entry, without copying it.
+ */
+static SDL_RWops *
+mrb_sdl2_assetpack_open_entry(mrb_state *mrb, mrb_value self, mrb_value name)
+{
+  size_t length;
+  Uint8 const *ptr = mrb_sdl2_assetpack_get_entry(mrb, self, name, &length);
+  if (length > (size_t)SDL_MAX_SINT32) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "asset is too large.");
+  }
+  SDL_RWops *rw = SDL_RWFromConstMem(ptr, (int)length);
+  if (NULL == rw) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return rw;
+}
+
+/***************************************************************************
+*
+* pack builder
+*
+***************************************************************************/
+
+typedef struct mrb_sdl2_assetpack_source_t {
+  char const *name;
+  size_t      name_length;
+  char const *path;
+  Uint64      offset;
+  Uint64      length;
+  Uint32      name_offset;
+  Uint32      hash;
+} mrb_sdl2_assetpack_source_t;
+
+static Uint64
+mrb_sdl2_assetpack_align(Uint64 value)
+{
+  return (value + ASSETPACK_DATA_ALIGN - 1) & ~(Uint64)(ASSETPACK_DATA_ALIGN - 1);
+}
+
+static bool
+mrb_sdl2_assetpack_copy(SDL_RWops *out, mrb_sdl2_assetpack_source_t const *src, Uint8 *chunk)
+{
+  SDL_RWops *in = SDL_RWFromFile(src->path, "rb");
+  if (NULL == in) {
+    return false;
+  }
+  Uint64 left = src->length;
+  while (0 < left) {
+    size_t const n = (size_t)SDL_min(left, (Uint64)ASSETPACK_COPY_CHUNK);
+    if ((1 != SDL_RWread(in, chunk, n, 1)) || (1 != SDL_RWwrite(out, chunk, n, 1))) {
+      SDL_RWclose(in);
+      return false;
+    }
+    left -= n;
+  }
+  SDL_RWclose(in);
+  return true;
+}
+
+/*
+ * Writes a pack made of the given files. Returns false with the SDL
+ * error set; a partially written file is left behind in that case.
+ */
+static bool
+mrb_sdl2_assetpack_write(char const *path, mrb_sdl2_assetpack_source_t *sources, Uint32 count)
+{
+  Uint32 bucket_count = 2;
+  Uint32 i, j;
+  if (ASSETPACK_MAX_ENTRIES < count) {
+    SDL_SetError("too many assets");
+    return false;
+  }
+  while (bucket_count < count * 2) {
+    bucket_count *= 2;
+  }
+
+  /* sizes and names. */
+  Uint64 names_size = 0;
+  for (i = 0; i < count; ++i) {
+    SDL_RWops *in = SDL_RWFromFile(sources[i].path, "rb");
+    if (NULL == in) {
+      return false;
+    }
+    Sint64 const size = SDL_RWsize(in);
+    SDL_RWclose(in);
+    if (0 > size) {
+      return false;
+    }
+    sources[i].length      = (Uint64)size;
+    sources[i].name_offset = (Uint32)names_size;
+    sources[i].hash        = mrb_sdl2_assetpack_hash(sources[i].name, sources[i].name_length);
+    names_size += sources[i].name_length;
+  }
+  if (names_size > 0xFFFFFFFFu) {
+    SDL_SetError("asset names are too long");
+    return false;
+  }
+
+  Uint64 const entries_offset = ASSETPACK_HEADER_SIZE;
+  Uint64 const buckets_offset = entries_offset + (Uint64)count * ASSETPACK_ENTRY_SIZE;
+  Uint64 const names_offset   = buckets_offset + (Uint64)bucket_count * 4;
+  Uint64 offset = mrb_sdl2_assetpack_align(names_offset + names_size);
+  for (i = 0; i < count; ++i) {
+    sources[i].offset = offset;
+    offset = mrb_sdl2_assetpack_align(offset + sources[i].length);
+  }
+
+  size_t const dir_size = (size_t)(names_offset + names_size);
+  Uint8 *dir = (Uint8*)SDL_calloc(1, dir_size + ASSETPACK_COPY_CHUNK);
+  if (NULL == dir) {
+    SDL_OutOfMemory();
+    return false;
+  }
+  Uint8 *chunk = dir + dir_size;
+
+  SDL_memcpy(dir, ASSETPACK_MAGIC, 4);
+  mrb_sdl2_assetpack_write32(dir +  4, ASSETPACK_VERSION);
+  mrb_sdl2_assetpack_write32(dir +  8, count);
+  mrb_sdl2_assetpack_write32(dir + 12, bucket_count);
+  mrb_sdl2_assetpack_write64(dir + 16, entries_offset);
+  mrb_sdl2_assetpack_write64(dir + 24, buckets_offset);
+  mrb_sdl2_assetpack_write64(dir + 32, names_offset);
+  mrb_sdl2_assetpack_write64(dir + 40, names_size);
+
+  for (i = 0; i < count; ++i) {
+    mrb_sdl2_assetpack_source_t const *src = &sources[i];
+    Uint8 *e = dir + entries_offset + (Uint64)i * ASSETPACK_ENTRY_SIZE;
+    mrb_sdl2_assetpack_write64(e,      src->offset);
+    mrb_sdl2_assetpack_write64(e +  8, src->length);
+    mrb_sdl2_assetpack_write32(e + 16, src->name_offset);
+    mrb_sdl2_assetpack_write32(e + 20, (Uint32)src->name_length);
+    mrb_sdl2_assetpack_write32(e + 24, src->hash);
+    SDL_memcpy(dir + names_offset + src->name_offset, src->name, src->name_length);
+
+    Uint32 const mask = bucket_count - 1;
+    for (j = src->hash & mask; ; j = (j + 1) & mask) {
+      Uint8 *bucket = dir + buckets_offset + (Uint64)j * 4;
+      Uint32 const index = mrb_sdl2_assetpack_read32(bucket);
+      if (0 == index) {
+        mrb_sdl2_assetpack_write32(bucket, i + 1);
+        break;
+      }
+      mrb_sdl2_assetpack_source_t const *other = &sources[index - 1];
+      if ((other->hash == src->hash) && (other->name_length == src->name_length) &&
+          (0 == SDL_memcmp(other->name, src->name, src->name_length))) {
+        SDL_free(dir);
+        SDL_SetError("duplicated asset name");
+        return false;
+      }
+    }
+  }
+
+  SDL_RWops *out = SDL_RWFromFile(path, "wb");
+  if (NULL == out) {
+    SDL_free(dir);
+    return false;
+  }
+  bool ok = (1 == SDL_RWwrite(out, dir, dir_size, 1));
+  Uint64 written = dir_size;
+  static Uint8 const padding[ASSETPACK_DATA_ALIGN] = { 0 };
+  for (i = 0; ok && (i < count); ++i) {
+    if (written < sources[i].offset) {
+      ok = (1 == SDL_RWwrite(out, padding, (size_t)(sources[i].offset - written), 1));
+    }
+    ok = ok && mrb_sdl2_assetpack_copy(out, &sources[i], chunk);
+    written = sources[i].offset + sources[i].length;
+  }
+  SDL_free(dir);
+  if (0 != SDL_RWclose(out)) {
+    ok = false;
+  }
+  return ok;
+}
+
+/*
+ * Builds a pack from a Hash of name => path or an Array of paths (which
+ * are used as names as well).
+ */
+static void
+mrb_sdl2_assetpack_build(mrb_state *mrb, mrb_value out, mrb_value entries)
+{
+  mrb_value names;
+  if (mrb_hash_p(entries)) {
+    names = mrb_hash_keys(mrb, entries);
+  } else if (mrb_array_p(entries)) {
+    names = entries;
+  } else {
+    mrb_raise(mrb, E_TYPE_ERROR, "given 2nd argument is unexpected type (expected Hash or Array).");
+  }
+  mrb_int const n = mrb_ary_len(mrb, names);
+  if ((mrb_int)ASSETPACK_MAX_ENTRIES < n) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "too many assets.");
+  }
+  mrb_sdl2_assetpack_source_t *sources =
+    (mrb_sdl2_assetpack_source_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_assetpack_source_t) * (n + 1));
+  if (NULL == sources) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  mrb_int i;
+  for (i = 0; i < n; ++i) {
+    mrb_value const name = mrb_ary_ref(mrb, names, i);
+    mrb_value const path = mrb_hash_p(entries) ? mrb_hash_get(mrb, entries, name) : name;
+    if (!mrb_string_p(name) || !mrb_string_p(path)) {
+      mrb_free(mrb, sources);
+      mrb_raise(mrb, E_TYPE_ERROR, "asset names and paths must be String.");
+    }
+    sources[i].name        = RSTRING_PTR(name);
+    sources[i].name_length = RSTRING_LEN(name);
+    sources[i].path        = RSTRING_PTR(path);
+  }
+  bool const ok = mrb_sdl2_assetpack_write(RSTRING_PTR(out), sources, (Uint32)n);
+  mrb_free(mrb, sources);
+  if (!ok) {
+    mruby_sdl2_raise_error(mrb);
+  }
+}
+
+#ifndef _WIN32
+/*
+ * Adds regular files under 'dir' to 'entries' as "prefix/name" => path.
+ * Hidden files and directories are skipped, and so are symbolic links to
+ * directories, which could make the walk loop.
+ */
+static void
+mrb_sdl2_assetpack_scan(mrb_state *mrb, mrb_value entries, mrb_value dir, mrb_value prefix)
+{
+  DIR *d = opendir(RSTRING_PTR(dir));
+  if (NULL == d) {
+    SDL_SetError("%s: %s", RSTRING_PTR(dir), strerror(errno));
+    mruby_sdl2_raise_error(mrb);
+  }
+  mrb_value const children = mrb_ary_new(mrb);
+  struct dirent *e;
+  while (NULL != (e = readdir(d))) {
+    if ('.' == e->d_name[0]) {
+      continue;
+    }
+    int const arena_size = mrb_gc_arena_save(mrb);
+    mrb_ary_push(mrb, children, mrb_str_new(mrb, e->d_name, strlen(e->d_name)));
+    mrb_gc_arena_restore(mrb, arena_size);
+  }
+  closedir(d);
+
+  mrb_int i;
+  mrb_int const n = mrb_ary_len(mrb, children);
+  for (i = 0; i < n; ++i) {
+    int const arena_size = mrb_gc_arena_save(mrb);
+    mrb_value const child = mrb_ary_ref(mrb, children, i);
+    mrb_value path = mrb_str_dup(mrb, dir);
+    mrb_str_cat(mrb, path, "/", 1);
+    mrb_str_cat(mrb, path, RSTRING_PTR(child), RSTRING_LEN(child));
+    mrb_value name = mrb_str_dup(mrb, prefix);
+    if (0 < RSTRING_LEN(name)) {
+      mrb_str_cat(mrb, name, "/", 1);
+    }
+    mrb_str_cat(mrb, name, RSTRING_PTR(child), RSTRING_LEN(child));
+    struct stat st;
+    if (0 == lstat(RSTRING_PTR(path), &st)) {
+      if (S_ISDIR(st.st_mode)) {
+        mrb_sdl2_assetpack_scan(mrb, entries, path, name);
+      } else if (S_ISREG(st.st_mode) ||
+                 (S_ISLNK(st.st_mode) && (0 == stat(RSTRING_PTR(path), &st)) && S_ISREG(st.st_mode))) {
+        mrb_hash_set(mrb, entries, name, path);
+      }
+    }
+    mrb_gc_arena_restore(mrb, arena_size);
+  }
+}
+#endif
+
+/***************************************************************************
+*
+* class SDL2::AssetPack
+*
+***************************************************************************/
+
+static mrb_value
+mrb_sdl2_assetpack_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value path;
+  mrb_get_args(mrb, "S", &path);
+  mrb_sdl2_assetpack_data_t *data =
+    (mrb_sdl2_assetpack_data_t*)DATA_PTR(self);
+  if (NULL == data) {
+    data = (mrb_sdl2_assetpack_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_assetpack_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->base   = NULL;
+    data->size   = 0;
+    data->shared = false;
+    DATA_PTR(self)  = data;
+    DATA_TYPE(self) = &mrb_sdl2_assetpack_data_type;
+  } else if (data->shared) {
+    /* the RWops keep this object alive, but not the mapping they read. */
+    mrb_raise(mrb, E_RUNTIME_ERROR, "cannot reopen an asset pack with RWops on its entries.");
+  } else {
+    mrb_sdl2_assetpack_unmap(data);
+  }
+  if (!mrb_sdl2_assetpack_map(data, RSTRING_PTR(path))) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  if (!mrb_sdl2_assetpack_validate(data)) {
+    mrb_sdl2_assetpack_unmap(data);
+    mruby_sdl2_raise_error(mrb);
+  }
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_assetpack_get_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_assetpack_get_ptr(mrb, self)->count);
+}
+
+static mrb_value
+mrb_sdl2_assetpack_include(mrb_state *mrb, mrb_value self)
+{
+  mrb_value name;
+  mrb_get_args(mrb, "S", &name);
+  mrb_sdl2_assetpack_data_t *data = mrb_sdl2_assetpack_get_ptr(mrb, self);
+  return (NULL != mrb_sdl2_assetpack_find(data, RSTRING_PTR(name), RSTRING_LEN(name))) ?
+    mrb_true_value() : mrb_false_value();
+}
+
+static mrb_value
+mrb_sdl2_assetpack_get_names(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_assetpack_data_t *data = mrb_sdl2_assetpack_get_ptr(mrb, self);
+  mrb_value const ary = mrb_ary_new_capa(mrb, data->count);
+  Uint32 i;
+  for (i = 0; i < data->count; ++i) {
+    int const arena_size = mrb_gc_arena_save(mrb);
+    Uint8 const *e = data->entries + i * ASSETPACK_ENTRY_SIZE;
+    mrb_ary_push(mrb, ary, mrb_str_new(mrb,
+      (char const*)data->names + mrb_sdl2_assetpack_read32(e + 16),
+      mrb_sdl2_assetpack_read32(e + 20)));
+    mrb_gc_arena_restore(mrb, arena_size);
+  }
+  return ary;
+}
+
+static mrb_value
+mrb_sdl2_assetpack_get_bytesize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value name;
+  mrb_get_args(mrb, "S", &name);
+  size_t length;
+  mrb_sdl2_assetpack_get_entry(mrb, self, name, &length);
+  return mrb_fixnum_value((mrb_int)length);
+}
+
+/*
+ * SDL2::AssetPack#read(name)
+ *
+ * Returns a copy of the entry as a String.
+ */
+static mrb_value
+mrb_sdl2_assetpack_read(mrb_state *mrb, mrb_value self)
+{
+  mrb_value name;
+  mrb_get_args(mrb, "S", &name);
+  size_t length;
+  Uint8 const *ptr = mrb_sdl2_assetpack_get_entry(mrb, self, name, &length);
+  return mrb_str_new(mrb, (char const*)ptr, length);
+}
+
+/*
+ * SDL2::AssetPack#rwops(name)
+ *
+ * Returns a read-only SDL2::RWops over the mapped entry. The pack can not
+ * be reinitialized afterwards.
+ */
+static mrb_value
+mrb_sdl2_assetpack_rwops(mrb_state *mrb, mrb_value self)
+{
+  mrb_value name;
+  mrb_get_args(mrb, "S", &name);
+  mrb_value const rwops = mrb_sdl2_rwops(mrb, mrb_sdl2_assetpack_open_entry(mrb, self, name), self);
+  mrb_sdl2_assetpack_get_ptr(mrb, self)->shared = true;
+  return rwops;
+}
+
+static mrb_value
+mrb_sdl2_assetpack_load_bmp(mrb_state *mrb, mrb_value self)
+{
+  mrb_value name;
+  mrb_get_args(mrb, "S", &name);
+  SDL_Surface *surface = SDL_LoadBMP_RW(mrb_sdl2_assetpack_open_entry(mrb, self, name), 1);
+  if (NULL == surface) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_sdl2_video_surface(mrb, surface, false);
+}
+
+static mrb_value
+mrb_sdl2_assetpack_load_wav(mrb_state *mrb, mrb_value self)
+{
+  mrb_value name;
+  mrb_get_args(mrb, "S", &name);
+  return mrb_sdl2_audiodata_from_rw(mrb, mrb_sdl2_assetpack_open_entry(mrb, self, name), 1);
+}
+
+/*
+ * SDL2::AssetPack::build(path, entries)
+ *
+ * 'entries' is a Hash of name => file path, or an Array of file paths.
+ */
+static mrb_value
+mrb_sdl2_assetpack_s_build(mrb_state *mrb, mrb_value self)
+{
+  mrb_value out, entries;
+  mrb_get_args(mrb, "So", &out, &entries);
+  mrb_sdl2_assetpack_build(mrb, out, entries);
+  return mrb_nil_value();
+}
+
+/*
+ * SDL2::AssetPack::build_from_directory(path, dir)
+ *
+ * Packs every regular file under 'dir', named by its relative path.
+ * Returns the Hash of name => file path that was packed.
+ */
+static mrb_value
+mrb_sdl2_assetpack_s_build_from_directory(mrb_state *mrb, mrb_value self)
+{
+  mrb_value out, dir;
+  mrb_get_args(mrb, "SS", &out, &dir);
+#ifndef _WIN32
+  mrb_value const entries = mrb_hash_new(mrb);
+  mrb_sdl2_assetpack_scan(mrb, entries, dir, mrb_str_new(mrb, NULL, 0));
+  mrb_sdl2_assetpack_build(mrb, out, entries);
+  return entries;
+#else
+  mrb_raise(mrb, E_NOTIMP_ERROR, "not implemented.");
+  return mrb_nil_value();
+#endif
+}
+
+
+void
+mruby_sdl2_assetpack_init(mrb_state *mrb)
+{
+  class_AssetPack = mrb_define_class_under(mrb, mod_SDL2, "AssetPack", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_AssetPack, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_AssetPack, "initialize", mrb_sdl2_assetpack_initialize,   MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AssetPack, "size",       mrb_sdl2_assetpack_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AssetPack, "include?",   mrb_sdl2_assetpack_include,      MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AssetPack, "names",      mrb_sdl2_assetpack_get_names,    MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AssetPack, "bytesize",   mrb_sdl2_assetpack_get_bytesize, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AssetPack, "read",       mrb_sdl2_assetpack_read,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AssetPack, "rwops",      mrb_sdl2_assetpack_rwops,        MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AssetPack, "load_bmp",   mrb_sdl2_assetpack_load_bmp,     MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AssetPack, "load_wav",   mrb_sdl2_assetpack_load_wav,     MRB_ARGS_REQ(1));
+
+  mrb_define_class_method(mrb, class_AssetPack, "build",                mrb_sdl2_assetpack_s_build,                MRB_ARGS_REQ(2));
+  mrb_define_class_method(mrb, class_AssetPack, "build_from_directory", mrb_sdl2_assetpack_s_build_from_directory, MRB_ARGS_REQ(2));
+}
+
+void
+mruby_sdl2_assetpack_final(mrb_state *mrb)
+{
+}
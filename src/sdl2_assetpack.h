@@ -0,0 +1,17 @@
+#ifndef MRUBY_SDL2_ASSETPACK_H
+#define MRUBY_SDL2_ASSETPACK_H
+
+#include "sdl2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void mruby_sdl2_assetpack_init(mrb_state *mrb);
+extern void mruby_sdl2_assetpack_final(mrb_state *mrb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_ASSETPACK_H */
@@ -1,10 +1,15 @@
 #include "sdl2_audio.h"
+#include "sdl2_audiostream.h"
+#include "sdl2_effectchain.h"
+#include "sdl2_rwops.h"
+#include "mrb_sdl2_buffer.h"
 #include "mruby/data.h"
 #include "mruby/value.h"
 #include "mruby/class.h"
 #include "mruby/string.h"
 #include "mruby/array.h"
 #include "mruby/variable.h"
+#include "mruby/hash.h"
 
 struct RClass *mod_Audio = NULL;
 static struct RClass *class_AudioCVT    = NULL;
@@ -12,9 +17,31 @@ static struct RClass *class_AudioSpec   = NULL;
 static struct RClass *class_AudioDevice = NULL;
 static struct RClass *class_AudioData   = NULL;
 
+#define MRB_SDL2_AUDIO_STATS_BUCKETS 16
+
+/* callback timings; written on the audio thread under 'lock'. */
+typedef struct mrb_sdl2_audio_stats_t {
+  SDL_SpinLock lock;
+  int          freq;          /* of the opened device; 0 uses the spec's own. */
+  Uint32       frame_size;
+  Uint64       callbacks;
+  Uint64       overruns;      /* callbacks that took longer than the buffer lasts. */
+  Uint64       silence_fills; /* callbacks that left the buffer (partly) silent. */
+  Uint64       total_ticks;
+  Uint64       max_ticks;
+  Uint64       last_ticks;
+  Uint64       budget_ticks;  /* of the last callback. */
+  Uint64       histogram[MRB_SDL2_AUDIO_STATS_BUCKETS]; /* log2 of microseconds. */
+} mrb_sdl2_audio_stats_t;
+
 typedef struct mrb_sdl2_audio_userdata_t {
-  mrb_state *mrb;
-  mrb_value  obj;
+  mrb_state              *mrb;
+  mrb_value               obj;
+  SDL_AudioDeviceID       device;  /* the device running the callback; 0 while closed. */
+  SDL_AudioSpec           obtained; /* the format 'device' plays, which may differ from the desired one. */
+  void                   *stream;  /* mrb_sdl2_audiostream_t; swapped under the device lock. */
+  void                   *effects; /* mrb_sdl2_effectchain_t; swapped under the device lock. */
+  mrb_sdl2_audio_stats_t  stats;
 } mrb_sdl2_audio_userdata_t;
 
 typedef struct mrb_sdl2_audio_audiocvt_data_t {
@@ -101,6 +128,22 @@ struct mrb_data_type const mrb_sdl2_audio_audiodata_data_type = {
   "AudioData", mrb_sdl2_audio_audiodata_data_free
 };
 
+static void mrb_sdl2_audio_audiospec_callback(void *userdata, Uint8 *stream, int len);
+
+/* points 'data' at the callback and resets its userdata. */
+static void
+mrb_sdl2_audio_audiospec_bind(mrb_state *mrb, mrb_sdl2_audio_audiospec_data_t *data, mrb_value obj)
+{
+  data->spec.callback = &mrb_sdl2_audio_audiospec_callback;
+  data->spec.userdata = (void*)&data->udata;
+  data->udata.mrb     = mrb;
+  data->udata.obj     = obj;
+  data->udata.device  = 0;
+  data->udata.stream  = NULL;
+  data->udata.effects = NULL;
+  SDL_zero(data->udata.stats);
+}
+
 SDL_AudioSpec *
 mrb_sdl2_audiospec_get_ptr(mrb_state *mrb, mrb_value value)
 {
@@ -141,7 +184,9 @@ mrb_sdl2_audiospec(mrb_state *mrb, SDL_AudioSpec const *value)
   } else {
     data->spec = *value;
   }
-  return mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioSpec, &mrb_sdl2_audio_audiospec_data_type, data));
+  mrb_value const obj = mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioSpec, &mrb_sdl2_audio_audiospec_data_type, data));
+  mrb_sdl2_audio_audiospec_bind(mrb, data, obj);
+  return obj;
 }
 
 mrb_value
@@ -172,6 +217,74 @@ mrb_sdl2_audiodevice(mrb_state *mrb, SDL_AudioDeviceID id)
   return mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioDevice, &mrb_sdl2_audio_audiodevice_data_type, data));
 }
 
+/* the format the callback of 'data' fills: the obtained one once opened. */
+static SDL_AudioSpec const *
+mrb_sdl2_audio_audiospec_output(mrb_sdl2_audio_audiospec_data_t const *data)
+{
+  return (0 != data->udata.device) ? &data->udata.obtained : &data->spec;
+}
+
+/* true when 'stream' holds PCM in the format, channel count and rate of 'spec'. */
+static bool
+mrb_sdl2_audio_stream_matches(mrb_sdl2_audiostream_t const *stream, SDL_AudioSpec const *spec)
+{
+  SDL_AudioSpec const *s = mrb_sdl2_audiostream_spec(stream);
+  return (s->format == spec->format) && (s->channels == spec->channels) && (s->freq == spec->freq);
+}
+
+/* true when the native sources attached to 'data' can fill 'spec'. */
+static bool
+mrb_sdl2_audio_audiospec_sources_match(mrb_sdl2_audio_audiospec_data_t const *data, SDL_AudioSpec const *spec)
+{
+  mrb_sdl2_audiostream_t const *stream = (mrb_sdl2_audiostream_t const*)data->udata.stream;
+  mrb_sdl2_effectchain_t const *chain  = (mrb_sdl2_effectchain_t const*)data->udata.effects;
+  return ((NULL == stream) || mrb_sdl2_audio_stream_matches(stream, spec)) &&
+         ((NULL == chain) || mrb_sdl2_effectchain_accepts(chain, spec));
+}
+
+/*
+ * Checks, right after a device was opened for 'spec', that what is
+ * attached to it matches the obtained format. Returns false (with the SDL
+ * error set) so the caller can close the device before raising.
+ */
+static bool
+mrb_sdl2_audio_audiospec_check_obtained(mrb_state *mrb, mrb_value spec, SDL_AudioSpec const *obtained)
+{
+  mrb_sdl2_audio_audiospec_data_t const *data =
+    (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, spec, &mrb_sdl2_audio_audiospec_data_type);
+  if ((NULL != data) && !mrb_sdl2_audio_audiospec_sources_match(data, obtained)) {
+    SDL_SetError("attached sources do not match the obtained audio format");
+    return false;
+  }
+  return true;
+}
+
+/* marks the spec as run by device 'id' playing the 'obtained' format. */
+static void
+mrb_sdl2_audio_audiospec_opened(mrb_state *mrb, mrb_value spec, SDL_AudioDeviceID id, SDL_AudioSpec const *obtained)
+{
+  mrb_sdl2_audio_audiospec_data_t *data =
+    (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, spec, &mrb_sdl2_audio_audiospec_data_type);
+  data->udata.obtained = *obtained;
+  data->udata.device   = id;
+  SDL_AtomicLock(&data->udata.stats.lock);
+  data->udata.stats.freq       = obtained->freq;
+  data->udata.stats.frame_size = (SDL_AUDIO_BITSIZE(obtained->format) / 8) * obtained->channels;
+  SDL_AtomicUnlock(&data->udata.stats.lock);
+}
+
+/*
+ * Keeps the desired spec, whose callback userdata SDL holds on to, alive
+ * with the device, and tells it the obtained format.
+ */
+static void
+mrb_sdl2_audio_audiodevice_attach_spec(mrb_state *mrb, mrb_value device, mrb_value spec, SDL_AudioDeviceID id,
+                                       SDL_AudioSpec const *obtained)
+{
+  mrb_iv_set(mrb, device, mrb_intern(mrb, "spec", 4), spec);
+  mrb_sdl2_audio_audiospec_opened(mrb, spec, id, obtained);
+}
+
 /***************************************************************************
 *
 * module SDL2::Audio
@@ -213,6 +326,12 @@ mrb_sdl2_audio_open(mrb_state *mrb, mrb_value mod)
   if (0 != ret) {
     mruby_sdl2_raise_error(mrb);
   }
+  if (!mrb_sdl2_audio_audiospec_check_obtained(mrb, arg, &obtained)) {
+    SDL_CloseAudio();
+    mruby_sdl2_raise_error(mrb);
+  }
+  /* the legacy interface always runs device 1. */
+  mrb_sdl2_audio_audiospec_opened(mrb, arg, 1, &obtained);
   return mrb_sdl2_audiospec(mrb, &obtained);
 }
 
@@ -237,42 +356,41 @@ mrb_sdl2_audio_open_device(mrb_state *mrb, mrb_value mod)
     mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
   }
 
-  SDL_AudioDeviceID id = 0;
-  switch (argc) {
-  case 3:
-    id = SDL_OpenAudioDevice(
-          RSTRING_PTR(device),
-          iscapture ? 1 : 0,
-          mrb_sdl2_audiospec_get_ptr(mrb, desired),
-          NULL,
-          0);
-    break;
-  case 4:
-    id = SDL_OpenAudioDevice(
-          RSTRING_PTR(device),
-          iscapture ? 1 : 0,
-          mrb_sdl2_audiospec_get_ptr(mrb, desired),
-          mrb_sdl2_audiospec_get_ptr(mrb, obtained),
-          0);
-    break;
-  case 5:
-    id = SDL_OpenAudioDevice(
-          RSTRING_PTR(device),
-          iscapture ? 1 : 0,
-          mrb_sdl2_audiospec_get_ptr(mrb, desired),
-          mrb_sdl2_audiospec_get_ptr(mrb, obtained),
-          allowed_changes);
-    break;
-  default:
+  if ((3 > argc) || (5 < argc)) {
     mrb_free(mrb, data);
     mrb_raise(mrb, E_ARGUMENT_ERROR, "wrong number of arguments.");
-    break;
+  }
+  /* opened into a local spec; an 'obtained' object is optional, and nil is allowed. */
+  SDL_AudioSpec obtained_spec;
+  SDL_AudioDeviceID id = SDL_OpenAudioDevice(
+    RSTRING_PTR(device),
+    iscapture ? 1 : 0,
+    mrb_sdl2_audiospec_get_ptr(mrb, desired),
+    &obtained_spec,
+    (5 == argc) ? (int)allowed_changes : 0);
+  if ((0 != id) && !mrb_sdl2_audio_audiospec_check_obtained(mrb, desired, &obtained_spec)) {
+    SDL_CloseAudioDevice(id);
+    id = 0;
   }
   if (0 == id) {
     mrb_free(mrb, data);
     mruby_sdl2_raise_error(mrb);
   }
-  return mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioDevice, &mrb_sdl2_audio_audiodevice_data_type, data));
+  SDL_AudioSpec * const out = (3 < argc) ? mrb_sdl2_audiospec_get_ptr(mrb, obtained) : NULL;
+  if (NULL != out) {
+    /* the callback and userdata stay bound to the object itself. */
+    out->freq     = obtained_spec.freq;
+    out->format   = obtained_spec.format;
+    out->channels = obtained_spec.channels;
+    out->silence  = obtained_spec.silence;
+    out->samples  = obtained_spec.samples;
+    out->size     = obtained_spec.size;
+  }
+  data->id = id;
+  data->spec = obtained_spec;
+  mrb_value const self = mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioDevice, &mrb_sdl2_audio_audiodevice_data_type, data));
+  mrb_sdl2_audio_audiodevice_attach_spec(mrb, self, desired, id, &data->spec);
+  return self;
 }
 
 static mrb_value
@@ -352,9 +470,25 @@ mrb_sdl2_audio_mix_audio(mrb_state *mrb, mrb_value mod)
   Uint8 const *src_ptr = NULL;
   if (mrb_type(dst) == MRB_TT_CPTR) {
     dst_ptr = (Uint8*)mrb_cptr(dst);
+  } else if (mrb_sdl2_buffer_p(mrb, dst)) {
+    size_t sz;
+    dst_ptr = (Uint8*)mrb_sdl2_buffer_get_ptr(mrb, dst, &sz);
+    if (dpos > sz) {
+      len = 0;
+    } else if (len > (sz - dpos)) {
+      len = sz - dpos;
+    }
   }
   if (mrb_type(src) == MRB_TT_CPTR) {
     src_ptr = (Uint8 const *)mrb_cptr(src);
+  } else if (mrb_sdl2_buffer_p(mrb, src)) {
+    size_t sz;
+    src_ptr = (Uint8 const *)mrb_sdl2_buffer_get_ptr(mrb, src, &sz);
+    if (spos > sz) {
+      len = 0;
+    } else if (len > (sz - spos)) {
+      len = sz - spos;
+    }
   } else if (mrb_type(src) == MRB_TT_DATA) {
     if (DATA_TYPE(src) == &mrb_sdl2_audio_audiodata_data_type) {
       mrb_sdl2_audio_audiodata_data_t const *data =
@@ -402,10 +536,47 @@ mrb_sdl2_auiod_get_status(mrb_state *mrb, mrb_value mod)
 *
 ***************************************************************************/
 
+static void
+mrb_sdl2_audio_stats_record(mrb_sdl2_audio_stats_t *stats, SDL_AudioSpec const *spec, Uint64 start, int len, bool silent)
+{
+  Uint64 const ticks = SDL_GetPerformanceCounter() - start;
+  Uint64 const frequency = SDL_GetPerformanceFrequency();
+  int const freq = (0 < stats->freq) ? stats->freq : spec->freq;
+  Uint32 const frame_size = (0 < stats->frame_size) ? stats->frame_size : (SDL_AUDIO_BITSIZE(spec->format) / 8) * spec->channels;
+  Uint64 budget = 0;
+  if ((0 < freq) && (0 < frame_size)) {
+    budget = (Uint64)((Uint32)len / frame_size) * frequency / (Uint64)freq;
+  }
+  Uint64 const us = ticks * 1000000 / frequency;
+  int bucket = 0;
+  while ((bucket < MRB_SDL2_AUDIO_STATS_BUCKETS - 1) && ((Uint64)2 << bucket) <= us) {
+    ++bucket;
+  }
+
+  SDL_AtomicLock(&stats->lock);
+  ++stats->callbacks;
+  if ((0 < budget) && (ticks > budget)) {
+    /* without a known rate there is no budget to overrun. */
+    ++stats->overruns;
+  }
+  if (silent) {
+    ++stats->silence_fills;
+  }
+  stats->total_ticks  += ticks;
+  stats->last_ticks    = ticks;
+  stats->budget_ticks  = budget;
+  if (ticks > stats->max_ticks) {
+    stats->max_ticks = ticks;
+  }
+  ++stats->histogram[bucket];
+  SDL_AtomicUnlock(&stats->lock);
+}
+
 static void
 mrb_sdl2_audio_audiospec_callback(void *userdata, Uint8 *stream, int len)
 {
   mrb_sdl2_audio_userdata_t *data = (mrb_sdl2_audio_userdata_t*)userdata;
+  Uint64 const start = SDL_GetPerformanceCounter();
   mrb_state *mrb = data->mrb;
   mrb_value obj = data->obj;
 
@@ -415,18 +586,35 @@ mrb_sdl2_audio_audiospec_callback(void *userdata, Uint8 *stream, int len)
 
   SDL_memset(stream, spec->silence, len);
 
-  if (mrb_nil_p(block)) {
-    return;
+  /* an attached Audio::Stream is read natively, without entering the VM. */
+  Uint32 filled = 0;
+  mrb_sdl2_audiostream_t * const source =
+    (mrb_sdl2_audiostream_t*)SDL_AtomicGetPtr(&data->stream);
+  if (NULL != source) {
+    filled = mrb_sdl2_audiostream_read(source, stream, (Uint32)len);
   }
 
-  // TODO migrate thread context if necessary.
+  if (!mrb_nil_p(block)) {
+    // TODO migrate thread context if necessary.
 
-  mrb_value args[3] = {
-    udata,
-    mrb_cptr_value(mrb, stream),
-    mrb_fixnum_value(len)
-  };
-  mrb_yield_argv(mrb, block, 3, args);
+    mrb_value args[3] = {
+      udata,
+      mrb_cptr_value(mrb, stream),
+      mrb_fixnum_value(len)
+    };
+    mrb_yield_argv(mrb, block, 3, args);
+  }
+
+  /* the effect chain sees the final mix, stream and block output alike. */
+  mrb_sdl2_effectchain_t * const effects =
+    (mrb_sdl2_effectchain_t*)SDL_AtomicGetPtr(&data->effects);
+  if (NULL != effects) {
+    mrb_sdl2_effectchain_process(effects, stream, (Uint32)len);
+  }
+
+  /* with a block the output is up to Ruby; only a short or missing stream counts as silence. */
+  bool const silent = mrb_nil_p(block) && (filled < (Uint32)len);
+  mrb_sdl2_audio_stats_record(&data->stats, spec, start, len, silent);
 }
 
 static mrb_value
@@ -444,8 +632,7 @@ mrb_sdl2_audio_audiospec_initialize(mrb_state *mrb, mrb_value self)
       mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
     }
     data->spec = (SDL_AudioSpec){ 0, };
-    data->spec.callback = &mrb_sdl2_audio_audiospec_callback;
-    data->spec.userdata = (void*)&data->udata;
+    mrb_sdl2_audio_audiospec_bind(mrb, data, self);
   }
 
   data->udata.mrb = mrb;
@@ -581,6 +768,83 @@ mrb_sdl2_audio_audiospec_set_userdata(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+/*
+ * Replaces a native source of the callback: the ivar that keeps 'obj'
+ * alive and the pointer the callback reads. Both change under the device
+ * lock, so a callback already running is done with the old object before
+ * the ivar stops referencing it. SDL's device lock is recursive, so this
+ * is also safe from inside the callback block.
+ */
+static void
+mrb_sdl2_audio_audiospec_swap(mrb_state *mrb, mrb_value self, mrb_sdl2_audio_audiospec_data_t *data,
+                              char const *name, void **slot, void *ptr, mrb_value obj)
+{
+  SDL_AudioDeviceID const device = data->udata.device;
+  if (0 != device) {
+    SDL_LockAudioDevice(device);
+  }
+  mrb_iv_set(mrb, self, mrb_intern_cstr(mrb, name), obj);
+  SDL_AtomicSetPtr(slot, ptr);
+  if (0 != device) {
+    SDL_UnlockAudioDevice(device);
+  }
+}
+
+static mrb_value
+mrb_sdl2_audio_audiospec_get_stream(mrb_state *mrb, mrb_value self)
+{
+  return mrb_iv_get(mrb, self, mrb_intern(mrb, "stream", 6));
+}
+
+/*
+ * SDL2::Audio::AudioSpec#stream=(stream)
+ * Attaches an Audio::Stream (or nil) whose PCM is copied into the output
+ * buffer before the callback block runs. The stream is not converted, so
+ * its format, channel count and rate must be the ones the callback fills.
+ */
+static mrb_value
+mrb_sdl2_audio_audiospec_set_stream(mrb_state *mrb, mrb_value self)
+{
+  mrb_value obj;
+  mrb_get_args(mrb, "o", &obj);
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_get_ptr(mrb, obj);
+  mrb_sdl2_audio_audiospec_data_t *data =
+    (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_audio_audiospec_data_type);
+  if ((NULL != stream) && !mrb_sdl2_audio_stream_matches(stream, mrb_sdl2_audio_audiospec_output(data))) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "stream does not match the audio format.");
+  }
+  mrb_sdl2_audio_audiospec_swap(mrb, self, data, "stream", &data->udata.stream, stream, obj);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_audio_audiospec_get_effects(mrb_state *mrb, mrb_value self)
+{
+  return mrb_iv_get(mrb, self, mrb_intern(mrb, "effects", 7));
+}
+
+/*
+ * SDL2::Audio::AudioSpec#effects=(chain)
+ * Attaches an Audio::EffectChain (or nil) that runs natively over the
+ * output buffer after the stream and the callback block. The chain must
+ * have been built for the format, channel count and rate the callback
+ * fills: the obtained ones once a device was opened with this spec.
+ */
+static mrb_value
+mrb_sdl2_audio_audiospec_set_effects(mrb_state *mrb, mrb_value self)
+{
+  mrb_value obj;
+  mrb_get_args(mrb, "o", &obj);
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_get_ptr(mrb, obj);
+  mrb_sdl2_audio_audiospec_data_t *data =
+    (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_audio_audiospec_data_type);
+  if ((NULL != chain) && !mrb_sdl2_effectchain_accepts(chain, mrb_sdl2_audio_audiospec_output(data))) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "effect chain does not match the audio format.");
+  }
+  mrb_sdl2_audio_audiospec_swap(mrb, self, data, "effects", &data->udata.effects, chain, obj);
+  return self;
+}
+
 /***************************************************************************
 *
 * class SDL2::Audio::AudioCVT
@@ -689,7 +953,14 @@ mrb_sdl2_audio_audiodevice_initialize(mrb_state *mrb, mrb_value self)
 
   SDL_AudioDeviceID id = SDL_OpenAudioDevice(
     device, iscapture ? 1 : 0, desired, &obtained, allowed_changes);
+  if ((0 != id) && !mrb_sdl2_audio_audiospec_check_obtained(mrb, spec, &obtained)) {
+    SDL_CloseAudioDevice(id);
+    id = 0;
+  }
   if (0 == id) {
+    if (NULL == DATA_PTR(self)) {
+      mrb_free(mrb, data);
+    }
     mruby_sdl2_raise_error(mrb);
   }
 
@@ -699,6 +970,8 @@ mrb_sdl2_audio_audiodevice_initialize(mrb_state *mrb, mrb_value self)
   DATA_PTR(self) = data;
   DATA_TYPE(self) = &mrb_sdl2_audio_audiodevice_data_type;
 
+  mrb_sdl2_audio_audiodevice_attach_spec(mrb, self, spec, id, &obtained);
+
   return self;
 }
 
@@ -709,6 +982,14 @@ mrb_sdl2_audio_audiodevice_close(mrb_state *mrb, mrb_value self)
     (mrb_sdl2_audio_audiodevice_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_audio_audiodevice_data_type);
   if (0 < data->id) {
     SDL_CloseAudioDevice(data->id);
+    mrb_value const spec = mrb_iv_get(mrb, self, mrb_intern(mrb, "spec", 4));
+    if (!mrb_nil_p(spec)) {
+      mrb_sdl2_audio_audiospec_data_t *sd =
+        (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, spec, &mrb_sdl2_audio_audiospec_data_type);
+      if (sd->udata.device == data->id) {
+        sd->udata.device = 0;
+      }
+    }
     data->id = 0;
   }
   return self;
@@ -722,6 +1003,88 @@ mrb_sdl2_audio_audiodevice_get_spec(mrb_state *mrb, mrb_value self)
   return mrb_sdl2_audiospec(mrb, &data->spec);
 }
 
+/* callback stats of the spec the device was opened with. */
+static mrb_sdl2_audio_stats_t *
+mrb_sdl2_audio_audiodevice_stats(mrb_state *mrb, mrb_value self)
+{
+  mrb_data_get_ptr(mrb, self, &mrb_sdl2_audio_audiodevice_data_type);
+  mrb_value const spec = mrb_iv_get(mrb, self, mrb_intern(mrb, "spec", 4));
+  if (mrb_nil_p(spec)) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "audio device is not opened.");
+  }
+  mrb_sdl2_audio_audiospec_data_t *data =
+    (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, spec, &mrb_sdl2_audio_audiospec_data_type);
+  return &data->udata.stats;
+}
+
+static void
+mrb_sdl2_audio_stats_set(mrb_state *mrb, mrb_value hash, char const *key, mrb_value value)
+{
+  mrb_hash_set(mrb, hash, mrb_symbol_value(mrb_intern_cstr(mrb, key)), value);
+}
+
+/* a counter as a Fixnum, saturated at MRB_INT_MAX. */
+static mrb_value
+mrb_sdl2_audio_stats_count(Uint64 n)
+{
+  return mrb_fixnum_value(((Uint64)MRB_INT_MAX < n) ? MRB_INT_MAX : (mrb_int)n);
+}
+
+/*
+ * SDL2::Audio::AudioDevice#stats
+ *
+ * Timings of the audio callback, measured natively around it:
+ *   :callbacks, :overruns (took longer than the buffer plays),
+ *   :silence_fills (no block, and no stream or a short one),
+ *   :budget (seconds one buffer plays), :last_time, :max_time,
+ *   :mean_time (seconds), and :histogram, where element i counts
+ *   durations of [2^i, 2^(i+1)) microseconds (the ends are open).
+ */
+static mrb_value
+mrb_sdl2_audio_audiodevice_get_stats(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audio_stats_t *stats = mrb_sdl2_audio_audiodevice_stats(mrb, self);
+  mrb_sdl2_audio_stats_t snapshot;
+  int i;
+  SDL_AtomicLock(&stats->lock);
+  snapshot = *stats;
+  SDL_AtomicUnlock(&stats->lock);
+
+  double const frequency = (double)SDL_GetPerformanceFrequency();
+  double const mean = (0 < snapshot.callbacks) ? (double)snapshot.total_ticks / (double)snapshot.callbacks : 0.0;
+  mrb_value const histogram = mrb_ary_new_capa(mrb, MRB_SDL2_AUDIO_STATS_BUCKETS);
+  for (i = 0; i < MRB_SDL2_AUDIO_STATS_BUCKETS; ++i) {
+    mrb_ary_push(mrb, histogram, mrb_sdl2_audio_stats_count(snapshot.histogram[i]));
+  }
+  mrb_value const hash = mrb_hash_new(mrb);
+  mrb_sdl2_audio_stats_set(mrb, hash, "callbacks",     mrb_sdl2_audio_stats_count(snapshot.callbacks));
+  mrb_sdl2_audio_stats_set(mrb, hash, "overruns",      mrb_sdl2_audio_stats_count(snapshot.overruns));
+  mrb_sdl2_audio_stats_set(mrb, hash, "silence_fills", mrb_sdl2_audio_stats_count(snapshot.silence_fills));
+  mrb_sdl2_audio_stats_set(mrb, hash, "budget",        mrb_float_value(mrb, (mrb_float)((double)snapshot.budget_ticks / frequency)));
+  mrb_sdl2_audio_stats_set(mrb, hash, "last_time",     mrb_float_value(mrb, (mrb_float)((double)snapshot.last_ticks / frequency)));
+  mrb_sdl2_audio_stats_set(mrb, hash, "max_time",      mrb_float_value(mrb, (mrb_float)((double)snapshot.max_ticks / frequency)));
+  mrb_sdl2_audio_stats_set(mrb, hash, "mean_time",     mrb_float_value(mrb, (mrb_float)(mean / frequency)));
+  mrb_sdl2_audio_stats_set(mrb, hash, "histogram",     histogram);
+  return hash;
+}
+
+static mrb_value
+mrb_sdl2_audio_audiodevice_reset_stats(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audio_stats_t *stats = mrb_sdl2_audio_audiodevice_stats(mrb, self);
+  SDL_AtomicLock(&stats->lock);
+  stats->callbacks     = 0;
+  stats->overruns      = 0;
+  stats->silence_fills = 0;
+  stats->total_ticks   = 0;
+  stats->max_ticks     = 0;
+  stats->last_ticks    = 0;
+  stats->budget_ticks  = 0;
+  SDL_memset(stats->histogram, 0, sizeof(stats->histogram));
+  SDL_AtomicUnlock(&stats->lock);
+  return self;
+}
+
 static mrb_value
 mrb_sdl2_audio_audiodevice_pause(mrb_state *mrb, mrb_value self)
 {
@@ -774,51 +1137,122 @@ mrb_sdl2_audio_audiodevice_get_status(mrb_state *mrb, mrb_value self)
 *
 ***************************************************************************/
 
-static mrb_value
-mrb_sdl2_audio_audiodata_initialize(mrb_state *mrb, mrb_value self)
+/*
+ * Loads WAV data from 'rw' into 'self' (closing 'rw' if 'freesrc' is set).
+ */
+static void
+mrb_sdl2_audio_audiodata_load(mrb_state *mrb, mrb_value self, SDL_RWops *rw, int freesrc)
 {
-  mrb_value file;
   mrb_sdl2_audio_audiodata_data_t *data =
     (mrb_sdl2_audio_audiodata_data_t*)DATA_PTR(self);
+  bool const is_new = (NULL == data);
 
   mrb_sdl2_audio_audiospec_data_t *spec =
     (mrb_sdl2_audio_audiospec_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_audio_audiospec_data_t));
   if (NULL == spec) {
+    if (freesrc && (NULL != rw)) {
+      SDL_RWclose(rw);
+    }
     mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
   }
 
-  if (NULL == data) {
+  if (is_new) {
     data = (mrb_sdl2_audio_audiodata_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_audio_audiodata_data_t));
     if (NULL == data) {
       mrb_free(mrb, spec);
+      if (freesrc && (NULL != rw)) {
+        SDL_RWclose(rw);
+      }
       mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
     }
     data->buf = NULL;
     data->len = 0;
   }
 
-  mrb_get_args(mrb, "S", &file);
-  if (NULL == SDL_LoadWAV(RSTRING_PTR(file), &spec->spec, &data->buf, &data->len)) {
+  /* a failed reload keeps the clip already loaded. */
+  Uint8 *buf = NULL;
+  Uint32 len = 0;
+  if (NULL == SDL_LoadWAV_RW(rw, freesrc, &spec->spec, &buf, &len)) {
     mrb_free(mrb, spec);
-    mrb_free(mrb, data);
+    if (is_new) {
+      mrb_free(mrb, data);
+    }
     mruby_sdl2_raise_error(mrb);
   }
+  if (NULL != data->buf) {
+    SDL_FreeWAV(data->buf);
+  }
+  data->buf = buf;
+  data->len = len;
 
   mrb_value s = mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioSpec, &mrb_sdl2_audio_audiospec_data_type, spec));
 
-  spec->spec.userdata = &spec->udata;
-  spec->spec.callback = &mrb_sdl2_audio_audiospec_callback;
-  spec->udata.mrb = mrb;
-  spec->udata.obj = s;
+  mrb_sdl2_audio_audiospec_bind(mrb, spec, s);
 
   mrb_iv_set(mrb, self, mrb_intern(mrb, "spec", 4), s);
 
   DATA_PTR(self) = data;
   DATA_TYPE(self) = &mrb_sdl2_audio_audiodata_data_type;
+}
 
+mrb_value
+mrb_sdl2_audiodata_from_rw(mrb_state *mrb, SDL_RWops *rw, int freesrc)
+{
+  mrb_value self = mrb_obj_value(Data_Wrap_Struct(mrb, class_AudioData, NULL, NULL));
+  mrb_sdl2_audio_audiodata_load(mrb, self, rw, freesrc);
   return self;
 }
 
+static mrb_value
+mrb_sdl2_audio_audiodata_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value file;
+  mrb_get_args(mrb, "S", &file);
+  mrb_sdl2_audio_audiodata_load(mrb, self, SDL_RWFromFile(RSTRING_PTR(file), "rb"), 1);
+  return self;
+}
+
+/*
+ * Returns the PCM of an AudioData (NULL once destroyed) and stores its
+ * length and format to 'len' and 'spec'. Raises ArgumentError for
+ * anything else than an initialized AudioData.
+ */
+Uint8 *
+mrb_sdl2_audiodata_get_ptr(mrb_state *mrb, mrb_value value, Uint32 *len, SDL_AudioSpec *spec)
+{
+  mrb_sdl2_audio_audiodata_data_t *data =
+    (mrb_sdl2_audio_audiodata_data_t*)mrb_data_get_ptr(mrb, value, &mrb_sdl2_audio_audiodata_data_type);
+  if (NULL == data) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "given argument is not an initialized AudioData.");
+  }
+  if (NULL != spec) {
+    mrb_value const obj = mrb_iv_get(mrb, value, mrb_intern(mrb, "spec", 4));
+    mrb_sdl2_audio_audiospec_data_t const *spec_data = mrb_nil_p(obj) ? NULL :
+      (mrb_sdl2_audio_audiospec_data_t*)mrb_data_get_ptr(mrb, obj, &mrb_sdl2_audio_audiospec_data_type);
+    if (NULL == spec_data) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "given AudioData has no audio spec.");
+    }
+    *spec = spec_data->spec;
+  }
+  if (NULL != len) {
+    *len = data->len;
+  }
+  return data->buf;
+}
+
+/*
+ * SDL2::Audio::AudioData::from_rw(rwops)
+ *
+ * The RWops is left open.
+ */
+static mrb_value
+mrb_sdl2_audio_audiodata_s_from_rw(mrb_state *mrb, mrb_value self)
+{
+  mrb_value rwops;
+  mrb_get_args(mrb, "o", &rwops);
+  return mrb_sdl2_audiodata_from_rw(mrb, mrb_sdl2_rwops_get_ptr(mrb, rwops), 0);
+}
+
 static mrb_value
 mrb_sdl2_audio_audiodata_destroy(mrb_state *mrb, mrb_value self)
 {
@@ -898,17 +1332,23 @@ mruby_sdl2_audio_init(mrb_state *mrb)
   mrb_define_method(mrb, class_AudioSpec, "callback=",  mrb_sdl2_audio_audiospec_set_callback, MRB_ARGS_BLOCK());
   mrb_define_method(mrb, class_AudioSpec, "userdata",   mrb_sdl2_audio_audiospec_get_userdata, MRB_ARGS_NONE());
   mrb_define_method(mrb, class_AudioSpec, "userdata=",  mrb_sdl2_audio_audiospec_set_userdata, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AudioSpec, "stream",     mrb_sdl2_audio_audiospec_get_stream,   MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioSpec, "stream=",    mrb_sdl2_audio_audiospec_set_stream,   MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AudioSpec, "effects",    mrb_sdl2_audio_audiospec_get_effects,  MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioSpec, "effects=",   mrb_sdl2_audio_audiospec_set_effects,  MRB_ARGS_REQ(1));
 
   mrb_define_method(mrb, class_AudioCVT, "initialize", mrb_sdl2_audio_audiocvt_initialize, MRB_ARGS_REQ(4));
   mrb_define_method(mrb, class_AudioCVT, "convert",    mrb_sdl2_audio_audiocvt_convert,    MRB_ARGS_NONE());
 
-  mrb_define_method(mrb, class_AudioDevice, "initialize", mrb_sdl2_audio_audiodevice_initialize, MRB_ARGS_REQ(3));
-  mrb_define_method(mrb, class_AudioDevice, "close",      mrb_sdl2_audio_audiodevice_close,      MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_AudioDevice, "spec",       mrb_sdl2_audio_audiodevice_get_spec,   MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_AudioDevice, "pause",      mrb_sdl2_audio_audiodevice_pause,      MRB_ARGS_REQ(1));
-  mrb_define_method(mrb, class_AudioDevice, "lock",       mrb_sdl2_audio_audiodevice_lock,       MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_AudioDevice, "unlock",     mrb_sdl2_audio_audiodevice_unlock,     MRB_ARGS_NONE());
-  mrb_define_method(mrb, class_AudioDevice, "status",     mrb_sdl2_audio_audiodevice_get_status, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "initialize",  mrb_sdl2_audio_audiodevice_initialize,  MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, class_AudioDevice, "close",       mrb_sdl2_audio_audiodevice_close,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "spec",        mrb_sdl2_audio_audiodevice_get_spec,    MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "pause",       mrb_sdl2_audio_audiodevice_pause,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_AudioDevice, "lock",        mrb_sdl2_audio_audiodevice_lock,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "unlock",      mrb_sdl2_audio_audiodevice_unlock,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "status",      mrb_sdl2_audio_audiodevice_get_status,  MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "stats",       mrb_sdl2_audio_audiodevice_get_stats,   MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_AudioDevice, "reset_stats", mrb_sdl2_audio_audiodevice_reset_stats, MRB_ARGS_NONE());
 
   mrb_define_method(mrb, class_AudioData, "initialize", mrb_sdl2_audio_audiodata_initialize, MRB_ARGS_REQ(1));
   mrb_define_method(mrb, class_AudioData, "destroy",    mrb_sdl2_audio_audiodata_destroy,    MRB_ARGS_NONE());
@@ -916,6 +1356,8 @@ mruby_sdl2_audio_init(mrb_state *mrb)
   mrb_define_method(mrb, class_AudioData, "buffer",     mrb_sdl2_audio_audiodata_get_buffer, MRB_ARGS_NONE());
   mrb_define_method(mrb, class_AudioData, "length",     mrb_sdl2_audio_audiodata_get_length, MRB_ARGS_NONE());
 
+  mrb_define_class_method(mrb, class_AudioData, "from_rw", mrb_sdl2_audio_audiodata_s_from_rw, MRB_ARGS_REQ(1));
+
   int arena_size = mrb_gc_arena_save(mrb);
 
   /* SDL_AudioFormat */
@@ -3,6 +3,7 @@
 
 #include "sdl2.h"
 #include <SDL2/SDL_audio.h>
+#include <SDL2/SDL_rwops.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,8 @@ extern SDL_AudioSpec *mrb_sdl2_audiospec_get_ptr(mrb_state *mrb, mrb_value value
 extern SDL_AudioCVT  *mrb_sdl2_audiocvt_get_ptr(mrb_state *mrb, mrb_value value);
 extern mrb_value      mrb_sdl2_audiospec(mrb_state *mrb, SDL_AudioSpec const *value);
 extern mrb_value      mrb_sdl2_audiocvt(mrb_state *mrb, SDL_AudioCVT const *value);
+extern mrb_value      mrb_sdl2_audiodata_from_rw(mrb_state *mrb, SDL_RWops *rw, int freesrc);
+extern Uint8         *mrb_sdl2_audiodata_get_ptr(mrb_state *mrb, mrb_value value, Uint32 *len, SDL_AudioSpec *spec);
 
 #ifdef __cplusplus
 }
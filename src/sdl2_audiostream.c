@@ -0,0 +1,611 @@
+#include "sdl2_audiostream.h"
+#include "sdl2_audio.h"
+#include "mrb_sdl2_buffer.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/string.h"
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_error.h>
+
+/*
+ * SDL2::Audio::Stream plays a WAV file without loading its payload.
+ *
+ * The RIFF header is parsed once; afterwards PCM is read in chunks into a
+ * ring buffer, by a prefetch thread unless the stream was opened without
+ * one. The ring has a single producer (the thread, or the reader itself
+ * when there is no thread) and a single consumer (Stream#read or the
+ * audio callback of an AudioSpec the stream is attached to). 'head' and
+ * 'tail' count bytes ever written and consumed; their difference is the
+ * amount buffered.
+ */
+
+#define AUDIOSTREAM_DEFAULT_BUFFER_SIZE (256 * 1024)
+#define AUDIOSTREAM_MIN_BUFFER_SIZE     4096
+#define AUDIOSTREAM_MAX_BUFFER_SIZE     (64 * 1024 * 1024)
+#define AUDIOSTREAM_CHUNK_SIZE          (32 * 1024)
+#define AUDIOSTREAM_IDLE_WAIT_MS        20
+
+static struct RClass *class_Stream = NULL;
+
+struct mrb_sdl2_audiostream_t {
+  SDL_RWops    *rw;
+  SDL_AudioSpec spec;
+  Sint64        data_offset; /* file offset of the PCM payload. */
+  SDL_atomic_t  data_length; /* payload bytes, in whole frames; shrunk by the producer on a truncated file. */
+  Uint32        frame_size;
+  Uint8        *ring;
+  Uint32        capacity;    /* a power of two. */
+  SDL_atomic_t  head;
+  SDL_atomic_t  tail;
+  SDL_atomic_t  eof;         /* the producer reached the end of the payload. */
+  SDL_atomic_t  looping;
+  SDL_atomic_t  quit;
+  Uint32        file_pos;    /* payload offset the producer reads next; guarded by io_lock. */
+  Uint32        position;    /* payload offset the consumer reads next; guarded by read_lock. */
+  SDL_mutex    *io_lock;
+  SDL_SpinLock  read_lock;
+  SDL_sem      *space;       /* posted by the consumer when it frees space. */
+  SDL_Thread   *thread;      /* cleared by close under read_lock; the callback reads it there. */
+  void         *memory;      /* the copied file of a stream opened from memory. */
+};
+
+static void
+mrb_sdl2_audiostream_stop(mrb_sdl2_audiostream_t *stream)
+{
+  if (NULL != stream->thread) {
+    SDL_AtomicSet(&stream->quit, 1);
+    SDL_SemPost(stream->space);
+    SDL_WaitThread(stream->thread, NULL);
+    SDL_AtomicLock(&stream->read_lock);
+    stream->thread = NULL;
+    SDL_AtomicUnlock(&stream->read_lock);
+  }
+  if (NULL != stream->rw) {
+    SDL_LockMutex(stream->io_lock);
+    SDL_RWclose(stream->rw);
+    stream->rw = NULL;
+    SDL_AtomicSet(&stream->eof, 1);
+    SDL_UnlockMutex(stream->io_lock);
+  }
+}
+
+static void
+mrb_sdl2_audiostream_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_audiostream_t *stream =
+    (mrb_sdl2_audiostream_t*)p;
+  if (NULL != stream) {
+    mrb_sdl2_audiostream_stop(stream);
+    if (NULL != stream->space) {
+      SDL_DestroySemaphore(stream->space);
+    }
+    if (NULL != stream->io_lock) {
+      SDL_DestroyMutex(stream->io_lock);
+    }
+    mrb_free(mrb, stream->ring);
+    mrb_free(mrb, stream->memory);
+    mrb_free(mrb, stream);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_audiostream_data_type = {
+  "Stream", mrb_sdl2_audiostream_data_free
+};
+
+mrb_sdl2_audiostream_t *
+mrb_sdl2_audiostream_get_ptr(mrb_state *mrb, mrb_value value)
+{
+  if (mrb_nil_p(value)) {
+    return NULL;
+  }
+  return (mrb_sdl2_audiostream_t*)mrb_data_get_ptr(mrb, value, &mrb_sdl2_audiostream_data_type);
+}
+
+/*
+ * Parses the RIFF header and leaves 'rw' at the start of the PCM payload.
+ * Returns false with the SDL error set.
+ */
+static bool
+mrb_sdl2_audiostream_parse_wav(mrb_sdl2_audiostream_t *stream)
+{
+  SDL_RWops *rw = stream->rw;
+  char id[4];
+  bool have_fmt = false;
+
+  if ((1 != SDL_RWread(rw, id, 4, 1)) || (0 != SDL_memcmp(id, "RIFF", 4))) {
+    SDL_SetError("not a RIFF file");
+    return false;
+  }
+  SDL_ReadLE32(rw);
+  if ((1 != SDL_RWread(rw, id, 4, 1)) || (0 != SDL_memcmp(id, "WAVE", 4))) {
+    SDL_SetError("not a WAVE file");
+    return false;
+  }
+
+  for (;;) {
+    if (1 != SDL_RWread(rw, id, 4, 1)) {
+      SDL_SetError("no data chunk");
+      return false;
+    }
+    Uint32 const size = SDL_ReadLE32(rw);
+    Sint64 const next = SDL_RWtell(rw) + size + (size & 1);
+
+    if (0 == SDL_memcmp(id, "fmt ", 4)) {
+      if (16 > size) {
+        SDL_SetError("broken fmt chunk");
+        return false;
+      }
+      Uint16 tag            = SDL_ReadLE16(rw);
+      Uint16 const channels = SDL_ReadLE16(rw);
+      Uint32 const rate     = SDL_ReadLE32(rw);
+      SDL_ReadLE32(rw);
+      Uint16 const align    = SDL_ReadLE16(rw);
+      Uint16 const bits     = SDL_ReadLE16(rw);
+      if ((0xFFFE == tag) && (40 <= size)) {
+        /* WAVE_FORMAT_EXTENSIBLE; the sub-format GUID starts with the tag. */
+        SDL_ReadLE16(rw);
+        SDL_ReadLE16(rw);
+        SDL_ReadLE32(rw);
+        tag = SDL_ReadLE16(rw);
+      }
+      if ((1 == tag) && (8 == bits)) {
+        stream->spec.format = AUDIO_U8;
+      } else if ((1 == tag) && (16 == bits)) {
+        stream->spec.format = AUDIO_S16LSB;
+      } else if ((1 == tag) && (32 == bits)) {
+        stream->spec.format = AUDIO_S32LSB;
+      } else if ((3 == tag) && (32 == bits)) {
+        stream->spec.format = AUDIO_F32LSB;
+      } else {
+        SDL_SetError("unsupported WAV format (tag %d, %d bits)", (int)tag, (int)bits);
+        return false;
+      }
+      if ((0 == channels) || (255 < channels) || (0 == rate) || (align != channels * (bits / 8))) {
+        SDL_SetError("broken fmt chunk");
+        return false;
+      }
+      stream->spec.freq     = (int)rate;
+      stream->spec.channels = (Uint8)channels;
+      stream->spec.samples  = 4096;
+      stream->spec.silence  = (AUDIO_U8 == stream->spec.format) ? 0x80 : 0x00;
+      stream->frame_size    = align;
+      have_fmt = true;
+    } else if (0 == SDL_memcmp(id, "data", 4)) {
+      if (!have_fmt) {
+        SDL_SetError("data chunk before fmt chunk");
+        return false;
+      }
+      stream->data_offset = SDL_RWtell(rw);
+      Uint32 length = size;
+      /* streamed WAV files may leave the size unset. */
+      Sint64 const file_size = SDL_RWsize(rw);
+      if ((0 <= file_size) && (file_size - stream->data_offset < (Sint64)length)) {
+        length = (Uint32)(file_size - stream->data_offset);
+      }
+      SDL_AtomicSet(&stream->data_length, (int)(length - (length % stream->frame_size)));
+      return true;
+    }
+
+    if (0 > SDL_RWseek(rw, next, RW_SEEK_SET)) {
+      return false;
+    }
+  }
+}
+
+/*
+ * Reads payload into the free part of the ring and returns the number of
+ * bytes added. Called with io_lock held.
+ */
+static Uint32
+mrb_sdl2_audiostream_fill(mrb_sdl2_audiostream_t *stream)
+{
+  if ((NULL == stream->rw) || SDL_AtomicGet(&stream->eof)) {
+    return 0;
+  }
+  Uint32 const head = (Uint32)SDL_AtomicGet(&stream->head);
+  Uint32 const tail = (Uint32)SDL_AtomicGet(&stream->tail);
+  Uint32 space = stream->capacity - (head - tail);
+  Uint32 total = 0;
+  while (0 < space) {
+    Uint32 const data_length = (Uint32)SDL_AtomicGet(&stream->data_length);
+    if (stream->file_pos >= data_length) {
+      if ((0 == data_length) || !SDL_AtomicGet(&stream->looping)) {
+        SDL_AtomicSet(&stream->eof, 1);
+        break;
+      }
+      SDL_RWseek(stream->rw, stream->data_offset, RW_SEEK_SET);
+      stream->file_pos = 0;
+    }
+    Uint32 const index = (head + total) & (stream->capacity - 1);
+    Uint32 n = SDL_min(space, stream->capacity - index);
+    n = SDL_min(n, data_length - stream->file_pos);
+    n = SDL_min(n, AUDIOSTREAM_CHUNK_SIZE);
+    size_t const got = SDL_RWread(stream->rw, stream->ring + index, 1, n);
+    if (0 == got) {
+      /* truncated file; treat what was read as the whole payload. */
+      SDL_AtomicSet(&stream->data_length, (int)(stream->file_pos - (stream->file_pos % stream->frame_size)));
+      SDL_AtomicSet(&stream->eof, 1);
+      break;
+    }
+    stream->file_pos += (Uint32)got;
+    total += (Uint32)got;
+    space -= (Uint32)got;
+  }
+  SDL_AtomicSet(&stream->head, (int)(head + total));
+  return total;
+}
+
+static int
+mrb_sdl2_audiostream_thread(void *arg)
+{
+  mrb_sdl2_audiostream_t *stream = (mrb_sdl2_audiostream_t*)arg;
+  while (!SDL_AtomicGet(&stream->quit)) {
+    SDL_LockMutex(stream->io_lock);
+    Uint32 const added = mrb_sdl2_audiostream_fill(stream);
+    SDL_UnlockMutex(stream->io_lock);
+    if (0 == added) {
+      SDL_SemWaitTimeout(stream->space, AUDIOSTREAM_IDLE_WAIT_MS);
+    }
+  }
+  return 0;
+}
+
+Uint32
+mrb_sdl2_audiostream_read(mrb_sdl2_audiostream_t *stream, Uint8 *dst, Uint32 len)
+{
+  SDL_AtomicLock(&stream->read_lock);
+  bool const prefetching = (NULL != stream->thread);
+  SDL_AtomicUnlock(&stream->read_lock);
+  if (!prefetching) {
+    SDL_LockMutex(stream->io_lock);
+    mrb_sdl2_audiostream_fill(stream);
+    SDL_UnlockMutex(stream->io_lock);
+  }
+
+  SDL_AtomicLock(&stream->read_lock);
+  Uint32 const head = (Uint32)SDL_AtomicGet(&stream->head);
+  Uint32 const tail = (Uint32)SDL_AtomicGet(&stream->tail);
+  Uint32 n = SDL_min(len, head - tail);
+  n -= n % stream->frame_size;
+  if (0 < n) {
+    Uint32 const index = tail & (stream->capacity - 1);
+    Uint32 const first = SDL_min(n, stream->capacity - index);
+    SDL_memcpy(dst, stream->ring + index, first);
+    SDL_memcpy(dst + first, stream->ring, n - first);
+    SDL_AtomicSet(&stream->tail, (int)(tail + n));
+    stream->position += n;
+    Uint32 const data_length = (Uint32)SDL_AtomicGet(&stream->data_length);
+    if ((0 < data_length) && (stream->position >= data_length)) {
+      stream->position %= data_length;
+    }
+  }
+  SDL_AtomicUnlock(&stream->read_lock);
+
+  if (prefetching && (0 < n) && (0 == SDL_SemValue(stream->space))) {
+    SDL_SemPost(stream->space);
+  }
+  return n;
+}
+
+/***************************************************************************
+*
+* class SDL2::Audio::Stream
+*
+***************************************************************************/
+
+/*
+ * Creates the stream of 'self' with a ring of at least 'buffer_size'
+ * bytes. An AudioSpec may be reading an existing stream on the audio
+ * thread, so a stream is never recreated.
+ */
+static mrb_sdl2_audiostream_t *
+mrb_sdl2_audiostream_setup(mrb_state *mrb, mrb_value self, mrb_int buffer_size)
+{
+  if ((AUDIOSTREAM_MIN_BUFFER_SIZE > buffer_size) || (AUDIOSTREAM_MAX_BUFFER_SIZE < buffer_size)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "buffer size out of range.");
+  }
+  Uint32 capacity = AUDIOSTREAM_MIN_BUFFER_SIZE;
+  while (capacity < (Uint32)buffer_size) {
+    capacity <<= 1;
+  }
+
+  if (NULL != DATA_PTR(self)) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "stream is already initialized.");
+  }
+  mrb_sdl2_audiostream_t *stream =
+    (mrb_sdl2_audiostream_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_audiostream_t));
+  if (NULL == stream) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_zerop(stream);
+  DATA_PTR(self)  = stream;
+  DATA_TYPE(self) = &mrb_sdl2_audiostream_data_type;
+
+  stream->ring     = (Uint8*)mrb_malloc(mrb, capacity);
+  stream->io_lock  = SDL_CreateMutex();
+  stream->space    = SDL_CreateSemaphore(0);
+  if (NULL == stream->ring) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  if ((NULL == stream->io_lock) || (NULL == stream->space)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  stream->capacity = capacity;
+  return stream;
+}
+
+/* takes 'rw', parses its header and starts the prefetch thread if asked to. */
+static void
+mrb_sdl2_audiostream_open(mrb_state *mrb, mrb_sdl2_audiostream_t *stream, SDL_RWops *rw, bool prefetch)
+{
+  if (NULL == rw) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  stream->rw = rw;
+  if (!mrb_sdl2_audiostream_parse_wav(stream)) {
+    SDL_RWclose(stream->rw);
+    stream->rw = NULL;
+    mruby_sdl2_raise_error(mrb);
+  }
+
+  if (prefetch) {
+    stream->thread = SDL_CreateThread(mrb_sdl2_audiostream_thread, "mrb_sdl2_audiostream", stream);
+    if (NULL == stream->thread) {
+      mruby_sdl2_raise_error(mrb);
+    }
+  }
+}
+
+/*
+ * SDL2::Audio::Stream#initialize(path, buffer_size = 262144, prefetch = true)
+ * Without 'prefetch' the file is read by Stream#read on the calling thread.
+ */
+static mrb_value
+mrb_sdl2_audiostream_initialize(mrb_state *mrb, mrb_value self)
+{
+  char *path;
+  mrb_int buffer_size = AUDIOSTREAM_DEFAULT_BUFFER_SIZE;
+  mrb_bool prefetch = true;
+  mrb_get_args(mrb, "z|ib", &path, &buffer_size, &prefetch);
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_setup(mrb, self, buffer_size);
+  mrb_sdl2_audiostream_open(mrb, stream, SDL_RWFromFile(path, "rb"), prefetch);
+  return self;
+}
+
+/*
+ * SDL2::Audio::Stream::from_memory(data, buffer_size = 262144)
+ * Streams a WAV file held in a String or Buffer. The bytes are copied,
+ * and with nothing to prefetch the reader fills the ring itself.
+ */
+static mrb_value
+mrb_sdl2_audiostream_s_from_memory(mrb_state *mrb, mrb_value klass)
+{
+  mrb_value data;
+  mrb_int buffer_size = AUDIOSTREAM_DEFAULT_BUFFER_SIZE;
+  mrb_get_args(mrb, "o|i", &data, &buffer_size);
+  void const *src;
+  size_t size;
+  if (mrb_string_p(data)) {
+    src  = RSTRING_PTR(data);
+    size = (size_t)RSTRING_LEN(data);
+  } else {
+    src = mrb_sdl2_buffer_get_ptr(mrb, data, &size);
+  }
+  if ((size_t)SDL_MAX_SINT32 < size) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "data is too large.");
+  }
+
+  mrb_value const self = mrb_obj_value(Data_Wrap_Struct(mrb, class_Stream, &mrb_sdl2_audiostream_data_type, NULL));
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_setup(mrb, self, buffer_size);
+  stream->memory = mrb_malloc(mrb, (0 < size) ? size : 1);
+  if (NULL == stream->memory) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_memcpy(stream->memory, src, size);
+  mrb_sdl2_audiostream_open(mrb, stream, SDL_RWFromConstMem(stream->memory, (int)size), false);
+  return self;
+}
+
+SDL_AudioSpec const *
+mrb_sdl2_audiostream_spec(mrb_sdl2_audiostream_t const *stream)
+{
+  return &stream->spec;
+}
+
+static mrb_sdl2_audiostream_t *
+mrb_sdl2_audiostream_self(mrb_state *mrb, mrb_value self)
+{
+  return (mrb_sdl2_audiostream_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_audiostream_data_type);
+}
+
+/*
+ * SDL2::Audio::Stream#read(dst, length)
+ * Copies up to 'length' bytes of PCM into 'dst' (a Buffer or a pointer such
+ * as the one given to the audio callback) and returns the number copied.
+ */
+static mrb_value
+mrb_sdl2_audiostream_read_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_value dst;
+  mrb_int length;
+  mrb_get_args(mrb, "oi", &dst, &length);
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  if (0 > length) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative length.");
+  }
+  Uint8 *ptr = NULL;
+  if (mrb_sdl2_buffer_p(mrb, dst)) {
+    size_t size;
+    ptr = (Uint8*)mrb_sdl2_buffer_get_ptr(mrb, dst, &size);
+    if ((size_t)length > size) {
+      length = (mrb_int)size;
+    }
+  } else if (mrb_type(dst) == MRB_TT_CPTR) {
+    ptr = (Uint8*)mrb_cptr(dst);
+  } else {
+    mrb_raise(mrb, E_TYPE_ERROR, "expected Buffer or pointer.");
+  }
+  return mrb_fixnum_value((mrb_int)mrb_sdl2_audiostream_read(stream, ptr, (Uint32)length));
+}
+
+/*
+ * Moves to a byte offset of the payload, rounded down to a whole frame,
+ * and drops what was buffered.
+ */
+static void
+mrb_sdl2_audiostream_seek_to(mrb_state *mrb, mrb_sdl2_audiostream_t *stream, mrb_int offset)
+{
+  if ((0 > offset) || ((Uint32)offset > (Uint32)SDL_AtomicGet(&stream->data_length))) {
+    mrb_raise(mrb, E_INDEX_ERROR, "offset out of range.");
+  }
+  if (NULL == stream->rw) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "stream is already closed.");
+  }
+  Uint32 const pos = (Uint32)offset - ((Uint32)offset % stream->frame_size);
+  SDL_LockMutex(stream->io_lock);
+  SDL_AtomicLock(&stream->read_lock);
+  SDL_RWseek(stream->rw, stream->data_offset + pos, RW_SEEK_SET);
+  stream->file_pos = pos;
+  stream->position = pos;
+  SDL_AtomicSet(&stream->tail, SDL_AtomicGet(&stream->head));
+  SDL_AtomicSet(&stream->eof, 0);
+  SDL_AtomicUnlock(&stream->read_lock);
+  SDL_UnlockMutex(stream->io_lock);
+  if (NULL != stream->thread) {
+    SDL_SemPost(stream->space);
+  }
+}
+
+static mrb_value
+mrb_sdl2_audiostream_seek(mrb_state *mrb, mrb_value self)
+{
+  mrb_int offset;
+  mrb_get_args(mrb, "i", &offset);
+  mrb_sdl2_audiostream_seek_to(mrb, mrb_sdl2_audiostream_self(mrb, self), offset);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_audiostream_rewind(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_seek_to(mrb, mrb_sdl2_audiostream_self(mrb, self), 0);
+  return self;
+}
+
+/* payload offset of the next byte read. */
+static mrb_value
+mrb_sdl2_audiostream_get_position(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  SDL_AtomicLock(&stream->read_lock);
+  Uint32 const position = stream->position;
+  SDL_AtomicUnlock(&stream->read_lock);
+  return mrb_fixnum_value((mrb_int)position);
+}
+
+static mrb_value
+mrb_sdl2_audiostream_get_length(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  return mrb_fixnum_value((mrb_int)(Uint32)SDL_AtomicGet(&stream->data_length));
+}
+
+/* bytes buffered and ready to be read. */
+static mrb_value
+mrb_sdl2_audiostream_get_available(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  Uint32 const head = (Uint32)SDL_AtomicGet(&stream->head);
+  Uint32 const tail = (Uint32)SDL_AtomicGet(&stream->tail);
+  return mrb_fixnum_value((mrb_int)(head - tail));
+}
+
+static mrb_value
+mrb_sdl2_audiostream_get_spec(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  return mrb_sdl2_audiospec(mrb, &stream->spec);
+}
+
+static mrb_value
+mrb_sdl2_audiostream_is_loop(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  return mrb_bool_value(0 != SDL_AtomicGet(&stream->looping));
+}
+
+/*
+ * SDL2::Audio::Stream#loop=(flag)
+ * Takes effect when the producer next reaches the end of the payload.
+ */
+static mrb_value
+mrb_sdl2_audiostream_set_loop(mrb_state *mrb, mrb_value self)
+{
+  mrb_bool loop;
+  mrb_get_args(mrb, "b", &loop);
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  SDL_LockMutex(stream->io_lock);
+  SDL_AtomicSet(&stream->looping, loop ? 1 : 0);
+  if (loop && (NULL != stream->rw)) {
+    SDL_AtomicSet(&stream->eof, 0);
+  }
+  SDL_UnlockMutex(stream->io_lock);
+  if (NULL != stream->thread) {
+    SDL_SemPost(stream->space);
+  }
+  return self;
+}
+
+/* true once the whole payload has been read. */
+static mrb_value
+mrb_sdl2_audiostream_is_eof(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  bool const drained = (SDL_AtomicGet(&stream->head) == SDL_AtomicGet(&stream->tail));
+  return mrb_bool_value(drained && (0 != SDL_AtomicGet(&stream->eof)));
+}
+
+/*
+ * SDL2::Audio::Stream#close
+ * Stops the prefetch thread and closes the file; what is still buffered
+ * can be read.
+ */
+static mrb_value
+mrb_sdl2_audiostream_close(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_audiostream_t *stream = mrb_sdl2_audiostream_self(mrb, self);
+  mrb_sdl2_audiostream_stop(stream);
+  return self;
+}
+
+
+void
+mruby_sdl2_audiostream_init(mrb_state *mrb)
+{
+  class_Stream = mrb_define_class_under(mrb, mod_Audio, "Stream", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_Stream, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_Stream, "initialize", mrb_sdl2_audiostream_initialize,    MRB_ARGS_REQ(1) | MRB_ARGS_OPT(2));
+  mrb_define_method(mrb, class_Stream, "read",       mrb_sdl2_audiostream_read_m,        MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_Stream, "seek",       mrb_sdl2_audiostream_seek,          MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_Stream, "rewind",     mrb_sdl2_audiostream_rewind,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "position",   mrb_sdl2_audiostream_get_position,  MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "length",     mrb_sdl2_audiostream_get_length,    MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "available",  mrb_sdl2_audiostream_get_available, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "spec",       mrb_sdl2_audiostream_get_spec,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "loop?",      mrb_sdl2_audiostream_is_loop,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "loop=",      mrb_sdl2_audiostream_set_loop,      MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_Stream, "eof?",       mrb_sdl2_audiostream_is_eof,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Stream, "close",      mrb_sdl2_audiostream_close,         MRB_ARGS_NONE());
+
+  mrb_define_class_method(mrb, class_Stream, "from_memory", mrb_sdl2_audiostream_s_from_memory, MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+}
+
+void
+mruby_sdl2_audiostream_final(mrb_state *mrb)
+{
+}
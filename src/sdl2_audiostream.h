@@ -0,0 +1,32 @@
+#ifndef MRUBY_SDL2_AUDIOSTREAM_H
+#define MRUBY_SDL2_AUDIOSTREAM_H
+
+#include "sdl2.h"
+#include <SDL2/SDL_audio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mrb_sdl2_audiostream_t mrb_sdl2_audiostream_t;
+
+extern void mruby_sdl2_audiostream_init(mrb_state *mrb);
+extern void mruby_sdl2_audiostream_final(mrb_state *mrb);
+
+extern mrb_sdl2_audiostream_t *mrb_sdl2_audiostream_get_ptr(mrb_state *mrb, mrb_value value);
+
+/* format, channel count and rate of the stream's PCM. */
+extern SDL_AudioSpec const *mrb_sdl2_audiostream_spec(mrb_sdl2_audiostream_t const *stream);
+
+/*
+ * copies up to 'len' bytes of buffered PCM (whole sample frames) to 'dst'
+ * and returns the number of bytes copied. does not touch the mruby VM, so
+ * it may be called from the audio callback.
+ */
+extern Uint32 mrb_sdl2_audiostream_read(mrb_sdl2_audiostream_t *stream, Uint8 *dst, Uint32 len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_AUDIOSTREAM_H */
@@ -0,0 +1,686 @@
+#include "sdl2_clipcache.h"
+#include "sdl2_audio.h"
+#include "sdl2_resampler.h"
+#include "mrb_sdl2_buffer.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/string.h"
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_rwops.h>
+
+/*
+ * SDL2::Audio::ClipCache holds sound clips converted once, at load time,
+ * to the format of an audio device.
+ *
+ * Converted PCM is appended to a single arena; clips are addressed by
+ * handle, so unloading only marks the space, and compact() moves live
+ * clips down without changing their handles. Format and channel changes
+ * go through SDL_AudioCVT; rate changes use Audio::Resampler. Scratch
+ * buffers and resamplers are kept between loads.
+ *
+ * The arena may move when it grows, so every access takes the cache's
+ * spinlock. reserve() up front keeps loads from reallocating later.
+ */
+
+#define CLIPCACHE_ALIGN          16
+#define CLIPCACHE_MAX_RESAMPLERS 4
+
+static struct RClass *class_ClipCache = NULL;
+
+typedef struct mrb_sdl2_clipcache_clip_t {
+  size_t   offset;
+  Uint32   length;
+  mrb_bool live;
+} mrb_sdl2_clipcache_clip_t;
+
+typedef struct mrb_sdl2_clipcache_resampler_t {
+  int                   rate;
+  mrb_sdl2_resampler_t *resampler;
+} mrb_sdl2_clipcache_resampler_t;
+
+struct mrb_sdl2_clipcache_t {
+  SDL_AudioSpec                   spec;
+  int                             quality;
+  SDL_SpinLock                    lock;
+  Uint8                          *arena;
+  size_t                          used;     /* arena bytes in use, including unloaded clips. */
+  size_t                          capacity;
+  size_t                          bytes;    /* bytes of live clips. */
+  mrb_sdl2_clipcache_clip_t      *clips;    /* indexed by handle - 1. */
+  Uint32                          clip_count;
+  Uint32                          clip_capacity;
+  Uint8                          *scratch[2];
+  size_t                          scratch_size[2];
+  mrb_sdl2_clipcache_resampler_t  resamplers[CLIPCACHE_MAX_RESAMPLERS];
+};
+
+static void
+mrb_sdl2_clipcache_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_clipcache_t *cache =
+    (mrb_sdl2_clipcache_t*)p;
+  if (NULL != cache) {
+    int i;
+    for (i = 0; i < CLIPCACHE_MAX_RESAMPLERS; ++i) {
+      mrb_sdl2_resampler_destroy(mrb, cache->resamplers[i].resampler);
+    }
+    mrb_free(mrb, cache->scratch[0]);
+    mrb_free(mrb, cache->scratch[1]);
+    mrb_free(mrb, cache->clips);
+    mrb_free(mrb, cache->arena);
+    mrb_free(mrb, cache);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_clipcache_data_type = {
+  "ClipCache", mrb_sdl2_clipcache_data_free
+};
+
+mrb_sdl2_clipcache_t *
+mrb_sdl2_clipcache_get_ptr(mrb_state *mrb, mrb_value value)
+{
+  if (mrb_nil_p(value)) {
+    return NULL;
+  }
+  return (mrb_sdl2_clipcache_t*)mrb_data_get_ptr(mrb, value, &mrb_sdl2_clipcache_data_type);
+}
+
+/* the live clip for 'handle', or NULL; called with the lock held. */
+static mrb_sdl2_clipcache_clip_t const *
+mrb_sdl2_clipcache_find(mrb_sdl2_clipcache_t const *cache, Uint32 handle)
+{
+  if ((0 == handle) || (handle > cache->clip_count) || !cache->clips[handle - 1].live) {
+    return NULL;
+  }
+  return &cache->clips[handle - 1];
+}
+
+Uint32
+mrb_sdl2_clipcache_read(mrb_sdl2_clipcache_t *cache, Uint32 handle, Uint32 pos, Uint8 *dst, Uint32 len)
+{
+  Uint32 n = 0;
+  SDL_AtomicLock(&cache->lock);
+  mrb_sdl2_clipcache_clip_t const *clip = mrb_sdl2_clipcache_find(cache, handle);
+  if ((NULL != clip) && (pos < clip->length)) {
+    n = SDL_min(len, clip->length - pos);
+    SDL_memcpy(dst, cache->arena + clip->offset + pos, n);
+  }
+  SDL_AtomicUnlock(&cache->lock);
+  return n;
+}
+
+Uint32
+mrb_sdl2_clipcache_mix(mrb_sdl2_clipcache_t *cache, Uint32 handle, Uint32 pos, Uint8 *dst, Uint32 len, int volume)
+{
+  Uint32 n = 0;
+  SDL_AtomicLock(&cache->lock);
+  mrb_sdl2_clipcache_clip_t const *clip = mrb_sdl2_clipcache_find(cache, handle);
+  if ((NULL != clip) && (pos < clip->length)) {
+    n = SDL_min(len, clip->length - pos);
+    SDL_MixAudioFormat(dst, cache->arena + clip->offset + pos, cache->spec.format, n, volume);
+  }
+  SDL_AtomicUnlock(&cache->lock);
+  return n;
+}
+
+/* grows scratch buffer 'i' to at least 'size' bytes. */
+static Uint8 *
+mrb_sdl2_clipcache_scratch(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, int i, size_t size)
+{
+  if (cache->scratch_size[i] < size) {
+    Uint8 *p = (Uint8*)mrb_realloc(mrb, cache->scratch[i], size);
+    if (NULL == p) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    cache->scratch[i]      = p;
+    cache->scratch_size[i] = size;
+  }
+  return cache->scratch[i];
+}
+
+/* a resampler from 'rate' to the cache's rate, created on first use. */
+static mrb_sdl2_resampler_t *
+mrb_sdl2_clipcache_resampler(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, int rate)
+{
+  int i;
+  for (i = 0; i < CLIPCACHE_MAX_RESAMPLERS; ++i) {
+    if ((NULL != cache->resamplers[i].resampler) && (rate == cache->resamplers[i].rate)) {
+      mrb_sdl2_resampler_reset(cache->resamplers[i].resampler);
+      return cache->resamplers[i].resampler;
+    }
+  }
+  /* evict the oldest entry. */
+  mrb_sdl2_resampler_t *r =
+    mrb_sdl2_resampler_create(mrb, cache->spec.channels, rate, cache->spec.freq, cache->quality);
+  mrb_sdl2_resampler_destroy(mrb, cache->resamplers[CLIPCACHE_MAX_RESAMPLERS - 1].resampler);
+  for (i = CLIPCACHE_MAX_RESAMPLERS - 1; i > 0; --i) {
+    cache->resamplers[i] = cache->resamplers[i - 1];
+  }
+  cache->resamplers[0].rate      = rate;
+  cache->resamplers[0].resampler = r;
+  return r;
+}
+
+/* swaps '*block' for 'p' under the lock and frees the old block. */
+static void
+mrb_sdl2_clipcache_swap(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, void **block, void *p)
+{
+  SDL_AtomicLock(&cache->lock);
+  void *old = *block;
+  *block = p;
+  SDL_AtomicUnlock(&cache->lock);
+  mrb_free(mrb, old);
+}
+
+/*
+ * Replaces '*block' with a copy grown to 'capacity' bytes. Only this
+ * thread writes the blocks and readers never modify them, so the copy is
+ * made outside the lock; the audio thread only waits for the swap.
+ */
+static void
+mrb_sdl2_clipcache_resize(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, void **block, size_t used, size_t capacity)
+{
+  void *p = mrb_malloc(mrb, capacity);
+  if (NULL == p) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  if (0 < used) {
+    SDL_memcpy(p, *block, used);
+  }
+  mrb_sdl2_clipcache_swap(mrb, cache, block, p);
+}
+
+/* makes room for 'size' more arena bytes. */
+static void
+mrb_sdl2_clipcache_reserve_arena(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, size_t size)
+{
+  if (cache->used + size <= cache->capacity) {
+    return;
+  }
+  size_t capacity = (0 < cache->capacity) ? cache->capacity : 64 * 1024;
+  while (capacity < cache->used + size) {
+    capacity *= 2;
+  }
+  mrb_sdl2_clipcache_resize(mrb, cache, (void**)&cache->arena, cache->used, capacity);
+  cache->capacity = capacity;
+}
+
+/* appends converted PCM as a new clip and returns its handle. */
+static Uint32
+mrb_sdl2_clipcache_append(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, Uint8 const *pcm, Uint32 length)
+{
+  if (cache->clip_count == cache->clip_capacity) {
+    Uint32 const n = (0 < cache->clip_capacity) ? cache->clip_capacity * 2 : 16;
+    mrb_sdl2_clipcache_resize(mrb, cache, (void**)&cache->clips,
+                              sizeof(mrb_sdl2_clipcache_clip_t) * cache->clip_count,
+                              sizeof(mrb_sdl2_clipcache_clip_t) * n);
+    cache->clip_capacity = n;
+  }
+  size_t const padded = ((size_t)length + CLIPCACHE_ALIGN - 1) & ~(size_t)(CLIPCACHE_ALIGN - 1);
+  mrb_sdl2_clipcache_reserve_arena(mrb, cache, padded);
+
+  /* the clip is invisible to readers until 'clip_count' covers it. */
+  mrb_sdl2_clipcache_clip_t *clip = &cache->clips[cache->clip_count];
+  clip->offset = cache->used;
+  clip->length = length;
+  clip->live   = true;
+  SDL_memcpy(cache->arena + clip->offset, pcm, length);
+  SDL_AtomicLock(&cache->lock);
+  cache->used  += padded;
+  cache->bytes += length;
+  Uint32 const handle = ++cache->clip_count;
+  SDL_AtomicUnlock(&cache->lock);
+  return handle;
+}
+
+/*
+ * Converts 'len' bytes of 'spec' PCM to the cache's format and appends
+ * them; returns the handle.
+ */
+static Uint32
+mrb_sdl2_clipcache_load_pcm(mrb_state *mrb, mrb_sdl2_clipcache_t *cache, SDL_AudioSpec const *spec, Uint8 const *pcm, Uint32 len)
+{
+  SDL_AudioSpec const *dev = &cache->spec;
+  if ((spec->format == dev->format) && (spec->channels == dev->channels) && (spec->freq == dev->freq)) {
+    return mrb_sdl2_clipcache_append(mrb, cache, pcm, len);
+  }
+
+  /* to float at the device's channel count, still at the clip's rate. */
+  SDL_AudioCVT cvt;
+  if (0 > SDL_BuildAudioCVT(&cvt, spec->format, spec->channels, spec->freq, AUDIO_F32SYS, dev->channels, spec->freq)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  cvt.len = (int)len;
+  cvt.buf = mrb_sdl2_clipcache_scratch(mrb, cache, 0, (size_t)len * (size_t)cvt.len_mult);
+  SDL_memcpy(cvt.buf, pcm, len);
+  cvt.len_cvt = cvt.len;
+  if (cvt.needed && (0 != SDL_ConvertAudio(&cvt))) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  size_t const frame = sizeof(float) * dev->channels;
+  float *samples = (float*)cvt.buf;
+  Uint32 frames = (Uint32)((size_t)cvt.len_cvt / frame);
+
+  /* to the device's rate. */
+  if (spec->freq != dev->freq) {
+    mrb_sdl2_resampler_t *r = mrb_sdl2_clipcache_resampler(mrb, cache, spec->freq);
+    Uint32 const limit = (Uint32)((Uint64)frames * (Uint64)dev->freq / (Uint64)spec->freq + 2);
+    float *out = (float*)mrb_sdl2_clipcache_scratch(mrb, cache, 1, frame * limit);
+    Uint32 consumed;
+    Uint32 produced = mrb_sdl2_resampler_process(r, samples, frames, &consumed, out, limit);
+    produced += mrb_sdl2_resampler_drain(r, out + (size_t)produced * dev->channels, limit - produced);
+    samples = out;
+    frames  = produced;
+  }
+
+  /* to the device's sample format, in place. */
+  SDL_AudioCVT out;
+  if (0 > SDL_BuildAudioCVT(&out, AUDIO_F32SYS, dev->channels, dev->freq, dev->format, dev->channels, dev->freq)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  out.buf     = (Uint8*)samples;
+  out.len     = (int)(frames * frame);
+  out.len_cvt = out.len;
+  if (out.needed && (0 != SDL_ConvertAudio(&out))) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_sdl2_clipcache_append(mrb, cache, out.buf, (Uint32)out.len_cvt);
+}
+
+/***************************************************************************
+*
+* class SDL2::Audio::ClipCache
+*
+***************************************************************************/
+
+/*
+ * SDL2::Audio::ClipCache#initialize(spec, quality = Resampler::MEDIUM)
+ * 'spec' is normally the obtained AudioDevice#spec.
+ */
+static mrb_value
+mrb_sdl2_clipcache_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value spec;
+  mrb_int quality = MRB_SDL2_RESAMPLER_MEDIUM;
+  mrb_get_args(mrb, "o|i", &spec, &quality);
+  SDL_AudioSpec const *s = mrb_sdl2_audiospec_get_ptr(mrb, spec);
+  if (NULL == s) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "1st argument cannot be set to null.");
+  }
+  if ((0 >= s->freq) || (0 == s->channels) || (0 == SDL_AUDIO_BITSIZE(s->format))) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "incomplete audio spec.");
+  }
+  if ((MRB_SDL2_RESAMPLER_LOW > quality) || (MRB_SDL2_RESAMPLER_BEST < quality)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown quality.");
+  }
+
+  mrb_sdl2_clipcache_t *cache =
+    (mrb_sdl2_clipcache_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_clipcache_t));
+  if (NULL == cache) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_zerop(cache);
+  cache->spec          = *s;
+  cache->spec.callback = NULL;
+  cache->spec.userdata = NULL;
+  cache->quality       = (int)quality;
+
+  if (NULL != DATA_PTR(self)) {
+    mrb_sdl2_clipcache_data_free(mrb, DATA_PTR(self));
+  }
+  DATA_PTR(self)  = cache;
+  DATA_TYPE(self) = &mrb_sdl2_clipcache_data_type;
+  return self;
+}
+
+static mrb_sdl2_clipcache_t *
+mrb_sdl2_clipcache_self(mrb_state *mrb, mrb_value self)
+{
+  return (mrb_sdl2_clipcache_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_clipcache_data_type);
+}
+
+/*
+ * SDL2::Audio::ClipCache#load(source)
+ * 'source' is an AudioData or the path of a WAV file. Returns the handle.
+ */
+static mrb_value
+mrb_sdl2_clipcache_load(mrb_state *mrb, mrb_value self)
+{
+  mrb_value source;
+  mrb_get_args(mrb, "o", &source);
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  SDL_AudioSpec spec;
+  Uint8 *pcm;
+  Uint32 len;
+  Uint32 handle;
+  if (mrb_string_p(source)) {
+    /* an AudioData owned by the VM, so a failed conversion does not leak the WAV. */
+    mrb_value const data =
+      mrb_sdl2_audiodata_from_rw(mrb, SDL_RWFromFile(RSTRING_PTR(source), "rb"), 1);
+    pcm = mrb_sdl2_audiodata_get_ptr(mrb, data, &len, &spec);
+    handle = mrb_sdl2_clipcache_load_pcm(mrb, cache, &spec, pcm, len);
+    mrb_funcall(mrb, data, "destroy", 0);
+  } else {
+    pcm = mrb_sdl2_audiodata_get_ptr(mrb, source, &len, &spec);
+    if (NULL == pcm) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "given argument has no audio buffer.");
+    }
+    handle = mrb_sdl2_clipcache_load_pcm(mrb, cache, &spec, pcm, len);
+  }
+  return mrb_fixnum_value((mrb_int)handle);
+}
+
+static Uint32
+mrb_sdl2_clipcache_handle(mrb_state *mrb, mrb_int handle)
+{
+  if ((0 >= handle) || ((mrb_int)0xFFFFFFFF < handle)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid clip handle.");
+  }
+  return (Uint32)handle;
+}
+
+/*
+ * SDL2::Audio::ClipCache#unload(handle)
+ * The space is reused by compact(); handles are never reused.
+ */
+static mrb_value
+mrb_sdl2_clipcache_unload(mrb_state *mrb, mrb_value self)
+{
+  mrb_int handle;
+  mrb_get_args(mrb, "i", &handle);
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  Uint32 const h = mrb_sdl2_clipcache_handle(mrb, handle);
+  mrb_bool found = false;
+  SDL_AtomicLock(&cache->lock);
+  if (NULL != mrb_sdl2_clipcache_find(cache, h)) {
+    cache->clips[h - 1].live = false;
+    cache->bytes -= cache->clips[h - 1].length;
+    found = true;
+  }
+  SDL_AtomicUnlock(&cache->lock);
+  return mrb_bool_value(found);
+}
+
+static mrb_value
+mrb_sdl2_clipcache_is_loaded(mrb_state *mrb, mrb_value self)
+{
+  mrb_int handle;
+  mrb_get_args(mrb, "i", &handle);
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  return mrb_bool_value((0 < handle) && (NULL != mrb_sdl2_clipcache_find(cache, (Uint32)handle)));
+}
+
+/* SDL2::Audio::ClipCache#length(handle): clip size in bytes. */
+static mrb_value
+mrb_sdl2_clipcache_get_length(mrb_state *mrb, mrb_value self)
+{
+  mrb_int handle;
+  mrb_get_args(mrb, "i", &handle);
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  mrb_sdl2_clipcache_clip_t const *clip = mrb_sdl2_clipcache_find(cache, mrb_sdl2_clipcache_handle(mrb, handle));
+  if (NULL == clip) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid clip handle.");
+  }
+  return mrb_fixnum_value((mrb_int)clip->length);
+}
+
+/* a pointer or Buffer destination, as for Audio.mix_audio; 'len' is clamped to a Buffer. */
+static Uint8 *
+mrb_sdl2_clipcache_destination(mrb_state *mrb, mrb_value dst, mrb_int dpos, mrb_int *len)
+{
+  if ((0 > dpos) || (0 > *len)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative position or length.");
+  }
+  if (mrb_type(dst) == MRB_TT_CPTR) {
+    return (Uint8*)mrb_cptr(dst) + dpos;
+  }
+  if (mrb_sdl2_buffer_p(mrb, dst)) {
+    size_t sz;
+    Uint8 *ptr = (Uint8*)mrb_sdl2_buffer_get_ptr(mrb, dst, &sz);
+    if ((size_t)dpos > sz) {
+      *len = 0;
+      return ptr;
+    }
+    if ((size_t)*len > sz - (size_t)dpos) {
+      *len = (mrb_int)(sz - (size_t)dpos);
+    }
+    return ptr + dpos;
+  }
+  mrb_raise(mrb, E_TYPE_ERROR, "expected Buffer or pointer.");
+  return NULL;
+}
+
+/*
+ * SDL2::Audio::ClipCache#read(dst, dpos, handle, spos, len)
+ * Copies clip bytes into 'dst' and returns the number copied.
+ */
+static mrb_value
+mrb_sdl2_clipcache_read_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_value dst;
+  mrb_int dpos, handle, spos, len;
+  mrb_get_args(mrb, "oiiii", &dst, &dpos, &handle, &spos, &len);
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  Uint8 *ptr = mrb_sdl2_clipcache_destination(mrb, dst, dpos, &len);
+  if (0 > spos) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative position or length.");
+  }
+  Uint32 const n =
+    mrb_sdl2_clipcache_read(cache, mrb_sdl2_clipcache_handle(mrb, handle), (Uint32)spos, ptr, (Uint32)len);
+  return mrb_fixnum_value((mrb_int)n);
+}
+
+/*
+ * SDL2::Audio::ClipCache#mix(dst, dpos, handle, spos, len, volume = SDL_MIX_MAXVOLUME)
+ * Arguments follow Audio.mix_audio; returns the number of bytes mixed.
+ */
+static mrb_value
+mrb_sdl2_clipcache_mix_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_value dst;
+  mrb_int dpos, handle, spos, len;
+  mrb_int volume = SDL_MIX_MAXVOLUME;
+  mrb_get_args(mrb, "oiiii|i", &dst, &dpos, &handle, &spos, &len, &volume);
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  Uint8 *ptr = mrb_sdl2_clipcache_destination(mrb, dst, dpos, &len);
+  if (0 > spos) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative position or length.");
+  }
+  Uint32 const n =
+    mrb_sdl2_clipcache_mix(cache, mrb_sdl2_clipcache_handle(mrb, handle), (Uint32)spos, ptr, (Uint32)len, (int)volume);
+  return mrb_fixnum_value((mrb_int)n);
+}
+
+/*
+ * SDL2::Audio::ClipCache#reserve(bytes)
+ * Grows the arena so that 'bytes' more can be loaded without moving it.
+ */
+static mrb_value
+mrb_sdl2_clipcache_reserve(mrb_state *mrb, mrb_value self)
+{
+  mrb_int bytes;
+  mrb_get_args(mrb, "i", &bytes);
+  if (0 > bytes) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative size.");
+  }
+  mrb_sdl2_clipcache_reserve_arena(mrb, mrb_sdl2_clipcache_self(mrb, self), (size_t)bytes);
+  return self;
+}
+
+/*
+ * SDL2::Audio::ClipCache#compact
+ * Moves live clips over the space of unloaded ones; handles stay valid.
+ * The clips are packed into a fresh arena and clip table outside the
+ * lock, so the audio thread only waits for the pointer swap.
+ */
+static mrb_value
+mrb_sdl2_clipcache_compact(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  size_t used = 0;
+  Uint32 i;
+  for (i = 0; i < cache->clip_count; ++i) {
+    if (cache->clips[i].live) {
+      used += ((size_t)cache->clips[i].length + CLIPCACHE_ALIGN - 1) & ~(size_t)(CLIPCACHE_ALIGN - 1);
+    }
+  }
+  if (used == cache->used) {
+    /* no unloaded clip sits in the arena. */
+    return self;
+  }
+  size_t const table_size = sizeof(mrb_sdl2_clipcache_clip_t) * cache->clip_capacity;
+  mrb_sdl2_clipcache_clip_t *clips = (mrb_sdl2_clipcache_clip_t*)mrb_malloc(mrb, table_size);
+  if (NULL == clips) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  /* mrb_malloc_simple() returns NULL instead of raising, so 'clips' is not leaked. */
+  Uint8 *arena = (Uint8*)mrb_malloc_simple(mrb, cache->capacity);
+  if (NULL == arena) {
+    mrb_free(mrb, clips);
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  used = 0;
+  for (i = 0; i < cache->clip_count; ++i) {
+    clips[i] = cache->clips[i];
+    if (!clips[i].live) {
+      continue;
+    }
+    SDL_memcpy(arena + used, cache->arena + clips[i].offset, clips[i].length);
+    clips[i].offset = used;
+    used += ((size_t)clips[i].length + CLIPCACHE_ALIGN - 1) & ~(size_t)(CLIPCACHE_ALIGN - 1);
+  }
+  SDL_AtomicLock(&cache->lock);
+  Uint8 *old_arena = cache->arena;
+  mrb_sdl2_clipcache_clip_t *old_clips = cache->clips;
+  cache->arena = arena;
+  cache->clips = clips;
+  cache->used  = used;
+  SDL_AtomicUnlock(&cache->lock);
+  mrb_free(mrb, old_arena);
+  mrb_free(mrb, old_clips);
+  return self;
+}
+
+/* SDL2::Audio::ClipCache#clear: unloads every clip, keeping the arena. */
+static mrb_value
+mrb_sdl2_clipcache_clear(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  Uint32 i;
+  SDL_AtomicLock(&cache->lock);
+  for (i = 0; i < cache->clip_count; ++i) {
+    cache->clips[i].live = false;
+  }
+  cache->used  = 0;
+  cache->bytes = 0;
+  SDL_AtomicUnlock(&cache->lock);
+  return self;
+}
+
+/* number of loaded clips. */
+static mrb_value
+mrb_sdl2_clipcache_get_count(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  mrb_int n = 0;
+  Uint32 i;
+  for (i = 0; i < cache->clip_count; ++i) {
+    if (cache->clips[i].live) {
+      ++n;
+    }
+  }
+  return mrb_fixnum_value(n);
+}
+
+/* byte counts saturate rather than wrap where mrb_int is narrower than size_t. */
+static mrb_value
+mrb_sdl2_clipcache_size_value(size_t n)
+{
+  return mrb_fixnum_value(((size_t)MRB_INT_MAX < n) ? MRB_INT_MAX : (mrb_int)n);
+}
+
+/* bytes of PCM held by loaded clips. */
+static mrb_value
+mrb_sdl2_clipcache_get_bytes(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_clipcache_size_value(mrb_sdl2_clipcache_self(mrb, self)->bytes);
+}
+
+/* arena bytes in use, including space left by unloaded clips until compact(). */
+static mrb_value
+mrb_sdl2_clipcache_get_used(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_clipcache_size_value(mrb_sdl2_clipcache_self(mrb, self)->used);
+}
+
+static mrb_value
+mrb_sdl2_clipcache_get_capacity(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_clipcache_size_value(mrb_sdl2_clipcache_self(mrb, self)->capacity);
+}
+
+/* every byte the cache owns: arena, clip table, scratch buffers. */
+static mrb_value
+mrb_sdl2_clipcache_get_memory(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_clipcache_t const *cache = mrb_sdl2_clipcache_self(mrb, self);
+  size_t const total = cache->capacity +
+                       sizeof(mrb_sdl2_clipcache_clip_t) * cache->clip_capacity +
+                       cache->scratch_size[0] + cache->scratch_size[1];
+  return mrb_sdl2_clipcache_size_value(total);
+}
+
+/*
+ * SDL2::Audio::ClipCache#release_scratch
+ * Frees the conversion buffers once loading is done.
+ */
+static mrb_value
+mrb_sdl2_clipcache_release_scratch(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_clipcache_t *cache = mrb_sdl2_clipcache_self(mrb, self);
+  int i;
+  for (i = 0; i < 2; ++i) {
+    mrb_free(mrb, cache->scratch[i]);
+    cache->scratch[i]      = NULL;
+    cache->scratch_size[i] = 0;
+  }
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_clipcache_get_spec(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_audiospec(mrb, &mrb_sdl2_clipcache_self(mrb, self)->spec);
+}
+
+
+void
+mruby_sdl2_clipcache_init(mrb_state *mrb)
+{
+  class_ClipCache = mrb_define_class_under(mrb, mod_Audio, "ClipCache", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_ClipCache, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_ClipCache, "initialize",      mrb_sdl2_clipcache_initialize,      MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_ClipCache, "load",            mrb_sdl2_clipcache_load,            MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_ClipCache, "unload",          mrb_sdl2_clipcache_unload,          MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_ClipCache, "loaded?",         mrb_sdl2_clipcache_is_loaded,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_ClipCache, "length",          mrb_sdl2_clipcache_get_length,      MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_ClipCache, "read",            mrb_sdl2_clipcache_read_m,          MRB_ARGS_REQ(5));
+  mrb_define_method(mrb, class_ClipCache, "mix",             mrb_sdl2_clipcache_mix_m,           MRB_ARGS_REQ(5) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_ClipCache, "reserve",         mrb_sdl2_clipcache_reserve,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_ClipCache, "compact",         mrb_sdl2_clipcache_compact,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "clear",           mrb_sdl2_clipcache_clear,           MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "release_scratch", mrb_sdl2_clipcache_release_scratch, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "count",           mrb_sdl2_clipcache_get_count,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "bytes",           mrb_sdl2_clipcache_get_bytes,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "used",            mrb_sdl2_clipcache_get_used,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "capacity",        mrb_sdl2_clipcache_get_capacity,    MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "memory",          mrb_sdl2_clipcache_get_memory,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_ClipCache, "spec",            mrb_sdl2_clipcache_get_spec,        MRB_ARGS_NONE());
+}
+
+void
+mruby_sdl2_clipcache_final(mrb_state *mrb)
+{
+}
@@ -0,0 +1,31 @@
+#ifndef MRUBY_SDL2_CLIPCACHE_H
+#define MRUBY_SDL2_CLIPCACHE_H
+
+#include "sdl2.h"
+#include <SDL2/SDL_audio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mrb_sdl2_clipcache_t mrb_sdl2_clipcache_t;
+
+extern void mruby_sdl2_clipcache_init(mrb_state *mrb);
+extern void mruby_sdl2_clipcache_final(mrb_state *mrb);
+
+extern mrb_sdl2_clipcache_t *mrb_sdl2_clipcache_get_ptr(mrb_state *mrb, mrb_value value);
+
+/*
+ * copy or mix up to 'len' bytes of clip 'handle' from byte 'pos' on into
+ * 'dst' and return the number of bytes used; 0 for an unknown handle.
+ * the clip is in the cache's format. neither function touches the VM,
+ * so both may be called from the audio callback.
+ */
+extern Uint32 mrb_sdl2_clipcache_read(mrb_sdl2_clipcache_t *cache, Uint32 handle, Uint32 pos, Uint8 *dst, Uint32 len);
+extern Uint32 mrb_sdl2_clipcache_mix(mrb_sdl2_clipcache_t *cache, Uint32 handle, Uint32 pos, Uint8 *dst, Uint32 len, int volume);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_CLIPCACHE_H */
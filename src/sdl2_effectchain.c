@@ -0,0 +1,729 @@
+#include "sdl2_effectchain.h"
+#include "sdl2_audio.h"
+#include "float_kernels.h"
+#include "mrb_sdl2_buffer.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include <SDL2/SDL_atomic.h>
+#include <math.h>
+
+/*
+ * SDL2::Audio::EffectChain runs native processors (gain, biquad filters,
+ * delay, compressor) over audio buffers in place.
+ *
+ * Parameters are written from Ruby as float bits in atomics, and each
+ * write bumps the effect's version; the audio thread re-derives its
+ * coefficients when it sees a new version, so a write never blocks on
+ * the callback. The effect list itself only changes under the chain's
+ * spinlock, which process() holds for the whole pass.
+ *
+ * Samples are processed as floats in blocks; S16 buffers go through a
+ * scratch block kept in the chain, so processing never allocates.
+ */
+
+#define EFFECTCHAIN_MAX_EFFECTS  16
+#define EFFECTCHAIN_MAX_CHANNELS 8
+#define EFFECTCHAIN_BLOCK        256 /* frames per pass. */
+
+static struct RClass *class_EffectChain = NULL;
+
+enum {
+  EFFECT_GAIN,
+  EFFECT_LOWPASS,
+  EFFECT_HIGHPASS,
+  EFFECT_DELAY,
+  EFFECT_COMPRESSOR,
+};
+
+enum {
+  PARAM_GAIN,      /* linear. */
+  PARAM_RAMP,      /* seconds a gain change takes. */
+  PARAM_FREQUENCY, /* Hz. */
+  PARAM_Q,
+  PARAM_TIME,      /* seconds. */
+  PARAM_FEEDBACK,
+  PARAM_MIX,       /* 0 dry .. 1 wet. */
+  PARAM_THRESHOLD, /* dBFS. */
+  PARAM_RATIO,
+  PARAM_ATTACK,    /* seconds. */
+  PARAM_RELEASE,   /* seconds. */
+  PARAM_MAKEUP,    /* dB. */
+  PARAM_COUNT
+};
+
+#define PARAM_BIT(p) (1u << (p))
+
+/* parameters each effect accepts, indexed by kind. */
+static Uint32 const mrb_sdl2_effectchain_param_masks[] = {
+  PARAM_BIT(PARAM_GAIN) | PARAM_BIT(PARAM_RAMP),
+  PARAM_BIT(PARAM_FREQUENCY) | PARAM_BIT(PARAM_Q),
+  PARAM_BIT(PARAM_FREQUENCY) | PARAM_BIT(PARAM_Q),
+  PARAM_BIT(PARAM_TIME) | PARAM_BIT(PARAM_FEEDBACK) | PARAM_BIT(PARAM_MIX),
+  PARAM_BIT(PARAM_THRESHOLD) | PARAM_BIT(PARAM_RATIO) | PARAM_BIT(PARAM_ATTACK) |
+    PARAM_BIT(PARAM_RELEASE) | PARAM_BIT(PARAM_MAKEUP),
+};
+
+typedef struct mrb_sdl2_effect_t {
+  int          kind;
+  SDL_atomic_t params[PARAM_COUNT]; /* float bits. */
+  SDL_atomic_t version;
+  SDL_atomic_t bypass;
+  /* state below is owned by the processing thread. */
+  int          seen;                /* version the derived values come from. */
+  float        gain;                /* GAIN: current gain. */
+  float        target;
+  float        step;
+  float        b0, b1, b2, a1, a2;  /* LOWPASS, HIGHPASS */
+  float        z1[EFFECTCHAIN_MAX_CHANNELS];
+  float        z2[EFFECTCHAIN_MAX_CHANNELS];
+  float       *line;                /* DELAY: interleaved frames. */
+  Uint32       line_frames;
+  Uint32       line_pos;
+  Uint32       delay;
+  float        feedback;
+  float        mix;
+  float        envelope;            /* COMPRESSOR */
+  float        attack;
+  float        release;
+  float        threshold;
+  float        slope;
+  float        makeup;
+} mrb_sdl2_effect_t;
+
+struct mrb_sdl2_effectchain_t {
+  int                freq;
+  int                channels;
+  SDL_AudioFormat    format;
+  SDL_SpinLock       lock;
+  mrb_sdl2_effect_t *effects[EFFECTCHAIN_MAX_EFFECTS];
+  int                count;
+  float              scratch[EFFECTCHAIN_BLOCK * EFFECTCHAIN_MAX_CHANNELS];
+};
+
+static float
+mrb_sdl2_effectchain_param(mrb_sdl2_effect_t *effect, int param)
+{
+  union { int i; float f; } bits;
+  bits.i = SDL_AtomicGet(&effect->params[param]);
+  return bits.f;
+}
+
+static void
+mrb_sdl2_effectchain_set_param(mrb_sdl2_effect_t *effect, int param, float value)
+{
+  union { int i; float f; } bits;
+  bits.f = value;
+  SDL_AtomicSet(&effect->params[param], bits.i);
+  SDL_AtomicAdd(&effect->version, 1);
+}
+
+static void
+mrb_sdl2_effect_free(mrb_state *mrb, mrb_sdl2_effect_t *effect)
+{
+  if (NULL != effect) {
+    mrb_free(mrb, effect->line);
+    mrb_free(mrb, effect);
+  }
+}
+
+static void
+mrb_sdl2_effectchain_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_effectchain_t *chain =
+    (mrb_sdl2_effectchain_t*)p;
+  if (NULL != chain) {
+    int i;
+    for (i = 0; i < chain->count; ++i) {
+      mrb_sdl2_effect_free(mrb, chain->effects[i]);
+    }
+    mrb_free(mrb, chain);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_effectchain_data_type = {
+  "EffectChain", mrb_sdl2_effectchain_data_free
+};
+
+mrb_sdl2_effectchain_t *
+mrb_sdl2_effectchain_get_ptr(mrb_state *mrb, mrb_value value)
+{
+  if (mrb_nil_p(value)) {
+    return NULL;
+  }
+  return (mrb_sdl2_effectchain_t*)mrb_data_get_ptr(mrb, value, &mrb_sdl2_effectchain_data_type);
+}
+
+mrb_bool
+mrb_sdl2_effectchain_accepts(mrb_sdl2_effectchain_t const *chain, SDL_AudioSpec const *spec)
+{
+  return (chain->format == spec->format) && (chain->channels == spec->channels) && (chain->freq == spec->freq);
+}
+
+/***************************************************************************
+*
+* processors
+*
+***************************************************************************/
+
+/* re-derives coefficients after a parameter write. */
+static void
+mrb_sdl2_effect_update(mrb_sdl2_effect_t *e, int freq)
+{
+  int const version = SDL_AtomicGet(&e->version);
+  if (version == e->seen) {
+    return;
+  }
+  e->seen = version;
+
+  switch (e->kind) {
+  case EFFECT_GAIN: {
+    float const ramp = mrb_sdl2_effectchain_param(e, PARAM_RAMP) * (float)freq;
+    e->target = mrb_sdl2_effectchain_param(e, PARAM_GAIN);
+    e->step   = (e->target - e->gain) / ((1.0f < ramp) ? ramp : 1.0f);
+    break;
+  }
+  case EFFECT_LOWPASS:
+  case EFFECT_HIGHPASS: {
+    /* RBJ audio EQ cookbook. */
+    double const f  = SDL_min(SDL_max((double)mrb_sdl2_effectchain_param(e, PARAM_FREQUENCY), 10.0), 0.49 * freq);
+    double const q  = SDL_max((double)mrb_sdl2_effectchain_param(e, PARAM_Q), 0.1);
+    double const w0 = 2.0 * M_PI * f / (double)freq;
+    double const cw = cos(w0);
+    double const alpha = sin(w0) / (2.0 * q);
+    double const a0 = 1.0 + alpha;
+    if (EFFECT_LOWPASS == e->kind) {
+      e->b0 = (float)((1.0 - cw) / 2.0 / a0);
+      e->b1 = (float)((1.0 - cw) / a0);
+    } else {
+      e->b0 = (float)((1.0 + cw) / 2.0 / a0);
+      e->b1 = (float)(-(1.0 + cw) / a0);
+    }
+    e->b2 = e->b0;
+    e->a1 = (float)(-2.0 * cw / a0);
+    e->a2 = (float)((1.0 - alpha) / a0);
+    break;
+  }
+  case EFFECT_DELAY: {
+    float const frames = mrb_sdl2_effectchain_param(e, PARAM_TIME) * (float)freq;
+    e->delay    = (Uint32)SDL_min(SDL_max(frames + 0.5f, 1.0f), (float)e->line_frames);
+    e->feedback = SDL_min(SDL_max(mrb_sdl2_effectchain_param(e, PARAM_FEEDBACK), 0.0f), 0.99f);
+    e->mix      = SDL_min(SDL_max(mrb_sdl2_effectchain_param(e, PARAM_MIX), 0.0f), 1.0f);
+    break;
+  }
+  case EFFECT_COMPRESSOR: {
+    float const ratio   = SDL_max(mrb_sdl2_effectchain_param(e, PARAM_RATIO), 1.0f);
+    float const attack  = SDL_max(mrb_sdl2_effectchain_param(e, PARAM_ATTACK), 1e-4f);
+    float const release = SDL_max(mrb_sdl2_effectchain_param(e, PARAM_RELEASE), 1e-4f);
+    e->threshold = mrb_sdl2_effectchain_param(e, PARAM_THRESHOLD);
+    e->slope     = 1.0f - 1.0f / ratio;
+    e->attack    = expf(-1.0f / (attack * (float)freq));
+    e->release   = expf(-1.0f / (release * (float)freq));
+    e->makeup    = powf(10.0f, mrb_sdl2_effectchain_param(e, PARAM_MAKEUP) / 20.0f);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static void
+mrb_sdl2_effect_gain(mrb_sdl2_effect_t *e, float *x, Uint32 frames, int channels)
+{
+  Uint32 i = 0;
+  int c;
+  /* ramp frame by frame until the target is reached, then scale the rest at once. */
+  for (; (i < frames) && (e->gain != e->target); ++i) {
+    e->gain += e->step;
+    if (((0.0f < e->step) && (e->gain > e->target)) || ((0.0f > e->step) && (e->gain < e->target)) || (0.0f == e->step)) {
+      e->gain = e->target;
+    }
+    for (c = 0; c < channels; ++c) {
+      x[i * channels + c] *= e->gain;
+    }
+  }
+  if ((i < frames) && (1.0f != e->gain)) {
+    mrb_sdl2_float_kernels_scale(x + (size_t)i * channels, (size_t)(frames - i) * channels, e->gain);
+  }
+}
+
+static void
+mrb_sdl2_effect_biquad(mrb_sdl2_effect_t *e, float *x, Uint32 frames, int channels)
+{
+  int c;
+  Uint32 i;
+  for (c = 0; c < channels; ++c) {
+    float z1 = e->z1[c];
+    float z2 = e->z2[c];
+    for (i = 0; i < frames; ++i) {
+      float const in  = x[i * channels + c];
+      float const out = e->b0 * in + z1;
+      z1 = e->b1 * in - e->a1 * out + z2;
+      z2 = e->b2 * in - e->a2 * out;
+      x[i * channels + c] = out;
+    }
+    e->z1[c] = z1;
+    e->z2[c] = z2;
+  }
+}
+
+static void
+mrb_sdl2_effect_delay(mrb_sdl2_effect_t *e, float *x, Uint32 frames, int channels)
+{
+  Uint32 i;
+  int c;
+  for (i = 0; i < frames; ++i) {
+    Uint32 const read = (e->line_pos + e->line_frames - e->delay) % e->line_frames;
+    float *w = e->line + (size_t)e->line_pos * channels;
+    float const *r = e->line + (size_t)read * channels;
+    for (c = 0; c < channels; ++c) {
+      float const in = x[i * channels + c];
+      float const delayed = r[c];
+      x[i * channels + c] = in + (delayed - in) * e->mix;
+      w[c] = in + delayed * e->feedback;
+    }
+    if (++e->line_pos == e->line_frames) {
+      e->line_pos = 0;
+    }
+  }
+}
+
+static void
+mrb_sdl2_effect_compressor(mrb_sdl2_effect_t *e, float *x, Uint32 frames, int channels)
+{
+  Uint32 i;
+  int c;
+  for (i = 0; i < frames; ++i) {
+    float *frame = x + (size_t)i * channels;
+    float peak = 0.0f;
+    for (c = 0; c < channels; ++c) {
+      peak = SDL_max(peak, fabsf(frame[c]));
+    }
+    float const coef = (peak > e->envelope) ? e->attack : e->release;
+    e->envelope = peak + (e->envelope - peak) * coef;
+    float gain = e->makeup;
+    float const level = 20.0f * log10f(e->envelope + 1e-9f);
+    if (level > e->threshold) {
+      gain *= powf(10.0f, (e->threshold - level) * e->slope / 20.0f);
+    }
+    for (c = 0; c < channels; ++c) {
+      frame[c] *= gain;
+    }
+  }
+}
+
+static void
+mrb_sdl2_effectchain_run(mrb_sdl2_effectchain_t *chain, float *x, Uint32 frames)
+{
+  int i;
+  for (i = 0; i < chain->count; ++i) {
+    mrb_sdl2_effect_t *e = chain->effects[i];
+    mrb_sdl2_effect_update(e, chain->freq);
+    if (SDL_AtomicGet(&e->bypass)) {
+      continue;
+    }
+    switch (e->kind) {
+    case EFFECT_GAIN:
+      mrb_sdl2_effect_gain(e, x, frames, chain->channels);
+      break;
+    case EFFECT_LOWPASS:
+    case EFFECT_HIGHPASS:
+      mrb_sdl2_effect_biquad(e, x, frames, chain->channels);
+      break;
+    case EFFECT_DELAY:
+      mrb_sdl2_effect_delay(e, x, frames, chain->channels);
+      break;
+    case EFFECT_COMPRESSOR:
+      mrb_sdl2_effect_compressor(e, x, frames, chain->channels);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void
+mrb_sdl2_effectchain_process(mrb_sdl2_effectchain_t *chain, Uint8 *buf, Uint32 len)
+{
+  int const channels = chain->channels;
+  Uint32 const sample_size = SDL_AUDIO_BITSIZE(chain->format) / 8;
+  Uint32 const frames = len / (sample_size * (Uint32)channels);
+  Uint32 offset, i;
+
+  SDL_AtomicLock(&chain->lock);
+  if (0 < chain->count) {
+    for (offset = 0; offset < frames; offset += EFFECTCHAIN_BLOCK) {
+      Uint32 const n = SDL_min(frames - offset, EFFECTCHAIN_BLOCK);
+      Uint32 const samples = n * (Uint32)channels;
+      if (AUDIO_F32SYS == chain->format) {
+        mrb_sdl2_effectchain_run(chain, (float*)buf + (size_t)offset * channels, n);
+        continue;
+      }
+      Sint16 *s = (Sint16*)buf + (size_t)offset * channels;
+      for (i = 0; i < samples; ++i) {
+        chain->scratch[i] = (float)s[i] * (1.0f / 32768.0f);
+      }
+      mrb_sdl2_effectchain_run(chain, chain->scratch, n);
+      for (i = 0; i < samples; ++i) {
+        float const v = chain->scratch[i] * 32768.0f;
+        s[i] = (Sint16)((32767.0f < v) ? 32767 : ((-32768.0f > v) ? -32768 : (int)lrintf(v)));
+      }
+    }
+  }
+  SDL_AtomicUnlock(&chain->lock);
+}
+
+/***************************************************************************
+*
+* class SDL2::Audio::EffectChain
+*
+***************************************************************************/
+
+/*
+ * SDL2::Audio::EffectChain#initialize(spec)
+ * 'spec' gives the rate, channels and format of the buffers processed;
+ * AUDIO_F32SYS and AUDIO_S16SYS are supported.
+ */
+static mrb_value
+mrb_sdl2_effectchain_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value spec;
+  mrb_get_args(mrb, "o", &spec);
+  SDL_AudioSpec const *s = mrb_sdl2_audiospec_get_ptr(mrb, spec);
+  if (NULL == s) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "1st argument cannot be set to null.");
+  }
+  if ((AUDIO_F32SYS != s->format) && (AUDIO_S16SYS != s->format)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unsupported audio format.");
+  }
+  if ((0 >= s->freq) || (0 == s->channels) || (EFFECTCHAIN_MAX_CHANNELS < s->channels)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unsupported audio spec.");
+  }
+  if (NULL != DATA_PTR(self)) {
+    /* an AudioSpec may run this chain on the audio thread. */
+    mrb_raise(mrb, E_RUNTIME_ERROR, "effect chain is already initialized.");
+  }
+  mrb_sdl2_effectchain_t *chain =
+    (mrb_sdl2_effectchain_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_effectchain_t));
+  if (NULL == chain) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_zerop(chain);
+  chain->freq     = s->freq;
+  chain->channels = s->channels;
+  chain->format   = s->format;
+  DATA_PTR(self)  = chain;
+  DATA_TYPE(self) = &mrb_sdl2_effectchain_data_type;
+  return self;
+}
+
+static mrb_sdl2_effectchain_t *
+mrb_sdl2_effectchain_self(mrb_state *mrb, mrb_value self)
+{
+  return (mrb_sdl2_effectchain_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_effectchain_data_type);
+}
+
+/* allocates an effect of 'kind' with a 'line_frames' delay line. */
+static mrb_sdl2_effect_t *
+mrb_sdl2_effectchain_new_effect(mrb_state *mrb, mrb_sdl2_effectchain_t *chain, int kind, Uint32 line_frames)
+{
+  if (EFFECTCHAIN_MAX_EFFECTS <= chain->count) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "too many effects.");
+  }
+  mrb_sdl2_effect_t *e = (mrb_sdl2_effect_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_effect_t));
+  if (NULL == e) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_zerop(e);
+  e->kind = kind;
+  e->seen = -1;
+  e->gain = 1.0f;
+  if (0 < line_frames) {
+    e->line = (float*)mrb_malloc(mrb, sizeof(float) * line_frames * (size_t)chain->channels);
+    if (NULL == e->line) {
+      mrb_free(mrb, e);
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    SDL_memset(e->line, 0, sizeof(float) * line_frames * (size_t)chain->channels);
+    e->line_frames = line_frames;
+  }
+  return e;
+}
+
+/* publishes a configured effect and returns its index. */
+static mrb_value
+mrb_sdl2_effectchain_push(mrb_sdl2_effectchain_t *chain, mrb_sdl2_effect_t *e)
+{
+  SDL_AtomicLock(&chain->lock);
+  int const index = chain->count;
+  chain->effects[chain->count++] = e;
+  SDL_AtomicUnlock(&chain->lock);
+  return mrb_fixnum_value(index);
+}
+
+/* SDL2::Audio::EffectChain#add_gain(gain = 1.0, ramp = 0.0) */
+static mrb_value
+mrb_sdl2_effectchain_add_gain(mrb_state *mrb, mrb_value self)
+{
+  mrb_float gain = 1.0, ramp = 0.0;
+  mrb_get_args(mrb, "|ff", &gain, &ramp);
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_new_effect(mrb, chain, EFFECT_GAIN, 0);
+  e->gain = (float)gain;
+  mrb_sdl2_effectchain_set_param(e, PARAM_GAIN, (float)gain);
+  mrb_sdl2_effectchain_set_param(e, PARAM_RAMP, (float)ramp);
+  return mrb_sdl2_effectchain_push(chain, e);
+}
+
+static mrb_value
+mrb_sdl2_effectchain_add_biquad(mrb_state *mrb, mrb_value self, int kind)
+{
+  mrb_float frequency, q = M_SQRT1_2;
+  mrb_get_args(mrb, "f|f", &frequency, &q);
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_new_effect(mrb, chain, kind, 0);
+  mrb_sdl2_effectchain_set_param(e, PARAM_FREQUENCY, (float)frequency);
+  mrb_sdl2_effectchain_set_param(e, PARAM_Q, (float)q);
+  return mrb_sdl2_effectchain_push(chain, e);
+}
+
+/* SDL2::Audio::EffectChain#add_lowpass(frequency, q = 0.7071) */
+static mrb_value
+mrb_sdl2_effectchain_add_lowpass(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_effectchain_add_biquad(mrb, self, EFFECT_LOWPASS);
+}
+
+/* SDL2::Audio::EffectChain#add_highpass(frequency, q = 0.7071) */
+static mrb_value
+mrb_sdl2_effectchain_add_highpass(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_effectchain_add_biquad(mrb, self, EFFECT_HIGHPASS);
+}
+
+/*
+ * SDL2::Audio::EffectChain#add_delay(time, feedback = 0.3, mix = 0.3, max_time = time)
+ * The delay line is sized for 'max_time' seconds; TIME can be changed
+ * up to that.
+ */
+static mrb_value
+mrb_sdl2_effectchain_add_delay(mrb_state *mrb, mrb_value self)
+{
+  mrb_float time, feedback = 0.3, mix = 0.3, max_time = 0.0;
+  mrb_get_args(mrb, "f|fff", &time, &feedback, &mix, &max_time);
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  double const longest = SDL_max(time, max_time);
+  if ((0.0 >= time) || (60.0 < longest)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "delay time out of range.");
+  }
+  Uint32 const frames = (Uint32)ceil(longest * chain->freq) + 1;
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_new_effect(mrb, chain, EFFECT_DELAY, frames);
+  mrb_sdl2_effectchain_set_param(e, PARAM_TIME, (float)time);
+  mrb_sdl2_effectchain_set_param(e, PARAM_FEEDBACK, (float)feedback);
+  mrb_sdl2_effectchain_set_param(e, PARAM_MIX, (float)mix);
+  return mrb_sdl2_effectchain_push(chain, e);
+}
+
+/*
+ * SDL2::Audio::EffectChain#add_compressor(threshold = -12.0, ratio = 4.0,
+ *                                          attack = 0.01, release = 0.1, makeup = 0.0)
+ * 'threshold' and 'makeup' are in dB; channels share one envelope.
+ */
+static mrb_value
+mrb_sdl2_effectchain_add_compressor(mrb_state *mrb, mrb_value self)
+{
+  mrb_float threshold = -12.0, ratio = 4.0, attack = 0.01, release = 0.1, makeup = 0.0;
+  mrb_get_args(mrb, "|fffff", &threshold, &ratio, &attack, &release, &makeup);
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_new_effect(mrb, chain, EFFECT_COMPRESSOR, 0);
+  mrb_sdl2_effectchain_set_param(e, PARAM_THRESHOLD, (float)threshold);
+  mrb_sdl2_effectchain_set_param(e, PARAM_RATIO, (float)ratio);
+  mrb_sdl2_effectchain_set_param(e, PARAM_ATTACK, (float)attack);
+  mrb_sdl2_effectchain_set_param(e, PARAM_RELEASE, (float)release);
+  mrb_sdl2_effectchain_set_param(e, PARAM_MAKEUP, (float)makeup);
+  return mrb_sdl2_effectchain_push(chain, e);
+}
+
+/* the effect at 'index'; the list only grows or is cleared from this thread. */
+static mrb_sdl2_effect_t *
+mrb_sdl2_effectchain_effect(mrb_state *mrb, mrb_sdl2_effectchain_t *chain, mrb_int index)
+{
+  if ((0 > index) || (chain->count <= index)) {
+    mrb_raise(mrb, E_INDEX_ERROR, "effect index out of range.");
+  }
+  return chain->effects[index];
+}
+
+static int
+mrb_sdl2_effectchain_param_id(mrb_state *mrb, mrb_sdl2_effect_t const *e, mrb_int param)
+{
+  if ((0 > param) || (PARAM_COUNT <= param) || !(mrb_sdl2_effectchain_param_masks[e->kind] & PARAM_BIT(param))) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "parameter not supported by the effect.");
+  }
+  return (int)param;
+}
+
+/*
+ * SDL2::Audio::EffectChain#set(index, param, value)
+ * Takes effect on the next processed block without waiting for it.
+ */
+static mrb_value
+mrb_sdl2_effectchain_set(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index, param;
+  mrb_float value;
+  mrb_get_args(mrb, "iif", &index, &param, &value);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_effect(mrb, mrb_sdl2_effectchain_self(mrb, self), index);
+  mrb_sdl2_effectchain_set_param(e, mrb_sdl2_effectchain_param_id(mrb, e, param), (float)value);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_effectchain_get(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index, param;
+  mrb_get_args(mrb, "ii", &index, &param);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_effect(mrb, mrb_sdl2_effectchain_self(mrb, self), index);
+  return mrb_float_value(mrb, (mrb_float)mrb_sdl2_effectchain_param(e, mrb_sdl2_effectchain_param_id(mrb, e, param)));
+}
+
+static mrb_value
+mrb_sdl2_effectchain_set_bypass(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_bool bypass;
+  mrb_get_args(mrb, "ib", &index, &bypass);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_effect(mrb, mrb_sdl2_effectchain_self(mrb, self), index);
+  SDL_AtomicSet(&e->bypass, bypass ? 1 : 0);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_effectchain_is_bypass(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_get_args(mrb, "i", &index);
+  mrb_sdl2_effect_t *e = mrb_sdl2_effectchain_effect(mrb, mrb_sdl2_effectchain_self(mrb, self), index);
+  return mrb_bool_value(0 != SDL_AtomicGet(&e->bypass));
+}
+
+static mrb_value
+mrb_sdl2_effectchain_get_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_effectchain_self(mrb, self)->count);
+}
+
+/* SDL2::Audio::EffectChain#clear: removes every effect. */
+static mrb_value
+mrb_sdl2_effectchain_clear(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  mrb_sdl2_effect_t *removed[EFFECTCHAIN_MAX_EFFECTS];
+  int i, n;
+  SDL_AtomicLock(&chain->lock);
+  n = chain->count;
+  for (i = 0; i < n; ++i) {
+    removed[i] = chain->effects[i];
+    chain->effects[i] = NULL;
+  }
+  chain->count = 0;
+  SDL_AtomicUnlock(&chain->lock);
+  for (i = 0; i < n; ++i) {
+    mrb_sdl2_effect_free(mrb, removed[i]);
+  }
+  return self;
+}
+
+/* SDL2::Audio::EffectChain#reset: silences filter, delay and envelope state. */
+static mrb_value
+mrb_sdl2_effectchain_reset(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  int i;
+  SDL_AtomicLock(&chain->lock);
+  for (i = 0; i < chain->count; ++i) {
+    mrb_sdl2_effect_t *e = chain->effects[i];
+    SDL_memset(e->z1, 0, sizeof(e->z1));
+    SDL_memset(e->z2, 0, sizeof(e->z2));
+    if (NULL != e->line) {
+      SDL_memset(e->line, 0, sizeof(float) * e->line_frames * (size_t)chain->channels);
+    }
+    e->line_pos = 0;
+    e->envelope = 0.0f;
+  }
+  SDL_AtomicUnlock(&chain->lock);
+  return self;
+}
+
+/*
+ * SDL2::Audio::EffectChain#process(dst, len = nil)
+ * Runs the chain in place over a Buffer, or over 'len' bytes at a
+ * pointer (as given to the audio callback).
+ */
+static mrb_value
+mrb_sdl2_effectchain_process_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_value dst;
+  mrb_int len = -1;
+  mrb_get_args(mrb, "o|i", &dst, &len);
+  mrb_sdl2_effectchain_t *chain = mrb_sdl2_effectchain_self(mrb, self);
+  Uint8 *ptr;
+  if (mrb_sdl2_buffer_p(mrb, dst)) {
+    size_t sz;
+    ptr = (Uint8*)mrb_sdl2_buffer_get_ptr(mrb, dst, &sz);
+    if ((0 > len) || ((size_t)len > sz)) {
+      len = (mrb_int)sz;
+    }
+  } else if (mrb_type(dst) == MRB_TT_CPTR) {
+    if (0 > len) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "length is required for a pointer.");
+    }
+    ptr = (Uint8*)mrb_cptr(dst);
+  } else {
+    mrb_raise(mrb, E_TYPE_ERROR, "expected Buffer or pointer.");
+    return self;
+  }
+  mrb_sdl2_effectchain_process(chain, ptr, (Uint32)len);
+  return self;
+}
+
+
+void
+mruby_sdl2_effectchain_init(mrb_state *mrb)
+{
+  class_EffectChain = mrb_define_class_under(mrb, mod_Audio, "EffectChain", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_EffectChain, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_EffectChain, "initialize",     mrb_sdl2_effectchain_initialize,     MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_EffectChain, "add_gain",       mrb_sdl2_effectchain_add_gain,       MRB_ARGS_OPT(2));
+  mrb_define_method(mrb, class_EffectChain, "add_lowpass",    mrb_sdl2_effectchain_add_lowpass,    MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_EffectChain, "add_highpass",   mrb_sdl2_effectchain_add_highpass,   MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_EffectChain, "add_delay",      mrb_sdl2_effectchain_add_delay,      MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_EffectChain, "add_compressor", mrb_sdl2_effectchain_add_compressor, MRB_ARGS_OPT(5));
+  mrb_define_method(mrb, class_EffectChain, "set",            mrb_sdl2_effectchain_set,            MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, class_EffectChain, "get",            mrb_sdl2_effectchain_get,            MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_EffectChain, "bypass",         mrb_sdl2_effectchain_set_bypass,     MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_EffectChain, "bypass?",        mrb_sdl2_effectchain_is_bypass,      MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_EffectChain, "size",           mrb_sdl2_effectchain_get_size,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_EffectChain, "clear",          mrb_sdl2_effectchain_clear,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_EffectChain, "reset",          mrb_sdl2_effectchain_reset,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_EffectChain, "process",        mrb_sdl2_effectchain_process_m,      MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+
+  mrb_define_const(mrb, class_EffectChain, "GAIN",      mrb_fixnum_value(PARAM_GAIN));
+  mrb_define_const(mrb, class_EffectChain, "RAMP",      mrb_fixnum_value(PARAM_RAMP));
+  mrb_define_const(mrb, class_EffectChain, "FREQUENCY", mrb_fixnum_value(PARAM_FREQUENCY));
+  mrb_define_const(mrb, class_EffectChain, "Q",         mrb_fixnum_value(PARAM_Q));
+  mrb_define_const(mrb, class_EffectChain, "TIME",      mrb_fixnum_value(PARAM_TIME));
+  mrb_define_const(mrb, class_EffectChain, "FEEDBACK",  mrb_fixnum_value(PARAM_FEEDBACK));
+  mrb_define_const(mrb, class_EffectChain, "MIX",       mrb_fixnum_value(PARAM_MIX));
+  mrb_define_const(mrb, class_EffectChain, "THRESHOLD", mrb_fixnum_value(PARAM_THRESHOLD));
+  mrb_define_const(mrb, class_EffectChain, "RATIO",     mrb_fixnum_value(PARAM_RATIO));
+  mrb_define_const(mrb, class_EffectChain, "ATTACK",    mrb_fixnum_value(PARAM_ATTACK));
+  mrb_define_const(mrb, class_EffectChain, "RELEASE",   mrb_fixnum_value(PARAM_RELEASE));
+  mrb_define_const(mrb, class_EffectChain, "MAKEUP",    mrb_fixnum_value(PARAM_MAKEUP));
+}
+
+void
+mruby_sdl2_effectchain_final(mrb_state *mrb)
+{
+}
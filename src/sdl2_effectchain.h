@@ -0,0 +1,32 @@
+#ifndef MRUBY_SDL2_EFFECTCHAIN_H
+#define MRUBY_SDL2_EFFECTCHAIN_H
+
+#include "sdl2.h"
+#include <SDL2/SDL_audio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mrb_sdl2_effectchain_t mrb_sdl2_effectchain_t;
+
+extern void mruby_sdl2_effectchain_init(mrb_state *mrb);
+extern void mruby_sdl2_effectchain_final(mrb_state *mrb);
+
+extern mrb_sdl2_effectchain_t *mrb_sdl2_effectchain_get_ptr(mrb_state *mrb, mrb_value value);
+
+/* true when the chain was built for the format, channel count and rate of 'spec'. */
+extern mrb_bool mrb_sdl2_effectchain_accepts(mrb_sdl2_effectchain_t const *chain, SDL_AudioSpec const *spec);
+
+/*
+ * runs the chain in place over 'len' bytes of PCM in the chain's format.
+ * does not allocate or touch the VM, so it may be called from the audio
+ * callback.
+ */
+extern void mrb_sdl2_effectchain_process(mrb_sdl2_effectchain_t *chain, Uint8 *buf, Uint32 len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_EFFECTCHAIN_H */
@@ -0,0 +1,606 @@
+#include "sdl2_framedumper.h"
+#include "sdl2_surface.h"
+#include "sdl2_render.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/string.h"
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_render.h>
+#include <SDL2/SDL_rwops.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_timer.h>
+#include <SDL2/SDL_error.h>
+
+/*
+ * Frames are copied into pooled buffers on the calling thread and written
+ * out by a dedicated writer thread, so the caller only pays for a memcpy
+ * (or a renderer readback).
+ *
+ * FORMAT_BMP writes every frame to its own file named by the path
+ * pattern. FORMAT_RAW appends every frame to a single sequence file:
+ *
+ *   file header   magic "MSFD", version
+ *   frame header  index, ticks, width, height, pitch, SDL pixel format
+ *   frame pixels  height rows of pitch bytes
+ *
+ * All integers are 32-bit little-endian.
+ */
+#define FRAMEDUMPER_FORMAT_BMP   0
+#define FRAMEDUMPER_FORMAT_RAW   1
+#define FRAMEDUMPER_POLICY_DROP  0
+#define FRAMEDUMPER_POLICY_BLOCK 1
+#define FRAMEDUMPER_RAW_MAGIC    "MSFD"
+#define FRAMEDUMPER_RAW_VERSION  1
+#define FRAMEDUMPER_MAX_QUEUE    256
+#define FRAMEDUMPER_PATH_MAX     1024
+#define FRAMEDUMPER_ERROR_MAX    256
+
+static struct RClass *class_FrameDumper = NULL;
+
+typedef struct mrb_sdl2_video_frame_t {
+  Uint8                         *pixels;
+  size_t                         capacity;
+  int                            w;
+  int                            h;
+  int                            pitch;
+  Uint32                         format;
+  Uint32                         index;
+  Uint32                         ticks;
+  struct mrb_sdl2_video_frame_t *next;
+} mrb_sdl2_video_frame_t;
+
+typedef struct mrb_sdl2_video_framedumper_data_t {
+  char                    pattern[FRAMEDUMPER_PATH_MAX];
+  int                     format;
+  int                     policy;
+  SDL_RWops              *raw;
+  SDL_Thread             *thread;
+  SDL_mutex              *mutex;
+  SDL_cond               *queued;   /* signaled when a frame is queued or on close. */
+  SDL_cond               *released; /* signaled when a frame is written. */
+  mrb_sdl2_video_frame_t *frames;
+  mrb_sdl2_video_frame_t *free_list;
+  mrb_sdl2_video_frame_t *head;
+  mrb_sdl2_video_frame_t *tail;
+  int                     frame_count;
+  int                     pending;
+  bool                    quit;
+  Uint32                  next_index;
+  Uint32                  written;
+  Uint32                  dropped;
+  Uint32                  failed;
+  char                    last_error[FRAMEDUMPER_ERROR_MAX];
+} mrb_sdl2_video_framedumper_data_t;
+
+/*
+ * Checks that 'pattern' holds exactly 'expected' "%d" conversions (with
+ * optional flags and width) and no other conversion than "%%".
+ */
+static bool
+mrb_sdl2_video_framedumper_check_pattern(char const *pattern, int expected)
+{
+  int count = 0;
+  char const *p = pattern;
+  while ('\0' != *p) {
+    if ('%' != *p++) {
+      continue;
+    }
+    if ('%' == *p) {
+      ++p;
+      continue;
+    }
+    while (('\0' != *p) && (NULL != SDL_strchr("-+ 0#", *p))) {
+      ++p;
+    }
+    while (('0' <= *p) && ('9' >= *p)) {
+      ++p;
+    }
+    if ('d' != *p++) {
+      return false;
+    }
+    ++count;
+  }
+  return count == expected;
+}
+
+static bool
+mrb_sdl2_video_framedumper_write_bmp(mrb_sdl2_video_framedumper_data_t *data, mrb_sdl2_video_frame_t const *frame)
+{
+  char path[FRAMEDUMPER_PATH_MAX];
+  int bpp;
+  Uint32 rmask, gmask, bmask, amask;
+  if (!SDL_PixelFormatEnumToMasks(frame->format, &bpp, &rmask, &gmask, &bmask, &amask)) {
+    return false;
+  }
+  SDL_Surface *s = SDL_CreateRGBSurfaceFrom(frame->pixels, frame->w, frame->h, bpp, frame->pitch, rmask, gmask, bmask, amask);
+  if (NULL == s) {
+    return false;
+  }
+  SDL_snprintf(path, sizeof(path), data->pattern, (int)frame->index);
+  int const ret = SDL_SaveBMP_RW(s, SDL_RWFromFile(path, "wb"), 1);
+  SDL_FreeSurface(s);
+  return 0 == ret;
+}
+
+static bool
+mrb_sdl2_video_framedumper_write_raw(mrb_sdl2_video_framedumper_data_t *data, mrb_sdl2_video_frame_t const *frame)
+{
+  SDL_RWops *rw = data->raw;
+  if ((1 != SDL_WriteLE32(rw, frame->index)) ||
+      (1 != SDL_WriteLE32(rw, frame->ticks)) ||
+      (1 != SDL_WriteLE32(rw, (Uint32)frame->w)) ||
+      (1 != SDL_WriteLE32(rw, (Uint32)frame->h)) ||
+      (1 != SDL_WriteLE32(rw, (Uint32)frame->pitch)) ||
+      (1 != SDL_WriteLE32(rw, frame->format))) {
+    return false;
+  }
+  return 1 == SDL_RWwrite(rw, frame->pixels, (size_t)frame->pitch * frame->h, 1);
+}
+
+static int
+mrb_sdl2_video_framedumper_thread(void *arg)
+{
+  mrb_sdl2_video_framedumper_data_t *data = (mrb_sdl2_video_framedumper_data_t*)arg;
+  SDL_LockMutex(data->mutex);
+  for (;;) {
+    while (!data->quit && (NULL == data->head)) {
+      SDL_CondWait(data->queued, data->mutex);
+    }
+    mrb_sdl2_video_frame_t *frame = data->head;
+    if (NULL == frame) {
+      break;
+    }
+    data->head = frame->next;
+    if (NULL == data->head) {
+      data->tail = NULL;
+    }
+    SDL_UnlockMutex(data->mutex);
+
+    bool const ok = (FRAMEDUMPER_FORMAT_RAW == data->format) ?
+      mrb_sdl2_video_framedumper_write_raw(data, frame) :
+      mrb_sdl2_video_framedumper_write_bmp(data, frame);
+
+    SDL_LockMutex(data->mutex);
+    if (ok) {
+      ++data->written;
+    } else {
+      ++data->failed;
+      SDL_strlcpy(data->last_error, SDL_GetError(), sizeof(data->last_error));
+    }
+    frame->next     = data->free_list;
+    data->free_list = frame;
+    --data->pending;
+    SDL_CondBroadcast(data->released);
+  }
+  SDL_UnlockMutex(data->mutex);
+  return 0;
+}
+
+/* waits until every queued frame is written. */
+static void
+mrb_sdl2_video_framedumper_flush_queue(mrb_sdl2_video_framedumper_data_t *data)
+{
+  if (NULL == data->thread) {
+    return;
+  }
+  SDL_LockMutex(data->mutex);
+  while (0 < data->pending) {
+    SDL_CondWait(data->released, data->mutex);
+  }
+  SDL_UnlockMutex(data->mutex);
+}
+
+/* writes out pending frames and stops the writer thread. */
+static void
+mrb_sdl2_video_framedumper_close(mrb_sdl2_video_framedumper_data_t *data)
+{
+  if (NULL != data->thread) {
+    SDL_LockMutex(data->mutex);
+    data->quit = true;
+    SDL_CondSignal(data->queued);
+    SDL_UnlockMutex(data->mutex);
+    SDL_WaitThread(data->thread, NULL);
+    data->thread = NULL;
+  }
+  if (NULL != data->raw) {
+    SDL_RWclose(data->raw);
+    data->raw = NULL;
+  }
+}
+
+static void
+mrb_sdl2_video_framedumper_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_video_framedumper_data_t *data =
+    (mrb_sdl2_video_framedumper_data_t*)p;
+  if (NULL != data) {
+    mrb_sdl2_video_framedumper_close(data);
+    if (NULL != data->frames) {
+      int i;
+      for (i = 0; i < data->frame_count; ++i) {
+        SDL_free(data->frames[i].pixels);
+      }
+      SDL_free(data->frames);
+    }
+    if (NULL != data->queued) {
+      SDL_DestroyCond(data->queued);
+    }
+    if (NULL != data->released) {
+      SDL_DestroyCond(data->released);
+    }
+    if (NULL != data->mutex) {
+      SDL_DestroyMutex(data->mutex);
+    }
+    mrb_free(mrb, data);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_video_framedumper_data_type = {
+  "FrameDumper", mrb_sdl2_video_framedumper_data_free
+};
+
+static mrb_sdl2_video_framedumper_data_t *
+mrb_sdl2_video_framedumper_get_ptr(mrb_state *mrb, mrb_value dumper)
+{
+  return (mrb_sdl2_video_framedumper_data_t*)mrb_data_get_ptr(mrb, dumper, &mrb_sdl2_video_framedumper_data_type);
+}
+
+/*
+ * Takes a free frame buffer big enough for 'size' bytes. Returns NULL when
+ * the frame has to be dropped; raises on errors.
+ */
+static mrb_sdl2_video_frame_t *
+mrb_sdl2_video_framedumper_acquire(mrb_state *mrb, mrb_sdl2_video_framedumper_data_t *data, size_t size)
+{
+  if (NULL == data->thread) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "frame dumper is already closed.");
+  }
+  SDL_LockMutex(data->mutex);
+  if ((NULL == data->free_list) && (FRAMEDUMPER_POLICY_BLOCK == data->policy)) {
+    while (NULL == data->free_list) {
+      SDL_CondWait(data->released, data->mutex);
+    }
+  }
+  mrb_sdl2_video_frame_t *frame = data->free_list;
+  if (NULL == frame) {
+    ++data->dropped;
+  } else {
+    data->free_list = frame->next;
+  }
+  SDL_UnlockMutex(data->mutex);
+  if ((NULL != frame) && (frame->capacity < size)) {
+    Uint8 *pixels = (Uint8*)SDL_realloc(frame->pixels, size);
+    if (NULL == pixels) {
+      SDL_LockMutex(data->mutex);
+      frame->next     = data->free_list;
+      data->free_list = frame;
+      SDL_UnlockMutex(data->mutex);
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    frame->pixels   = pixels;
+    frame->capacity = size;
+  }
+  return frame;
+}
+
+static void
+mrb_sdl2_video_framedumper_enqueue(mrb_sdl2_video_framedumper_data_t *data, mrb_sdl2_video_frame_t *frame)
+{
+  SDL_LockMutex(data->mutex);
+  frame->index = data->next_index++;
+  frame->ticks = SDL_GetTicks();
+  frame->next  = NULL;
+  if (NULL == data->tail) {
+    data->head = frame;
+  } else {
+    data->tail->next = frame;
+  }
+  data->tail = frame;
+  ++data->pending;
+  SDL_CondSignal(data->queued);
+  SDL_UnlockMutex(data->mutex);
+}
+
+/*
+ * Returns 'frame' to the free list without writing it.
+ */
+static void
+mrb_sdl2_video_framedumper_discard(mrb_sdl2_video_framedumper_data_t *data, mrb_sdl2_video_frame_t *frame)
+{
+  SDL_LockMutex(data->mutex);
+  frame->next     = data->free_list;
+  data->free_list = frame;
+  SDL_UnlockMutex(data->mutex);
+}
+
+/*
+ * SDL2::Video::FrameDumper.new(path, format = FORMAT_BMP, queue = 4, policy = POLICY_DROP)
+ *
+ * With FORMAT_BMP, 'path' is a pattern with a single "%d" conversion for
+ * the frame number, e.g. "frame_%05d.bmp". With FORMAT_RAW, 'path' names
+ * the sequence file. 'queue' is the number of frames that may wait for
+ * the writer; when it is full, POLICY_DROP drops new frames and
+ * POLICY_BLOCK waits for the writer.
+ */
+static mrb_value
+mrb_sdl2_video_framedumper_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_value path;
+  mrb_int format = FRAMEDUMPER_FORMAT_BMP;
+  mrb_int queue  = 4;
+  mrb_int policy = FRAMEDUMPER_POLICY_DROP;
+  mrb_get_args(mrb, "S|iii", &path, &format, &queue, &policy);
+  if ((FRAMEDUMPER_FORMAT_BMP != format) && (FRAMEDUMPER_FORMAT_RAW != format)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown format.");
+  }
+  if ((FRAMEDUMPER_POLICY_DROP != policy) && (FRAMEDUMPER_POLICY_BLOCK != policy)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown policy.");
+  }
+  if ((0 >= queue) || (FRAMEDUMPER_MAX_QUEUE < queue)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "queue size is out of range.");
+  }
+  if (FRAMEDUMPER_PATH_MAX <= RSTRING_LEN(path)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "path is too long.");
+  }
+  if (!mrb_sdl2_video_framedumper_check_pattern(RSTRING_PTR(path), (FRAMEDUMPER_FORMAT_BMP == format) ? 1 : 0)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid path pattern.");
+  }
+  if (NULL != DATA_PTR(self)) {
+    mrb_sdl2_video_framedumper_data_free(mrb, DATA_PTR(self));
+    DATA_PTR(self) = NULL;
+  }
+
+  mrb_sdl2_video_framedumper_data_t *data =
+    (mrb_sdl2_video_framedumper_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_video_framedumper_data_t));
+  if (NULL == data) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_memset(data, 0, sizeof(*data));
+  SDL_memcpy(data->pattern, RSTRING_PTR(path), RSTRING_LEN(path));
+  data->format = (int)format;
+  data->policy = (int)policy;
+  DATA_PTR(self)  = data;
+  DATA_TYPE(self) = &mrb_sdl2_video_framedumper_data_type;
+
+  /* one frame more than the queue holds is being written. */
+  data->frame_count = (int)queue + 1;
+  data->frames      = (mrb_sdl2_video_frame_t*)SDL_calloc(data->frame_count, sizeof(mrb_sdl2_video_frame_t));
+  if (NULL == data->frames) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  int i;
+  for (i = 0; i < data->frame_count; ++i) {
+    data->frames[i].next = data->free_list;
+    data->free_list = &data->frames[i];
+  }
+
+  data->mutex    = SDL_CreateMutex();
+  data->queued   = SDL_CreateCond();
+  data->released = SDL_CreateCond();
+  if ((NULL == data->mutex) || (NULL == data->queued) || (NULL == data->released)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  if (FRAMEDUMPER_FORMAT_RAW == format) {
+    data->raw = SDL_RWFromFile(data->pattern, "wb");
+    if (NULL == data->raw) {
+      mruby_sdl2_raise_error(mrb);
+    }
+    if ((1 != SDL_RWwrite(data->raw, FRAMEDUMPER_RAW_MAGIC, 4, 1)) ||
+        (1 != SDL_WriteLE32(data->raw, FRAMEDUMPER_RAW_VERSION))) {
+      mruby_sdl2_raise_error(mrb);
+    }
+  }
+  data->thread = SDL_CreateThread(mrb_sdl2_video_framedumper_thread, "mrb_sdl2_framedumper", data);
+  if (NULL == data->thread) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return self;
+}
+
+/*
+ * SDL2::Video::FrameDumper#capture(surface)
+ *
+ * Queues a copy of the surface (e.g. Window#surface). Returns false if
+ * the frame was dropped.
+ */
+static mrb_value
+mrb_sdl2_video_framedumper_capture(mrb_state *mrb, mrb_value self)
+{
+  mrb_value surface;
+  mrb_get_args(mrb, "o", &surface);
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, surface);
+  if (NULL == s) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "surface is already freed.");
+  }
+  if (NULL != s->format->palette) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unsupported pixel format.");
+  }
+  int const row = s->w * s->format->BytesPerPixel;
+  mrb_sdl2_video_frame_t *frame = mrb_sdl2_video_framedumper_acquire(mrb, data, (size_t)row * s->h);
+  if (NULL == frame) {
+    return mrb_false_value();
+  }
+  if (0 != SDL_LockSurface(s)) {
+    mrb_sdl2_video_framedumper_discard(data, frame);
+    mruby_sdl2_raise_error(mrb);
+  }
+  int y;
+  for (y = 0; y < s->h; ++y) {
+    SDL_memcpy(frame->pixels + y * row, (Uint8 const*)s->pixels + y * s->pitch, row);
+  }
+  SDL_UnlockSurface(s);
+  frame->w      = s->w;
+  frame->h      = s->h;
+  frame->pitch  = row;
+  frame->format = s->format->format;
+  mrb_sdl2_video_framedumper_enqueue(data, frame);
+  return mrb_true_value();
+}
+
+/*
+ * SDL2::Video::FrameDumper#capture_renderer(renderer)
+ *
+ * Reads back the current render target as ARGB8888 and queues it.
+ * Returns false if the frame was dropped.
+ */
+static mrb_value
+mrb_sdl2_video_framedumper_capture_renderer(mrb_state *mrb, mrb_value self)
+{
+  mrb_value renderer;
+  mrb_get_args(mrb, "o", &renderer);
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  SDL_Renderer *r = mrb_sdl2_video_renderer_get_ptr(mrb, renderer);
+  int w, h;
+  if (0 != SDL_GetRendererOutputSize(r, &w, &h)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  mrb_sdl2_video_frame_t *frame = mrb_sdl2_video_framedumper_acquire(mrb, data, (size_t)w * h * 4);
+  if (NULL == frame) {
+    return mrb_false_value();
+  }
+  if (0 != SDL_RenderReadPixels(r, NULL, SDL_PIXELFORMAT_ARGB8888, frame->pixels, w * 4)) {
+    mrb_sdl2_video_framedumper_discard(data, frame);
+    mruby_sdl2_raise_error(mrb);
+  }
+  frame->w      = w;
+  frame->h      = h;
+  frame->pitch  = w * 4;
+  frame->format = SDL_PIXELFORMAT_ARGB8888;
+  mrb_sdl2_video_framedumper_enqueue(data, frame);
+  return mrb_true_value();
+}
+
+/*
+ * SDL2::Video::FrameDumper#flush
+ *
+ * Waits until every queued frame is written.
+ */
+static mrb_value
+mrb_sdl2_video_framedumper_flush(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_flush_queue(mrb_sdl2_video_framedumper_get_ptr(mrb, self));
+  return self;
+}
+
+/*
+ * SDL2::Video::FrameDumper#close
+ *
+ * Writes out queued frames and stops the writer thread.
+ */
+static mrb_value
+mrb_sdl2_video_framedumper_close_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_close(mrb_sdl2_video_framedumper_get_ptr(mrb, self));
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_video_framedumper_is_closed(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  return (NULL == data->thread) ? mrb_true_value() : mrb_false_value();
+}
+
+/* reads a counter updated by the writer thread. */
+static mrb_value
+mrb_sdl2_video_framedumper_read_counter(mrb_sdl2_video_framedumper_data_t *data, Uint32 const *counter)
+{
+  if (NULL == data->mutex) {
+    return mrb_fixnum_value(*counter);
+  }
+  SDL_LockMutex(data->mutex);
+  Uint32 const value = *counter;
+  SDL_UnlockMutex(data->mutex);
+  return mrb_fixnum_value(value);
+}
+
+static mrb_value
+mrb_sdl2_video_framedumper_get_written(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  return mrb_sdl2_video_framedumper_read_counter(data, &data->written);
+}
+
+static mrb_value
+mrb_sdl2_video_framedumper_get_dropped(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  return mrb_sdl2_video_framedumper_read_counter(data, &data->dropped);
+}
+
+static mrb_value
+mrb_sdl2_video_framedumper_get_failed(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  return mrb_sdl2_video_framedumper_read_counter(data, &data->failed);
+}
+
+static mrb_value
+mrb_sdl2_video_framedumper_get_pending(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  if (NULL == data->mutex) {
+    return mrb_fixnum_value(0);
+  }
+  SDL_LockMutex(data->mutex);
+  int const pending = data->pending;
+  SDL_UnlockMutex(data->mutex);
+  return mrb_fixnum_value(pending);
+}
+
+/*
+ * SDL2::Video::FrameDumper#last_error
+ *
+ * Returns the message of the last failed write, or nil.
+ */
+static mrb_value
+mrb_sdl2_video_framedumper_get_last_error(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_framedumper_data_t *data = mrb_sdl2_video_framedumper_get_ptr(mrb, self);
+  char message[FRAMEDUMPER_ERROR_MAX];
+  if (NULL == data->mutex) {
+    return mrb_nil_value();
+  }
+  SDL_LockMutex(data->mutex);
+  SDL_memcpy(message, data->last_error, sizeof(message));
+  SDL_UnlockMutex(data->mutex);
+  if ('\0' == message[0]) {
+    return mrb_nil_value();
+  }
+  return mrb_str_new_cstr(mrb, message);
+}
+
+
+void
+mruby_sdl2_video_framedumper_init(mrb_state *mrb, struct RClass *mod_Video)
+{
+  class_FrameDumper = mrb_define_class_under(mrb, mod_Video, "FrameDumper", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_FrameDumper, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_FrameDumper, "initialize",       mrb_sdl2_video_framedumper_initialize,       MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_FrameDumper, "capture",          mrb_sdl2_video_framedumper_capture,          MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_FrameDumper, "capture_renderer", mrb_sdl2_video_framedumper_capture_renderer, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_FrameDumper, "flush",            mrb_sdl2_video_framedumper_flush,            MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "close",            mrb_sdl2_video_framedumper_close_m,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "closed?",          mrb_sdl2_video_framedumper_is_closed,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "written",          mrb_sdl2_video_framedumper_get_written,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "dropped",          mrb_sdl2_video_framedumper_get_dropped,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "failed",           mrb_sdl2_video_framedumper_get_failed,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "pending",          mrb_sdl2_video_framedumper_get_pending,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_FrameDumper, "last_error",       mrb_sdl2_video_framedumper_get_last_error,   MRB_ARGS_NONE());
+
+  int const arena_size = mrb_gc_arena_save(mrb);
+  mrb_define_const(mrb, class_FrameDumper, "FORMAT_BMP",   mrb_fixnum_value(FRAMEDUMPER_FORMAT_BMP));
+  mrb_define_const(mrb, class_FrameDumper, "FORMAT_RAW",   mrb_fixnum_value(FRAMEDUMPER_FORMAT_RAW));
+  mrb_define_const(mrb, class_FrameDumper, "POLICY_DROP",  mrb_fixnum_value(FRAMEDUMPER_POLICY_DROP));
+  mrb_define_const(mrb, class_FrameDumper, "POLICY_BLOCK", mrb_fixnum_value(FRAMEDUMPER_POLICY_BLOCK));
+  mrb_gc_arena_restore(mrb, arena_size);
+}
+
+void
+mruby_sdl2_video_framedumper_final(mrb_state *mrb, struct RClass *mod_Video)
+{
+}
@@ -1,8 +1,10 @@
 #include "sdl2_rect.h"
+#include "sdl2_rectarray.h"
 #include "mruby/data.h"
 #include "mruby/class.h"
 #include "mruby/variable.h"
 #include "mruby/array.h"
+#include <SDL2/SDL_atomic.h>
 
 static struct RClass *class_Rect = NULL;
 static struct RClass *class_Point = NULL;
@@ -20,13 +22,99 @@ typedef struct mrb_sdl2_rect_size_data_t {
   size_data_t size;
 } mrb_sdl2_rect_size_data_t;
 
+/*
+ * Rect, Point and Size data are carved out of shared slabs instead of
+ * being allocated one by one; freed cells are kept on a free list. RData
+ * has no inline storage, so this is what removes the per-object malloc.
+ * Threads run their own mrb_state, hence the lock.
+ */
+#define RECT_SLAB_CELLS 1024
+
+typedef union mrb_sdl2_rect_cell_t {
+  mrb_sdl2_rect_rect_data_t   rect;
+  mrb_sdl2_rect_point_data_t  point;
+  mrb_sdl2_rect_size_data_t   size;
+  union mrb_sdl2_rect_cell_t *next;
+} mrb_sdl2_rect_cell_t;
+
+typedef struct mrb_sdl2_rect_slab_t {
+  struct mrb_sdl2_rect_slab_t *next;
+  mrb_sdl2_rect_cell_t         cells[RECT_SLAB_CELLS];
+} mrb_sdl2_rect_slab_t;
+
+static SDL_SpinLock          slab_lock  = 0;
+static mrb_sdl2_rect_slab_t *slabs      = NULL;
+static mrb_sdl2_rect_cell_t *free_cells = NULL;
+static size_t                live_cells = 0;
+static int                   open_states = 0; /* mrb_states between init and final. */
+
+static void *
+mrb_sdl2_rect_cell_alloc(mrb_state *mrb)
+{
+  SDL_AtomicLock(&slab_lock);
+  if (NULL == free_cells) {
+    mrb_sdl2_rect_slab_t *slab = (mrb_sdl2_rect_slab_t*)SDL_malloc(sizeof(mrb_sdl2_rect_slab_t));
+    if (NULL == slab) {
+      SDL_AtomicUnlock(&slab_lock);
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    int i;
+    for (i = RECT_SLAB_CELLS - 1; i >= 0; --i) {
+      slab->cells[i].next = free_cells;
+      free_cells = &slab->cells[i];
+    }
+    slab->next = slabs;
+    slabs = slab;
+  }
+  mrb_sdl2_rect_cell_t *cell = free_cells;
+  free_cells = cell->next;
+  ++live_cells;
+  SDL_AtomicUnlock(&slab_lock);
+  return cell;
+}
+
+/* releases the slabs once no state is open and no cell is in use. */
+static void
+mrb_sdl2_rect_cell_trim(void)
+{
+  SDL_AtomicLock(&slab_lock);
+  if ((0 == live_cells) && (0 == open_states)) {
+    while (NULL != slabs) {
+      mrb_sdl2_rect_slab_t *next = slabs->next;
+      SDL_free(slabs);
+      slabs = next;
+    }
+    free_cells = NULL;
+  }
+  SDL_AtomicUnlock(&slab_lock);
+}
+
+/*
+ * Finals run before mrb_close() frees the remaining objects, so the last
+ * cell freed after the last final releases the slabs.
+ */
+static void
+mrb_sdl2_rect_cell_free(void *p)
+{
+  mrb_sdl2_rect_cell_t *cell = (mrb_sdl2_rect_cell_t*)p;
+  SDL_AtomicLock(&slab_lock);
+  cell->next = free_cells;
+  free_cells = cell;
+  --live_cells;
+  bool const release = (0 == live_cells) && (0 == open_states);
+  SDL_AtomicUnlock(&slab_lock);
+  if (release) {
+    mrb_sdl2_rect_cell_trim();
+  }
+}
+
 static void
 mrb_sdl2_rect_rect_data_free(mrb_state *mrb, void *p)
 {
   mrb_sdl2_rect_rect_data_t *data =
     (mrb_sdl2_rect_rect_data_t*)p;
   if (NULL != data) {
-    mrb_free(mrb, data);
+    mrb_sdl2_rect_cell_free(data);
   }
 }
 
@@ -36,7 +124,7 @@ mrb_sdl2_rect_point_data_free(mrb_state *mrb, void *p)
   mrb_sdl2_rect_point_data_t *data =
     (mrb_sdl2_rect_point_data_t*)p;
   if (NULL != data) {
-    mrb_free(mrb, data);
+    mrb_sdl2_rect_cell_free(data);
   }
 }
 
@@ -46,7 +134,7 @@ mrb_sdl2_rect_size_data_free(mrb_state *mrb, void *p)
   mrb_sdl2_rect_size_data_t *data =
     (mrb_sdl2_rect_size_data_t*)p;
   if (NULL != data) {
-    mrb_free(mrb, data);
+    mrb_sdl2_rect_cell_free(data);
   }
 }
 
@@ -66,10 +154,7 @@ mrb_value
 mrb_sdl2_rect(mrb_state *mrb, int x, int y, int w, int h)
 {
   mrb_sdl2_rect_rect_data_t *data =
-    (mrb_sdl2_rect_rect_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_rect_data_t));
-  if (NULL == data) {
-    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-  }
+    (mrb_sdl2_rect_rect_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   data->rect.x = x;
   data->rect.y = y;
   data->rect.w = w;
@@ -81,10 +166,7 @@ mrb_value
 mrb_sdl2_rect_direct(mrb_state *mrb, SDL_Rect const *rect)
 {
   mrb_sdl2_rect_rect_data_t *data =
-    (mrb_sdl2_rect_rect_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_rect_data_t));
-  if (NULL == data) {
-    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-  }
+    (mrb_sdl2_rect_rect_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   if (NULL == rect) {
     data->rect.x = 0;
     data->rect.y = 0;
@@ -103,10 +185,7 @@ mrb_value
 mrb_sdl2_point(mrb_state *mrb, int x, int y)
 {
   mrb_sdl2_rect_point_data_t *data =
-    (mrb_sdl2_rect_point_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_point_data_t));
-  if (NULL == data) {
-    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-  }
+    (mrb_sdl2_rect_point_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   data->point.x = x;
   data->point.y = y;
   return mrb_obj_value(Data_Wrap_Struct(mrb, class_Point, &mrb_sdl2_rect_point_data_type, data));
@@ -116,10 +195,7 @@ mrb_value
 mrb_sdl2_size(mrb_state *mrb, int w, int h)
 {
   mrb_sdl2_rect_size_data_t *data =
-    (mrb_sdl2_rect_size_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_size_data_t));
-  if (NULL == data) {
-    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-  }
+    (mrb_sdl2_rect_size_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   data->size.w = w;
   data->size.h = h;
   return mrb_obj_value(Data_Wrap_Struct(mrb, class_Size, &mrb_sdl2_rect_size_data_type, data));
@@ -173,10 +249,7 @@ mrb_sdl2_rect_rect_initialize(mrb_state *mrb, mrb_value self)
     (mrb_sdl2_rect_rect_data_t*)DATA_PTR(self);
 
   if (data == NULL) {
-    data = (mrb_sdl2_rect_rect_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_rect_data_t));
-    if (NULL == data) {
-      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-    }
+    data = (mrb_sdl2_rect_rect_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   }
 
   switch (argc) {
@@ -283,10 +356,7 @@ mrb_sdl2_rect_rect_get_position(mrb_state *mrb, mrb_value self)
 {
   SDL_Rect const * const rect = mrb_sdl2_rect_get_ptr(mrb, self);
   mrb_sdl2_rect_point_data_t *data =
-    (mrb_sdl2_rect_point_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_point_data_t));
-  if (NULL == data) {
-    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-  }
+    (mrb_sdl2_rect_point_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   data->point.x = rect->x;
   data->point.y = rect->y;
   return mrb_obj_value(Data_Wrap_Struct(mrb, class_Point, &mrb_sdl2_rect_point_data_type, data));
@@ -320,10 +390,7 @@ mrb_sdl2_rect_rect_get_size(mrb_state *mrb, mrb_value self)
 {
   SDL_Rect const * const rect = mrb_sdl2_rect_get_ptr(mrb, self);
   mrb_sdl2_rect_size_data_t *data =
-    (mrb_sdl2_rect_size_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_size_data_t));
-  if (NULL == data) {
-    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-  }
+    (mrb_sdl2_rect_size_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   data->size.w = rect->w;
   data->size.h = rect->h;
   return mrb_obj_value(Data_Wrap_Struct(mrb, class_Size, &mrb_sdl2_rect_size_data_type, data));
@@ -446,8 +513,14 @@ mrb_sdl2_rect_rect_enclose_points(mrb_state *mrb, mrb_value self)
   mrb_int argc;
   mrb_get_args(mrb, "o*", &clip, &argv, &argc);
   SDL_Rect const * const c = mrb_sdl2_rect_get_ptr(mrb, clip);
-  SDL_Point points[argc];
+  SDL_Point *packed;
+  int count;
   SDL_Rect result;
+  if ((1 == argc) && mrb_sdl2_pointarray_get(argv[0], &packed, &count)) {
+    return (SDL_FALSE == SDL_EnclosePoints(packed, count, c, &result)) ?
+      mrb_nil_value() : mrb_sdl2_rect_direct(mrb, &result);
+  }
+  SDL_Point points[argc];
   mrb_int i;
   for (i = 0; i < argc; ++i) {
     SDL_Point const * const p = mrb_sdl2_point_get_ptr(mrb, argv[i]);
@@ -473,10 +546,7 @@ mrb_sdl2_rect_point_initialize(mrb_state *mrb, mrb_value self)
     (mrb_sdl2_rect_point_data_t*)DATA_PTR(self);
 
   if (data == NULL) {
-    data = (mrb_sdl2_rect_point_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_point_data_t));
-    if (NULL == data) {
-      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-    }
+    data = (mrb_sdl2_rect_point_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   }
 
   switch (argc) {
@@ -544,10 +614,7 @@ mrb_sdl2_rect_size_initialize(mrb_state *mrb, mrb_value self)
     (mrb_sdl2_rect_size_data_t*)DATA_PTR(self);
 
   if (data == NULL) {
-    data = (mrb_sdl2_rect_size_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rect_size_data_t));
-    if (NULL == data) {
-      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
-    }
+    data = (mrb_sdl2_rect_size_data_t*)mrb_sdl2_rect_cell_alloc(mrb);
   }
 
   switch (argc) {
@@ -603,6 +670,10 @@ mrb_sdl2_rect_size_set_h(mrb_state *mrb, mrb_value self)
 void
 mruby_sdl2_rect_init(mrb_state *mrb)
 {
+  SDL_AtomicLock(&slab_lock);
+  ++open_states;
+  SDL_AtomicUnlock(&slab_lock);
+
   class_Rect  = mrb_define_class_under(mrb, mod_SDL2, "Rect", mrb->object_class);
   class_Point = mrb_define_class_under(mrb, mod_SDL2, "Point", mrb->object_class);
   class_Size  = mrb_define_class_under(mrb, mod_SDL2, "Size", mrb->object_class);
@@ -649,4 +720,8 @@ mruby_sdl2_rect_init(mrb_state *mrb)
 void
 mruby_sdl2_rect_final(mrb_state *mrb)
 {
+  SDL_AtomicLock(&slab_lock);
+  --open_states;
+  SDL_AtomicUnlock(&slab_lock);
+  mrb_sdl2_rect_cell_trim();
 }
@@ -0,0 +1,694 @@
+#include "sdl2_rectarray.h"
+#include "sdl2_rect.h"
+#include "rect_kernels.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/array.h"
+#include "mruby/string.h"
+
+static struct RClass *class_RectArray  = NULL;
+static struct RClass *class_PointArray = NULL;
+
+/* packed SDL_Rect or SDL_Point items. */
+typedef struct mrb_sdl2_rectarray_data_t {
+  void   *items;
+  mrb_int size;
+  mrb_int capacity;
+} mrb_sdl2_rectarray_data_t;
+
+static void
+mrb_sdl2_rectarray_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_rectarray_data_t *data =
+    (mrb_sdl2_rectarray_data_t*)p;
+  if (NULL != data) {
+    mrb_free(mrb, data->items);
+    mrb_free(mrb, data);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_rectarray_data_type = {
+  "RectArray", mrb_sdl2_rectarray_data_free
+};
+
+static struct mrb_data_type const mrb_sdl2_pointarray_data_type = {
+  "PointArray", mrb_sdl2_rectarray_data_free
+};
+
+bool
+mrb_sdl2_rectarray_get(mrb_value value, SDL_Rect **rects, int *count)
+{
+  if ((MRB_TT_DATA != mrb_type(value)) || (&mrb_sdl2_rectarray_data_type != DATA_TYPE(value))) {
+    return false;
+  }
+  mrb_sdl2_rectarray_data_t *data = (mrb_sdl2_rectarray_data_t*)DATA_PTR(value);
+  *rects = (SDL_Rect*)data->items;
+  *count = (int)data->size;
+  return true;
+}
+
+bool
+mrb_sdl2_pointarray_get(mrb_value value, SDL_Point **points, int *count)
+{
+  if ((MRB_TT_DATA != mrb_type(value)) || (&mrb_sdl2_pointarray_data_type != DATA_TYPE(value))) {
+    return false;
+  }
+  mrb_sdl2_rectarray_data_t *data = (mrb_sdl2_rectarray_data_t*)DATA_PTR(value);
+  *points = (SDL_Point*)data->items;
+  *count = (int)data->size;
+  return true;
+}
+
+static void
+mrb_sdl2_rectarray_reserve(mrb_state *mrb, mrb_sdl2_rectarray_data_t *data, mrb_int capacity, size_t item_size)
+{
+  if (capacity <= data->capacity) {
+    return;
+  }
+  /* counts are passed to SDL as int, and the byte size must fit size_t. */
+  mrb_int limit = (mrb_int)0x7FFFFFFF;
+  if ((size_t)limit > SIZE_MAX / item_size) {
+    limit = (mrb_int)(SIZE_MAX / item_size);
+  }
+  if (limit < capacity) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "too many items.");
+  }
+  mrb_int n = (0 < data->capacity) ? data->capacity : 16;
+  while (n < capacity) {
+    n = (limit / 2 < n) ? limit : n * 2;
+  }
+  void *items = mrb_realloc(mrb, data->items, item_size * n);
+  if (NULL == items) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  data->items    = items;
+  data->capacity = n;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_init_data(mrb_state *mrb, mrb_value self, struct mrb_data_type const *type, size_t item_size)
+{
+  mrb_int capacity = 0;
+  mrb_get_args(mrb, "|i", &capacity);
+  if (0 > capacity) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative capacity.");
+  }
+  mrb_sdl2_rectarray_data_t *data =
+    (mrb_sdl2_rectarray_data_t*)DATA_PTR(self);
+  if (NULL == data) {
+    data = (mrb_sdl2_rectarray_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rectarray_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->items    = NULL;
+    data->capacity = 0;
+    DATA_PTR(self)  = data;
+    DATA_TYPE(self) = type;
+  }
+  data->size = 0;
+  mrb_sdl2_rectarray_reserve(mrb, data, capacity, item_size);
+  return self;
+}
+
+/* converts a negative index and checks the range. */
+static mrb_int
+mrb_sdl2_rectarray_index(mrb_state *mrb, mrb_sdl2_rectarray_data_t const *data, mrb_int index)
+{
+  if (0 > index) {
+    index += data->size;
+  }
+  if ((0 > index) || (data->size <= index)) {
+    mrb_raise(mrb, E_INDEX_ERROR, "index out of range.");
+  }
+  return index;
+}
+
+static SDL_Rect *
+mrb_sdl2_rectarray_rect_arg(mrb_state *mrb, mrb_value rect)
+{
+  SDL_Rect *r = mrb_sdl2_rect_get_ptr(mrb, rect);
+  if (NULL == r) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot set nil.");
+  }
+  return r;
+}
+
+static SDL_Point *
+mrb_sdl2_rectarray_point_arg(mrb_state *mrb, mrb_value point)
+{
+  SDL_Point *p = mrb_sdl2_point_get_ptr(mrb, point);
+  if (NULL == p) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot set nil.");
+  }
+  return p;
+}
+
+/* rounds half away from zero. */
+static int
+mrb_sdl2_rectarray_round(double value)
+{
+  return (int)((0.0 <= value) ? SDL_floor(value + 0.5) : -SDL_floor(-value + 0.5));
+}
+
+/***************************************************************************
+*
+* class SDL2::RectArray
+*
+***************************************************************************/
+
+static mrb_sdl2_rectarray_data_t *
+mrb_sdl2_rectarray_get_data(mrb_state *mrb, mrb_value self)
+{
+  return (mrb_sdl2_rectarray_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_rectarray_data_type);
+}
+
+static mrb_value
+mrb_sdl2_rectarray_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_rectarray_init_data(mrb, self, &mrb_sdl2_rectarray_data_type, sizeof(SDL_Rect));
+}
+
+/*
+ * SDL2::RectArray#push(rect) / push(x, y, w, h)
+ */
+static mrb_value
+mrb_sdl2_rectarray_push(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  mrb_value arg;
+  mrb_int y, w, h;
+  SDL_Rect r;
+  int const argc = mrb_get_args(mrb, "o|iii", &arg, &y, &w, &h);
+  if (1 == argc) {
+    r = *mrb_sdl2_rectarray_rect_arg(mrb, arg);
+  } else if ((4 == argc) && mrb_fixnum_p(arg)) {
+    r.x = (int)mrb_fixnum(arg);
+    r.y = (int)y;
+    r.w = (int)w;
+    r.h = (int)h;
+  } else {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "expected a Rect or x, y, w and h.");
+  }
+  mrb_sdl2_rectarray_reserve(mrb, data, data->size + 1, sizeof(SDL_Rect));
+  ((SDL_Rect*)data->items)[data->size++] = r;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_pop(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  if (0 == data->size) {
+    return mrb_nil_value();
+  }
+  return mrb_sdl2_rect_direct(mrb, &((SDL_Rect*)data->items)[--data->size]);
+}
+
+static mrb_value
+mrb_sdl2_rectarray_get_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_get_args(mrb, "i", &index);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  index = mrb_sdl2_rectarray_index(mrb, data, index);
+  return mrb_sdl2_rect_direct(mrb, &((SDL_Rect*)data->items)[index]);
+}
+
+/*
+ * SDL2::RectArray#get(index, rect)
+ *
+ * Copies the item into an existing Rect instead of allocating one.
+ */
+static mrb_value
+mrb_sdl2_rectarray_get_into(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_value rect;
+  mrb_get_args(mrb, "io", &index, &rect);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  index = mrb_sdl2_rectarray_index(mrb, data, index);
+  *mrb_sdl2_rectarray_rect_arg(mrb, rect) = ((SDL_Rect*)data->items)[index];
+  return rect;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_set_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_value rect;
+  mrb_get_args(mrb, "io", &index, &rect);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  index = mrb_sdl2_rectarray_index(mrb, data, index);
+  ((SDL_Rect*)data->items)[index] = *mrb_sdl2_rectarray_rect_arg(mrb, rect);
+  return rect;
+}
+
+/*
+ * SDL2::RectArray#set(index, x, y, w, h)
+ */
+static mrb_value
+mrb_sdl2_rectarray_set(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index, x, y, w, h;
+  mrb_get_args(mrb, "iiiii", &index, &x, &y, &w, &h);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  SDL_Rect *r = &((SDL_Rect*)data->items)[mrb_sdl2_rectarray_index(mrb, data, index)];
+  r->x = (int)x;
+  r->y = (int)y;
+  r->w = (int)w;
+  r->h = (int)h;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_get_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_rectarray_get_data(mrb, self)->size);
+}
+
+static mrb_value
+mrb_sdl2_rectarray_get_capacity(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_rectarray_get_data(mrb, self)->capacity);
+}
+
+static mrb_value
+mrb_sdl2_rectarray_reserve_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_int capacity;
+  mrb_get_args(mrb, "i", &capacity);
+  mrb_sdl2_rectarray_reserve(mrb, mrb_sdl2_rectarray_get_data(mrb, self), capacity, sizeof(SDL_Rect));
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_clear(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_get_data(mrb, self)->size = 0;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_translate(mrb_state *mrb, mrb_value self)
+{
+  mrb_int dx, dy;
+  mrb_get_args(mrb, "ii", &dx, &dy);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  SDL_Rect *r = (SDL_Rect*)data->items;
+  mrb_int i;
+  for (i = 0; i < data->size; ++i) {
+    r[i].x += (int)dx;
+    r[i].y += (int)dy;
+  }
+  return self;
+}
+
+/*
+ * SDL2::RectArray#scale(sx, sy)
+ *
+ * Scales positions and sizes about the origin, rounding to nearest.
+ */
+static mrb_value
+mrb_sdl2_rectarray_scale(mrb_state *mrb, mrb_value self)
+{
+  mrb_float sx, sy;
+  mrb_get_args(mrb, "ff", &sx, &sy);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  SDL_Rect *r = (SDL_Rect*)data->items;
+  mrb_int i;
+  for (i = 0; i < data->size; ++i) {
+    r[i].x = mrb_sdl2_rectarray_round(r[i].x * sx);
+    r[i].y = mrb_sdl2_rectarray_round(r[i].y * sy);
+    r[i].w = mrb_sdl2_rectarray_round(r[i].w * sx);
+    r[i].h = mrb_sdl2_rectarray_round(r[i].h * sy);
+  }
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_to_a(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  mrb_value const ary = mrb_ary_new_capa(mrb, data->size);
+  mrb_int i;
+  for (i = 0; i < data->size; ++i) {
+    int const arena_size = mrb_gc_arena_save(mrb);
+    mrb_ary_push(mrb, ary, mrb_sdl2_rect_direct(mrb, &((SDL_Rect*)data->items)[i]));
+    mrb_gc_arena_restore(mrb, arena_size);
+  }
+  return ary;
+}
+
+/*
+ * SDL2::RectArray::simd_backend
+ */
+static mrb_value
+mrb_sdl2_rectarray_s_simd_backend(mrb_state *mrb, mrb_value self)
+{
+  return mrb_str_new_cstr(mrb, mrb_sdl2_rect_kernels_backend());
+}
+
+static SDL_Rect
+mrb_sdl2_rectarray_query_arg(mrb_state *mrb)
+{
+  mrb_value arg;
+  mrb_get_args(mrb, "o", &arg);
+  SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, arg);
+  if (NULL == r) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "expected a Rect.");
+  }
+  return *r;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_clip_bang(mrb_state *mrb, mrb_value self)
+{
+  SDL_Rect const clip = mrb_sdl2_rectarray_query_arg(mrb);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  SDL_Rect *r = (SDL_Rect*)data->items;
+  mrb_sdl2_rect_kernels_clip(r, r, (int)data->size, &clip);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_clip(mrb_state *mrb, mrb_value self)
+{
+  SDL_Rect const clip = mrb_sdl2_rectarray_query_arg(mrb);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  mrb_value const result = mrb_obj_new(mrb, class_RectArray, 0, NULL);
+  mrb_sdl2_rectarray_data_t *dst = mrb_sdl2_rectarray_get_data(mrb, result);
+  mrb_sdl2_rectarray_reserve(mrb, dst, data->size, sizeof(SDL_Rect));
+  mrb_sdl2_rect_kernels_clip((SDL_Rect*)dst->items, (SDL_Rect const*)data->items, (int)data->size, &clip);
+  dst->size = data->size;
+  return result;
+}
+
+/* indices of the rects which intersect the given rect. */
+static mrb_value
+mrb_sdl2_rectarray_intersecting(mrb_state *mrb, mrb_value self)
+{
+  SDL_Rect const rect = mrb_sdl2_rectarray_query_arg(mrb);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  mrb_value const result = mrb_ary_new(mrb);
+  Uint8 mask[256];
+  mrb_int i;
+  for (i = 0; i < data->size; i += (mrb_int)sizeof(mask)) {
+    int const n = (int)SDL_min(data->size - i, (mrb_int)sizeof(mask));
+    if (0 == mrb_sdl2_rect_kernels_overlaps(mask, (SDL_Rect const*)data->items + i, n, &rect)) {
+      continue;
+    }
+    int k;
+    for (k = 0; k < n; ++k) {
+      if (0 != mask[k]) {
+        mrb_ary_push(mrb, result, mrb_fixnum_value(i + k));
+      }
+    }
+  }
+  return result;
+}
+
+static mrb_value
+mrb_sdl2_rectarray_bounds(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  SDL_Rect result;
+  if (!mrb_sdl2_rect_kernels_bounds(&result, (SDL_Rect const*)data->items, (int)data->size)) {
+    return mrb_nil_value();
+  }
+  return mrb_sdl2_rect_direct(mrb, &result);
+}
+
+/*
+ * hit_test(x, y) returns the index of the last (topmost) rect containing
+ * the point or nil. hit_test(point_array) returns one such entry per point.
+ */
+static mrb_value
+mrb_sdl2_rectarray_hit_test(mrb_state *mrb, mrb_value self)
+{
+  mrb_value arg;
+  mrb_int y;
+  int const argc = mrb_get_args(mrb, "o|i", &arg, &y);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_rectarray_get_data(mrb, self);
+  SDL_Rect const *rects = (SDL_Rect const*)data->items;
+  int const count = (int)data->size;
+  if ((2 == argc) && mrb_fixnum_p(arg)) {
+    int const index = mrb_sdl2_rect_kernels_find_last(rects, count, (int)mrb_fixnum(arg), (int)y);
+    return (0 > index) ? mrb_nil_value() : mrb_fixnum_value(index);
+  }
+  SDL_Point *points;
+  int n;
+  if ((1 != argc) || !mrb_sdl2_pointarray_get(arg, &points, &n)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "expected x and y or a PointArray.");
+  }
+  mrb_value const result = mrb_ary_new_capa(mrb, n);
+  int i;
+  for (i = 0; i < n; ++i) {
+    int const index = mrb_sdl2_rect_kernels_find_last(rects, count, points[i].x, points[i].y);
+    mrb_ary_push(mrb, result, (0 > index) ? mrb_nil_value() : mrb_fixnum_value(index));
+  }
+  return result;
+}
+
+/***************************************************************************
+*
+* class SDL2::PointArray
+*
+***************************************************************************/
+
+static mrb_sdl2_rectarray_data_t *
+mrb_sdl2_pointarray_get_data(mrb_state *mrb, mrb_value self)
+{
+  return (mrb_sdl2_rectarray_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_pointarray_data_type);
+}
+
+static mrb_value
+mrb_sdl2_pointarray_initialize(mrb_state *mrb, mrb_value self)
+{
+  return mrb_sdl2_rectarray_init_data(mrb, self, &mrb_sdl2_pointarray_data_type, sizeof(SDL_Point));
+}
+
+/*
+ * SDL2::PointArray#push(point) / push(x, y)
+ */
+static mrb_value
+mrb_sdl2_pointarray_push(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  mrb_value arg;
+  mrb_int y;
+  SDL_Point p;
+  int const argc = mrb_get_args(mrb, "o|i", &arg, &y);
+  if (1 == argc) {
+    p = *mrb_sdl2_rectarray_point_arg(mrb, arg);
+  } else if (mrb_fixnum_p(arg)) {
+    p.x = (int)mrb_fixnum(arg);
+    p.y = (int)y;
+  } else {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "expected a Point or x and y.");
+  }
+  mrb_sdl2_rectarray_reserve(mrb, data, data->size + 1, sizeof(SDL_Point));
+  ((SDL_Point*)data->items)[data->size++] = p;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_pointarray_pop(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  if (0 == data->size) {
+    return mrb_nil_value();
+  }
+  SDL_Point const p = ((SDL_Point*)data->items)[--data->size];
+  return mrb_sdl2_point(mrb, p.x, p.y);
+}
+
+static mrb_value
+mrb_sdl2_pointarray_get_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_get_args(mrb, "i", &index);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  SDL_Point const p = ((SDL_Point*)data->items)[mrb_sdl2_rectarray_index(mrb, data, index)];
+  return mrb_sdl2_point(mrb, p.x, p.y);
+}
+
+/*
+ * SDL2::PointArray#get(index, point)
+ *
+ * Copies the item into an existing Point instead of allocating one.
+ */
+static mrb_value
+mrb_sdl2_pointarray_get_into(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_value point;
+  mrb_get_args(mrb, "io", &index, &point);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  index = mrb_sdl2_rectarray_index(mrb, data, index);
+  *mrb_sdl2_rectarray_point_arg(mrb, point) = ((SDL_Point*)data->items)[index];
+  return point;
+}
+
+static mrb_value
+mrb_sdl2_pointarray_set_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index;
+  mrb_value point;
+  mrb_get_args(mrb, "io", &index, &point);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  index = mrb_sdl2_rectarray_index(mrb, data, index);
+  ((SDL_Point*)data->items)[index] = *mrb_sdl2_rectarray_point_arg(mrb, point);
+  return point;
+}
+
+/*
+ * SDL2::PointArray#set(index, x, y)
+ */
+static mrb_value
+mrb_sdl2_pointarray_set(mrb_state *mrb, mrb_value self)
+{
+  mrb_int index, x, y;
+  mrb_get_args(mrb, "iii", &index, &x, &y);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  SDL_Point *p = &((SDL_Point*)data->items)[mrb_sdl2_rectarray_index(mrb, data, index)];
+  p->x = (int)x;
+  p->y = (int)y;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_pointarray_get_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_pointarray_get_data(mrb, self)->size);
+}
+
+static mrb_value
+mrb_sdl2_pointarray_get_capacity(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_pointarray_get_data(mrb, self)->capacity);
+}
+
+static mrb_value
+mrb_sdl2_pointarray_reserve_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_int capacity;
+  mrb_get_args(mrb, "i", &capacity);
+  mrb_sdl2_rectarray_reserve(mrb, mrb_sdl2_pointarray_get_data(mrb, self), capacity, sizeof(SDL_Point));
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_pointarray_clear(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_pointarray_get_data(mrb, self)->size = 0;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_pointarray_translate(mrb_state *mrb, mrb_value self)
+{
+  mrb_int dx, dy;
+  mrb_get_args(mrb, "ii", &dx, &dy);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  SDL_Point *p = (SDL_Point*)data->items;
+  mrb_int i;
+  for (i = 0; i < data->size; ++i) {
+    p[i].x += (int)dx;
+    p[i].y += (int)dy;
+  }
+  return self;
+}
+
+/*
+ * SDL2::PointArray#scale(sx, sy)
+ *
+ * Scales about the origin, rounding to nearest.
+ */
+static mrb_value
+mrb_sdl2_pointarray_scale(mrb_state *mrb, mrb_value self)
+{
+  mrb_float sx, sy;
+  mrb_get_args(mrb, "ff", &sx, &sy);
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  SDL_Point *p = (SDL_Point*)data->items;
+  mrb_int i;
+  for (i = 0; i < data->size; ++i) {
+    p[i].x = mrb_sdl2_rectarray_round(p[i].x * sx);
+    p[i].y = mrb_sdl2_rectarray_round(p[i].y * sy);
+  }
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_pointarray_to_a(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rectarray_data_t *data = mrb_sdl2_pointarray_get_data(mrb, self);
+  mrb_value const ary = mrb_ary_new_capa(mrb, data->size);
+  mrb_int i;
+  for (i = 0; i < data->size; ++i) {
+    int const arena_size = mrb_gc_arena_save(mrb);
+    SDL_Point const p = ((SDL_Point*)data->items)[i];
+    mrb_ary_push(mrb, ary, mrb_sdl2_point(mrb, p.x, p.y));
+    mrb_gc_arena_restore(mrb, arena_size);
+  }
+  return ary;
+}
+
+
+void
+mruby_sdl2_rectarray_init(mrb_state *mrb)
+{
+  class_RectArray  = mrb_define_class_under(mrb, mod_SDL2, "RectArray",  mrb->object_class);
+  class_PointArray = mrb_define_class_under(mrb, mod_SDL2, "PointArray", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_RectArray,  MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_PointArray, MRB_TT_DATA);
+
+  mrb_sdl2_rect_kernels_init();
+
+  mrb_define_class_method(mrb, class_RectArray, "simd_backend", mrb_sdl2_rectarray_s_simd_backend, MRB_ARGS_NONE());
+
+  mrb_define_method(mrb, class_RectArray, "initialize",   mrb_sdl2_rectarray_initialize,   MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_RectArray, "push",         mrb_sdl2_rectarray_push,         MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_RectArray, "<<",           mrb_sdl2_rectarray_push,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RectArray, "pop",          mrb_sdl2_rectarray_pop,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "[]",           mrb_sdl2_rectarray_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RectArray, "[]=",          mrb_sdl2_rectarray_set_at,       MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_RectArray, "get",          mrb_sdl2_rectarray_get_into,     MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_RectArray, "set",          mrb_sdl2_rectarray_set,          MRB_ARGS_REQ(5));
+  mrb_define_method(mrb, class_RectArray, "size",         mrb_sdl2_rectarray_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "length",       mrb_sdl2_rectarray_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "capacity",     mrb_sdl2_rectarray_get_capacity, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "reserve",      mrb_sdl2_rectarray_reserve_m,    MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RectArray, "clear",        mrb_sdl2_rectarray_clear,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "translate",    mrb_sdl2_rectarray_translate,    MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_RectArray, "scale",        mrb_sdl2_rectarray_scale,        MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_RectArray, "to_a",         mrb_sdl2_rectarray_to_a,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "clip",         mrb_sdl2_rectarray_clip,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RectArray, "clip!",        mrb_sdl2_rectarray_clip_bang,    MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RectArray, "intersecting", mrb_sdl2_rectarray_intersecting, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RectArray, "bounds",       mrb_sdl2_rectarray_bounds,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RectArray, "hit_test",     mrb_sdl2_rectarray_hit_test,     MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+
+  mrb_define_method(mrb, class_PointArray, "initialize", mrb_sdl2_pointarray_initialize,   MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_PointArray, "push",       mrb_sdl2_pointarray_push,         MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_PointArray, "<<",         mrb_sdl2_pointarray_push,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_PointArray, "pop",        mrb_sdl2_pointarray_pop,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PointArray, "[]",         mrb_sdl2_pointarray_get_at,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_PointArray, "[]=",        mrb_sdl2_pointarray_set_at,       MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PointArray, "get",        mrb_sdl2_pointarray_get_into,     MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PointArray, "set",        mrb_sdl2_pointarray_set,          MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, class_PointArray, "size",       mrb_sdl2_pointarray_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PointArray, "length",     mrb_sdl2_pointarray_get_size,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PointArray, "capacity",   mrb_sdl2_pointarray_get_capacity, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PointArray, "reserve",    mrb_sdl2_pointarray_reserve_m,    MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_PointArray, "clear",      mrb_sdl2_pointarray_clear,        MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PointArray, "translate",  mrb_sdl2_pointarray_translate,    MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PointArray, "scale",      mrb_sdl2_pointarray_scale,        MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PointArray, "to_a",       mrb_sdl2_pointarray_to_a,         MRB_ARGS_NONE());
+}
+
+void
+mruby_sdl2_rectarray_final(mrb_state *mrb)
+{
+}
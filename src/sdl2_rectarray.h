@@ -0,0 +1,26 @@
+#ifndef MRUBY_SDL2_RECTARRAY_H
+#define MRUBY_SDL2_RECTARRAY_H
+
+#include "sdl2.h"
+#include <SDL2/SDL_rect.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void mruby_sdl2_rectarray_init(mrb_state *mrb);
+extern void mruby_sdl2_rectarray_final(mrb_state *mrb);
+
+/*
+ * return false when 'value' is not a RectArray (PointArray). otherwise
+ * the packed contents are returned; they are valid until the array is
+ * modified.
+ */
+extern bool mrb_sdl2_rectarray_get(mrb_value value, SDL_Rect **rects, int *count);
+extern bool mrb_sdl2_pointarray_get(mrb_value value, SDL_Point **points, int *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_RECTARRAY_H */
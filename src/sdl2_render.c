@@ -2,9 +2,12 @@
 #include "sdl2_video.h"
 #include "sdl2_rect.h"
 #include "sdl2_surface.h"
+#include "sdl2_rectarray.h"
+#include "misc.h"
 #include "mruby/data.h"
 #include "mruby/class.h"
 #include "mruby/array.h"
+#include <SDL2/SDL_events.h>
 
 static struct RClass *class_Renderer     = NULL;
 static struct RClass *class_Texture      = NULL;
@@ -13,6 +16,9 @@ static struct RClass *class_RendererInfo = NULL;
 
 typedef struct mrb_sdl2_video_renderer_data_t {
   SDL_Renderer *renderer;
+  bool          culling;
+  SDL_Rect      cull_rect;
+  mrb_int       culled;
 } mrb_sdl2_video_renderer_data_t;
 
 typedef struct mrb_sdl2_video_texture_data_t {
@@ -27,12 +33,15 @@ typedef struct mrb_sdl2_video_rendererinfo_data_t {
   SDL_RendererInfo info;
 } mrb_sdl2_video_rendererinfo_data_t;
 
+static void mrb_sdl2_video_renderer_watch(mrb_sdl2_video_renderer_data_t *data, bool culling);
+
 static void
 mrb_sdl2_video_renderer_data_free(mrb_state *mrb, void *p)
 {
   mrb_sdl2_video_renderer_data_t *data =
     (mrb_sdl2_video_renderer_data_t*)p;
   if (NULL != data) {
+    mrb_sdl2_video_renderer_watch(data, false);
     if (NULL != data->renderer) {
       SDL_DestroyRenderer(data->renderer);
     }
@@ -141,7 +150,10 @@ mrb_sdl2_video_renderer(mrb_state *mrb, SDL_Renderer *renderer)
   if (NULL == data) {
     mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
   }
-  data->renderer = renderer;
+  data->renderer  = renderer;
+  data->culling   = false;
+  data->cull_rect = (SDL_Rect){ 0, 0, 0, 0 };
+  data->culled    = 0;
   return mrb_obj_value(Data_Wrap_Struct(mrb, class_Renderer, &mrb_sdl2_video_renderer_data_type, data));
 }
 
@@ -177,6 +189,110 @@ mrb_sdl2_video_rendererinfo(mrb_state *mrb, SDL_RendererInfo *info)
 *
 ***************************************************************************/
 
+static mrb_sdl2_video_renderer_data_t *
+mrb_sdl2_video_renderer_get_data(mrb_state *mrb, mrb_value renderer)
+{
+  return (mrb_sdl2_video_renderer_data_t*)mrb_data_get_ptr(mrb, renderer, &mrb_sdl2_video_renderer_data_type);
+}
+
+/*
+ * Cache the visible area (view port intersected with clip rect) in render
+ * coordinates, which are relative to the origin of the view port.
+ */
+static void
+mrb_sdl2_video_renderer_update_cull_rect(mrb_sdl2_video_renderer_data_t *data)
+{
+  SDL_Rect view_port, clip;
+  if (NULL == data->renderer) {
+    return;
+  }
+  SDL_RenderGetViewport(data->renderer, &view_port);
+  SDL_RenderGetClipRect(data->renderer, &clip);
+  data->cull_rect = (SDL_Rect){ 0, 0, view_port.w, view_port.h };
+  if (SDL_FALSE == SDL_RectEmpty(&clip)) {
+    SDL_Rect visible = { 0, 0, 0, 0 };
+    SDL_IntersectRect(&data->cull_rect, &clip, &visible);
+    data->cull_rect = visible;
+  }
+}
+
+/*
+ * Event watch refreshing the cull rect when the renderer's window is
+ * resized. SDL's own watch, added when the renderer was created, runs
+ * first and has already updated the view port.
+ */
+static int
+mrb_sdl2_video_renderer_event_watch(void *userdata, SDL_Event *event)
+{
+  mrb_sdl2_video_renderer_data_t *data =
+    (mrb_sdl2_video_renderer_data_t*)userdata;
+  if ((SDL_WINDOWEVENT == event->type) && (SDL_WINDOWEVENT_SIZE_CHANGED == event->window.event) &&
+      (NULL != data->renderer)) {
+    SDL_Window *window = SDL_RenderGetWindow(data->renderer);
+    if ((NULL != window) && (event->window.windowID == SDL_GetWindowID(window))) {
+      mrb_sdl2_video_renderer_update_cull_rect(data);
+    }
+  }
+  return 0;
+}
+
+/* sets 'data->culling', watching for resizes while it is on. */
+static void
+mrb_sdl2_video_renderer_watch(mrb_sdl2_video_renderer_data_t *data, bool culling)
+{
+  if (data->culling == culling) {
+    return;
+  }
+  if (culling) {
+    SDL_AddEventWatch(mrb_sdl2_video_renderer_event_watch, data);
+    mrb_sdl2_video_renderer_update_cull_rect(data);
+  } else {
+    SDL_DelEventWatch(mrb_sdl2_video_renderer_event_watch, data);
+  }
+  data->culling = culling;
+}
+
+/*
+ * Returns true (and counts it) if drawing to 'dst' cannot be visible.
+ * NULL stands for the whole target and is never culled.
+ */
+static bool
+mrb_sdl2_video_renderer_cull(mrb_sdl2_video_renderer_data_t *data, SDL_Rect const *dst)
+{
+  if (!data->culling || (NULL == dst)) {
+    return false;
+  }
+  if (SDL_FALSE != SDL_HasIntersection(dst, &data->cull_rect)) {
+    return false;
+  }
+  ++data->culled;
+  return true;
+}
+
+/*
+ * Same as mrb_sdl2_video_renderer_cull but for a dst rect rotated by
+ * 'angle' degrees around 'center' (relative to dst, NULL for its center).
+ */
+static bool
+mrb_sdl2_video_renderer_cull_rotated(mrb_sdl2_video_renderer_data_t *data, SDL_Rect const *dst, double angle, SDL_Point const *center)
+{
+  if (!data->culling || (NULL == dst)) {
+    return false;
+  }
+  if (0.0 == angle) {
+    return mrb_sdl2_video_renderer_cull(data, dst);
+  }
+  double const cx = (NULL != center) ? center->x : dst->w * 0.5;
+  double const cy = (NULL != center) ? center->y : dst->h * 0.5;
+  double const dx = SDL_max(cx, dst->w - cx);
+  double const dy = SDL_max(cy, dst->h - cy);
+  int const r = (int)SDL_ceil(SDL_sqrt(dx * dx + dy * dy));
+  SDL_Rect const bounds = {
+    dst->x + (int)cx - r, dst->y + (int)cy - r, r * 2 + 1, r * 2 + 1
+  };
+  return mrb_sdl2_video_renderer_cull(data, &bounds);
+}
+
 /*
  * SDL2::Video::Renderer.initialize
  */
@@ -197,6 +313,9 @@ mrb_sdl2_video_renderer_initialize(mrb_state *mrb, mrb_value self)
       mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
     }
     data->renderer = NULL;
+    data->culling  = false;
+  } else {
+    mrb_sdl2_video_renderer_watch(data, false);
   }
   SDL_Renderer *renderer = NULL;
   if (mrb_obj_is_instance_of(mrb, obj, mrb_class_get_under(mrb, mod_Video, "Window"))) {
@@ -213,7 +332,10 @@ mrb_sdl2_video_renderer_initialize(mrb_state *mrb, mrb_value self)
     mrb_free(mrb, data);
     mruby_sdl2_raise_error(mrb);
   }
-  data->renderer = renderer;
+  data->renderer  = renderer;
+  data->culling   = false;
+  data->cull_rect = (SDL_Rect){ 0, 0, 0, 0 };
+  data->culled    = 0;
   DATA_PTR(self) = data;
   DATA_TYPE(self) = &mrb_sdl2_video_renderer_data_type;
   return self;
@@ -227,6 +349,7 @@ mrb_sdl2_video_renderer_destroy(mrb_state *mrb, mrb_value self)
 {
   mrb_sdl2_video_renderer_data_t *data =
     (mrb_sdl2_video_renderer_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_video_renderer_data_type);
+  mrb_sdl2_video_renderer_watch(data, false);
   if (NULL != data->renderer) {
     SDL_DestroyRenderer(data->renderer);
     data->renderer = NULL;
@@ -308,6 +431,7 @@ mrb_sdl2_video_renderer_set_target(mrb_state *mrb, mrb_value self)
   if (0 != SDL_SetRenderTarget(renderer, texture)) {
     mruby_sdl2_raise_error(mrb);
   }
+  mrb_sdl2_video_renderer_update_cull_rect(mrb_sdl2_video_renderer_get_data(mrb, self));
   return self;
 }
 
@@ -347,6 +471,9 @@ mrb_sdl2_video_renderer_copy(mrb_state *mrb, mrb_value self)
   if (argc > 2) {
     dr = mrb_sdl2_rect_get_ptr(mrb, dst_rect);
   }
+  if (mrb_sdl2_video_renderer_cull(mrb_sdl2_video_renderer_get_data(mrb, self), dr)) {
+    return self;
+  }
   if (0 != SDL_RenderCopy(renderer, t, sr, dr)) {
     mruby_sdl2_raise_error(mrb);
   }
@@ -382,12 +509,76 @@ mrb_sdl2_video_renderer_copy_ex(mrb_state *mrb, mrb_value self)
   if (argc > 5) {
     f = (SDL_RendererFlip)flip;
   }
+  if (mrb_sdl2_video_renderer_cull_rotated(mrb_sdl2_video_renderer_get_data(mrb, self), dr, a, c)) {
+    return self;
+  }
   if (0 != SDL_RenderCopyEx(renderer, t, sr, dr, a, c, f)) {
     mruby_sdl2_raise_error(mrb);
   }
   return self;
 }
 
+/*
+ * SDL2::Video::Renderer#copy_ex_many(texture, instances [, count])
+ *
+ * 'instances' is a SDL2::FloatBuffer holding packed records of
+ * COPY_EX_RECORD_SIZE elements each:
+ *
+ *   src.x, src.y, src.w, src.h,
+ *   dst.x, dst.y, dst.w, dst.h,
+ *   angle, center.x, center.y, flags
+ *
+ * An empty src (or dst) rect selects the whole texture (or target).
+ * 'flags' holds SDL_RendererFlip bits; COPY_EX_USE_CENTER makes the center
+ * point valid, otherwise the rotation is done around the center of dst.
+ */
+#define MRB_SDL2_COPY_EX_RECORD_SIZE (12)
+#define MRB_SDL2_COPY_EX_USE_CENTER  (0x4)
+
+static mrb_value
+mrb_sdl2_video_renderer_copy_ex_many(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  SDL_Renderer *renderer = data->renderer;
+  mrb_value texture, instances;
+  mrb_int count;
+  int const argc = mrb_get_args(mrb, "oo|i", &texture, &instances, &count);
+  SDL_Texture *t = mrb_sdl2_video_texture_get_ptr(mrb, texture);
+  size_t elements;
+  float const *records = mrb_sdl2_misc_floatbuffer_get_ptr(mrb, instances, &elements);
+  size_t const n = elements / MRB_SDL2_COPY_EX_RECORD_SIZE;
+  if (argc > 2) {
+    if ((count < 0) || ((size_t)count > n)) {
+      mrb_raise(mrb, E_INDEX_ERROR, "count out of bounds.");
+    }
+  } else {
+    count = (mrb_int)n;
+  }
+  mrb_int i;
+  for (i = 0; i < count; ++i) {
+    float const * const r = &records[i * MRB_SDL2_COPY_EX_RECORD_SIZE];
+    SDL_Rect const src = { (int)r[0], (int)r[1], (int)r[2], (int)r[3] };
+    SDL_Rect const dst = { (int)r[4], (int)r[5], (int)r[6], (int)r[7] };
+    SDL_Point const center = { (int)r[9], (int)r[10] };
+    int const flags = (int)r[11];
+    SDL_Rect const * const dr = SDL_RectEmpty(&dst) ? NULL : &dst;
+    SDL_Point const * const c = (0 != (flags & MRB_SDL2_COPY_EX_USE_CENTER)) ? &center : NULL;
+    if (mrb_sdl2_video_renderer_cull_rotated(data, dr, (double)r[8], c)) {
+      continue;
+    }
+    if (0 != SDL_RenderCopyEx(
+          renderer, t,
+          SDL_RectEmpty(&src) ? NULL : &src,
+          dr,
+          (double)r[8],
+          c,
+          (SDL_RendererFlip)(flags & (SDL_FLIP_HORIZONTAL | SDL_FLIP_VERTICAL)))) {
+      mruby_sdl2_raise_error(mrb);
+    }
+  }
+  return self;
+}
+
 static mrb_value
 mrb_sdl2_video_renderer_draw_line(mrb_state *mrb, mrb_value self)
 {
@@ -402,6 +593,46 @@ mrb_sdl2_video_renderer_draw_line(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+/*
+ * Draws or fills the contents of a RectArray in one call. The packed
+ * storage is passed to SDL as-is unless culling is enabled, in which
+ * case the visible rects are compacted into a temporary buffer.
+ */
+static void
+mrb_sdl2_video_renderer_rects_packed(mrb_state *mrb, mrb_sdl2_video_renderer_data_t *data, SDL_Rect const *rects, int count, bool fill)
+{
+  SDL_Rect *visible = NULL;
+  int n = count;
+  int result;
+  if (data->culling && (0 < count)) {
+    int i;
+    visible = (SDL_Rect*)SDL_malloc(sizeof(SDL_Rect) * count);
+    if (NULL == visible) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    n = 0;
+    for (i = 0; i < count; ++i) {
+      if (!mrb_sdl2_video_renderer_cull(data, &rects[i])) {
+        visible[n++] = rects[i];
+      }
+    }
+    rects = visible;
+  }
+  if (0 == n) {
+    SDL_free(visible);
+    return;
+  }
+  if (fill) {
+    result = SDL_RenderFillRects(data->renderer, rects, n);
+  } else {
+    result = SDL_RenderDrawRects(data->renderer, rects, n);
+  }
+  SDL_free(visible);
+  if (0 != result) {
+    mruby_sdl2_raise_error(mrb);
+  }
+}
+
 static mrb_value
 mrb_sdl2_video_renderer_draw_lines(mrb_state *mrb, mrb_value self)
 {
@@ -409,6 +640,14 @@ mrb_sdl2_video_renderer_draw_lines(mrb_state *mrb, mrb_value self)
   mrb_value *argv;
   mrb_int argc;
   mrb_get_args(mrb, "*", &argv, &argc);
+  SDL_Point *packed;
+  int count;
+  if ((1 == argc) && mrb_sdl2_pointarray_get(argv[0], &packed, &count)) {
+    if ((0 < count) && (0 != SDL_RenderDrawLines(renderer, packed, count))) {
+      mruby_sdl2_raise_error(mrb);
+    }
+    return self;
+  }
   SDL_Point points[argc];
   mrb_int i;
   for (i = 0; i < argc; ++i) {
@@ -445,6 +684,14 @@ mrb_sdl2_video_renderer_draw_points(mrb_state *mrb, mrb_value self)
   mrb_value *argv;
   mrb_int argc;
   mrb_get_args(mrb, "*", &argv, &argc);
+  SDL_Point *packed;
+  int count;
+  if ((1 == argc) && mrb_sdl2_pointarray_get(argv[0], &packed, &count)) {
+    if ((0 < count) && (0 != SDL_RenderDrawPoints(renderer, packed, count))) {
+      mruby_sdl2_raise_error(mrb);
+    }
+    return self;
+  }
   SDL_Point points[argc];
   mrb_int i;
   for (i = 0; i < argc; ++i) {
@@ -468,6 +715,9 @@ mrb_sdl2_video_renderer_draw_rect(mrb_state *mrb, mrb_value self)
   mrb_value arg;
   mrb_get_args(mrb, "o", &arg);
   SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, arg);
+  if (mrb_sdl2_video_renderer_cull(mrb_sdl2_video_renderer_get_data(mrb, self), r)) {
+    return self;
+  }
   if (0 != SDL_RenderDrawRect(renderer, r)) {
     mruby_sdl2_raise_error(mrb);
   }
@@ -481,17 +731,24 @@ mrb_sdl2_video_renderer_draw_rects(mrb_state *mrb, mrb_value self)
   mrb_value *argv;
   mrb_int argc;
   mrb_get_args(mrb, "*", &argv, &argc);
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  SDL_Rect *packed;
+  int count;
+  if ((1 == argc) && mrb_sdl2_rectarray_get(argv[0], &packed, &count)) {
+    mrb_sdl2_video_renderer_rects_packed(mrb, data, packed, count, false);
+    return self;
+  }
   SDL_Rect rects[argc];
-  mrb_int i;
+  mrb_int i, n = 0;
   for (i = 0; i < argc; ++i) {
     SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, argv[i]);
-    if (NULL != r) {
-      rects[i] = *r;
-    } else {
-      rects[i] = (SDL_Rect){ 0, 0, 0, 0 };
+    if (NULL == r) {
+      rects[n++] = (SDL_Rect){ 0, 0, 0, 0 };
+    } else if (!mrb_sdl2_video_renderer_cull(data, r)) {
+      rects[n++] = *r;
     }
   }
-  if (0 != SDL_RenderDrawRects(renderer, rects, argc)) {
+  if ((0 < n) && (0 != SDL_RenderDrawRects(renderer, rects, n))) {
     mruby_sdl2_raise_error(mrb);
   }
   return self;
@@ -504,6 +761,9 @@ mrb_sdl2_video_renderer_fill_rect(mrb_state *mrb, mrb_value self)
   mrb_value arg;
   mrb_get_args(mrb, "o", &arg);
   SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, arg);
+  if (mrb_sdl2_video_renderer_cull(mrb_sdl2_video_renderer_get_data(mrb, self), r)) {
+    return self;
+  }
   if (0 != SDL_RenderFillRect(renderer, r)) {
     mruby_sdl2_raise_error(mrb);
   }
@@ -517,17 +777,24 @@ mrb_sdl2_video_renderer_fill_rects(mrb_state *mrb, mrb_value self)
   mrb_value *argv;
   mrb_int argc;
   mrb_get_args(mrb, "*", &argv, &argc);
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  SDL_Rect *packed;
+  int count;
+  if ((1 == argc) && mrb_sdl2_rectarray_get(argv[0], &packed, &count)) {
+    mrb_sdl2_video_renderer_rects_packed(mrb, data, packed, count, true);
+    return self;
+  }
   SDL_Rect rects[argc];
-  mrb_int i;
+  mrb_int i, n = 0;
   for (i = 0; i < argc; ++i) {
     SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, argv[i]);
-    if (NULL != r) {
-      rects[i] = *r;
-    } else {
-      rects[i] = (SDL_Rect){ 0, 0, 0, 0 };
+    if (NULL == r) {
+      rects[n++] = (SDL_Rect){ 0, 0, 0, 0 };
+    } else if (!mrb_sdl2_video_renderer_cull(data, r)) {
+      rects[n++] = *r;
     }
   }
-  if (0 != SDL_RenderFillRects(renderer, rects, argc)) {
+  if ((0 < n) && (0 != SDL_RenderFillRects(renderer, rects, n))) {
     mruby_sdl2_raise_error(mrb);
   }
   return self;
@@ -552,6 +819,7 @@ mrb_sdl2_video_renderer_set_clip_rect(mrb_state *mrb, mrb_value self)
   if (0 != SDL_RenderSetClipRect(renderer, rect)) {
     mruby_sdl2_raise_error(mrb);
   }
+  mrb_sdl2_video_renderer_update_cull_rect(mrb_sdl2_video_renderer_get_data(mrb, self));
   return self;
 }
 
@@ -574,6 +842,7 @@ mrb_sdl2_video_renderer_set_view_port(mrb_state *mrb, mrb_value self)
   if (0 != SDL_RenderSetViewport(renderer, rect)) {
     mruby_sdl2_raise_error(mrb);
   }
+  mrb_sdl2_video_renderer_update_cull_rect(mrb_sdl2_video_renderer_get_data(mrb, self));
   return self;
 }
 
@@ -601,6 +870,67 @@ mrb_sdl2_video_renderer_set_logical_size(mrb_state *mrb, mrb_value self)
   if (0 != SDL_RenderSetLogicalSize(renderer, w, h)) {
     mruby_sdl2_raise_error(mrb);
   }
+  mrb_sdl2_video_renderer_update_cull_rect(mrb_sdl2_video_renderer_get_data(mrb, self));
+  return self;
+}
+
+/*
+ * SDL2::Video::Renderer#culling=
+ *
+ * When enabled, copy/copy_ex/copy_ex_many and the rect drawing calls drop
+ * work whose destination lies entirely outside the cached visible area.
+ * The area follows resizes of the window through an SDL event watch.
+ */
+static mrb_value
+mrb_sdl2_video_renderer_set_culling(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  mrb_bool culling;
+  mrb_get_args(mrb, "b", &culling);
+  mrb_sdl2_video_renderer_watch(data, culling ? true : false);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_video_renderer_is_culling(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  return data->culling ? mrb_true_value() : mrb_false_value();
+}
+
+/*
+ * SDL2::Video::Renderer#refresh_cull_rect
+ *
+ * The visible area is re-read on view_port=, clip_rect=, target=,
+ * set_logical_size and when the window is resized; call this after
+ * anything else changed it.
+ */
+static mrb_value
+mrb_sdl2_video_renderer_refresh_cull_rect(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_update_cull_rect(mrb_sdl2_video_renderer_get_data(mrb, self));
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_video_renderer_get_cull_rect(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  return mrb_sdl2_rect_direct(mrb, &data->cull_rect);
+}
+
+static mrb_value
+mrb_sdl2_video_renderer_get_culled_count(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  return mrb_fixnum_value(data->culled);
+}
+
+static mrb_value
+mrb_sdl2_video_renderer_reset_culled_count(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_renderer_data_t *data = mrb_sdl2_video_renderer_get_data(mrb, self);
+  data->culled = 0;
   return self;
 }
 
@@ -911,6 +1241,7 @@ mruby_sdl2_video_renderer_init(mrb_state *mrb, struct RClass *mod_Video)
   mrb_define_method(mrb, class_Renderer, "clear",            mrb_sdl2_video_renderer_clear,               MRB_ARGS_NONE());
   mrb_define_method(mrb, class_Renderer, "copy",             mrb_sdl2_video_renderer_copy,                MRB_ARGS_REQ(1) | MRB_ARGS_OPT(2));
   mrb_define_method(mrb, class_Renderer, "copy_ex",          mrb_sdl2_video_renderer_copy_ex,             MRB_ARGS_REQ(1) | MRB_ARGS_OPT(5));
+  mrb_define_method(mrb, class_Renderer, "copy_ex_many",     mrb_sdl2_video_renderer_copy_ex_many,        MRB_ARGS_REQ(2) | MRB_ARGS_OPT(1));
   mrb_define_method(mrb, class_Renderer, "draw_line",        mrb_sdl2_video_renderer_draw_line,           MRB_ARGS_REQ(2));
   mrb_define_method(mrb, class_Renderer, "draw_lines",       mrb_sdl2_video_renderer_draw_lines,          MRB_ARGS_ANY());
   mrb_define_method(mrb, class_Renderer, "draw_point",       mrb_sdl2_video_renderer_draw_point,          MRB_ARGS_REQ(1));
@@ -926,6 +1257,12 @@ mruby_sdl2_video_renderer_init(mrb_state *mrb, struct RClass *mod_Video)
   mrb_define_method(mrb, class_Renderer, "present",          mrb_sdl2_video_renderer_present,             MRB_ARGS_NONE());
   mrb_define_method(mrb, class_Renderer, "read_pixels",      mrb_sdl2_video_renderer_read_pixels,         MRB_ARGS_REQ(1));
   mrb_define_method(mrb, class_Renderer, "set_logical_size", mrb_sdl2_video_renderer_set_logical_size,    MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_Renderer, "culling=",           mrb_sdl2_video_renderer_set_culling,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_Renderer, "culling?",           mrb_sdl2_video_renderer_is_culling,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Renderer, "cull_rect",          mrb_sdl2_video_renderer_get_cull_rect,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Renderer, "refresh_cull_rect",  mrb_sdl2_video_renderer_refresh_cull_rect,   MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Renderer, "culled_count",       mrb_sdl2_video_renderer_get_culled_count,    MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Renderer, "reset_culled_count", mrb_sdl2_video_renderer_reset_culled_count,  MRB_ARGS_NONE());
 
   int arena_size = mrb_gc_arena_save(mrb);
 
@@ -943,6 +1280,10 @@ mruby_sdl2_video_renderer_init(mrb_state *mrb, struct RClass *mod_Video)
   mrb_define_const(mrb, class_Renderer, "SDL_FLIP_HORIZONTAL", mrb_fixnum_value(SDL_FLIP_HORIZONTAL));
   mrb_define_const(mrb, class_Renderer, "SDL_FLIP_VERTICAL",   mrb_fixnum_value(SDL_FLIP_VERTICAL));
 
+  /* layout of records for copy_ex_many */
+  mrb_define_const(mrb, class_Renderer, "COPY_EX_RECORD_SIZE", mrb_fixnum_value(MRB_SDL2_COPY_EX_RECORD_SIZE));
+  mrb_define_const(mrb, class_Renderer, "COPY_EX_USE_CENTER",  mrb_fixnum_value(MRB_SDL2_COPY_EX_USE_CENTER));
+
   mrb_gc_arena_restore(mrb, arena_size);
   arena_size = mrb_gc_arena_save(mrb);
 
@@ -0,0 +1,539 @@
+#include "sdl2_resampler.h"
+#include "sdl2_audio.h"
+#include "float_kernels.h"
+#include "misc.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/array.h"
+#include "mruby/string.h"
+#include <math.h>
+#include <limits.h>
+
+/*
+ * SDL2::Audio::Resampler converts float PCM between sample rates with a
+ * polyphase windowed-sinc (Kaiser) filter.
+ *
+ * The rate ratio is reduced to up/down. While 'up' fits in the phase
+ * table every output sample uses an exact filter phase; otherwise the
+ * table is sampled at RESAMPLER_MAX_PHASES points and adjacent phases are
+ * interpolated. Input is kept per channel in a planar history so each
+ * output sample is one dot product, done by the float SIMD kernels. All
+ * storage is allocated up front; process() never allocates.
+ */
+
+#define RESAMPLER_MAX_PHASES 1024
+#define RESAMPLER_BLOCK      512  /* input frames buffered per refill. */
+#define RESAMPLER_MAX_RATIO  16
+/* keeps rate * RESAMPLER_MAX_RATIO within int. */
+#define RESAMPLER_MAX_RATE   (INT_MAX / RESAMPLER_MAX_RATIO)
+
+static struct RClass *class_Resampler = NULL;
+
+typedef struct mrb_sdl2_resampler_quality_t {
+  Uint32 taps;
+  double rolloff; /* cutoff relative to the lower Nyquist frequency. */
+  double beta;    /* Kaiser window shape. */
+} mrb_sdl2_resampler_quality_t;
+
+static mrb_sdl2_resampler_quality_t const mrb_sdl2_resampler_qualities[] = {
+  {  16, 0.80,  5.0 }, /* LOW */
+  {  32, 0.90,  7.0 }, /* MEDIUM */
+  {  64, 0.94,  8.6 }, /* HIGH */
+  { 128, 0.96, 10.0 }, /* BEST */
+};
+
+struct mrb_sdl2_resampler_t {
+  int     channels;
+  int     in_rate;
+  int     out_rate;
+  int     quality;
+  Uint32  taps;
+  Uint32  up;        /* out_rate / gcd */
+  Uint32  down;      /* in_rate / gcd */
+  Uint32  phases;    /* table phases; equal to 'up' when exact. */
+  float  *coeffs;    /* (phases + 1) rows of 'taps' coefficients. */
+  float  *history;   /* 'channels' rows of 'capacity' frames. */
+  Uint32  capacity;
+  Uint32  filled;    /* frames held in the history. */
+  Uint32  index;     /* first history frame of the next output's window. */
+  Uint32  num;       /* output position past 'index', in 1/up input frames. */
+  Uint64  in_total;  /* input frames taken since the last reset. */
+  Uint64  out_total; /* output frames written since the last reset. */
+};
+
+static void
+mrb_sdl2_resampler_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_resampler_destroy(mrb, (mrb_sdl2_resampler_t*)p);
+}
+
+static struct mrb_data_type const mrb_sdl2_resampler_data_type = {
+  "Resampler", mrb_sdl2_resampler_data_free
+};
+
+mrb_sdl2_resampler_t *
+mrb_sdl2_resampler_get_ptr(mrb_state *mrb, mrb_value value)
+{
+  if (mrb_nil_p(value)) {
+    return NULL;
+  }
+  return (mrb_sdl2_resampler_t*)mrb_data_get_ptr(mrb, value, &mrb_sdl2_resampler_data_type);
+}
+
+static Uint32
+mrb_sdl2_resampler_gcd(Uint32 a, Uint32 b)
+{
+  while (0 != b) {
+    Uint32 const t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* modified Bessel function of the first kind, order 0. */
+static double
+mrb_sdl2_resampler_bessel_i0(double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+  double const q = x * x / 4.0;
+  int k;
+  for (k = 1; k < 64; ++k) {
+    term *= q / ((double)k * (double)k);
+    sum += term;
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+  return sum;
+}
+
+/*
+ * Row p holds the filter for an output lying p/phases of an input frame
+ * past the window's centre tap; each row is normalised to unity DC gain.
+ */
+static void
+mrb_sdl2_resampler_build_table(mrb_sdl2_resampler_t *r, mrb_sdl2_resampler_quality_t const *q)
+{
+  double const cutoff = q->rolloff * ((r->up < r->down) ? (double)r->up / (double)r->down : 1.0);
+  double const i0_beta = mrb_sdl2_resampler_bessel_i0(q->beta);
+  int const half = (int)(r->taps / 2);
+  Uint32 p, j;
+  for (p = 0; p <= r->phases; ++p) {
+    float *row = r->coeffs + (size_t)p * r->taps;
+    double const frac = (double)p / (double)r->phases;
+    double sum = 0.0;
+    for (j = 0; j < r->taps; ++j) {
+      double const d = frac + (double)(half - 1) - (double)j;
+      double const x = d / (double)half;
+      double h = cutoff;
+      if (0.0 != d) {
+        h = sin(M_PI * cutoff * d) / (M_PI * d);
+      }
+      if (1.0 > x * x) {
+        h *= mrb_sdl2_resampler_bessel_i0(q->beta * sqrt(1.0 - x * x)) / i0_beta;
+      } else {
+        h = 0.0;
+      }
+      row[j] = (float)h;
+      sum += h;
+    }
+    for (j = 0; j < r->taps; ++j) {
+      row[j] = (float)(row[j] / sum);
+    }
+  }
+}
+
+void
+mrb_sdl2_resampler_reset(mrb_sdl2_resampler_t *r)
+{
+  /* half a window of leading silence lines the first output up with the first input. */
+  Uint32 const lead = r->taps / 2 - 1;
+  int c;
+  for (c = 0; c < r->channels; ++c) {
+    SDL_memset(r->history + (size_t)c * r->capacity, 0, sizeof(float) * lead);
+  }
+  r->filled    = lead;
+  r->index     = 0;
+  r->num       = 0;
+  r->in_total  = 0;
+  r->out_total = 0;
+}
+
+mrb_sdl2_resampler_t *
+mrb_sdl2_resampler_create(mrb_state *mrb, int channels, int in_rate, int out_rate, int quality)
+{
+  if ((1 > channels) || (255 < channels)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid number of channels.");
+  }
+  if ((0 >= in_rate) || (0 >= out_rate)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "sample rate must be positive.");
+  }
+  if ((RESAMPLER_MAX_RATE < in_rate) || (RESAMPLER_MAX_RATE < out_rate)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "sample rate out of range.");
+  }
+  if ((in_rate > out_rate * RESAMPLER_MAX_RATIO) || (out_rate > in_rate * RESAMPLER_MAX_RATIO)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "rate ratio out of range.");
+  }
+  if ((MRB_SDL2_RESAMPLER_LOW > quality) || (MRB_SDL2_RESAMPLER_BEST < quality)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unknown quality.");
+  }
+
+  mrb_sdl2_resampler_quality_t const *q = &mrb_sdl2_resampler_qualities[quality];
+  Uint32 const g = mrb_sdl2_resampler_gcd((Uint32)in_rate, (Uint32)out_rate);
+  mrb_sdl2_resampler_t *r =
+    (mrb_sdl2_resampler_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_resampler_t));
+  if (NULL == r) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  r->channels = channels;
+  r->in_rate  = in_rate;
+  r->out_rate = out_rate;
+  r->quality  = quality;
+  r->taps     = q->taps;
+  r->up       = (Uint32)out_rate / g;
+  r->down     = (Uint32)in_rate / g;
+  r->phases   = (RESAMPLER_MAX_PHASES < r->up) ? RESAMPLER_MAX_PHASES : r->up;
+  r->capacity = r->taps + RESAMPLER_BLOCK;
+  r->coeffs   = (float*)mrb_malloc(mrb, sizeof(float) * (r->phases + 1) * r->taps);
+  r->history  = (float*)mrb_malloc(mrb, sizeof(float) * r->capacity * (size_t)channels);
+  if ((NULL == r->coeffs) || (NULL == r->history)) {
+    mrb_sdl2_resampler_destroy(mrb, r);
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  mrb_sdl2_resampler_build_table(r, q);
+  mrb_sdl2_resampler_reset(r);
+  return r;
+}
+
+void
+mrb_sdl2_resampler_destroy(mrb_state *mrb, mrb_sdl2_resampler_t *r)
+{
+  if (NULL != r) {
+    mrb_free(mrb, r->coeffs);
+    mrb_free(mrb, r->history);
+    mrb_free(mrb, r);
+  }
+}
+
+/* writes output frames while a full window is buffered; returns the new 'produced'. */
+static Uint32
+mrb_sdl2_resampler_produce(mrb_sdl2_resampler_t *r, float *dst, Uint32 produced, Uint32 limit)
+{
+  Uint32 const taps = r->taps;
+  Uint32 const start = produced;
+  int const channels = r->channels;
+  int c;
+  while ((produced < limit) && (r->index + taps <= r->filled)) {
+    float *out = dst + (size_t)produced * channels;
+    if (r->phases == r->up) {
+      float const *row = r->coeffs + (size_t)r->num * taps;
+      for (c = 0; c < channels; ++c) {
+        out[c] = mrb_sdl2_float_kernels_dot(r->history + (size_t)c * r->capacity + r->index, row, taps);
+      }
+    } else {
+      double const pos = (double)r->num * (double)r->phases / (double)r->up;
+      Uint32 const p = (Uint32)pos;
+      float const w = (float)(pos - (double)p);
+      float const *row0 = r->coeffs + (size_t)p * taps;
+      float const *row1 = row0 + taps;
+      for (c = 0; c < channels; ++c) {
+        float const *x = r->history + (size_t)c * r->capacity + r->index;
+        float const a = mrb_sdl2_float_kernels_dot(x, row0, taps);
+        float const b = mrb_sdl2_float_kernels_dot(x, row1, taps);
+        out[c] = a + (b - a) * w;
+      }
+    }
+    ++produced;
+    r->num   += r->down;
+    r->index += r->num / r->up;
+    r->num   %= r->up;
+  }
+  r->out_total += produced - start;
+  return produced;
+}
+
+/* drops history frames no future window can reach. */
+static void
+mrb_sdl2_resampler_compact(mrb_sdl2_resampler_t *r)
+{
+  Uint32 const drop = SDL_min(r->index, r->filled);
+  int c;
+  if (0 == drop) {
+    return;
+  }
+  for (c = 0; c < r->channels; ++c) {
+    float *row = r->history + (size_t)c * r->capacity;
+    SDL_memmove(row, row + drop, sizeof(float) * (r->filled - drop));
+  }
+  r->filled -= drop;
+  r->index  -= drop;
+}
+
+/* de-interleaves up to 'frames' frames into the history; NULL 'src' appends silence. */
+static Uint32
+mrb_sdl2_resampler_append(mrb_sdl2_resampler_t *r, float const *src, Uint32 frames)
+{
+  Uint32 const n = SDL_min(frames, r->capacity - r->filled);
+  int const channels = r->channels;
+  Uint32 i;
+  int c;
+  for (c = 0; c < channels; ++c) {
+    float *row = r->history + (size_t)c * r->capacity + r->filled;
+    if (NULL == src) {
+      SDL_memset(row, 0, sizeof(float) * n);
+    } else {
+      for (i = 0; i < n; ++i) {
+        row[i] = src[(size_t)i * channels + c];
+      }
+    }
+  }
+  r->filled += n;
+  return n;
+}
+
+Uint32
+mrb_sdl2_resampler_process(mrb_sdl2_resampler_t *r,
+                           float const *src, Uint32 src_frames, Uint32 *consumed,
+                           float *dst, Uint32 dst_frames)
+{
+  Uint32 taken = 0;
+  Uint32 produced = 0;
+  for (;;) {
+    produced = mrb_sdl2_resampler_produce(r, dst, produced, dst_frames);
+    if ((produced == dst_frames) || (taken == src_frames)) {
+      break;
+    }
+    mrb_sdl2_resampler_compact(r);
+    taken += mrb_sdl2_resampler_append(r, src + (size_t)taken * r->channels, src_frames - taken);
+  }
+  r->in_total += taken;
+  if (NULL != consumed) {
+    *consumed = taken;
+  }
+  return produced;
+}
+
+Uint32
+mrb_sdl2_resampler_drain(mrb_sdl2_resampler_t *r, float *dst, Uint32 dst_frames)
+{
+  /* every input frame maps to up/down output frames; stop there rather than at the padding. */
+  Uint64 const expected = (r->in_total * r->up + r->down - 1) / r->down;
+  Uint32 const limit = (Uint32)SDL_min((Uint64)dst_frames, expected - SDL_min(expected, r->out_total));
+  Uint32 produced = 0;
+  for (;;) {
+    produced = mrb_sdl2_resampler_produce(r, dst, produced, limit);
+    if (produced == limit) {
+      break;
+    }
+    mrb_sdl2_resampler_compact(r);
+    mrb_sdl2_resampler_append(r, NULL, r->taps);
+  }
+  return produced;
+}
+
+/***************************************************************************
+*
+* class SDL2::Audio::Resampler
+*
+***************************************************************************/
+
+/*
+ * SDL2::Audio::Resampler#initialize(channels, in_rate, out_rate, quality = MEDIUM)
+ */
+static mrb_value
+mrb_sdl2_resampler_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_int channels, in_rate, out_rate;
+  mrb_int quality = MRB_SDL2_RESAMPLER_MEDIUM;
+  mrb_get_args(mrb, "iii|i", &channels, &in_rate, &out_rate, &quality);
+  if ((1 > in_rate) || (RESAMPLER_MAX_RATE < in_rate) ||
+      (1 > out_rate) || (RESAMPLER_MAX_RATE < out_rate)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "sample rate out of range.");
+  }
+  mrb_sdl2_resampler_t *r =
+    mrb_sdl2_resampler_create(mrb, (int)channels, (int)in_rate, (int)out_rate, (int)quality);
+  if (NULL != DATA_PTR(self)) {
+    mrb_sdl2_resampler_destroy(mrb, (mrb_sdl2_resampler_t*)DATA_PTR(self));
+  }
+  DATA_PTR(self)  = r;
+  DATA_TYPE(self) = &mrb_sdl2_resampler_data_type;
+  return self;
+}
+
+static mrb_sdl2_resampler_t *
+mrb_sdl2_resampler_self(mrb_state *mrb, mrb_value self)
+{
+  return (mrb_sdl2_resampler_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_resampler_data_type);
+}
+
+/* frames of 'buffer' from 'offset' on; raises IndexError past the end. */
+static float *
+mrb_sdl2_resampler_frames(mrb_state *mrb, mrb_sdl2_resampler_t const *r, mrb_value buffer, mrb_int offset, Uint32 *frames)
+{
+  size_t count;
+  float *ptr = mrb_sdl2_misc_floatbuffer_get_ptr(mrb, buffer, &count);
+  size_t const total = count / (size_t)r->channels;
+  if ((0 > offset) || ((size_t)offset > total)) {
+    mrb_raise(mrb, E_INDEX_ERROR, "offset out of range.");
+  }
+  *frames = (Uint32)SDL_min(total - (size_t)offset, (size_t)0xFFFFFFFFu);
+  return ptr + (size_t)offset * r->channels;
+}
+
+/*
+ * SDL2::Audio::Resampler#process(src, dst, src_offset = 0, dst_offset = 0)
+ * Converts interleaved frames of FloatBuffer 'src' into FloatBuffer 'dst'
+ * (offsets are in frames) and returns [frames consumed, frames written].
+ * Input left over because 'dst' filled up must be passed again.
+ */
+static mrb_value
+mrb_sdl2_resampler_process_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_value src, dst;
+  mrb_int src_offset = 0, dst_offset = 0;
+  mrb_get_args(mrb, "oo|ii", &src, &dst, &src_offset, &dst_offset);
+  mrb_sdl2_resampler_t *r = mrb_sdl2_resampler_self(mrb, self);
+  Uint32 src_frames, dst_frames, consumed;
+  float const *in = mrb_sdl2_resampler_frames(mrb, r, src, src_offset, &src_frames);
+  float *out = mrb_sdl2_resampler_frames(mrb, r, dst, dst_offset, &dst_frames);
+  Uint32 const produced = mrb_sdl2_resampler_process(r, in, src_frames, &consumed, out, dst_frames);
+  mrb_value values[2] = {
+    mrb_fixnum_value((mrb_int)consumed),
+    mrb_fixnum_value((mrb_int)produced)
+  };
+  return mrb_ary_new_from_values(mrb, 2, values);
+}
+
+/*
+ * SDL2::Audio::Resampler#drain(dst, dst_offset = 0)
+ * Writes the tail held back by the filter at the end of the input and
+ * returns the number of frames written; call reset before reusing.
+ */
+static mrb_value
+mrb_sdl2_resampler_drain_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_value dst;
+  mrb_int dst_offset = 0;
+  mrb_get_args(mrb, "o|i", &dst, &dst_offset);
+  mrb_sdl2_resampler_t *r = mrb_sdl2_resampler_self(mrb, self);
+  Uint32 dst_frames;
+  float *out = mrb_sdl2_resampler_frames(mrb, r, dst, dst_offset, &dst_frames);
+  return mrb_fixnum_value((mrb_int)mrb_sdl2_resampler_drain(r, out, dst_frames));
+}
+
+static mrb_value
+mrb_sdl2_resampler_reset_m(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_resampler_reset(mrb_sdl2_resampler_self(mrb, self));
+  return self;
+}
+
+/*
+ * SDL2::Audio::Resampler#output_frames(input_frames)
+ * Upper bound on the frames process() writes for that much input.
+ */
+static mrb_value
+mrb_sdl2_resampler_output_frames(mrb_state *mrb, mrb_value self)
+{
+  mrb_int frames;
+  mrb_get_args(mrb, "i", &frames);
+  mrb_sdl2_resampler_t *r = mrb_sdl2_resampler_self(mrb, self);
+  if (0 > frames) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "negative frame count.");
+  }
+  if (SDL_MAX_UINT32 < (Uint64)frames) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "frame count out of range.");
+  }
+  Uint64 const n = ((Uint64)frames * r->up + r->down - 1) / r->down + 1;
+  if ((Uint64)MRB_INT_MAX < n) {
+    return mrb_fixnum_value(MRB_INT_MAX);
+  }
+  return mrb_fixnum_value((mrb_int)n);
+}
+
+/* input frames read ahead of the output. */
+static mrb_value
+mrb_sdl2_resampler_get_latency(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value((mrb_int)(mrb_sdl2_resampler_self(mrb, self)->taps / 2));
+}
+
+static mrb_value
+mrb_sdl2_resampler_get_channels(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_resampler_self(mrb, self)->channels);
+}
+
+static mrb_value
+mrb_sdl2_resampler_get_in_rate(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_resampler_self(mrb, self)->in_rate);
+}
+
+static mrb_value
+mrb_sdl2_resampler_get_out_rate(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_resampler_self(mrb, self)->out_rate);
+}
+
+static mrb_value
+mrb_sdl2_resampler_get_quality(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_resampler_self(mrb, self)->quality);
+}
+
+static mrb_value
+mrb_sdl2_resampler_get_taps(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value((mrb_int)mrb_sdl2_resampler_self(mrb, self)->taps);
+}
+
+/* true when every output sample uses an exact filter phase. */
+static mrb_value
+mrb_sdl2_resampler_is_exact(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_resampler_t const *r = mrb_sdl2_resampler_self(mrb, self);
+  return mrb_bool_value(r->phases == r->up);
+}
+
+static mrb_value
+mrb_sdl2_resampler_s_simd_backend(mrb_state *mrb, mrb_value klass)
+{
+  return mrb_str_new_cstr(mrb, mrb_sdl2_float_kernels_backend());
+}
+
+
+void
+mruby_sdl2_resampler_init(mrb_state *mrb)
+{
+  class_Resampler = mrb_define_class_under(mrb, mod_Audio, "Resampler", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_Resampler, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_Resampler, "initialize",    mrb_sdl2_resampler_initialize,    MRB_ARGS_REQ(3) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_Resampler, "process",       mrb_sdl2_resampler_process_m,     MRB_ARGS_REQ(2) | MRB_ARGS_OPT(2));
+  mrb_define_method(mrb, class_Resampler, "drain",         mrb_sdl2_resampler_drain_m,       MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_Resampler, "reset",         mrb_sdl2_resampler_reset_m,       MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "output_frames", mrb_sdl2_resampler_output_frames, MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_Resampler, "latency",       mrb_sdl2_resampler_get_latency,   MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "channels",      mrb_sdl2_resampler_get_channels,  MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "in_rate",       mrb_sdl2_resampler_get_in_rate,   MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "out_rate",      mrb_sdl2_resampler_get_out_rate,  MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "quality",       mrb_sdl2_resampler_get_quality,   MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "taps",          mrb_sdl2_resampler_get_taps,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Resampler, "exact?",        mrb_sdl2_resampler_is_exact,      MRB_ARGS_NONE());
+
+  mrb_define_class_method(mrb, class_Resampler, "simd_backend", mrb_sdl2_resampler_s_simd_backend, MRB_ARGS_NONE());
+
+  mrb_define_const(mrb, class_Resampler, "LOW",    mrb_fixnum_value(MRB_SDL2_RESAMPLER_LOW));
+  mrb_define_const(mrb, class_Resampler, "MEDIUM", mrb_fixnum_value(MRB_SDL2_RESAMPLER_MEDIUM));
+  mrb_define_const(mrb, class_Resampler, "HIGH",   mrb_fixnum_value(MRB_SDL2_RESAMPLER_HIGH));
+  mrb_define_const(mrb, class_Resampler, "BEST",   mrb_fixnum_value(MRB_SDL2_RESAMPLER_BEST));
+}
+
+void
+mruby_sdl2_resampler_final(mrb_state *mrb)
+{
+}
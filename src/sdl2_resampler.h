@@ -0,0 +1,46 @@
+#ifndef MRUBY_SDL2_RESAMPLER_H
+#define MRUBY_SDL2_RESAMPLER_H
+
+#include "sdl2.h"
+#include <SDL2/SDL_stdinc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mrb_sdl2_resampler_t mrb_sdl2_resampler_t;
+
+enum {
+  MRB_SDL2_RESAMPLER_LOW,
+  MRB_SDL2_RESAMPLER_MEDIUM,
+  MRB_SDL2_RESAMPLER_HIGH,
+  MRB_SDL2_RESAMPLER_BEST,
+};
+
+extern void mruby_sdl2_resampler_init(mrb_state *mrb);
+extern void mruby_sdl2_resampler_final(mrb_state *mrb);
+
+extern mrb_sdl2_resampler_t *mrb_sdl2_resampler_get_ptr(mrb_state *mrb, mrb_value value);
+
+/* raises ArgumentError for unsupported parameters. */
+extern mrb_sdl2_resampler_t *mrb_sdl2_resampler_create(mrb_state *mrb, int channels, int in_rate, int out_rate, int quality);
+extern void                  mrb_sdl2_resampler_destroy(mrb_state *mrb, mrb_sdl2_resampler_t *resampler);
+
+/*
+ * converts interleaved float frames; stores the number of 'src' frames
+ * taken to 'consumed' and returns the number of frames written to 'dst'.
+ * input that does not fit is left to the next call. 'src' may be NULL
+ * when 'src_frames' is 0. neither function allocates or touches the VM.
+ */
+extern Uint32 mrb_sdl2_resampler_process(mrb_sdl2_resampler_t *resampler,
+                                         float const *src, Uint32 src_frames, Uint32 *consumed,
+                                         float *dst, Uint32 dst_frames);
+/* writes the frames still held back by the filter after the last input. */
+extern Uint32 mrb_sdl2_resampler_drain(mrb_sdl2_resampler_t *resampler, float *dst, Uint32 dst_frames);
+extern void   mrb_sdl2_resampler_reset(mrb_sdl2_resampler_t *resampler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_RESAMPLER_H */
@@ -0,0 +1,415 @@
+#include "sdl2_rwops.h"
+#include "misc.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/string.h"
+#include "mruby/variable.h"
+
+static struct RClass *class_RWops = NULL;
+
+typedef struct mrb_sdl2_rwops_data_t {
+  SDL_RWops *rwops;
+} mrb_sdl2_rwops_data_t;
+
+static void
+mrb_sdl2_rwops_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_rwops_data_t *data =
+    (mrb_sdl2_rwops_data_t*)p;
+  if (NULL != data) {
+    if (NULL != data->rwops) {
+      SDL_RWclose(data->rwops);
+    }
+    mrb_free(mrb, data);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_rwops_data_type = {
+  "RWops", mrb_sdl2_rwops_data_free
+};
+
+SDL_RWops *
+mrb_sdl2_rwops_get_ptr(mrb_state *mrb, mrb_value rwops)
+{
+  mrb_sdl2_rwops_data_t *data =
+    (mrb_sdl2_rwops_data_t*)mrb_data_get_ptr(mrb, rwops, &mrb_sdl2_rwops_data_type);
+  if (NULL == data->rwops) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "RWops is already closed.");
+  }
+  return data->rwops;
+}
+
+mrb_value
+mrb_sdl2_rwops(mrb_state *mrb, SDL_RWops *rwops, mrb_value owner)
+{
+  mrb_sdl2_rwops_data_t *data =
+    (mrb_sdl2_rwops_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_rwops_data_t));
+  if (NULL == data) {
+    SDL_RWclose(rwops);
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  data->rwops = rwops;
+  mrb_value const self = mrb_obj_value(Data_Wrap_Struct(mrb, class_RWops, &mrb_sdl2_rwops_data_type, data));
+  if (!mrb_nil_p(owner)) {
+    /* memory backing the RWops must outlive it. */
+    mrb_iv_set(mrb, self, mrb_intern(mrb, "owner", 5), owner);
+  }
+  return self;
+}
+
+/***************************************************************************
+*
+* read-only subrange of another RWops
+*
+***************************************************************************/
+
+typedef struct mrb_sdl2_rwops_subrange_t {
+  SDL_RWops *base;
+  Sint64     offset;
+  Sint64     length;
+  Sint64     pos;
+} mrb_sdl2_rwops_subrange_t;
+
+static Sint64
+mrb_sdl2_rwops_subrange_size(SDL_RWops *context)
+{
+  mrb_sdl2_rwops_subrange_t const *range =
+    (mrb_sdl2_rwops_subrange_t const*)context->hidden.unknown.data1;
+  return range->length;
+}
+
+static Sint64
+mrb_sdl2_rwops_subrange_seek(SDL_RWops *context, Sint64 offset, int whence)
+{
+  mrb_sdl2_rwops_subrange_t *range =
+    (mrb_sdl2_rwops_subrange_t*)context->hidden.unknown.data1;
+  Sint64 pos;
+  switch (whence) {
+  case RW_SEEK_SET:
+    pos = offset;
+    break;
+  case RW_SEEK_CUR:
+    pos = range->pos + offset;
+    break;
+  case RW_SEEK_END:
+    pos = range->length + offset;
+    break;
+  default:
+    return SDL_SetError("Unknown value for 'whence'");
+  }
+  if (pos < 0) {
+    return SDL_SetError("Seek before the beginning of the range");
+  }
+  if (pos > range->length) {
+    pos = range->length;
+  }
+  if (pos != range->pos) {
+    if (0 > SDL_RWseek(range->base, range->offset + pos, RW_SEEK_SET)) {
+      return -1;
+    }
+    range->pos = pos;
+  }
+  return pos;
+}
+
+static size_t
+mrb_sdl2_rwops_subrange_read(SDL_RWops *context, void *ptr, size_t size, size_t maxnum)
+{
+  mrb_sdl2_rwops_subrange_t *range =
+    (mrb_sdl2_rwops_subrange_t*)context->hidden.unknown.data1;
+  if (0 == size) {
+    return 0;
+  }
+  size_t const avail = (size_t)((range->length - range->pos) / (Sint64)size);
+  size_t const num = SDL_min(maxnum, avail);
+  if (0 == num) {
+    return 0;
+  }
+  size_t const n = SDL_RWread(range->base, ptr, size, num);
+  range->pos += (Sint64)(n * size);
+  if (n < num) {
+    /* a partial object may have been consumed; resync the base. */
+    SDL_RWseek(range->base, range->offset + range->pos, RW_SEEK_SET);
+  }
+  return n;
+}
+
+static size_t
+mrb_sdl2_rwops_subrange_write(SDL_RWops *context, void const *ptr, size_t size, size_t num)
+{
+  SDL_SetError("RWops subrange is read-only");
+  return 0;
+}
+
+static int
+mrb_sdl2_rwops_subrange_close(SDL_RWops *context)
+{
+  int ret = 0;
+  if (NULL != context) {
+    mrb_sdl2_rwops_subrange_t *range =
+      (mrb_sdl2_rwops_subrange_t*)context->hidden.unknown.data1;
+    if (NULL != range) {
+      ret = SDL_RWclose(range->base);
+      SDL_free(range);
+    }
+    SDL_FreeRW(context);
+  }
+  return ret;
+}
+
+/*
+ * Returns NULL on error, in which case 'base' is left open.
+ * A negative 'length' means up to the end of 'base'.
+ */
+SDL_RWops *
+mrb_sdl2_rwops_subrange(SDL_RWops *base, Sint64 offset, Sint64 length)
+{
+  Sint64 const size = SDL_RWsize(base);
+  if (0 > size) {
+    return NULL;
+  }
+  if ((0 > offset) || (offset > size)) {
+    SDL_SetError("RWops offset is out of range");
+    return NULL;
+  }
+  if (0 > length) {
+    length = size - offset;
+  }
+  if (length > size - offset) {
+    SDL_SetError("RWops length is out of range");
+    return NULL;
+  }
+  if (0 > SDL_RWseek(base, offset, RW_SEEK_SET)) {
+    return NULL;
+  }
+  mrb_sdl2_rwops_subrange_t *range =
+    (mrb_sdl2_rwops_subrange_t*)SDL_malloc(sizeof(mrb_sdl2_rwops_subrange_t));
+  if (NULL == range) {
+    SDL_OutOfMemory();
+    return NULL;
+  }
+  SDL_RWops *rw = SDL_AllocRW();
+  if (NULL == rw) {
+    SDL_free(range);
+    return NULL;
+  }
+  range->base   = base;
+  range->offset = offset;
+  range->length = length;
+  range->pos    = 0;
+  rw->size  = mrb_sdl2_rwops_subrange_size;
+  rw->seek  = mrb_sdl2_rwops_subrange_seek;
+  rw->read  = mrb_sdl2_rwops_subrange_read;
+  rw->write = mrb_sdl2_rwops_subrange_write;
+  rw->close = mrb_sdl2_rwops_subrange_close;
+  rw->type  = SDL_RWOPS_UNKNOWN;
+  rw->hidden.unknown.data1 = range;
+  return rw;
+}
+
+/***************************************************************************
+*
+* class SDL2::RWops
+*
+***************************************************************************/
+
+/*
+ * SDL2::RWops::from_file(path [, mode [, offset [, length]]])
+ *
+ * With an offset or a non-negative length, the returned RWops is a
+ * read-only view of that region of the file.
+ */
+static mrb_value
+mrb_sdl2_rwops_s_from_file(mrb_state *mrb, mrb_value self)
+{
+  mrb_value path, mode = mrb_nil_value();
+  mrb_int offset = 0, length = -1;
+  mrb_get_args(mrb, "S|Sii", &path, &mode, &offset, &length);
+  char const *m = mrb_nil_p(mode) ? "rb" : RSTRING_PTR(mode);
+  SDL_RWops *rw = SDL_RWFromFile(RSTRING_PTR(path), m);
+  if (NULL == rw) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  if ((0 != offset) || (0 <= length)) {
+    SDL_RWops *range = mrb_sdl2_rwops_subrange(rw, (Sint64)offset, (Sint64)length);
+    if (NULL == range) {
+      SDL_RWclose(rw);
+      mruby_sdl2_raise_error(mrb);
+    }
+    rw = range;
+  }
+  return mrb_sdl2_rwops(mrb, rw, mrb_nil_value());
+}
+
+/*
+ * SDL2::RWops::from_memory(string)
+ *
+ * Reads from a private copy of the string.
+ */
+static mrb_value
+mrb_sdl2_rwops_s_from_memory(mrb_state *mrb, mrb_value self)
+{
+  mrb_value str;
+  mrb_get_args(mrb, "S", &str);
+  mrb_value const copy = mrb_str_dup(mrb, str);
+  SDL_RWops *rw = SDL_RWFromConstMem(RSTRING_PTR(copy), RSTRING_LEN(copy));
+  if (NULL == rw) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_sdl2_rwops(mrb, rw, copy);
+}
+
+/*
+ * SDL2::RWops::from_buffer(buffer)
+ *
+ * Reads and writes the memory of a SDL2::Buffer without copying it.
+ */
+static mrb_value
+mrb_sdl2_rwops_s_from_buffer(mrb_state *mrb, mrb_value self)
+{
+  mrb_value buffer;
+  mrb_get_args(mrb, "o", &buffer);
+  size_t size;
+  void *ptr = mrb_sdl2_misc_buffer_get_ptr(mrb, buffer, &size);
+  if (size > (size_t)SDL_MAX_SINT32) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "buffer is too large.");
+  }
+  SDL_RWops *rw = SDL_RWFromMem(ptr, (int)size);
+  if (NULL == rw) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_sdl2_rwops(mrb, rw, buffer);
+}
+
+static mrb_value
+mrb_sdl2_rwops_get_size(mrb_state *mrb, mrb_value self)
+{
+  Sint64 const size = SDL_RWsize(mrb_sdl2_rwops_get_ptr(mrb, self));
+  if (0 > size) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_fixnum_value((mrb_int)size);
+}
+
+static mrb_value
+mrb_sdl2_rwops_seek(mrb_state *mrb, mrb_value self)
+{
+  mrb_int offset, whence = RW_SEEK_SET;
+  mrb_get_args(mrb, "i|i", &offset, &whence);
+  Sint64 const pos = SDL_RWseek(mrb_sdl2_rwops_get_ptr(mrb, self), (Sint64)offset, (int)whence);
+  if (0 > pos) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_fixnum_value((mrb_int)pos);
+}
+
+static mrb_value
+mrb_sdl2_rwops_tell(mrb_state *mrb, mrb_value self)
+{
+  Sint64 const pos = SDL_RWtell(mrb_sdl2_rwops_get_ptr(mrb, self));
+  if (0 > pos) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_fixnum_value((mrb_int)pos);
+}
+
+/*
+ * SDL2::RWops#read([length])
+ *
+ * Reads up to 'length' bytes (everything left by default).
+ * Returns nil at the end of the stream.
+ */
+static mrb_value
+mrb_sdl2_rwops_read(mrb_state *mrb, mrb_value self)
+{
+  mrb_int length = -1;
+  mrb_get_args(mrb, "|i", &length);
+  SDL_RWops *rw = mrb_sdl2_rwops_get_ptr(mrb, self);
+  Sint64 n = (Sint64)length;
+  if (0 > length) {
+    Sint64 const size = SDL_RWsize(rw);
+    Sint64 const pos  = SDL_RWtell(rw);
+    if ((0 > size) || (0 > pos)) {
+      mruby_sdl2_raise_error(mrb);
+    }
+    n = size - pos;
+  }
+  if (0 >= n) {
+    return mrb_nil_value();
+  }
+  mrb_value str = mrb_str_new(mrb, NULL, (size_t)n);
+  size_t const got = SDL_RWread(rw, RSTRING_PTR(str), 1, (size_t)n);
+  if (0 == got) {
+    return mrb_nil_value();
+  }
+  mrb_str_resize(mrb, str, (mrb_int)got);
+  return str;
+}
+
+static mrb_value
+mrb_sdl2_rwops_write(mrb_state *mrb, mrb_value self)
+{
+  mrb_value str;
+  mrb_get_args(mrb, "S", &str);
+  SDL_RWops *rw = mrb_sdl2_rwops_get_ptr(mrb, self);
+  size_t const n = SDL_RWwrite(rw, RSTRING_PTR(str), 1, RSTRING_LEN(str));
+  if ((0 == n) && (0 < RSTRING_LEN(str))) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_fixnum_value((mrb_int)n);
+}
+
+static mrb_value
+mrb_sdl2_rwops_close(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rwops_data_t *data =
+    (mrb_sdl2_rwops_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_rwops_data_type);
+  if (NULL != data->rwops) {
+    int const ret = SDL_RWclose(data->rwops);
+    data->rwops = NULL;
+    if (0 != ret) {
+      mruby_sdl2_raise_error(mrb);
+    }
+  }
+  return mrb_nil_value();
+}
+
+static mrb_value
+mrb_sdl2_rwops_is_closed(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_rwops_data_t *data =
+    (mrb_sdl2_rwops_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_rwops_data_type);
+  return (NULL == data->rwops) ? mrb_true_value() : mrb_false_value();
+}
+
+
+void
+mruby_sdl2_rwops_init(mrb_state *mrb)
+{
+  class_RWops = mrb_define_class_under(mrb, mod_SDL2, "RWops", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_RWops, MRB_TT_DATA);
+
+  mrb_define_class_method(mrb, class_RWops, "from_file",   mrb_sdl2_rwops_s_from_file,   MRB_ARGS_REQ(1) | MRB_ARGS_OPT(3));
+  mrb_define_class_method(mrb, class_RWops, "from_memory", mrb_sdl2_rwops_s_from_memory, MRB_ARGS_REQ(1));
+  mrb_define_class_method(mrb, class_RWops, "from_buffer", mrb_sdl2_rwops_s_from_buffer, MRB_ARGS_REQ(1));
+
+  mrb_define_method(mrb, class_RWops, "size",    mrb_sdl2_rwops_get_size,  MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RWops, "seek",    mrb_sdl2_rwops_seek,      MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_RWops, "tell",    mrb_sdl2_rwops_tell,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RWops, "read",    mrb_sdl2_rwops_read,      MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_RWops, "write",   mrb_sdl2_rwops_write,     MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_RWops, "close",   mrb_sdl2_rwops_close,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_RWops, "closed?", mrb_sdl2_rwops_is_closed, MRB_ARGS_NONE());
+
+  int arena_size = mrb_gc_arena_save(mrb);
+  mrb_define_const(mrb, class_RWops, "SEEK_SET", mrb_fixnum_value(RW_SEEK_SET));
+  mrb_define_const(mrb, class_RWops, "SEEK_CUR", mrb_fixnum_value(RW_SEEK_CUR));
+  mrb_define_const(mrb, class_RWops, "SEEK_END", mrb_fixnum_value(RW_SEEK_END));
+  mrb_gc_arena_restore(mrb, arena_size);
+}
+
+void
+mruby_sdl2_rwops_final(mrb_state *mrb)
+{
+}
@@ -0,0 +1,27 @@
+#ifndef MRUBY_SDL2_RWOPS_H
+#define MRUBY_SDL2_RWOPS_H
+
+#include "sdl2.h"
+#include <SDL2/SDL_rwops.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void mruby_sdl2_rwops_init(mrb_state *mrb);
+extern void mruby_sdl2_rwops_final(mrb_state *mrb);
+
+/* the returned RWops is owned by the Ruby object; do not close it. */
+extern SDL_RWops *mrb_sdl2_rwops_get_ptr(mrb_state *mrb, mrb_value rwops);
+
+/* wraps 'rwops' and takes its ownership. 'owner' is kept alive with it. */
+extern mrb_value mrb_sdl2_rwops(mrb_state *mrb, SDL_RWops *rwops, mrb_value owner);
+
+/* read-only view of [offset, offset + length) of 'base'; closes 'base' on close. */
+extern SDL_RWops *mrb_sdl2_rwops_subrange(SDL_RWops *base, Sint64 offset, Sint64 length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_RWOPS_H */
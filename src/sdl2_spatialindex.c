@@ -0,0 +1,714 @@
+#include "sdl2_spatialindex.h"
+#include "sdl2_rect.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/array.h"
+
+/*
+ * SDL2::SpatialIndex is a uniform grid over integer rectangles. Each
+ * object is registered in every cell its rect covers, and the cells are
+ * kept in a hash table so that only populated cells cost memory.
+ * The cell size should be close to the typical object size.
+ */
+
+#define SPATIALINDEX_EMPTY       (-1)
+#define SPATIALINDEX_DELETED     (-2)
+#define SPATIALINDEX_DEFAULT_CELL_SIZE 64
+#define SPATIALINDEX_MAX_SPAN    (1 << 16)
+
+static struct RClass *class_SpatialIndex = NULL;
+
+typedef struct mrb_sdl2_spatialindex_entry_t {
+  mrb_int  id;
+  SDL_Rect rect;
+  int      cx0, cy0, cx1, cy1; /* covered cells (inclusive). */
+  Uint32   stamp;              /* last query which reported this entry. */
+  int      next_free;
+  bool     used;
+} mrb_sdl2_spatialindex_entry_t;
+
+typedef struct mrb_sdl2_spatialindex_cell_t {
+  int  cx, cy;
+  int *items;                  /* indices into the entry table. */
+  int  count;
+  int  capacity;
+  bool used;
+} mrb_sdl2_spatialindex_cell_t;
+
+typedef struct mrb_sdl2_spatialindex_data_t {
+  int                            cell_size;
+  mrb_sdl2_spatialindex_entry_t *entries;
+  int                            entry_count;
+  int                            entry_capacity;
+  int                            free_head;
+  int                            size;
+  int                           *ids;          /* id -> entry index. */
+  int                            id_capacity;
+  int                            id_used;      /* including deleted slots. */
+  mrb_sdl2_spatialindex_cell_t  *cells;
+  int                            cell_capacity;
+  int                            cell_used;
+  Uint32                         stamp;
+} mrb_sdl2_spatialindex_data_t;
+
+static void
+mrb_sdl2_spatialindex_free_cells(mrb_state *mrb, mrb_sdl2_spatialindex_data_t *data)
+{
+  int i;
+  for (i = 0; i < data->cell_capacity; ++i) {
+    mrb_free(mrb, data->cells[i].items);
+  }
+  mrb_free(mrb, data->cells);
+  data->cells         = NULL;
+  data->cell_capacity = 0;
+  data->cell_used     = 0;
+}
+
+static void
+mrb_sdl2_spatialindex_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_spatialindex_data_t *data =
+    (mrb_sdl2_spatialindex_data_t*)p;
+  if (NULL != data) {
+    mrb_sdl2_spatialindex_free_cells(mrb, data);
+    mrb_free(mrb, data->entries);
+    mrb_free(mrb, data->ids);
+    mrb_free(mrb, data);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_spatialindex_data_type = {
+  "SpatialIndex", mrb_sdl2_spatialindex_data_free
+};
+
+static mrb_sdl2_spatialindex_data_t *
+mrb_sdl2_spatialindex_get_data(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_spatialindex_data_t *data =
+    (mrb_sdl2_spatialindex_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_spatialindex_data_type);
+  if (NULL == data) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "uninitialized SpatialIndex.");
+  }
+  return data;
+}
+
+static Uint32
+mrb_sdl2_spatialindex_hash(Uint64 v)
+{
+  v ^= v >> 33;
+  v *= 0xFF51AFD7ED558CCDULL;
+  v ^= v >> 33;
+  return (Uint32)v;
+}
+
+static Uint32
+mrb_sdl2_spatialindex_cell_hash(int cx, int cy)
+{
+  return mrb_sdl2_spatialindex_hash(((Uint64)(Uint32)cx << 32) | (Uint32)cy);
+}
+
+/* floor division, so that negative coordinates map to negative cells. */
+static int
+mrb_sdl2_spatialindex_cell_of(int v, int cell_size)
+{
+  return (0 <= v) ? (v / cell_size) : (-((-(v + 1)) / cell_size) - 1);
+}
+
+static void
+mrb_sdl2_spatialindex_cell_range(mrb_sdl2_spatialindex_data_t const *data, SDL_Rect const *r, int *cx0, int *cy0, int *cx1, int *cy1)
+{
+  Sint64 const x1 = (Sint64)r->x + SDL_max(r->w, 1) - 1;
+  Sint64 const y1 = (Sint64)r->y + SDL_max(r->h, 1) - 1;
+  *cx0 = mrb_sdl2_spatialindex_cell_of(r->x, data->cell_size);
+  *cy0 = mrb_sdl2_spatialindex_cell_of(r->y, data->cell_size);
+  *cx1 = mrb_sdl2_spatialindex_cell_of((int)SDL_min(x1, (Sint64)0x7FFFFFFF), data->cell_size);
+  *cy1 = mrb_sdl2_spatialindex_cell_of((int)SDL_min(y1, (Sint64)0x7FFFFFFF), data->cell_size);
+}
+
+/* keeps a degenerate cell size from turning one insert into millions of cells. */
+static void
+mrb_sdl2_spatialindex_check_span(mrb_state *mrb, int cx0, int cy0, int cx1, int cy1)
+{
+  if (((Sint64)cx1 - cx0 + 1) * ((Sint64)cy1 - cy0 + 1) > SPATIALINDEX_MAX_SPAN) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "rect covers too many cells.");
+  }
+}
+
+/* same semantics as SDL_HasIntersection: empty rects never overlap. */
+static bool
+mrb_sdl2_spatialindex_overlaps(SDL_Rect const *a, SDL_Rect const *b)
+{
+  return (0 < a->w) && (0 < a->h) && (0 < b->w) && (0 < b->h) &&
+    (a->x < b->x + b->w) && (b->x < a->x + a->w) &&
+    (a->y < b->y + b->h) && (b->y < a->y + a->h);
+}
+
+static void *
+mrb_sdl2_spatialindex_calloc(mrb_state *mrb, size_t n, size_t size)
+{
+  void *p = mrb_malloc(mrb, n * size);
+  if (NULL == p) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  SDL_memset(p, 0, n * size);
+  return p;
+}
+
+/*
+ * id table: open addressing with linear probing. it is rebuilt from the
+ * entry table whenever live and deleted slots exceed half the capacity.
+ */
+static int
+mrb_sdl2_spatialindex_find(mrb_sdl2_spatialindex_data_t const *data, mrb_int id, int *slot)
+{
+  if (0 == data->id_capacity) {
+    return SPATIALINDEX_EMPTY;
+  }
+  Uint32 const mask = (Uint32)data->id_capacity - 1;
+  Uint32 i = mrb_sdl2_spatialindex_hash((Uint64)id) & mask;
+  for (;;) {
+    int const e = data->ids[i];
+    if (SPATIALINDEX_EMPTY == e) {
+      return SPATIALINDEX_EMPTY;
+    }
+    if ((0 <= e) && (data->entries[e].id == id)) {
+      if (NULL != slot) {
+        *slot = (int)i;
+      }
+      return e;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+static void
+mrb_sdl2_spatialindex_id_put(mrb_sdl2_spatialindex_data_t *data, mrb_int id, int entry)
+{
+  Uint32 const mask = (Uint32)data->id_capacity - 1;
+  Uint32 i = mrb_sdl2_spatialindex_hash((Uint64)id) & mask;
+  while (0 <= data->ids[i]) {
+    i = (i + 1) & mask;
+  }
+  if (SPATIALINDEX_EMPTY == data->ids[i]) {
+    ++data->id_used;
+  }
+  data->ids[i] = entry;
+}
+
+static void
+mrb_sdl2_spatialindex_id_reserve(mrb_state *mrb, mrb_sdl2_spatialindex_data_t *data)
+{
+  if ((data->id_used + 1) * 2 <= data->id_capacity) {
+    return;
+  }
+  int capacity = 16;
+  while (capacity < (data->size + 1) * 4) {
+    capacity *= 2;
+  }
+  int *ids = (int*)mrb_malloc(mrb, sizeof(int) * capacity);
+  if (NULL == ids) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  int i;
+  for (i = 0; i < capacity; ++i) {
+    ids[i] = SPATIALINDEX_EMPTY;
+  }
+  mrb_free(mrb, data->ids);
+  data->ids         = ids;
+  data->id_capacity = capacity;
+  data->id_used     = 0;
+  for (i = 0; i < data->entry_count; ++i) {
+    if (data->entries[i].used) {
+      mrb_sdl2_spatialindex_id_put(data, data->entries[i].id, i);
+    }
+  }
+}
+
+/*
+ * cell table: open addressing keyed by cell coordinates. cells are never
+ * removed individually; empty ones are dropped when the table is rebuilt.
+ */
+static mrb_sdl2_spatialindex_cell_t *
+mrb_sdl2_spatialindex_cell_find(mrb_sdl2_spatialindex_data_t const *data, int cx, int cy)
+{
+  if (0 == data->cell_capacity) {
+    return NULL;
+  }
+  Uint32 const mask = (Uint32)data->cell_capacity - 1;
+  Uint32 i = mrb_sdl2_spatialindex_cell_hash(cx, cy) & mask;
+  while (data->cells[i].used) {
+    if ((data->cells[i].cx == cx) && (data->cells[i].cy == cy)) {
+      return &data->cells[i];
+    }
+    i = (i + 1) & mask;
+  }
+  return NULL;
+}
+
+static mrb_sdl2_spatialindex_cell_t *
+mrb_sdl2_spatialindex_cell_slot(mrb_sdl2_spatialindex_cell_t *cells, int capacity, int cx, int cy)
+{
+  Uint32 const mask = (Uint32)capacity - 1;
+  Uint32 i = mrb_sdl2_spatialindex_cell_hash(cx, cy) & mask;
+  while (cells[i].used && ((cells[i].cx != cx) || (cells[i].cy != cy))) {
+    i = (i + 1) & mask;
+  }
+  return &cells[i];
+}
+
+static void
+mrb_sdl2_spatialindex_cell_rehash(mrb_state *mrb, mrb_sdl2_spatialindex_data_t *data)
+{
+  int live = 0;
+  int i;
+  for (i = 0; i < data->cell_capacity; ++i) {
+    if (data->cells[i].used && (0 < data->cells[i].count)) {
+      ++live;
+    }
+  }
+  int capacity = 64;
+  while (capacity < (live + 1) * 4) {
+    capacity *= 2;
+  }
+  mrb_sdl2_spatialindex_cell_t *cells =
+    (mrb_sdl2_spatialindex_cell_t*)mrb_sdl2_spatialindex_calloc(mrb, capacity, sizeof(mrb_sdl2_spatialindex_cell_t));
+  for (i = 0; i < data->cell_capacity; ++i) {
+    mrb_sdl2_spatialindex_cell_t *c = &data->cells[i];
+    if (c->used && (0 < c->count)) {
+      *mrb_sdl2_spatialindex_cell_slot(cells, capacity, c->cx, c->cy) = *c;
+    } else {
+      mrb_free(mrb, c->items);
+    }
+  }
+  mrb_free(mrb, data->cells);
+  data->cells         = cells;
+  data->cell_capacity = capacity;
+  data->cell_used     = live;
+}
+
+static void
+mrb_sdl2_spatialindex_cell_add(mrb_state *mrb, mrb_sdl2_spatialindex_data_t *data, int cx, int cy, int entry)
+{
+  mrb_sdl2_spatialindex_cell_t *c = mrb_sdl2_spatialindex_cell_find(data, cx, cy);
+  if (NULL == c) {
+    if ((data->cell_used + 1) * 2 > data->cell_capacity) {
+      mrb_sdl2_spatialindex_cell_rehash(mrb, data);
+    }
+    c = mrb_sdl2_spatialindex_cell_slot(data->cells, data->cell_capacity, cx, cy);
+    if (!c->used) {
+      c->cx       = cx;
+      c->cy       = cy;
+      c->items    = NULL;
+      c->count    = 0;
+      c->capacity = 0;
+      c->used     = true;
+      ++data->cell_used;
+    }
+  }
+  if (c->count == c->capacity) {
+    int const capacity = (0 < c->capacity) ? c->capacity * 2 : 4;
+    int *items = (int*)mrb_realloc(mrb, c->items, sizeof(int) * capacity);
+    if (NULL == items) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    c->items    = items;
+    c->capacity = capacity;
+  }
+  c->items[c->count++] = entry;
+}
+
+static void
+mrb_sdl2_spatialindex_cell_remove(mrb_sdl2_spatialindex_data_t *data, int cx, int cy, int entry)
+{
+  mrb_sdl2_spatialindex_cell_t *c = mrb_sdl2_spatialindex_cell_find(data, cx, cy);
+  if (NULL == c) {
+    return;
+  }
+  int i;
+  for (i = 0; i < c->count; ++i) {
+    if (c->items[i] == entry) {
+      c->items[i] = c->items[--c->count];
+      return;
+    }
+  }
+}
+
+static void
+mrb_sdl2_spatialindex_link(mrb_state *mrb, mrb_sdl2_spatialindex_data_t *data, int entry)
+{
+  mrb_sdl2_spatialindex_entry_t const *e = &data->entries[entry];
+  int const cx0 = e->cx0, cy0 = e->cy0, cx1 = e->cx1, cy1 = e->cy1;
+  int cx, cy;
+  for (cy = cy0; cy <= cy1; ++cy) {
+    for (cx = cx0; cx <= cx1; ++cx) {
+      mrb_sdl2_spatialindex_cell_add(mrb, data, cx, cy, entry);
+    }
+  }
+}
+
+static void
+mrb_sdl2_spatialindex_unlink(mrb_sdl2_spatialindex_data_t *data, int entry)
+{
+  mrb_sdl2_spatialindex_entry_t const *e = &data->entries[entry];
+  int cx, cy;
+  for (cy = e->cy0; cy <= e->cy1; ++cy) {
+    for (cx = e->cx0; cx <= e->cx1; ++cx) {
+      mrb_sdl2_spatialindex_cell_remove(data, cx, cy, entry);
+    }
+  }
+}
+
+static Uint32
+mrb_sdl2_spatialindex_next_stamp(mrb_sdl2_spatialindex_data_t *data)
+{
+  if (0 == ++data->stamp) {
+    int i;
+    for (i = 0; i < data->entry_count; ++i) {
+      data->entries[i].stamp = 0;
+    }
+    data->stamp = 1;
+  }
+  return data->stamp;
+}
+
+/* accepts either a Rect or x, y, w and h following the id. */
+static SDL_Rect
+mrb_sdl2_spatialindex_rect_args(mrb_state *mrb, mrb_int *id)
+{
+  mrb_value arg;
+  mrb_int y, w, h;
+  SDL_Rect r;
+  int const argc = mrb_get_args(mrb, "io|iii", id, &arg, &y, &w, &h);
+  if (2 == argc) {
+    SDL_Rect const * const p = mrb_sdl2_rect_get_ptr(mrb, arg);
+    if (NULL == p) {
+      mrb_raise(mrb, E_ARGUMENT_ERROR, "expected a Rect or x, y, w and h.");
+    }
+    r = *p;
+  } else if ((5 == argc) && mrb_fixnum_p(arg)) {
+    r.x = (int)mrb_fixnum(arg);
+    r.y = (int)y;
+    r.w = (int)w;
+    r.h = (int)h;
+  } else {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "expected a Rect or x, y, w and h.");
+  }
+  return r;
+}
+
+/***************************************************************************
+*
+* class SDL2::SpatialIndex
+*
+***************************************************************************/
+
+static mrb_value
+mrb_sdl2_spatialindex_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_int cell_size = SPATIALINDEX_DEFAULT_CELL_SIZE;
+  mrb_get_args(mrb, "|i", &cell_size);
+  if ((0 >= cell_size) || (0x7FFFFFFF < cell_size)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cell size must be positive.");
+  }
+  mrb_sdl2_spatialindex_data_t *data =
+    (mrb_sdl2_spatialindex_data_t*)DATA_PTR(self);
+  if (NULL != data) {
+    mrb_sdl2_spatialindex_data_free(mrb, data);
+    DATA_PTR(self) = NULL;
+  }
+  data = (mrb_sdl2_spatialindex_data_t*)mrb_sdl2_spatialindex_calloc(mrb, 1, sizeof(mrb_sdl2_spatialindex_data_t));
+  data->cell_size = (int)cell_size;
+  data->free_head = -1;
+  DATA_PTR(self)  = data;
+  DATA_TYPE(self) = &mrb_sdl2_spatialindex_data_type;
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_insert(mrb_state *mrb, mrb_value self)
+{
+  mrb_int id;
+  SDL_Rect const r = mrb_sdl2_spatialindex_rect_args(mrb, &id);
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  if (SPATIALINDEX_EMPTY != mrb_sdl2_spatialindex_find(data, id, NULL)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "id is already registered.");
+  }
+  int cx0, cy0, cx1, cy1;
+  mrb_sdl2_spatialindex_cell_range(data, &r, &cx0, &cy0, &cx1, &cy1);
+  mrb_sdl2_spatialindex_check_span(mrb, cx0, cy0, cx1, cy1);
+  mrb_sdl2_spatialindex_id_reserve(mrb, data);
+  int entry = data->free_head;
+  if (0 > entry) {
+    if (data->entry_count == data->entry_capacity) {
+      int const capacity = (0 < data->entry_capacity) ? data->entry_capacity * 2 : 64;
+      mrb_sdl2_spatialindex_entry_t *entries =
+        (mrb_sdl2_spatialindex_entry_t*)mrb_realloc(mrb, data->entries, sizeof(mrb_sdl2_spatialindex_entry_t) * capacity);
+      if (NULL == entries) {
+        mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+      }
+      data->entries        = entries;
+      data->entry_capacity = capacity;
+    }
+    entry = data->entry_count++;
+  } else {
+    data->free_head = data->entries[entry].next_free;
+  }
+  mrb_sdl2_spatialindex_entry_t *e = &data->entries[entry];
+  e->id        = id;
+  e->rect      = r;
+  e->stamp     = 0;
+  e->next_free = -1;
+  e->used      = true;
+  e->cx0       = cx0;
+  e->cy0       = cy0;
+  e->cx1       = cx1;
+  e->cy1       = cy1;
+  mrb_sdl2_spatialindex_id_put(data, id, entry);
+  ++data->size;
+  mrb_sdl2_spatialindex_link(mrb, data, entry);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_move(mrb_state *mrb, mrb_value self)
+{
+  mrb_int id;
+  SDL_Rect const r = mrb_sdl2_spatialindex_rect_args(mrb, &id);
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  int const entry = mrb_sdl2_spatialindex_find(data, id, NULL);
+  if (SPATIALINDEX_EMPTY == entry) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "id is not registered.");
+  }
+  mrb_sdl2_spatialindex_entry_t *e = &data->entries[entry];
+  int cx0, cy0, cx1, cy1;
+  mrb_sdl2_spatialindex_cell_range(data, &r, &cx0, &cy0, &cx1, &cy1);
+  mrb_sdl2_spatialindex_check_span(mrb, cx0, cy0, cx1, cy1);
+  e->rect = r;
+  /* most moves stay within the same cells. */
+  if ((cx0 == e->cx0) && (cy0 == e->cy0) && (cx1 == e->cx1) && (cy1 == e->cy1)) {
+    return self;
+  }
+  mrb_sdl2_spatialindex_unlink(data, entry);
+  e->cx0 = cx0;
+  e->cy0 = cy0;
+  e->cx1 = cx1;
+  e->cy1 = cy1;
+  mrb_sdl2_spatialindex_link(mrb, data, entry);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_remove(mrb_state *mrb, mrb_value self)
+{
+  mrb_int id;
+  mrb_get_args(mrb, "i", &id);
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  int slot;
+  int const entry = mrb_sdl2_spatialindex_find(data, id, &slot);
+  if (SPATIALINDEX_EMPTY == entry) {
+    return mrb_false_value();
+  }
+  mrb_sdl2_spatialindex_unlink(data, entry);
+  data->ids[slot] = SPATIALINDEX_DELETED;
+  data->entries[entry].used      = false;
+  data->entries[entry].next_free = data->free_head;
+  data->free_head = entry;
+  --data->size;
+  return mrb_true_value();
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_include(mrb_state *mrb, mrb_value self)
+{
+  mrb_int id;
+  mrb_get_args(mrb, "i", &id);
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  return (SPATIALINDEX_EMPTY == mrb_sdl2_spatialindex_find(data, id, NULL)) ?
+    mrb_false_value() : mrb_true_value();
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_get_rect(mrb_state *mrb, mrb_value self)
+{
+  mrb_int id;
+  mrb_get_args(mrb, "i", &id);
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  int const entry = mrb_sdl2_spatialindex_find(data, id, NULL);
+  if (SPATIALINDEX_EMPTY == entry) {
+    return mrb_nil_value();
+  }
+  return mrb_sdl2_rect_direct(mrb, &data->entries[entry].rect);
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_get_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_spatialindex_get_data(mrb, self)->size);
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_get_cell_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_spatialindex_get_data(mrb, self)->cell_size);
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_clear(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  mrb_sdl2_spatialindex_free_cells(mrb, data);
+  mrb_free(mrb, data->ids);
+  data->ids         = NULL;
+  data->id_capacity = 0;
+  data->id_used     = 0;
+  data->entry_count = 0;
+  data->free_head   = -1;
+  data->size        = 0;
+  return self;
+}
+
+static void
+mrb_sdl2_spatialindex_query_cell(mrb_state *mrb, mrb_sdl2_spatialindex_data_t *data, mrb_sdl2_spatialindex_cell_t const *c, SDL_Rect const *r, Uint32 stamp, mrb_value result)
+{
+  int i;
+  for (i = 0; i < c->count; ++i) {
+    mrb_sdl2_spatialindex_entry_t *e = &data->entries[c->items[i]];
+    if (e->stamp == stamp) {
+      continue;
+    }
+    e->stamp = stamp;
+    if (mrb_sdl2_spatialindex_overlaps(&e->rect, r)) {
+      mrb_ary_push(mrb, result, mrb_fixnum_value(e->id));
+    }
+  }
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_query(mrb_state *mrb, mrb_value self)
+{
+  mrb_value arg;
+  mrb_get_args(mrb, "o", &arg);
+  SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, arg);
+  if (NULL == r) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot query nil.");
+  }
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  mrb_value const result = mrb_ary_new(mrb);
+  if ((0 == data->size) || (0 >= r->w) || (0 >= r->h)) {
+    return result;
+  }
+  Uint32 const stamp = mrb_sdl2_spatialindex_next_stamp(data);
+  int cx0, cy0, cx1, cy1;
+  mrb_sdl2_spatialindex_cell_range(data, r, &cx0, &cy0, &cx1, &cy1);
+  Sint64 const span = ((Sint64)cx1 - cx0 + 1) * ((Sint64)cy1 - cy0 + 1);
+  if (span <= data->cell_used) {
+    int cx, cy;
+    for (cy = cy0; cy <= cy1; ++cy) {
+      for (cx = cx0; cx <= cx1; ++cx) {
+        mrb_sdl2_spatialindex_cell_t const *c = mrb_sdl2_spatialindex_cell_find(data, cx, cy);
+        if (NULL != c) {
+          mrb_sdl2_spatialindex_query_cell(mrb, data, c, r, stamp, result);
+        }
+      }
+    }
+  } else {
+    /* the query covers more cells than exist; walk the table instead. */
+    int i;
+    for (i = 0; i < data->cell_capacity; ++i) {
+      mrb_sdl2_spatialindex_cell_t const *c = &data->cells[i];
+      if (c->used && (cx0 <= c->cx) && (c->cx <= cx1) && (cy0 <= c->cy) && (c->cy <= cy1)) {
+        mrb_sdl2_spatialindex_query_cell(mrb, data, c, r, stamp, result);
+      }
+    }
+  }
+  return result;
+}
+
+static mrb_value
+mrb_sdl2_spatialindex_query_point(mrb_state *mrb, mrb_value self)
+{
+  mrb_int x, y;
+  mrb_get_args(mrb, "ii", &x, &y);
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  mrb_value const result = mrb_ary_new(mrb);
+  mrb_sdl2_spatialindex_cell_t const *c = mrb_sdl2_spatialindex_cell_find(data,
+    mrb_sdl2_spatialindex_cell_of((int)x, data->cell_size),
+    mrb_sdl2_spatialindex_cell_of((int)y, data->cell_size));
+  if (NULL == c) {
+    return result;
+  }
+  int i;
+  for (i = 0; i < c->count; ++i) {
+    SDL_Rect const *r = &data->entries[c->items[i]].rect;
+    if ((r->x <= x) && (x < r->x + r->w) && (r->y <= y) && (y < r->y + r->h)) {
+      mrb_ary_push(mrb, result, mrb_fixnum_value(data->entries[c->items[i]].id));
+    }
+  }
+  return result;
+}
+
+/*
+ * every overlapping pair is reported exactly once: by the cell that
+ * contains the top-left corner of the overlap, which both rects cover.
+ */
+static mrb_value
+mrb_sdl2_spatialindex_pairs(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_spatialindex_data_t *data = mrb_sdl2_spatialindex_get_data(mrb, self);
+  mrb_value const result = mrb_ary_new(mrb);
+  int n;
+  for (n = 0; n < data->cell_capacity; ++n) {
+    mrb_sdl2_spatialindex_cell_t const *c = &data->cells[n];
+    if (!c->used || (2 > c->count)) {
+      continue;
+    }
+    int i, j;
+    for (i = 0; i < c->count; ++i) {
+      mrb_sdl2_spatialindex_entry_t const *a = &data->entries[c->items[i]];
+      for (j = i + 1; j < c->count; ++j) {
+        mrb_sdl2_spatialindex_entry_t const *b = &data->entries[c->items[j]];
+        if (!mrb_sdl2_spatialindex_overlaps(&a->rect, &b->rect)) {
+          continue;
+        }
+        int const ox = SDL_max(a->rect.x, b->rect.x);
+        int const oy = SDL_max(a->rect.y, b->rect.y);
+        if ((mrb_sdl2_spatialindex_cell_of(ox, data->cell_size) != c->cx) ||
+            (mrb_sdl2_spatialindex_cell_of(oy, data->cell_size) != c->cy)) {
+          continue;
+        }
+        int const arena_size = mrb_gc_arena_save(mrb);
+        mrb_value pair[2] = { mrb_fixnum_value(a->id), mrb_fixnum_value(b->id) };
+        mrb_ary_push(mrb, result, mrb_ary_new_from_values(mrb, 2, pair));
+        mrb_gc_arena_restore(mrb, arena_size);
+      }
+    }
+  }
+  return result;
+}
+
+
+void
+mruby_sdl2_spatialindex_init(mrb_state *mrb)
+{
+  class_SpatialIndex = mrb_define_class_under(mrb, mod_SDL2, "SpatialIndex", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_SpatialIndex, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_SpatialIndex, "initialize",  mrb_sdl2_spatialindex_initialize,    MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_SpatialIndex, "insert",      mrb_sdl2_spatialindex_insert,        MRB_ARGS_REQ(2) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_SpatialIndex, "move",        mrb_sdl2_spatialindex_move,          MRB_ARGS_REQ(2) | MRB_ARGS_OPT(3));
+  mrb_define_method(mrb, class_SpatialIndex, "remove",      mrb_sdl2_spatialindex_remove,        MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_SpatialIndex, "include?",    mrb_sdl2_spatialindex_include,       MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_SpatialIndex, "rect",        mrb_sdl2_spatialindex_get_rect,      MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_SpatialIndex, "size",        mrb_sdl2_spatialindex_get_size,      MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SpatialIndex, "cell_size",   mrb_sdl2_spatialindex_get_cell_size, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SpatialIndex, "clear",       mrb_sdl2_spatialindex_clear,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SpatialIndex, "query",       mrb_sdl2_spatialindex_query,         MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_SpatialIndex, "query_point", mrb_sdl2_spatialindex_query_point,   MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_SpatialIndex, "pairs",       mrb_sdl2_spatialindex_pairs,         MRB_ARGS_NONE());
+}
+
+void
+mruby_sdl2_spatialindex_final(mrb_state *mrb)
+{
+}
@@ -0,0 +1,17 @@
+#ifndef MRUBY_SDL2_SPATIALINDEX_H
+#define MRUBY_SDL2_SPATIALINDEX_H
+
+#include "sdl2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void mruby_sdl2_spatialindex_init(mrb_state *mrb);
+extern void mruby_sdl2_spatialindex_final(mrb_state *mrb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_SPATIALINDEX_H */
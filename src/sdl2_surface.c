@@ -1,18 +1,39 @@
 #include "sdl2_surface.h"
 #include "sdl2_rect.h"
+#include "sdl2_rectarray.h"
+#include "misc.h"
+#include "pixel_kernels.h"
+#include "workpool.h"
+#include "sdl2_rwops.h"
 #include "mruby/data.h"
 #include "mruby/class.h"
 #include "mruby/string.h"
 #include "mruby/array.h"
+#include "mruby/error.h"
 #include "mruby/variable.h"
 
 static struct RClass *class_Surface;
+static struct RClass *class_PixelView;
+
+/* operations touching fewer pixels than this stay on the calling thread. */
+static mrb_int parallel_threshold = 512 * 512;
 
 typedef struct mrb_sdl2_video_surface_data_t {
   bool         is_associated;
   SDL_Surface *surface;
 } mrb_sdl2_video_surface_data_t;
 
+typedef struct mrb_sdl2_video_pixelview_data_t {
+  mrb_sdl2_video_surface_data_t *owner;
+  SDL_Surface                   *surface;
+  Uint8                         *pixels;
+  int                            pitch;
+  int                            bpp;
+  int                            w;
+  int                            h;
+  bool                           is_valid;
+} mrb_sdl2_video_pixelview_data_t;
+
 static void
 mrb_sdl2_video_surface_data_free(mrb_state *mrb, void *p)
 {
@@ -26,10 +47,24 @@ mrb_sdl2_video_surface_data_free(mrb_state *mrb, void *p)
   }
 }
 
+static void
+mrb_sdl2_video_pixelview_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_video_pixelview_data_t *data =
+    (mrb_sdl2_video_pixelview_data_t*)p;
+  if (NULL != data) {
+    mrb_free(mrb, data);
+  }
+}
+
 static struct mrb_data_type const mrb_sdl2_video_surface_data_type = {
   "Surface", mrb_sdl2_video_surface_data_free
 };
 
+static struct mrb_data_type const mrb_sdl2_video_pixelview_data_type = {
+  "PixelView", mrb_sdl2_video_pixelview_data_free
+};
+
 mrb_value
 mrb_sdl2_video_surface(mrb_state *mrb, SDL_Surface *surface, bool is_associated)
 {
@@ -54,6 +89,19 @@ mrb_sdl2_video_surface_get_ptr(mrb_state *mrb, mrb_value surface)
   return data->surface;
 }
 
+SDL_Surface *
+mrb_sdl2_video_surface_detach(mrb_state *mrb, mrb_value surface)
+{
+  mrb_sdl2_video_surface_data_t *data =
+    (mrb_sdl2_video_surface_data_t*)mrb_data_get_ptr(mrb, surface, &mrb_sdl2_video_surface_data_type);
+  if (data->is_associated) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot detach a surface owned by a window.");
+  }
+  SDL_Surface *s = data->surface;
+  data->surface = NULL;
+  return s;
+}
+
 
 static mrb_value
 mrb_sdl2_video_surface_initialize(mrb_state *mrb, mrb_value self)
@@ -96,6 +144,501 @@ mrb_sdl2_video_surface_free(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+/*
+ * Native kernels only handle surfaces whose pixels can be read as is and
+ * that have no per-pixel color key.
+ */
+static bool
+mrb_sdl2_video_surface_is_plain(SDL_Surface *s)
+{
+  Uint32 key;
+  return !SDL_MUSTLOCK(s) && (0 != SDL_GetColorKey(s, &key));
+}
+
+static bool
+mrb_sdl2_video_surface_is_parallel(Sint64 pixels)
+{
+  return (1 < mrb_sdl2_workpool_threads()) && (pixels >= parallel_threshold);
+}
+
+/*
+ * Runs a band job over 'rows' rows, on the work pool when the operation
+ * is large enough.
+ */
+static void
+mrb_sdl2_video_surface_run_bands(mrb_sdl2_workpool_func func, void *job, int rows, Sint64 pixels)
+{
+  if (mrb_sdl2_video_surface_is_parallel(pixels)) {
+    mrb_sdl2_workpool_run(func, job, rows);
+  } else {
+    func(job, 0, rows);
+  }
+}
+
+typedef struct mrb_sdl2_video_surface_row_job_t {
+  mrb_sdl2_pixel_row_func func;
+  Uint8                  *dst;
+  int                     dst_pitch;
+  Uint8 const            *src;
+  int                     src_pitch;
+  int                     width;
+  Uint8                   alpha_mod;
+} mrb_sdl2_video_surface_row_job_t;
+
+static void
+mrb_sdl2_video_surface_convert_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_row_job_t const *job = (mrb_sdl2_video_surface_row_job_t const*)arg;
+  mrb_sdl2_pixel_kernels_convert(job->func,
+    job->dst + first * job->dst_pitch, job->dst_pitch,
+    job->src + first * job->src_pitch, job->src_pitch,
+    job->width, last - first);
+}
+
+static void
+mrb_sdl2_video_surface_blend_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_row_job_t const *job = (mrb_sdl2_video_surface_row_job_t const*)arg;
+  mrb_sdl2_pixel_kernels_blend(
+    job->dst + first * job->dst_pitch, job->dst_pitch,
+    job->src + first * job->src_pitch, job->src_pitch,
+    job->width, last - first, job->alpha_mod);
+}
+
+static void
+mrb_sdl2_video_surface_blend_premultiplied_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_row_job_t const *job = (mrb_sdl2_video_surface_row_job_t const*)arg;
+  mrb_sdl2_pixel_kernels_blend_premultiplied(
+    job->dst + first * job->dst_pitch, job->dst_pitch,
+    job->src + first * job->src_pitch, job->src_pitch,
+    job->width, last - first, job->alpha_mod);
+}
+
+typedef struct mrb_sdl2_video_surface_fill_job_t {
+  SDL_Surface    *surface;
+  SDL_Rect const *rects;
+  int             count;
+  int             top;
+  Uint32          color;
+} mrb_sdl2_video_surface_fill_job_t;
+
+static void
+mrb_sdl2_video_surface_fill_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_fill_job_t const *job = (mrb_sdl2_video_surface_fill_job_t const*)arg;
+  SDL_Surface const *s = job->surface;
+  int const bpp = s->format->BytesPerPixel;
+  int i, x, y;
+  first += job->top;
+  last  += job->top;
+  for (i = 0; i < job->count; ++i) {
+    SDL_Rect const *r = &job->rects[i];
+    int const y0 = SDL_max(r->y, first);
+    int const y1 = SDL_min(r->y + r->h, last);
+    for (y = y0; y < y1; ++y) {
+      Uint8 *row = (Uint8*)s->pixels + y * s->pitch + r->x * bpp;
+      switch (bpp) {
+      case 1:
+        SDL_memset(row, (Uint8)job->color, r->w);
+        break;
+      case 2:
+        for (x = 0; x < r->w; ++x) {
+          ((Uint16*)row)[x] = (Uint16)job->color;
+        }
+        break;
+      default:
+        for (x = 0; x < r->w; ++x) {
+          ((Uint32*)row)[x] = job->color;
+        }
+        break;
+      }
+    }
+  }
+}
+
+/*
+ * Banded fill of large areas on the work pool.
+ * Returns false when the fill has to be done by SDL.
+ */
+static bool
+mrb_sdl2_video_surface_fill_native(SDL_Surface *s, SDL_Rect const *rects, int count, Uint32 color)
+{
+  if ((NULL == s) || (NULL == s->pixels) || SDL_MUSTLOCK(s) || (3 == s->format->BytesPerPixel)) {
+    return false;
+  }
+  if (1 >= mrb_sdl2_workpool_threads()) {
+    return false;
+  }
+  SDL_Rect *clipped = (SDL_Rect*)SDL_malloc(sizeof(SDL_Rect) * SDL_max(count, 1));
+  if (NULL == clipped) {
+    return false;
+  }
+  Sint64 pixels = 0;
+  int i, n = 0;
+  if (NULL == rects) {
+    clipped[n++] = s->clip_rect;
+  } else {
+    for (i = 0; i < count; ++i) {
+      if (SDL_IntersectRect(&rects[i], &s->clip_rect, &clipped[n])) {
+        ++n;
+      }
+    }
+  }
+  for (i = 0; i < n; ++i) {
+    pixels += (Sint64)clipped[i].w * clipped[i].h;
+  }
+  bool const parallel = mrb_sdl2_video_surface_is_parallel(pixels);
+  if (parallel) {
+    mrb_sdl2_video_surface_fill_job_t job = { s, clipped, n, s->clip_rect.y, color };
+    mrb_sdl2_workpool_run(mrb_sdl2_video_surface_fill_band, &job, s->clip_rect.h);
+  }
+  SDL_free(clipped);
+  return parallel;
+}
+
+typedef struct mrb_sdl2_video_surface_scale_job_t {
+  SDL_Surface *src;
+  SDL_Surface *dst;
+  SDL_Rect     sr;
+  SDL_Rect     dr;
+  Uint32       row_step;  /* 16.16 fixed point, as in SDL_SoftStretch. */
+  int         *columns;
+} mrb_sdl2_video_surface_scale_job_t;
+
+static void
+mrb_sdl2_video_surface_scale_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_scale_job_t const *job = (mrb_sdl2_video_surface_scale_job_t const*)arg;
+  SDL_Surface const *src = job->src;
+  SDL_Surface const *dst = job->dst;
+  int const bpp = dst->format->BytesPerPixel;
+  int x, y;
+  for (y = first; y < last; ++y) {
+    int const sy = job->sr.y + (int)(((Uint64)job->row_step / 2 + (Uint64)y * job->row_step) >> 16);
+    Uint8 const *srow = (Uint8 const*)src->pixels + sy * src->pitch;
+    Uint8 *drow = (Uint8*)dst->pixels + (job->dr.y + y) * dst->pitch + job->dr.x * bpp;
+    if (4 == bpp) {
+      for (x = 0; x < job->dr.w; ++x) {
+        ((Uint32*)drow)[x] = ((Uint32 const*)srow)[job->columns[x]];
+      }
+    } else {
+      for (x = 0; x < job->dr.w; ++x) {
+        ((Uint16*)drow)[x] = ((Uint16 const*)srow)[job->columns[x]];
+      }
+    }
+  }
+}
+
+/*
+ * Banded nearest-neighbour scaling on the work pool.
+ * Only plain copies between surfaces of the same 16/32-bit format that
+ * need no clipping are handled; returns false for anything else.
+ */
+static bool
+mrb_sdl2_video_surface_scale_native(SDL_Surface *ss, SDL_Rect const *srcrect, SDL_Surface *ds, SDL_Rect const *dstrect)
+{
+  SDL_BlendMode mode;
+  Uint8 r, g, b, a;
+  if ((NULL == ss) || (NULL == ds) || (ss == ds) || (NULL == ss->pixels) || (NULL == ds->pixels)) {
+    return false;
+  }
+  if (ss->format->format != ds->format->format) {
+    return false;
+  }
+  int const bpp = ds->format->BytesPerPixel;
+  if ((2 != bpp) && (4 != bpp)) {
+    return false;
+  }
+  if (!mrb_sdl2_video_surface_is_plain(ss) || SDL_MUSTLOCK(ds)) {
+    return false;
+  }
+  if ((0 != SDL_GetSurfaceBlendMode(ss, &mode)) || (SDL_BLENDMODE_NONE != mode)) {
+    return false;
+  }
+  if ((0 != SDL_GetSurfaceColorMod(ss, &r, &g, &b)) || (0xFF != (r & g & b))) {
+    return false;
+  }
+  if ((0 != SDL_GetSurfaceAlphaMod(ss, &a)) || (0xFF != a)) {
+    return false;
+  }
+  SDL_Rect const src_bounds = { 0, 0, ss->w, ss->h };
+  SDL_Rect const dst_bounds = { 0, 0, ds->w, ds->h };
+  SDL_Rect const sr = (NULL != srcrect) ? *srcrect : src_bounds;
+  SDL_Rect const dr = (NULL != dstrect) ? *dstrect : dst_bounds;
+  SDL_Rect tmp;
+  if (SDL_RectEmpty(&sr) || SDL_RectEmpty(&dr)) {
+    return false;
+  }
+  if (!SDL_IntersectRect(&sr, &src_bounds, &tmp) || !SDL_RectEquals(&sr, &tmp)) {
+    return false;
+  }
+  if (!SDL_IntersectRect(&dr, &ds->clip_rect, &tmp) || !SDL_RectEquals(&dr, &tmp)) {
+    return false;
+  }
+  if (!mrb_sdl2_video_surface_is_parallel((Sint64)dr.w * dr.h)) {
+    return false;
+  }
+  int *columns = (int*)SDL_malloc(sizeof(int) * dr.w);
+  if (NULL == columns) {
+    return false;
+  }
+  /*
+   * step through the source in 16.16 fixed point from half a step in,
+   * exactly like SDL_SoftStretch and the generic scaled blitters, so the
+   * result does not depend on which path took the blit.
+   */
+  Uint32 const column_step = ((Uint32)sr.w << 16) / (Uint32)dr.w;
+  Uint32 const row_step    = ((Uint32)sr.h << 16) / (Uint32)dr.h;
+  int x;
+  for (x = 0; x < dr.w; ++x) {
+    columns[x] = sr.x + (int)(((Uint64)column_step / 2 + (Uint64)x * column_step) >> 16);
+  }
+  mrb_sdl2_video_surface_scale_job_t job = { ss, ds, sr, dr, row_step, columns };
+  mrb_sdl2_workpool_run(mrb_sdl2_video_surface_scale_band, &job, dr.h);
+  SDL_free(columns);
+  return true;
+}
+
+/*
+ * Clips a blit the same way SDL_UpperBlit does.
+ * Returns false when nothing is left to draw.
+ */
+static bool
+mrb_sdl2_video_surface_clip_blit(SDL_Surface *src, SDL_Rect const *srcrect, SDL_Surface *dst, SDL_Rect const *dstrect, SDL_Rect *sr, SDL_Rect *dr)
+{
+  int srcx, srcy, w, h, dx, dy;
+  dr->x = dstrect->x;
+  dr->y = dstrect->y;
+  if (NULL != srcrect) {
+    srcx = srcrect->x;
+    w = srcrect->w;
+    if (srcx < 0) {
+      w += srcx;
+      dr->x -= srcx;
+      srcx = 0;
+    }
+    if (src->w - srcx < w) {
+      w = src->w - srcx;
+    }
+    srcy = srcrect->y;
+    h = srcrect->h;
+    if (srcy < 0) {
+      h += srcy;
+      dr->y -= srcy;
+      srcy = 0;
+    }
+    if (src->h - srcy < h) {
+      h = src->h - srcy;
+    }
+  } else {
+    srcx = srcy = 0;
+    w = src->w;
+    h = src->h;
+  }
+  SDL_Rect const *clip = &dst->clip_rect;
+  dx = clip->x - dr->x;
+  if (dx > 0) {
+    w -= dx;
+    dr->x += dx;
+    srcx += dx;
+  }
+  dx = dr->x + w - clip->x - clip->w;
+  if (dx > 0) {
+    w -= dx;
+  }
+  dy = clip->y - dr->y;
+  if (dy > 0) {
+    h -= dy;
+    dr->y += dy;
+    srcy += dy;
+  }
+  dy = dr->y + h - clip->y - clip->h;
+  if (dy > 0) {
+    h -= dy;
+  }
+  *sr = (SDL_Rect){ srcx, srcy, w, h };
+  dr->w = w;
+  dr->h = h;
+  return (w > 0) && (h > 0);
+}
+
+/* clips a blit and runs 'band' over the rows of the clipped area. */
+static void
+mrb_sdl2_video_surface_blend_rows(SDL_Surface *ss, SDL_Rect const *srcrect, SDL_Surface *ds, SDL_Rect const *dstrect, Uint8 alpha, mrb_sdl2_workpool_func band)
+{
+  SDL_Rect sr, dr;
+  if (mrb_sdl2_video_surface_clip_blit(ss, srcrect, ds, dstrect, &sr, &dr)) {
+    mrb_sdl2_video_surface_row_job_t job = {
+      NULL,
+      (Uint8*)ds->pixels + dr.y * ds->pitch + dr.x * 4, ds->pitch,
+      (Uint8 const*)ss->pixels + sr.y * ss->pitch + sr.x * 4, ss->pitch,
+      sr.w, alpha
+    };
+    mrb_sdl2_video_surface_run_bands(band, &job, sr.h, (Sint64)sr.w * sr.h);
+  }
+}
+
+/*
+ * Alpha blending of 32bpp surfaces through the native kernels.
+ * Returns false when the blit has to be done by SDL.
+ */
+static bool
+mrb_sdl2_video_surface_blit_native(SDL_Surface *ss, SDL_Rect const *srcrect, SDL_Surface *ds, SDL_Rect const *dstrect)
+{
+  SDL_BlendMode mode;
+  Uint8 r, g, b, alpha;
+  if ((NULL == ss) || (NULL == ds) || (ss == ds)) {
+    return false;
+  }
+  if (!mrb_sdl2_pixel_kernels_can_blend(ss->format->format, ds->format->format)) {
+    return false;
+  }
+  if (!mrb_sdl2_video_surface_is_plain(ss) || SDL_MUSTLOCK(ds)) {
+    return false;
+  }
+  if ((0 != SDL_GetSurfaceBlendMode(ss, &mode)) || (SDL_BLENDMODE_BLEND != mode)) {
+    return false;
+  }
+  if ((0 != SDL_GetSurfaceColorMod(ss, &r, &g, &b)) || (0xFF != (r & g & b))) {
+    return false;
+  }
+  if (0 != SDL_GetSurfaceAlphaMod(ss, &alpha)) {
+    return false;
+  }
+  mrb_sdl2_video_surface_blend_rows(ss, srcrect, ds, dstrect, alpha, mrb_sdl2_video_surface_blend_band);
+  return true;
+}
+
+/* carries the modulation over like SDL_ConvertSurface does. */
+static void
+mrb_sdl2_video_surface_copy_modulation(SDL_Surface *dst, SDL_Surface *src)
+{
+  Uint8 r, g, b, a;
+  if (0 == SDL_GetSurfaceColorMod(src, &r, &g, &b)) {
+    SDL_SetSurfaceColorMod(dst, r, g, b);
+  }
+  if (0 == SDL_GetSurfaceAlphaMod(src, &a)) {
+    SDL_SetSurfaceAlphaMod(dst, a);
+  }
+}
+
+/*
+ * Format conversion through the native kernels.
+ * Returns NULL when the conversion has to be done by SDL.
+ */
+static SDL_Surface *
+mrb_sdl2_video_surface_convert_native(SDL_Surface *s, Uint32 format)
+{
+  mrb_sdl2_pixel_row_func const func = mrb_sdl2_pixel_kernels_converter(s->format->format, format);
+  if ((NULL == func) || !mrb_sdl2_video_surface_is_plain(s)) {
+    return NULL;
+  }
+  int bpp;
+  Uint32 rmask, gmask, bmask, amask;
+  if (SDL_FALSE == SDL_PixelFormatEnumToMasks(format, &bpp, &rmask, &gmask, &bmask, &amask)) {
+    return NULL;
+  }
+  SDL_Surface *converted = SDL_CreateRGBSurface(0, s->w, s->h, bpp, rmask, gmask, bmask, amask);
+  if (NULL == converted) {
+    return NULL;
+  }
+  mrb_sdl2_video_surface_row_job_t job = {
+    func,
+    (Uint8*)converted->pixels, converted->pitch,
+    (Uint8 const*)s->pixels, s->pitch,
+    s->w, 0xFF
+  };
+  mrb_sdl2_video_surface_run_bands(mrb_sdl2_video_surface_convert_band, &job, s->h, (Sint64)s->w * s->h);
+  mrb_sdl2_video_surface_copy_modulation(converted, s);
+  return converted;
+}
+
+/***************************************************************************
+*
+* resampling filters
+*
+***************************************************************************/
+
+typedef struct mrb_sdl2_video_surface_filter_job_t {
+  SDL_Surface const *src;
+  SDL_Surface       *dst;
+  int const         *x0;
+  int const         *x1;
+  int const         *fx;
+} mrb_sdl2_video_surface_filter_job_t;
+
+/* returns a new surface of the same pixel format as 's'. */
+static SDL_Surface *
+mrb_sdl2_video_surface_create_like(SDL_Surface const *s, int w, int h)
+{
+  SDL_PixelFormat const *f = s->format;
+  return SDL_CreateRGBSurface(0, w, h, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, f->Amask);
+}
+
+static void
+mrb_sdl2_video_surface_downsample_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_filter_job_t const *job = (mrb_sdl2_video_surface_filter_job_t const*)arg;
+  SDL_Surface const *src = job->src;
+  SDL_Surface *dst = job->dst;
+  int y;
+  for (y = first; y < last; ++y) {
+    Uint8 const *row0 = (Uint8 const*)src->pixels + SDL_min(y * 2,     src->h - 1) * src->pitch;
+    Uint8 const *row1 = (Uint8 const*)src->pixels + SDL_min(y * 2 + 1, src->h - 1) * src->pitch;
+    mrb_sdl2_pixel_kernels_downsample_row((Uint8*)dst->pixels + y * dst->pitch, row0, row1, src->w, dst->format->BytesPerPixel);
+  }
+}
+
+/*
+ * Maps destination pixel 'i' of 'dst_size' onto a source of 'src_size'
+ * pixels, sampling at pixel centers. Stores the first sample and the
+ * weight of the next one in 1/256.
+ */
+static void
+mrb_sdl2_video_surface_bilinear_sample(int i, int dst_size, int src_size, int *index, int *weight)
+{
+  Sint64 const pos = (((Sint64)i * 2 + 1) * src_size * 256) / ((Sint64)dst_size * 2) - 128;
+  if (0 > pos) {
+    *index  = 0;
+    *weight = 0;
+  } else if ((pos >> 8) >= src_size - 1) {
+    *index  = src_size - 1;
+    *weight = 0;
+  } else {
+    *index  = (int)(pos >> 8);
+    *weight = (int)(pos & 0xFF);
+  }
+}
+
+static void
+mrb_sdl2_video_surface_bilinear_band(void *arg, int first, int last)
+{
+  mrb_sdl2_video_surface_filter_job_t const *job = (mrb_sdl2_video_surface_filter_job_t const*)arg;
+  SDL_Surface const *src = job->src;
+  SDL_Surface *dst = job->dst;
+  int y;
+  for (y = first; y < last; ++y) {
+    int sy, fy;
+    mrb_sdl2_video_surface_bilinear_sample(y, dst->h, src->h, &sy, &fy);
+    Uint8 const *row0 = (Uint8 const*)src->pixels + sy * src->pitch;
+    Uint8 const *row1 = (Uint8 const*)src->pixels + SDL_min(sy + 1, src->h - 1) * src->pitch;
+    mrb_sdl2_pixel_kernels_bilinear_row((Uint8*)dst->pixels + y * dst->pitch, row0, row1, fy,
+                                        job->x0, job->x1, job->fx, dst->w, dst->format->BytesPerPixel);
+  }
+}
+
+static void
+mrb_sdl2_video_surface_check_filterable(mrb_state *mrb, SDL_Surface *s)
+{
+  if (NULL == s) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "surface is already freed.");
+  }
+  if (!mrb_sdl2_pixel_kernels_can_filter(s->format->format)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unsupported pixel format.");
+  }
+}
+
 static mrb_value
 mrb_sdl2_video_surface_blit_scaled(mrb_state *mrb, mrb_value self)
 {
@@ -106,6 +649,9 @@ mrb_sdl2_video_surface_blit_scaled(mrb_state *mrb, mrb_value self)
   SDL_Surface * const    ds = mrb_sdl2_video_surface_get_ptr(mrb, dst);
   SDL_Rect * const       dr = mrb_sdl2_rect_get_ptr(mrb, dst_rect);
   int ret;
+  if (mrb_sdl2_video_surface_scale_native(ss, sr, ds, dr)) {
+    return self;
+  }
   if (NULL != dr) {
     SDL_Rect tmp = *dr;
     ret = SDL_BlitScaled(ss, sr, ds, &tmp);
@@ -130,6 +676,9 @@ mrb_sdl2_video_surface_blit_surface(mrb_state *mrb, mrb_value self)
   if (NULL == dr) {
     mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot set 3rd argument nil.");
   }
+  if (mrb_sdl2_video_surface_blit_native(ss, sr, ds, dr)) {
+    return self;
+  }
   SDL_Rect tmp = *dr;
   if (0 != SDL_BlitSurface(ss, sr, ds, &tmp)) {
     mruby_sdl2_raise_error(mrb);
@@ -137,21 +686,270 @@ mrb_sdl2_video_surface_blit_surface(mrb_state *mrb, mrb_value self)
   return self;
 }
 
+/*
+ * SDL2::Video::Surface#blit_premultiplied(src_rect, dst, dst_rect)
+ *
+ * Composites a source whose colors are premultiplied by alpha, as made by
+ * #premultiply_alpha: dst = src + dst * (1 - srcA). SDL surfaces have no
+ * blend mode for this, so the blend mode, color key and color modulation
+ * of the source are ignored; the alpha modulation scales all channels.
+ * Supports the same formats as the native SDL_BLENDMODE_BLEND path.
+ */
+static mrb_value
+mrb_sdl2_video_surface_blit_premultiplied(mrb_state *mrb, mrb_value self)
+{
+  mrb_value src_rect, dst, dst_rect;
+  mrb_get_args(mrb, "ooo", &src_rect, &dst, &dst_rect);
+  SDL_Surface * const    ss = mrb_sdl2_video_surface_get_ptr(mrb, self);
+  SDL_Rect const * const sr = mrb_sdl2_rect_get_ptr(mrb, src_rect);
+  SDL_Surface * const    ds = mrb_sdl2_video_surface_get_ptr(mrb, dst);
+  SDL_Rect * const       dr = mrb_sdl2_rect_get_ptr(mrb, dst_rect);
+  Uint8 alpha;
+  if ((NULL == ss) || (NULL == ds)) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "surface is already freed.");
+  }
+  if (NULL == dr) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot set 3rd argument nil.");
+  }
+  if (ss == ds) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "cannot blit a surface onto itself.");
+  }
+  if (!mrb_sdl2_pixel_kernels_can_blend(ss->format->format, ds->format->format)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unsupported pixel format.");
+  }
+  if (0 != SDL_GetSurfaceAlphaMod(ss, &alpha)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  if (0 != SDL_LockSurface(ss)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  if (0 != SDL_LockSurface(ds)) {
+    SDL_UnlockSurface(ss);
+    mruby_sdl2_raise_error(mrb);
+  }
+  mrb_sdl2_video_surface_blend_rows(ss, sr, ds, dr, alpha, mrb_sdl2_video_surface_blend_premultiplied_band);
+  SDL_UnlockSurface(ds);
+  SDL_UnlockSurface(ss);
+  return self;
+}
+
+/*
+ * SDL2::Video::Surface#convert_format(format [, flags])
+ *
+ * Common 24/32-bit conversions are done by the native kernels; everything
+ * else falls back to SDL_ConvertSurfaceFormat. 'flags' is unused by SDL2
+ * and must be 0.
+ */
 static mrb_value
 mrb_sdl2_video_surface_convert_format(mrb_state *mrb, mrb_value self)
 {
-  mrb_raise(mrb, E_NOTIMP_ERROR, "not implemented.");
+  mrb_int format, flags = 0;
+  mrb_get_args(mrb, "i|i", &format, &flags);
+  if (0 != flags) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "flags must be 0.");
+  }
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
+  if (NULL == s) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "surface is already freed.");
+  }
+  SDL_Surface *converted = mrb_sdl2_video_surface_convert_native(s, (Uint32)format);
+  if (NULL == converted) {
+    converted = SDL_ConvertSurfaceFormat(s, (Uint32)format, 0);
+    if (NULL == converted) {
+      mruby_sdl2_raise_error(mrb);
+    }
+  }
+  return mrb_sdl2_video_surface(mrb, converted, false);
+}
+
+/*
+ * SDL2::Video::Surface#premultiply_alpha
+ *
+ * Multiplies the color channels by alpha in place.
+ * Only ARGB8888 and ABGR8888 surfaces are supported.
+ */
+static mrb_value
+mrb_sdl2_video_surface_premultiply_alpha(mrb_state *mrb, mrb_value self)
+{
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
+  if (NULL == s) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "surface is already freed.");
+  }
+  if ((SDL_PIXELFORMAT_ARGB8888 != s->format->format) && (SDL_PIXELFORMAT_ABGR8888 != s->format->format)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "unsupported pixel format.");
+  }
+  if (0 != SDL_LockSurface(s)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  mrb_sdl2_pixel_kernels_premultiply((Uint8*)s->pixels, s->pitch, s->w, s->h);
+  SDL_UnlockSurface(s);
   return self;
 }
 
+/*
+ * SDL2::Video::Surface#build_mipmaps([levels])
+ *
+ * Returns an Array of successively halved copies of the surface made
+ * with a 2x2 box filter, down to 1x1 or 'levels' surfaces.
+ * Only 24/32-bit formats with 8-bit channels are supported.
+ */
+static mrb_value
+mrb_sdl2_video_surface_build_mipmaps(mrb_state *mrb, mrb_value self)
+{
+  mrb_int levels = -1;
+  mrb_get_args(mrb, "|i", &levels);
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
+  mrb_sdl2_video_surface_check_filterable(mrb, s);
+  if (0 != SDL_LockSurface(s)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  mrb_value const ary = mrb_ary_new(mrb);
+  SDL_Surface *src = s;
+  mrb_int n;
+  for (n = 0; ((0 > levels) || (n < levels)) && ((1 < src->w) || (1 < src->h)); ++n) {
+    int const w = SDL_max(src->w / 2, 1);
+    int const h = SDL_max(src->h / 2, 1);
+    SDL_Surface *dst = mrb_sdl2_video_surface_create_like(src, w, h);
+    if (NULL == dst) {
+      SDL_UnlockSurface(s);
+      mruby_sdl2_raise_error(mrb);
+    }
+    mrb_sdl2_video_surface_filter_job_t job = { src, dst, NULL, NULL, NULL };
+    mrb_sdl2_video_surface_run_bands(mrb_sdl2_video_surface_downsample_band, &job, h, (Sint64)w * h);
+    mrb_sdl2_video_surface_copy_modulation(dst, s);
+    int const arena_size = mrb_gc_arena_save(mrb);
+    mrb_ary_push(mrb, ary, mrb_sdl2_video_surface(mrb, dst, false));
+    mrb_gc_arena_restore(mrb, arena_size);
+    src = dst;
+  }
+  SDL_UnlockSurface(s);
+  return ary;
+}
+
+/*
+ * SDL2::Video::Surface#scale_to(width, height)
+ *
+ * Returns a bilinear filtered copy of the surface in the given size.
+ * Only 24/32-bit formats with 8-bit channels are supported.
+ */
+static mrb_value
+mrb_sdl2_video_surface_scale_to(mrb_state *mrb, mrb_value self)
+{
+  mrb_int width, height;
+  mrb_get_args(mrb, "ii", &width, &height);
+  if ((0 >= width) || (0 >= height) || (SDL_MAX_SINT32 / 4 < width) || (SDL_MAX_SINT32 / 4 < height)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid size.");
+  }
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
+  mrb_sdl2_video_surface_check_filterable(mrb, s);
+  SDL_Surface *dst = mrb_sdl2_video_surface_create_like(s, (int)width, (int)height);
+  if (NULL == dst) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  int *columns = (int*)SDL_malloc(sizeof(int) * width * 3);
+  if (NULL == columns) {
+    SDL_FreeSurface(dst);
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  int *x0 = columns;
+  int *x1 = columns + width;
+  int *fx = columns + width * 2;
+  int const bpp = s->format->BytesPerPixel;
+  int x;
+  for (x = 0; x < width; ++x) {
+    int sx;
+    mrb_sdl2_video_surface_bilinear_sample(x, (int)width, s->w, &sx, &fx[x]);
+    x0[x] = sx * bpp;
+    x1[x] = SDL_min(sx + 1, s->w - 1) * bpp;
+  }
+  if (0 != SDL_LockSurface(s)) {
+    SDL_free(columns);
+    SDL_FreeSurface(dst);
+    mruby_sdl2_raise_error(mrb);
+  }
+  mrb_sdl2_video_surface_filter_job_t job = { s, dst, x0, x1, fx };
+  mrb_sdl2_video_surface_run_bands(mrb_sdl2_video_surface_bilinear_band, &job, (int)height, (Sint64)width * height);
+  SDL_UnlockSurface(s);
+  SDL_free(columns);
+  mrb_sdl2_video_surface_copy_modulation(dst, s);
+  return mrb_sdl2_video_surface(mrb, dst, false);
+}
+
+/*
+ * SDL2::Video::Surface::parallel_threads
+ */
+static mrb_value
+mrb_sdl2_video_surface_s_get_parallel_threads(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_workpool_threads());
+}
+
+/*
+ * SDL2::Video::Surface::parallel_threads=
+ *
+ * Number of threads (including the caller) used by large fills, scaled
+ * blits and format conversions. 1 disables the parallel mode.
+ */
+static mrb_value
+mrb_sdl2_video_surface_s_set_parallel_threads(mrb_state *mrb, mrb_value self)
+{
+  mrb_int count;
+  mrb_get_args(mrb, "i", &count);
+  if (count < 1) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "thread count must be positive.");
+  }
+  if (!mrb_sdl2_workpool_set_threads((int)count)) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_fixnum_value(count);
+}
+
+/*
+ * SDL2::Video::Surface::parallel_threshold
+ */
+static mrb_value
+mrb_sdl2_video_surface_s_get_parallel_threshold(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(parallel_threshold);
+}
+
+/*
+ * SDL2::Video::Surface::parallel_threshold=
+ *
+ * Minimum number of destination pixels for an operation to be split.
+ */
+static mrb_value
+mrb_sdl2_video_surface_s_set_parallel_threshold(mrb_state *mrb, mrb_value self)
+{
+  mrb_int threshold;
+  mrb_get_args(mrb, "i", &threshold);
+  if (threshold < 0) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "threshold must not be negative.");
+  }
+  parallel_threshold = threshold;
+  return mrb_fixnum_value(threshold);
+}
+
+/*
+ * SDL2::Video::Surface::simd_backend
+ */
+static mrb_value
+mrb_sdl2_video_surface_s_simd_backend(mrb_state *mrb, mrb_value self)
+{
+  return mrb_str_new_cstr(mrb, mrb_sdl2_pixel_kernels_backend());
+}
+
 static mrb_value
 mrb_sdl2_video_surface_fill_rect(mrb_state *mrb, mrb_value self)
 {
   uint32_t color;
-  mrb_value rect;
+  mrb_value rect = mrb_nil_value();
   mrb_get_args(mrb, "i|o", &color, &rect);
   SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
   SDL_Rect const * const r = mrb_sdl2_rect_get_ptr(mrb, rect);
+  if (mrb_sdl2_video_surface_fill_native(s, r, 1, color)) {
+    return self;
+  }
   if (0 != SDL_FillRect(s, r, color)) {
     mruby_sdl2_raise_error(mrb);
   }
@@ -164,11 +962,22 @@ mrb_sdl2_video_surface_fill_rects(mrb_state *mrb, mrb_value self)
   uint32_t color;
   mrb_value rects;
   mrb_get_args(mrb, "io", &color, &rects);
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
+  SDL_Rect *packed;
+  int count;
+  if (mrb_sdl2_rectarray_get(rects, &packed, &count)) {
+    if ((0 == count) || mrb_sdl2_video_surface_fill_native(s, packed, count, color)) {
+      return self;
+    }
+    if (0 != SDL_FillRects(s, packed, count, color)) {
+      mruby_sdl2_raise_error(mrb);
+    }
+    return self;
+  }
   if (!mrb_array_p(rects)) {
-    mrb_raise(mrb, E_TYPE_ERROR, "given 2nd argument is unexpected type (expected Array).");
+    mrb_raise(mrb, E_TYPE_ERROR, "given 2nd argument is unexpected type (expected Array or RectArray).");
   }
   mrb_int const n = mrb_ary_len(mrb, rects);
-  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, self);
   SDL_Rect r[n];
   mrb_int i;
   for (i = 0; i < n; ++i) {
@@ -179,6 +988,9 @@ mrb_sdl2_video_surface_fill_rects(mrb_state *mrb, mrb_value self)
       r[i] = (SDL_Rect){ 0, 0, 0, 0 };
     }
   }
+  if (mrb_sdl2_video_surface_fill_native(s, r, n, color)) {
+    return self;
+  }
   if (0 != SDL_FillRects(s, r, n, color)) {
     mruby_sdl2_raise_error(mrb);
   }
@@ -349,6 +1161,72 @@ mrb_sdl2_video_surface_unlock(mrb_state *mrb, mrb_value self)
 }
 
 
+static mrb_value
+mrb_sdl2_video_surface_pixels_yield(mrb_state *mrb, mrb_value args)
+{
+  return mrb_yield(mrb, mrb_ary_ref(mrb, args, 0), mrb_ary_ref(mrb, args, 1));
+}
+
+/* invalidates the view and unlocks its surface, also when the block raised. */
+static mrb_value
+mrb_sdl2_video_surface_pixels_release(mrb_state *mrb, mrb_value view)
+{
+  mrb_sdl2_video_pixelview_data_t *data =
+    (mrb_sdl2_video_pixelview_data_t*)DATA_PTR(view);
+  data->is_valid = false;
+  if (data->owner->surface == data->surface) {
+    SDL_UnlockSurface(data->surface);
+  }
+  return mrb_nil_value();
+}
+
+/*
+ * SDL2::Video::Surface#pixels { |view| ... }
+ *
+ * Locks the surface and yields a SDL2::Video::PixelView over its pixel
+ * memory. The view is invalidated and the surface unlocked when the block
+ * returns.
+ */
+static mrb_value
+mrb_sdl2_video_surface_pixels(mrb_state *mrb, mrb_value self)
+{
+  mrb_value block;
+  mrb_get_args(mrb, "&", &block);
+  if (mrb_nil_p(block)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "block is required.");
+  }
+  mrb_sdl2_video_surface_data_t *owner =
+    (mrb_sdl2_video_surface_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_video_surface_data_type);
+  SDL_Surface *s = owner->surface;
+  if (NULL == s) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "surface is already freed.");
+  }
+  mrb_sdl2_video_pixelview_data_t *data =
+    (mrb_sdl2_video_pixelview_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_video_pixelview_data_t));
+  if (NULL == data) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  if (0 != SDL_LockSurface(s)) {
+    mrb_free(mrb, data);
+    mruby_sdl2_raise_error(mrb);
+  }
+  data->owner    = owner;
+  data->surface  = s;
+  data->pixels   = (Uint8*)s->pixels;
+  data->pitch    = s->pitch;
+  data->bpp      = s->format->BytesPerPixel;
+  data->w        = s->w;
+  data->h        = s->h;
+  data->is_valid = true;
+  mrb_value const view = mrb_obj_value(Data_Wrap_Struct(mrb, class_PixelView, &mrb_sdl2_video_pixelview_data_type, data));
+  /* keep the owner alive while the view exists. */
+  mrb_iv_set(mrb, view, mrb_intern(mrb, "surface", 7), self);
+
+  mrb_value const args[2] = { block, view };
+  return mrb_ensure(mrb, mrb_sdl2_video_surface_pixels_yield, mrb_ary_new_from_values(mrb, 2, args),
+                    mrb_sdl2_video_surface_pixels_release, view);
+}
+
 /*
  * SDL2::Video::Surface::load_bmp
  */
@@ -364,6 +1242,23 @@ mrb_sdl2_video_surface_load_bmp(mrb_state *mrb, mrb_value self)
   return mrb_sdl2_video_surface(mrb, surface, false);
 }
 
+/*
+ * SDL2::Video::Surface::load_bmp_rw(rwops)
+ *
+ * The RWops is left open.
+ */
+static mrb_value
+mrb_sdl2_video_surface_load_bmp_rw(mrb_state *mrb, mrb_value self)
+{
+  mrb_value rwops;
+  mrb_get_args(mrb, "o", &rwops);
+  SDL_Surface *surface = SDL_LoadBMP_RW(mrb_sdl2_rwops_get_ptr(mrb, rwops), 0);
+  if (NULL == surface) {
+    mruby_sdl2_raise_error(mrb);
+  }
+  return mrb_sdl2_video_surface(mrb, surface, false);
+}
+
 /*
  * SDL2::Video::Surface::save_bmp
  */
@@ -380,19 +1275,311 @@ mrb_sdl2_video_surface_save_bmp(mrb_state *mrb, mrb_value self)
 }
 
 
+/***************************************************************************
+*
+* class SDL2::Video::PixelView
+*
+***************************************************************************/
+
+/*
+ * A view is usable only while the surface it was created for is alive,
+ * still locked and its pixels have not moved.
+ */
+static mrb_sdl2_video_pixelview_data_t *
+mrb_sdl2_video_pixelview_get_ptr(mrb_state *mrb, mrb_value view)
+{
+  mrb_sdl2_video_pixelview_data_t *data =
+    (mrb_sdl2_video_pixelview_data_t*)mrb_data_get_ptr(mrb, view, &mrb_sdl2_video_pixelview_data_type);
+  if (!data->is_valid ||
+      (data->owner->surface != data->surface) ||
+      (0 == data->surface->locked) ||
+      (data->surface->pixels != (void*)data->pixels)) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "pixel view is no longer valid.");
+  }
+  return data;
+}
+
+static Uint8 *
+mrb_sdl2_video_pixelview_at(mrb_state *mrb, mrb_sdl2_video_pixelview_data_t *data, mrb_int x, mrb_int y)
+{
+  if ((x < 0) || (x >= data->w) || (y < 0) || (y >= data->h)) {
+    mrb_raise(mrb, E_INDEX_ERROR, "pixel position out of bounds.");
+  }
+  return data->pixels + y * data->pitch + x * data->bpp;
+}
+
+static Uint32
+mrb_sdl2_video_pixelview_read(Uint8 const *p, int bpp)
+{
+  switch (bpp) {
+  case 1:
+    return *p;
+  case 2:
+    return *(Uint16 const *)p;
+  case 3:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    return p[0] | (p[1] << 8) | (p[2] << 16);
+#else
+    return (p[0] << 16) | (p[1] << 8) | p[2];
+#endif
+  default:
+    return *(Uint32 const *)p;
+  }
+}
+
+static void
+mrb_sdl2_video_pixelview_write(Uint8 *p, int bpp, Uint32 value)
+{
+  switch (bpp) {
+  case 1:
+    *p = (Uint8)value;
+    break;
+  case 2:
+    *(Uint16*)p = (Uint16)value;
+    break;
+  case 3:
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+    p[0] = (Uint8)(value);
+    p[1] = (Uint8)(value >> 8);
+    p[2] = (Uint8)(value >> 16);
+#else
+    p[0] = (Uint8)(value >> 16);
+    p[1] = (Uint8)(value >> 8);
+    p[2] = (Uint8)(value);
+#endif
+    break;
+  default:
+    *(Uint32*)p = value;
+    break;
+  }
+}
+
+/*
+ * Returns the start of 'rows' packed rows ('w * bpp' bytes each) at
+ * 'offset' of the given buffer, after checking it is large enough.
+ */
+static Uint8 *
+mrb_sdl2_video_pixelview_buffer_at(mrb_state *mrb, mrb_sdl2_video_pixelview_data_t *data, mrb_value buffer, mrb_int offset, mrb_int rows)
+{
+  size_t size;
+  Uint8 *ptr = (Uint8*)mrb_sdl2_misc_buffer_get_ptr(mrb, buffer, &size);
+  size_t const need = (size_t)data->w * data->bpp * rows;
+  if ((offset < 0) || ((size_t)offset > size) || (need > (size - (size_t)offset))) {
+    mrb_raise(mrb, E_INDEX_ERROR, "buffer is too small.");
+  }
+  return ptr + offset;
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_get_width(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_pixelview_get_ptr(mrb, self)->w);
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_get_height(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_pixelview_get_ptr(mrb, self)->h);
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_get_pitch(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_pixelview_get_ptr(mrb, self)->pitch);
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_get_bytes_per_pixel(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_pixelview_get_ptr(mrb, self)->bpp);
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_is_valid(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_pixelview_data_t *data =
+    (mrb_sdl2_video_pixelview_data_t*)mrb_data_get_ptr(mrb, self, &mrb_sdl2_video_pixelview_data_type);
+  return (data->is_valid &&
+          (data->owner->surface == data->surface) &&
+          (0 != data->surface->locked)) ? mrb_true_value() : mrb_false_value();
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_get_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int x, y;
+  mrb_get_args(mrb, "ii", &x, &y);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  return mrb_fixnum_value(mrb_sdl2_video_pixelview_read(mrb_sdl2_video_pixelview_at(mrb, data, x, y), data->bpp));
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_set_at(mrb_state *mrb, mrb_value self)
+{
+  mrb_int x, y, value;
+  mrb_get_args(mrb, "iii", &x, &y, &value);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  mrb_sdl2_video_pixelview_write(mrb_sdl2_video_pixelview_at(mrb, data, x, y), data->bpp, (Uint32)value);
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_get_rgba(mrb_state *mrb, mrb_value self)
+{
+  mrb_int x, y;
+  mrb_get_args(mrb, "ii", &x, &y);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint32 const pixel = mrb_sdl2_video_pixelview_read(mrb_sdl2_video_pixelview_at(mrb, data, x, y), data->bpp);
+  Uint8 r, g, b, a;
+  SDL_GetRGBA(pixel, data->surface->format, &r, &g, &b, &a);
+  mrb_value rgba[] = {
+    mrb_fixnum_value(r),
+    mrb_fixnum_value(g),
+    mrb_fixnum_value(b),
+    mrb_fixnum_value(a),
+  };
+  return mrb_obj_new(mrb, mrb_class_get_under(mrb, mod_SDL2, "RGBA"), 4, rgba);
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_set_rgba(mrb_state *mrb, mrb_value self)
+{
+  mrb_int x, y;
+  mrb_value color;
+  mrb_get_args(mrb, "iio", &x, &y, &color);
+  if (!mrb_obj_is_kind_of(mrb, color, mrb_class_get_under(mrb, mod_SDL2, "RGB"))) {
+    mrb_raise(mrb, E_TYPE_ERROR, "given 3rd argument is unexpected type (expected RGB).");
+  }
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint8 *p = mrb_sdl2_video_pixelview_at(mrb, data, x, y);
+  uint8_t const r = mrb_fixnum(mrb_funcall(mrb, color, "r", 0));
+  uint8_t const g = mrb_fixnum(mrb_funcall(mrb, color, "g", 0));
+  uint8_t const b = mrb_fixnum(mrb_funcall(mrb, color, "b", 0));
+  uint8_t a = SDL_ALPHA_OPAQUE;
+  if (mrb_respond_to(mrb, color, mrb_intern(mrb, "a", 1))) {
+    a = mrb_fixnum(mrb_funcall(mrb, color, "a", 0));
+  }
+  mrb_sdl2_video_pixelview_write(p, data->bpp, SDL_MapRGBA(data->surface->format, r, g, b, a));
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_video_pixelview_copy_row(mrb_state *mrb, mrb_value self)
+{
+  mrb_int src_y, dst_y;
+  mrb_get_args(mrb, "ii", &src_y, &dst_y);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint8 const *src = mrb_sdl2_video_pixelview_at(mrb, data, 0, src_y);
+  Uint8 *dst = mrb_sdl2_video_pixelview_at(mrb, data, 0, dst_y);
+  if (src != dst) {
+    SDL_memcpy(dst, src, (size_t)data->w * data->bpp);
+  }
+  return self;
+}
+
+/*
+ * SDL2::Video::PixelView#import_row(y, buffer [, offset])
+ */
+static mrb_value
+mrb_sdl2_video_pixelview_import_row(mrb_state *mrb, mrb_value self)
+{
+  mrb_int y, offset = 0;
+  mrb_value buffer;
+  mrb_get_args(mrb, "io|i", &y, &buffer, &offset);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint8 *dst = mrb_sdl2_video_pixelview_at(mrb, data, 0, y);
+  Uint8 const *src = mrb_sdl2_video_pixelview_buffer_at(mrb, data, buffer, offset, 1);
+  SDL_memcpy(dst, src, (size_t)data->w * data->bpp);
+  return self;
+}
+
+/*
+ * SDL2::Video::PixelView#export_row(y, buffer [, offset])
+ */
+static mrb_value
+mrb_sdl2_video_pixelview_export_row(mrb_state *mrb, mrb_value self)
+{
+  mrb_int y, offset = 0;
+  mrb_value buffer;
+  mrb_get_args(mrb, "io|i", &y, &buffer, &offset);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint8 const *src = mrb_sdl2_video_pixelview_at(mrb, data, 0, y);
+  Uint8 *dst = mrb_sdl2_video_pixelview_buffer_at(mrb, data, buffer, offset, 1);
+  SDL_memcpy(dst, src, (size_t)data->w * data->bpp);
+  return self;
+}
+
+/*
+ * SDL2::Video::PixelView#import(buffer [, offset])
+ *
+ * Copies tightly packed rows ('width * bytes_per_pixel' bytes each) from
+ * the buffer into the surface.
+ */
+static mrb_value
+mrb_sdl2_video_pixelview_import(mrb_state *mrb, mrb_value self)
+{
+  mrb_int offset = 0;
+  mrb_value buffer;
+  mrb_get_args(mrb, "o|i", &buffer, &offset);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint8 const *src = mrb_sdl2_video_pixelview_buffer_at(mrb, data, buffer, offset, data->h);
+  size_t const row = (size_t)data->w * data->bpp;
+  if (row == (size_t)data->pitch) {
+    SDL_memcpy(data->pixels, src, row * data->h);
+  } else {
+    int y;
+    for (y = 0; y < data->h; ++y) {
+      SDL_memcpy(data->pixels + y * data->pitch, src + y * row, row);
+    }
+  }
+  return self;
+}
+
+/*
+ * SDL2::Video::PixelView#export(buffer [, offset])
+ */
+static mrb_value
+mrb_sdl2_video_pixelview_export(mrb_state *mrb, mrb_value self)
+{
+  mrb_int offset = 0;
+  mrb_value buffer;
+  mrb_get_args(mrb, "o|i", &buffer, &offset);
+  mrb_sdl2_video_pixelview_data_t *data = mrb_sdl2_video_pixelview_get_ptr(mrb, self);
+  Uint8 *dst = mrb_sdl2_video_pixelview_buffer_at(mrb, data, buffer, offset, data->h);
+  size_t const row = (size_t)data->w * data->bpp;
+  if (row == (size_t)data->pitch) {
+    SDL_memcpy(dst, data->pixels, row * data->h);
+  } else {
+    int y;
+    for (y = 0; y < data->h; ++y) {
+      SDL_memcpy(dst + y * row, data->pixels + y * data->pitch, row);
+    }
+  }
+  return self;
+}
+
+
 void
 mruby_sdl2_video_surface_init(mrb_state *mrb, struct RClass *mod_Video)
 {
-  class_Surface = mrb_define_class_under(mrb, mod_Video, "Surface", mrb->object_class);
+  class_Surface   = mrb_define_class_under(mrb, mod_Video, "Surface",   mrb->object_class);
+  class_PixelView = mrb_define_class_under(mrb, mod_Video, "PixelView", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_Surface,   MRB_TT_DATA);
+  MRB_SET_INSTANCE_TT(class_PixelView, MRB_TT_DATA);
 
-  MRB_SET_INSTANCE_TT(class_Surface, MRB_TT_DATA);
+  mrb_sdl2_pixel_kernels_init();
 
   mrb_define_method(mrb, class_Surface, "initialize",     mrb_sdl2_video_surface_initialize,     MRB_ARGS_REQ(8));
   mrb_define_method(mrb, class_Surface, "free",           mrb_sdl2_video_surface_free,           MRB_ARGS_NONE());
   mrb_define_method(mrb, class_Surface, "destroy",        mrb_sdl2_video_surface_free,           MRB_ARGS_NONE());
   mrb_define_method(mrb, class_Surface, "blit_scaled",    mrb_sdl2_video_surface_blit_scaled,    MRB_ARGS_REQ(2) | MRB_ARGS_OPT(1));
   mrb_define_method(mrb, class_Surface, "blit_surface",   mrb_sdl2_video_surface_blit_surface,   MRB_ARGS_REQ(3));
-  mrb_define_method(mrb, class_Surface, "convert_format", mrb_sdl2_video_surface_convert_format, MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_Surface, "blit_premultiplied", mrb_sdl2_video_surface_blit_premultiplied, MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, class_Surface, "convert_format", mrb_sdl2_video_surface_convert_format, MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_Surface, "premultiply_alpha", mrb_sdl2_video_surface_premultiply_alpha, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Surface, "build_mipmaps",  mrb_sdl2_video_surface_build_mipmaps,  MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_Surface, "scale_to",       mrb_sdl2_video_surface_scale_to,       MRB_ARGS_REQ(2));
   mrb_define_method(mrb, class_Surface, "fill_rect",      mrb_sdl2_video_surface_fill_rect,      MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
   mrb_define_method(mrb, class_Surface, "fill_rects",     mrb_sdl2_video_surface_fill_rects,     MRB_ARGS_REQ(2));
   mrb_define_method(mrb, class_Surface, "clip_rect",      mrb_sdl2_video_surface_get_clip_rect,  MRB_ARGS_NONE());
@@ -409,14 +1596,37 @@ mruby_sdl2_video_surface_init(mrb_state *mrb, struct RClass *mod_Video)
   mrb_define_method(mrb, class_Surface, "rle",            mrb_sdl2_video_surface_set_rle,        MRB_ARGS_REQ(1));
   mrb_define_method(mrb, class_Surface, "lock",           mrb_sdl2_video_surface_lock,           MRB_ARGS_NONE());
   mrb_define_method(mrb, class_Surface, "unlock",         mrb_sdl2_video_surface_unlock,         MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_Surface, "pixels",         mrb_sdl2_video_surface_pixels,         MRB_ARGS_BLOCK());
 
   mrb_define_class_method(mrb, class_Surface, "load_bmp", mrb_sdl2_video_surface_load_bmp, MRB_ARGS_REQ(1));
+  mrb_define_class_method(mrb, class_Surface, "load_bmp_rw", mrb_sdl2_video_surface_load_bmp_rw, MRB_ARGS_REQ(1));
   mrb_define_class_method(mrb, class_Surface, "save_bmp", mrb_sdl2_video_surface_save_bmp, MRB_ARGS_REQ(2));
+  mrb_define_class_method(mrb, class_Surface, "simd_backend", mrb_sdl2_video_surface_s_simd_backend, MRB_ARGS_NONE());
+  mrb_define_class_method(mrb, class_Surface, "parallel_threads",    mrb_sdl2_video_surface_s_get_parallel_threads,   MRB_ARGS_NONE());
+  mrb_define_class_method(mrb, class_Surface, "parallel_threads=",   mrb_sdl2_video_surface_s_set_parallel_threads,   MRB_ARGS_REQ(1));
+  mrb_define_class_method(mrb, class_Surface, "parallel_threshold",  mrb_sdl2_video_surface_s_get_parallel_threshold, MRB_ARGS_NONE());
+  mrb_define_class_method(mrb, class_Surface, "parallel_threshold=", mrb_sdl2_video_surface_s_set_parallel_threshold, MRB_ARGS_REQ(1));
+
+  mrb_define_method(mrb, class_PixelView, "width",           mrb_sdl2_video_pixelview_get_width,           MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PixelView, "height",          mrb_sdl2_video_pixelview_get_height,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PixelView, "pitch",           mrb_sdl2_video_pixelview_get_pitch,           MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PixelView, "bytes_per_pixel", mrb_sdl2_video_pixelview_get_bytes_per_pixel, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PixelView, "valid?",          mrb_sdl2_video_pixelview_is_valid,            MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_PixelView, "[]",              mrb_sdl2_video_pixelview_get_at,              MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PixelView, "[]=",             mrb_sdl2_video_pixelview_set_at,              MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, class_PixelView, "rgba",            mrb_sdl2_video_pixelview_get_rgba,            MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PixelView, "set_rgba",        mrb_sdl2_video_pixelview_set_rgba,            MRB_ARGS_REQ(3));
+  mrb_define_method(mrb, class_PixelView, "copy_row",        mrb_sdl2_video_pixelview_copy_row,            MRB_ARGS_REQ(2));
+  mrb_define_method(mrb, class_PixelView, "import_row",      mrb_sdl2_video_pixelview_import_row,          MRB_ARGS_REQ(2) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_PixelView, "export_row",      mrb_sdl2_video_pixelview_export_row,          MRB_ARGS_REQ(2) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_PixelView, "import",          mrb_sdl2_video_pixelview_import,              MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_PixelView, "export",          mrb_sdl2_video_pixelview_export,              MRB_ARGS_REQ(1) | MRB_ARGS_OPT(1));
 }
 
 void
 mruby_sdl2_video_surface_final(mrb_state *mrb, struct RClass *mod_Video)
 {
+  mrb_sdl2_workpool_final();
 }
 
 
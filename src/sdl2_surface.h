@@ -15,6 +15,9 @@ extern mrb_value mrb_sdl2_video_surface(mrb_state *mrb, SDL_Surface *surface, bo
 
 extern SDL_Surface *mrb_sdl2_video_surface_get_ptr(mrb_state *mrb, mrb_value surface);
 
+/* takes the SDL_Surface away from 'surface', which becomes freed. */
+extern SDL_Surface *mrb_sdl2_video_surface_detach(mrb_state *mrb, mrb_value surface);
+
 #ifdef __cplusplus
 }
 #endif
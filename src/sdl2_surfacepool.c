@@ -0,0 +1,329 @@
+#include "sdl2_surfacepool.h"
+#include "sdl2_surface.h"
+#include "mruby/data.h"
+#include "mruby/class.h"
+#include "mruby/variable.h"
+#include <SDL2/SDL_surface.h>
+#include <SDL2/SDL_pixels.h>
+
+static struct RClass *class_SurfacePool = NULL;
+
+/* surfaces are interchangeable when their size and pixel format match. */
+typedef struct mrb_sdl2_video_surfacepool_key_t {
+  int    w;
+  int    h;
+  Uint32 format;
+} mrb_sdl2_video_surfacepool_key_t;
+
+typedef struct mrb_sdl2_video_surfacepool_bucket_t {
+  mrb_sdl2_video_surfacepool_key_t            key;
+  SDL_Surface                               **surfaces;
+  int                                         count;
+  struct mrb_sdl2_video_surfacepool_bucket_t *next;
+} mrb_sdl2_video_surfacepool_bucket_t;
+
+typedef struct mrb_sdl2_video_surfacepool_data_t {
+  mrb_sdl2_video_surfacepool_bucket_t *buckets;
+  int                                  max_per_key;
+  mrb_int                              idle;
+  mrb_int                              in_use;
+  mrb_int                              high_water_mark;
+  mrb_int                              reuse_count;
+  mrb_int                              alloc_count;
+} mrb_sdl2_video_surfacepool_data_t;
+
+static void
+mrb_sdl2_video_surfacepool_clear_buckets(mrb_state *mrb, mrb_sdl2_video_surfacepool_data_t *data)
+{
+  mrb_sdl2_video_surfacepool_bucket_t *bucket = data->buckets;
+  while (NULL != bucket) {
+    mrb_sdl2_video_surfacepool_bucket_t *next = bucket->next;
+    int i;
+    for (i = 0; i < bucket->count; ++i) {
+      SDL_FreeSurface(bucket->surfaces[i]);
+    }
+    mrb_free(mrb, bucket->surfaces);
+    mrb_free(mrb, bucket);
+    bucket = next;
+  }
+  data->buckets = NULL;
+  data->idle    = 0;
+}
+
+static void
+mrb_sdl2_video_surfacepool_data_free(mrb_state *mrb, void *p)
+{
+  mrb_sdl2_video_surfacepool_data_t *data =
+    (mrb_sdl2_video_surfacepool_data_t*)p;
+  if (NULL != data) {
+    mrb_sdl2_video_surfacepool_clear_buckets(mrb, data);
+    mrb_free(mrb, data);
+  }
+}
+
+static struct mrb_data_type const mrb_sdl2_video_surfacepool_data_type = {
+  "SurfacePool", mrb_sdl2_video_surfacepool_data_free
+};
+
+static mrb_sdl2_video_surfacepool_data_t *
+mrb_sdl2_video_surfacepool_get_ptr(mrb_state *mrb, mrb_value pool)
+{
+  return (mrb_sdl2_video_surfacepool_data_t*)mrb_data_get_ptr(mrb, pool, &mrb_sdl2_video_surfacepool_data_type);
+}
+
+static mrb_sdl2_video_surfacepool_bucket_t *
+mrb_sdl2_video_surfacepool_find(mrb_sdl2_video_surfacepool_data_t *data, mrb_sdl2_video_surfacepool_key_t const *key)
+{
+  mrb_sdl2_video_surfacepool_bucket_t *bucket;
+  for (bucket = data->buckets; NULL != bucket; bucket = bucket->next) {
+    if ((bucket->key.w == key->w) && (bucket->key.h == key->h) && (bucket->key.format == key->format)) {
+      return bucket;
+    }
+  }
+  return NULL;
+}
+
+static mrb_sdl2_video_surfacepool_bucket_t *
+mrb_sdl2_video_surfacepool_find_or_add(mrb_state *mrb, mrb_sdl2_video_surfacepool_data_t *data, mrb_sdl2_video_surfacepool_key_t const *key)
+{
+  mrb_sdl2_video_surfacepool_bucket_t *bucket = mrb_sdl2_video_surfacepool_find(data, key);
+  if (NULL != bucket) {
+    return bucket;
+  }
+  bucket = (mrb_sdl2_video_surfacepool_bucket_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_video_surfacepool_bucket_t));
+  if (NULL == bucket) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  bucket->surfaces = (SDL_Surface**)mrb_malloc(mrb, sizeof(SDL_Surface*) * data->max_per_key);
+  if (NULL == bucket->surfaces) {
+    mrb_free(mrb, bucket);
+    mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+  }
+  bucket->key   = *key;
+  bucket->count = 0;
+  bucket->next  = data->buckets;
+  data->buckets = bucket;
+  return bucket;
+}
+
+/*
+ * Only surfaces that own plain pixel memory can be recycled; palettes and
+ * RLE encodings would leak state to the next user.
+ */
+static bool
+mrb_sdl2_video_surfacepool_is_poolable(SDL_Surface const *s)
+{
+  return (1 == s->refcount) &&
+         (NULL == s->format->palette) &&
+         (0 == (s->flags & (SDL_PREALLOC | SDL_RLEACCEL)));
+}
+
+/*
+ * Puts a recycled surface back into the state SDL_CreateRGBSurface
+ * returns it in.
+ */
+static void
+mrb_sdl2_video_surfacepool_reset(SDL_Surface *s, bool clear)
+{
+  SDL_SetColorKey(s, SDL_FALSE, 0);
+  SDL_SetSurfaceColorMod(s, 0xFF, 0xFF, 0xFF);
+  SDL_SetSurfaceAlphaMod(s, 0xFF);
+  SDL_SetSurfaceBlendMode(s, (0 != s->format->Amask) ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+  SDL_SetClipRect(s, NULL);
+  if (clear) {
+    SDL_memset(s->pixels, 0, (size_t)s->pitch * s->h);
+  }
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_initialize(mrb_state *mrb, mrb_value self)
+{
+  mrb_int max_per_key = 8;
+  mrb_get_args(mrb, "|i", &max_per_key);
+  if ((0 >= max_per_key) || (0xFFFF < max_per_key)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "max_per_key is out of range.");
+  }
+  mrb_sdl2_video_surfacepool_data_t *data =
+    (mrb_sdl2_video_surfacepool_data_t*)DATA_PTR(self);
+  if (NULL == data) {
+    data = (mrb_sdl2_video_surfacepool_data_t*)mrb_malloc(mrb, sizeof(mrb_sdl2_video_surfacepool_data_t));
+    if (NULL == data) {
+      mrb_raise(mrb, E_RUNTIME_ERROR, "insufficient memory.");
+    }
+    data->buckets = NULL;
+  } else {
+    mrb_sdl2_video_surfacepool_clear_buckets(mrb, data);
+  }
+  data->max_per_key     = (int)max_per_key;
+  data->idle            = 0;
+  data->in_use          = 0;
+  data->high_water_mark = 0;
+  data->reuse_count     = 0;
+  data->alloc_count     = 0;
+  DATA_PTR(self)  = data;
+  DATA_TYPE(self) = &mrb_sdl2_video_surfacepool_data_type;
+  return self;
+}
+
+/*
+ * SDL2::Video::SurfacePool#acquire(width, height, depth, rmask, gmask, bmask, amask[, clear = true])
+ *
+ * Returns a pooled surface of the given layout, or a new one if none is
+ * available. Recycled surfaces are zero-filled unless 'clear' is false.
+ */
+static mrb_value
+mrb_sdl2_video_surfacepool_acquire(mrb_state *mrb, mrb_value self)
+{
+  mrb_int width, height, depth, rmask, gmask, bmask, amask;
+  mrb_bool clear = true;
+  mrb_get_args(mrb, "iiiiiii|b", &width, &height, &depth, &rmask, &gmask, &bmask, &amask, &clear);
+  mrb_sdl2_video_surfacepool_data_t *data = mrb_sdl2_video_surfacepool_get_ptr(mrb, self);
+
+  mrb_sdl2_video_surfacepool_key_t key;
+  key.w      = (int)width;
+  key.h      = (int)height;
+  key.format = SDL_MasksToPixelFormatEnum((int)depth, (Uint32)rmask, (Uint32)gmask, (Uint32)bmask, (Uint32)amask);
+
+  SDL_Surface *s = NULL;
+  mrb_sdl2_video_surfacepool_bucket_t *bucket = mrb_sdl2_video_surfacepool_find(data, &key);
+  if ((NULL != bucket) && (0 < bucket->count)) {
+    s = bucket->surfaces[--bucket->count];
+    --data->idle;
+    ++data->reuse_count;
+    mrb_sdl2_video_surfacepool_reset(s, clear);
+  } else {
+    s = SDL_CreateRGBSurface(0, width, height, depth, rmask, gmask, bmask, amask);
+    if (NULL == s) {
+      mruby_sdl2_raise_error(mrb);
+    }
+    ++data->alloc_count;
+  }
+  if (++data->in_use > data->high_water_mark) {
+    data->high_water_mark = data->in_use;
+  }
+  mrb_value const result = mrb_sdl2_video_surface(mrb, s, false);
+  /* marks the surface as ours for release. */
+  mrb_iv_set(mrb, result, mrb_intern(mrb, "pool", 4), self);
+  return result;
+}
+
+/*
+ * SDL2::Video::SurfacePool#release(surface)
+ *
+ * Takes the pixels of 'surface' back into the pool; 'surface' is freed.
+ * Returns false if the surface could not be kept and was destroyed.
+ * Surfaces not acquired from this pool raise ArgumentError.
+ */
+static mrb_value
+mrb_sdl2_video_surfacepool_release(mrb_state *mrb, mrb_value self)
+{
+  mrb_value surface;
+  mrb_get_args(mrb, "o", &surface);
+  mrb_sdl2_video_surfacepool_data_t *data = mrb_sdl2_video_surfacepool_get_ptr(mrb, self);
+  SDL_Surface *s = mrb_sdl2_video_surface_get_ptr(mrb, surface);
+  if (NULL == s) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "surface is already freed.");
+  }
+  if (0 != s->locked) {
+    mrb_raise(mrb, E_RUNTIME_ERROR, "cannot release a locked surface.");
+  }
+  mrb_value const pool = mrb_iv_get(mrb, surface, mrb_intern(mrb, "pool", 4));
+  if (!mrb_obj_equal(mrb, pool, self)) {
+    mrb_raise(mrb, E_ARGUMENT_ERROR, "surface was not acquired from this pool.");
+  }
+
+  mrb_sdl2_video_surfacepool_bucket_t *bucket = NULL;
+  if (mrb_sdl2_video_surfacepool_is_poolable(s)) {
+    mrb_sdl2_video_surfacepool_key_t key;
+    key.w      = s->w;
+    key.h      = s->h;
+    key.format = s->format->format;
+    bucket = mrb_sdl2_video_surfacepool_find_or_add(mrb, data, &key);
+  }
+
+  s = mrb_sdl2_video_surface_detach(mrb, surface);
+  mrb_iv_set(mrb, surface, mrb_intern(mrb, "pool", 4), mrb_nil_value());
+  if (0 < data->in_use) {
+    --data->in_use;
+  }
+  if ((NULL != bucket) && (bucket->count < data->max_per_key)) {
+    bucket->surfaces[bucket->count++] = s;
+    ++data->idle;
+    return mrb_true_value();
+  }
+  SDL_FreeSurface(s);
+  return mrb_false_value();
+}
+
+/*
+ * SDL2::Video::SurfacePool#clear
+ *
+ * Destroys every idle surface. Counters are kept.
+ */
+static mrb_value
+mrb_sdl2_video_surfacepool_clear(mrb_state *mrb, mrb_value self)
+{
+  mrb_sdl2_video_surfacepool_clear_buckets(mrb, mrb_sdl2_video_surfacepool_get_ptr(mrb, self));
+  return self;
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_get_size(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_surfacepool_get_ptr(mrb, self)->idle);
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_get_in_use(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_surfacepool_get_ptr(mrb, self)->in_use);
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_get_high_water_mark(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_surfacepool_get_ptr(mrb, self)->high_water_mark);
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_get_reuse_count(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_surfacepool_get_ptr(mrb, self)->reuse_count);
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_get_alloc_count(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_surfacepool_get_ptr(mrb, self)->alloc_count);
+}
+
+static mrb_value
+mrb_sdl2_video_surfacepool_get_max_per_key(mrb_state *mrb, mrb_value self)
+{
+  return mrb_fixnum_value(mrb_sdl2_video_surfacepool_get_ptr(mrb, self)->max_per_key);
+}
+
+
+void
+mruby_sdl2_video_surfacepool_init(mrb_state *mrb, struct RClass *mod_Video)
+{
+  class_SurfacePool = mrb_define_class_under(mrb, mod_Video, "SurfacePool", mrb->object_class);
+
+  MRB_SET_INSTANCE_TT(class_SurfacePool, MRB_TT_DATA);
+
+  mrb_define_method(mrb, class_SurfacePool, "initialize",      mrb_sdl2_video_surfacepool_initialize,          MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_SurfacePool, "acquire",         mrb_sdl2_video_surfacepool_acquire,             MRB_ARGS_REQ(7) | MRB_ARGS_OPT(1));
+  mrb_define_method(mrb, class_SurfacePool, "release",         mrb_sdl2_video_surfacepool_release,             MRB_ARGS_REQ(1));
+  mrb_define_method(mrb, class_SurfacePool, "clear",           mrb_sdl2_video_surfacepool_clear,               MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SurfacePool, "size",            mrb_sdl2_video_surfacepool_get_size,            MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SurfacePool, "in_use",          mrb_sdl2_video_surfacepool_get_in_use,          MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SurfacePool, "high_water_mark", mrb_sdl2_video_surfacepool_get_high_water_mark, MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SurfacePool, "reuse_count",     mrb_sdl2_video_surfacepool_get_reuse_count,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SurfacePool, "alloc_count",     mrb_sdl2_video_surfacepool_get_alloc_count,     MRB_ARGS_NONE());
+  mrb_define_method(mrb, class_SurfacePool, "max_per_key",     mrb_sdl2_video_surfacepool_get_max_per_key,     MRB_ARGS_NONE());
+}
+
+void
+mruby_sdl2_video_surfacepool_final(mrb_state *mrb, struct RClass *mod_Video)
+{
+}
@@ -2,6 +2,8 @@
 #include "sdl2_rect.h"
 #include "sdl2_render.h"
 #include "sdl2_surface.h"
+#include "sdl2_surfacepool.h"
+#include "sdl2_framedumper.h"
 #include "mruby/class.h"
 #include "mruby/data.h"
 #include "mruby/string.h"
@@ -1003,6 +1005,8 @@ mruby_sdl2_video_init(mrb_state *mrb)
 
   mruby_sdl2_video_renderer_init(mrb, mod_Video);
   mruby_sdl2_video_surface_init(mrb, mod_Video);
+  mruby_sdl2_video_surfacepool_init(mrb, mod_Video);
+  mruby_sdl2_video_framedumper_init(mrb, mod_Video);
 
   mrb_gc_arena_restore(mrb, arena_size);
 }
@@ -1010,6 +1014,8 @@ mruby_sdl2_video_init(mrb_state *mrb)
 void
 mruby_sdl2_video_final(mrb_state *mrb)
 {
+  mruby_sdl2_video_framedumper_final(mrb, mod_Video);
+  mruby_sdl2_video_surfacepool_final(mrb, mod_Video);
   mruby_sdl2_video_surface_final(mrb, mod_Video);
   mruby_sdl2_video_renderer_final(mrb, mod_Video);
 }
@@ -0,0 +1,21 @@
+#ifndef MRUBY_SDL2_SIMD_H
+#define MRUBY_SDL2_SIMD_H
+
+#include <SDL2/SDL_endian.h>
+#include <SDL2/SDL_cpuinfo.h>
+
+/*
+ * Compile-time SIMD availability.
+ * The NEON kernels assume little-endian pixel layout.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+# define MRB_SDL2_HAVE_SSE2 1
+# include <emmintrin.h>
+#endif
+
+#if (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+# define MRB_SDL2_HAVE_NEON 1
+# include <arm_neon.h>
+#endif
+
+#endif /* end of MRUBY_SDL2_SIMD_H */
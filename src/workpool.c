@@ -0,0 +1,229 @@
+#include "workpool.h"
+#include <SDL2/SDL_stdinc.h>
+#include <SDL2/SDL_thread.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_atomic.h>
+
+/*
+ * A small pool of SDL threads for band-parallel pixel work.
+ *
+ * Jobs are split into horizontal bands which are handed out through an
+ * atomic counter; the calling thread takes bands too. Only one job runs
+ * at a time.
+ */
+
+#define WORKPOOL_MAX_THREADS      32
+#define WORKPOOL_BANDS_PER_THREAD 4
+#define WORKPOOL_MIN_BAND_ROWS    8
+
+typedef struct mrb_sdl2_workpool_t {
+  SDL_mutex  *mutex;
+  SDL_cond   *wakeup;
+  SDL_cond   *idle;
+  SDL_Thread *threads[WORKPOOL_MAX_THREADS];
+  int         count;
+  int         generation;
+  int         active;
+  bool        busy;
+  bool        quit;
+  /* current job. */
+  mrb_sdl2_workpool_func func;
+  void                  *arg;
+  int                    rows;
+  int                    band;
+  int                    bands;
+  SDL_atomic_t           next;
+} mrb_sdl2_workpool_t;
+
+static mrb_sdl2_workpool_t pool;
+
+static void
+mrb_sdl2_workpool_process(void)
+{
+  for (;;) {
+    int const i = SDL_AtomicAdd(&pool.next, 1);
+    if (i >= pool.bands) {
+      break;
+    }
+    int const first = i * pool.band;
+    int const last  = SDL_min(first + pool.band, pool.rows);
+    pool.func(pool.arg, first, last);
+  }
+}
+
+static int
+mrb_sdl2_workpool_thread(void *unused)
+{
+  SDL_LockMutex(pool.mutex);
+  int seen = pool.generation;
+  for (;;) {
+    while (!pool.quit && (seen == pool.generation)) {
+      SDL_CondWait(pool.wakeup, pool.mutex);
+    }
+    if (pool.quit) {
+      break;
+    }
+    seen = pool.generation;
+    ++pool.active;
+    SDL_UnlockMutex(pool.mutex);
+
+    mrb_sdl2_workpool_process();
+
+    SDL_LockMutex(pool.mutex);
+    if (0 == --pool.active) {
+      SDL_CondBroadcast(pool.idle);
+    }
+  }
+  SDL_UnlockMutex(pool.mutex);
+  return 0;
+}
+
+static void
+mrb_sdl2_workpool_stop(void)
+{
+  int i;
+  if (NULL == pool.mutex) {
+    return;
+  }
+  SDL_LockMutex(pool.mutex);
+  pool.quit = true;
+  SDL_CondBroadcast(pool.wakeup);
+  SDL_UnlockMutex(pool.mutex);
+  for (i = 0; i < pool.count; ++i) {
+    SDL_WaitThread(pool.threads[i], NULL);
+    pool.threads[i] = NULL;
+  }
+  pool.count = 0;
+  pool.quit  = false;
+}
+
+/* waits for the running job, then keeps new ones out until released. */
+static void
+mrb_sdl2_workpool_acquire(void)
+{
+  SDL_LockMutex(pool.mutex);
+  while (pool.busy || (0 < pool.active)) {
+    SDL_CondWait(pool.idle, pool.mutex);
+  }
+  pool.busy = true;
+  SDL_UnlockMutex(pool.mutex);
+}
+
+static void
+mrb_sdl2_workpool_release(void)
+{
+  SDL_LockMutex(pool.mutex);
+  pool.busy = false;
+  SDL_CondBroadcast(pool.idle);
+  SDL_UnlockMutex(pool.mutex);
+}
+
+bool
+mrb_sdl2_workpool_set_threads(int count)
+{
+  if (NULL == pool.mutex) {
+    if (count <= 1) {
+      return true;
+    }
+    pool.mutex  = SDL_CreateMutex();
+    pool.wakeup = SDL_CreateCond();
+    pool.idle   = SDL_CreateCond();
+    if ((NULL == pool.mutex) || (NULL == pool.wakeup) || (NULL == pool.idle)) {
+      mrb_sdl2_workpool_final();
+      return false;
+    }
+  }
+  count = (count <= 1) ? 0 : SDL_min(count - 1, WORKPOOL_MAX_THREADS);
+
+  bool result = true;
+  mrb_sdl2_workpool_acquire();
+  mrb_sdl2_workpool_stop();
+  for (pool.count = 0; pool.count < count; ++pool.count) {
+    pool.threads[pool.count] = SDL_CreateThread(mrb_sdl2_workpool_thread, "mrb_sdl2_workpool", NULL);
+    if (NULL == pool.threads[pool.count]) {
+      mrb_sdl2_workpool_stop();
+      result = false;
+      break;
+    }
+  }
+  mrb_sdl2_workpool_release();
+  return result;
+}
+
+int
+mrb_sdl2_workpool_threads(void)
+{
+  if (NULL == pool.mutex) {
+    return 1;
+  }
+  /* set_threads rewrites pool.count while it holds 'busy'. */
+  SDL_LockMutex(pool.mutex);
+  while (pool.busy) {
+    SDL_CondWait(pool.idle, pool.mutex);
+  }
+  int const count = pool.count;
+  SDL_UnlockMutex(pool.mutex);
+  return count + 1;
+}
+
+void
+mrb_sdl2_workpool_run(mrb_sdl2_workpool_func func, void *arg, int rows)
+{
+  if (rows <= 0) {
+    return;
+  }
+  if ((NULL == pool.mutex) || (rows < WORKPOOL_MIN_BAND_ROWS * 2)) {
+    func(arg, 0, rows);
+    return;
+  }
+
+  SDL_LockMutex(pool.mutex);
+  while (pool.busy || (0 < pool.active)) {
+    SDL_CondWait(pool.idle, pool.mutex);
+  }
+  if (0 == pool.count) {
+    SDL_UnlockMutex(pool.mutex);
+    func(arg, 0, rows);
+    return;
+  }
+  int const parts = (pool.count + 1) * WORKPOOL_BANDS_PER_THREAD;
+  pool.busy  = true;
+  pool.func  = func;
+  pool.arg   = arg;
+  pool.rows  = rows;
+  pool.band  = SDL_max((rows + parts - 1) / parts, WORKPOOL_MIN_BAND_ROWS);
+  pool.bands = (rows + pool.band - 1) / pool.band;
+  SDL_AtomicSet(&pool.next, 0);
+  ++pool.generation;
+  SDL_CondBroadcast(pool.wakeup);
+  SDL_UnlockMutex(pool.mutex);
+
+  mrb_sdl2_workpool_process();
+
+  /* every band handed out belongs to a thread counted in 'active'. */
+  SDL_LockMutex(pool.mutex);
+  while (0 < pool.active) {
+    SDL_CondWait(pool.idle, pool.mutex);
+  }
+  pool.busy = false;
+  SDL_CondBroadcast(pool.idle);
+  SDL_UnlockMutex(pool.mutex);
+}
+
+void
+mrb_sdl2_workpool_final(void)
+{
+  mrb_sdl2_workpool_stop();
+  if (NULL != pool.idle) {
+    SDL_DestroyCond(pool.idle);
+    pool.idle = NULL;
+  }
+  if (NULL != pool.wakeup) {
+    SDL_DestroyCond(pool.wakeup);
+    pool.wakeup = NULL;
+  }
+  if (NULL != pool.mutex) {
+    SDL_DestroyMutex(pool.mutex);
+    pool.mutex = NULL;
+  }
+}
@@ -0,0 +1,29 @@
+#ifndef MRUBY_SDL2_WORKPOOL_H
+#define MRUBY_SDL2_WORKPOOL_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * processes rows [first, last) of a job.
+ * runs on internal SDL threads, so it must not touch the mruby VM.
+ */
+typedef void (*mrb_sdl2_workpool_func)(void *arg, int first, int last);
+
+/* 'count' includes the calling thread; 1 or less disables the pool. */
+extern bool mrb_sdl2_workpool_set_threads(int count);
+extern int  mrb_sdl2_workpool_threads(void);
+
+/* splits 'rows' into bands and returns when all of them are processed. */
+extern void mrb_sdl2_workpool_run(mrb_sdl2_workpool_func func, void *arg, int rows);
+
+extern void mrb_sdl2_workpool_final(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end of MRUBY_SDL2_WORKPOOL_H */
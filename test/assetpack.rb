@@ -0,0 +1,98 @@
+##
+# SDL2::AssetPack test
+
+# an empty directory under the system temporary directory.
+def assetpack_test_dir
+  dir = "#{ENV['TMPDIR'] || '/tmp'}/mruby-sdl2-assetpack"
+  assetpack_test_remove(dir) if Dir.exist?(dir)
+  Dir.mkdir(dir)
+  dir
+end
+
+def assetpack_test_remove(dir)
+  Dir.entries(dir).each do |e|
+    next if e == '.' || e == '..'
+    path = "#{dir}/#{e}"
+    Dir.exist?(path) ? assetpack_test_remove(path) : File.delete(path)
+  end
+  Dir.delete(dir)
+end
+
+def assetpack_test_write(path, bytes)
+  rw = SDL2::RWops.from_file(path, 'wb')
+  rw.write(bytes)
+  rw.close
+end
+
+def assetpack_test_read(path)
+  rw = SDL2::RWops.from_file(path, 'rb')
+  bytes = rw.read
+  rw.close
+  bytes
+end
+
+# packs a.txt, .hidden, sub/b.bin and sub/img.bmp; returns the pack path.
+def assetpack_test_pack(root)
+  assets = "#{root}/assets"
+  Dir.mkdir(assets)
+  Dir.mkdir("#{assets}/sub")
+  assetpack_test_write("#{assets}/a.txt", 'hello')
+  assetpack_test_write("#{assets}/.hidden", 'skipped')
+  assetpack_test_write("#{assets}/sub/b.bin", "\x00\x01\x02")
+  surface = SDL2::Video::Surface.new(0, 3, 2, 32, 0xff0000, 0xff00, 0xff, 0)
+  surface.fill_rect(0x336699)
+  SDL2::Video::Surface.save_bmp(surface, "#{assets}/sub/img.bmp")
+  pack = "#{root}/assets.pack"
+  entries = SDL2::AssetPack.build_from_directory(pack, assets)
+  raise 'unexpected entries' unless entries.keys.sort == ['a.txt', 'sub/b.bin', 'sub/img.bmp']
+  pack
+end
+
+def assetpack_test_rejects(path, bytes)
+  assetpack_test_write(path, bytes)
+  SDL2::AssetPack.new(path)
+  false
+rescue SDL2::SDL2Error
+  true
+end
+
+SDL2::init
+begin
+  assert('SDL2::AssetPack.build_from_directory') do
+    root = assetpack_test_dir
+    begin
+      assets = SDL2::AssetPack.new(assetpack_test_pack(root))
+      missing = begin
+        assets.read('missing')
+        false
+      rescue ArgumentError
+        true
+      end
+      color = assets.load_bmp('sub/img.bmp').pixels { |v| c = v.rgba(2, 1); [c.r, c.g, c.b] }
+      assets.size == 3 && assets.names.sort == ['a.txt', 'sub/b.bin', 'sub/img.bmp'] &&
+        assets.include?('sub/b.bin') && !assets.include?('.hidden') && !assets.include?('b.bin') &&
+        assets.read('a.txt') == 'hello' && assets.read('sub/b.bin') == "\x00\x01\x02" &&
+        assets.bytesize('sub/b.bin') == 3 && missing && color == [0x33, 0x66, 0x99]
+    ensure
+      assetpack_test_remove(root)
+    end
+  end
+  assert('SDL2::AssetPack.new truncated or corrupt') do
+    root = assetpack_test_dir
+    begin
+      bytes = assetpack_test_read(assetpack_test_pack(root))
+      broken = "#{root}/broken.pack"
+      [
+        bytes[0, 40],                                   # shorter than the header
+        bytes[0, 60],                                   # into the entry table
+        bytes[0, bytes.size - 1],                       # into the last entry
+        'XSAP' + bytes[4, bytes.size - 4],              # magic
+        bytes[0, 12] + "\x03\x00\x00\x00" + bytes[16, bytes.size - 16], # bucket count
+      ].all? { |b| assetpack_test_rejects(broken, b) }
+    ensure
+      assetpack_test_remove(root)
+    end
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,60 @@
+##
+# SDL2::Audio test
+
+# an 8kHz mono 16bit WAV file of 'frames' samples, as a ByteBuffer.
+def audio_test_wav(frames)
+  le16 = lambda { |v| [v & 0xff, (v >> 8) & 0xff] }
+  le32 = lambda { |v| le16.call(v & 0xffff) + le16.call((v >> 16) & 0xffff) }
+  fmt = le16.call(1) + le16.call(1) + le32.call(8000) + le32.call(16000) + le16.call(2) + le16.call(16)
+  data = Array.new(frames * 2, 0)
+  SDL2::ByteBuffer.new('RIFF'.bytes + le32.call(36 + data.size) + 'WAVE'.bytes +
+                       'fmt '.bytes + le32.call(16) + fmt + 'data'.bytes + le32.call(data.size) + data)
+end
+
+SDL2::init
+begin
+  # the dummy driver consumes audio in real time without an output device.
+  SDL2::Audio.init('dummy')
+
+  assert('SDL2::Audio::AudioDevice.stats') do
+    spec = SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_S16SYS, 2, 512)
+    device = SDL2::Audio::AudioDevice.new(nil, false, spec, 0)
+    begin
+      device.pause(false)
+      SDL2::delay(200)
+      device.pause(true)
+      stats = device.stats
+      counters = [stats[:callbacks], stats[:overruns], stats[:silence_fills]] + stats[:histogram]
+      ok = counters.all? { |n| n.kind_of?(Integer) } &&
+           stats[:callbacks] > 0 && stats[:silence_fills] == stats[:callbacks] &&
+           stats[:budget] > 0.0 && stats[:max_time] >= stats[:mean_time] &&
+           stats[:histogram].size == 16 && stats[:histogram].inject(0) { |sum, n| sum + n } == stats[:callbacks]
+      device.reset_stats
+      ok && device.stats[:callbacks] == 0
+    ensure
+      device.close
+    end
+  end
+  assert('SDL2::Audio.open_device without obtained spec') do
+    spec = SDL2::Audio::AudioSpec.new(44100, SDL2::Audio::AUDIO_F32SYS, 1, 1024)
+    device = SDL2::Audio.open_device('System audio output device', false, spec, nil)
+    begin
+      device.spec.freq == 44100 && device.stats[:callbacks] == 0
+    ensure
+      device.close
+    end
+  end
+  assert('SDL2::Audio::AudioData failed reload') do
+    d = SDL2::Audio::AudioData.from_rw(SDL2::RWops.from_buffer(audio_test_wav(100)))
+    begin
+      d.send(:initialize, '/nonexistent/mruby-sdl2.wav')
+      false
+    rescue SDL2::SDL2Error
+      # the clip loaded before is kept.
+      d.length == 200 && d.spec.freq == 8000
+    end
+  end
+ensure
+  SDL2::Audio.quit
+  SDL2::quit
+end
@@ -0,0 +1,88 @@
+##
+# SDL2::Audio::Stream test
+
+# a mono 16bit WAV file whose n-th sample is n.
+def audiostream_test_wav(frames, freq = 8000)
+  le16 = lambda { |v| [v & 0xff, (v >> 8) & 0xff] }
+  le32 = lambda { |v| le16.call(v & 0xffff) + le16.call((v >> 16) & 0xffff) }
+  data = []
+  frames.times { |i| data.concat(le16.call(i)) }
+  fmt = le16.call(1) + le16.call(1) + le32.call(freq) + le32.call(freq * 2) + le16.call(2) + le16.call(16)
+  bytes = 'RIFF'.bytes + le32.call(4 + 8 + fmt.size + 8 + data.size) + 'WAVE'.bytes +
+          'fmt '.bytes + le32.call(fmt.size) + fmt +
+          'data'.bytes + le32.call(data.size) + data
+  SDL2::ByteBuffer.new(bytes)
+end
+
+SDL2::init
+begin
+  assert('SDL2::Audio::Stream missing file') do
+    begin
+      SDL2::Audio::Stream.new('/nonexistent/mruby-sdl2.wav')
+      false
+    rescue SDL2::SDL2Error
+      true
+    end
+  end
+  assert('SDL2::Audio::Stream buffer size') do
+    begin
+      SDL2::Audio::Stream.new('/nonexistent/mruby-sdl2.wav', 16)
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+  assert('SDL2::Audio::Stream.from_memory') do
+    s = SDL2::Audio::Stream.from_memory(audiostream_test_wav(1000), 4096)
+    s.length == 2000 && s.spec.freq == 8000 && s.spec.channels == 1 && s.position == 0
+  end
+  assert('SDL2::Audio::Stream.read') do
+    s = SDL2::Audio::Stream.from_memory(audiostream_test_wav(1000), 4096)
+    buf = SDL2::Int16Buffer.new(1000)
+    n = s.read(buf, 1200)
+    ok = n == 1200 && buf[0] == 0 && buf[599] == 599 && s.position == 1200
+    n = s.read(buf, 2000)
+    ok && n == 800 && buf[0] == 600 && buf[399] == 999 && s.eof?
+  end
+  assert('SDL2::Audio::Stream.seek') do
+    s = SDL2::Audio::Stream.from_memory(audiostream_test_wav(1000), 4096)
+    buf = SDL2::Int16Buffer.new(4)
+    s.read(buf, 8)
+    s.seek(1001)
+    ok = s.position == 1000 && s.read(buf, 8) == 8 && buf[0] == 500 && buf[3] == 503
+    s.rewind
+    ok && s.read(buf, 2) == 2 && buf[0] == 0
+  end
+  assert('SDL2::Audio::Stream.loop') do
+    s = SDL2::Audio::Stream.from_memory(audiostream_test_wav(100), 4096)
+    s.loop = true
+    buf = SDL2::Int16Buffer.new(150)
+    s.read(buf, 300) == 300 && !s.eof? && buf[99] == 99 && buf[100] == 0 && buf[149] == 49
+  end
+  assert('SDL2::Audio::Stream.initialize twice') do
+    s = SDL2::Audio::Stream.from_memory(audiostream_test_wav(100), 4096)
+    begin
+      s.send(:initialize, '/nonexistent/mruby-sdl2.wav')
+      false
+    rescue RuntimeError
+      s.length == 200
+    end
+  end
+  assert('SDL2::Audio::AudioSpec.stream=') do
+    s = SDL2::Audio::Stream.from_memory(audiostream_test_wav(100), 4096)
+    spec = SDL2::Audio::AudioSpec.new(8000, SDL2::Audio::AUDIO_S16SYS, 1, 1024)
+    spec.stream = s
+    ok = spec.stream.equal?(s)
+    spec.stream = nil
+    [[44100, 1], [8000, 2]].all? do |freq, channels|
+      begin
+        SDL2::Audio::AudioSpec.new(freq, SDL2::Audio::AUDIO_S16SYS, channels, 1024).stream = s
+        false
+      rescue ArgumentError
+        true
+      end
+    end && ok && spec.stream.nil?
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,218 @@
+##
+# SDL2::Buffer test
+
+SDL2::init
+begin
+  assert('SDL2::Int16Buffer.initialize') do
+    b = SDL2::Int16Buffer.new([1, -2, 3])
+    b.size == 3 && b.element_size == 2 && b[0] == 1 && b[1] == -2 && b[2] == 3
+  end
+  assert('SDL2::UInt16Buffer.[]=') do
+    b = SDL2::UInt16Buffer.new(2)
+    b[0] = 65535
+    b[1] = 65536
+    b[0] == 65535 && b[1] == 0
+  end
+  assert('SDL2::DoubleBuffer.initialize') do
+    b = SDL2::DoubleBuffer.new([0.5, 1.25])
+    b.element_size == 8 && b[0] == 0.5 && b[1] == 1.25
+  end
+  assert('SDL2::Buffer.slice') do
+    b = SDL2::Int32Buffer.new([1, 2, 3, 4, 5])
+    s = b.slice(1, 3)
+    s[0] = 20
+    s.size == 3 && s[2] == 4 && b[1] == 20
+  end
+  assert('SDL2::Buffer.slice out of range') do
+    b = SDL2::Int32Buffer.new(4)
+    begin
+      b.slice(2, 3)
+      false
+    rescue IndexError
+      true
+    end
+  end
+  assert('SDL2::Buffer.slice reinitialize') do
+    b = SDL2::Int32Buffer.new([1, 2, 3, 4])
+    s = b.slice(1, 2)
+    begin
+      b.send(:initialize, 1)
+      false
+    rescue RuntimeError
+      b.size == 4 && s[1] == 3
+    end
+  end
+  assert('SDL2::Buffer.copy_from') do
+    src = SDL2::FloatBuffer.new([1.0, 2.0, 3.0, 4.0])
+    dst = SDL2::FloatBuffer.new(4)
+    dst.copy_from(src, 1, 0, 2)
+    dst[0] == 2.0 && dst[1] == 3.0 && dst[2] == 0.0
+  end
+  assert('SDL2::Buffer.copy_from with conversion') do
+    src = SDL2::FloatBuffer.new([1.5, -2.5])
+    dst = SDL2::Int16Buffer.new(2)
+    dst.copy_from(src)
+    dst[0] == 1 && dst[1] == -2
+  end
+  assert('SDL2::Buffer.fill') do
+    b = SDL2::UInt32Buffer.new(5)
+    b.fill(7, 1, 3)
+    b[0] == 0 && b[1] == 7 && b[3] == 7 && b[4] == 0
+  end
+  assert('SDL2::Buffer.to_s') do
+    b = SDL2::ByteBuffer.new([65, 66, 67])
+    b.to_s == "ABC"
+  end
+  assert('SDL2::Buffer.from_string') do
+    b = SDL2::UInt16Buffer.from_string("\x01\x00\x02\x00")
+    b.class == SDL2::UInt16Buffer && b.size == 2 && b[0] == 1 && b[1] == 2
+  end
+  assert('SDL2::FloatBuffer.scale/add/mul') do
+    b = SDL2::FloatBuffer.new([1.0, 2.0, 3.0, 4.0, 5.0])
+    o = SDL2::FloatBuffer.new([1.0, 1.0, 1.0, 1.0, 2.0])
+    b.scale(2.0).add(1).mul(o)
+    b[0] == 3.0 && b[3] == 9.0 && b[4] == 22.0
+  end
+  assert('SDL2::FloatBuffer.add size mismatch') do
+    begin
+      SDL2::FloatBuffer.new(3).add(SDL2::FloatBuffer.new(4))
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+  assert('SDL2::FloatBuffer.madd/clamp') do
+    b = SDL2::FloatBuffer.new([0.0, 0.5, 1.0])
+    s = SDL2::FloatBuffer.new([1.0, 1.0, 1.0])
+    b.madd(s, 0.5).clamp(0.0, 1.0)
+    b[0] == 0.5 && b[1] == 1.0 && b[2] == 1.0
+  end
+  assert('SDL2::FloatBuffer.min/max/sum') do
+    b = SDL2::FloatBuffer.new([3.0, -1.0, 7.0, 2.0, 0.5])
+    b.min == -1.0 && b.max == 7.0 && b.sum == 11.5
+  end
+  assert('SDL2::FloatBuffer.transform2d') do
+    b = SDL2::FloatBuffer.new([1.0, 2.0, 0.0, 3.0, 4.0, 0.0])
+    b.transform2d([0.0, -1.0, 10.0, 1.0, 0.0, 20.0], 3)
+    b[0] == 8.0 && b[1] == 21.0 && b[2] == 0.0 && b[3] == 6.0 && b[4] == 23.0
+  end
+  assert('SDL2::FloatBuffer.transform3d') do
+    b = SDL2::FloatBuffer.new([1.0, 2.0, 3.0])
+    b.transform3d([2, 0, 0, 1, 0, 2, 0, 1, 0, 0, 2, 1])
+    b[0] == 3.0 && b[1] == 5.0 && b[2] == 7.0
+  end
+  assert('SDL2::FloatBuffer.simd_backend') do
+    SDL2::FloatBuffer.simd_backend.is_a?(String)
+  end
+  assert('SDL2::Buffer.from_array') do
+    b = SDL2::Buffer.from_array([1, 2.5, -3], SDL2::Buffer::FLOAT)
+    b.class == SDL2::FloatBuffer && b.size == 3 && b[1] == 2.5 && b[2] == -3.0
+  end
+  assert('SDL2::Buffer.from_array receiver type') do
+    b = SDL2::Int16Buffer.from_array([1, -2])
+    b.class == SDL2::Int16Buffer && b[1] == -2
+  end
+  assert('SDL2::Buffer.from_array rejects strings') do
+    begin
+      SDL2::ByteBuffer.from_array(["1"])
+      false
+    rescue TypeError
+      true
+    end
+  end
+  assert('SDL2::Buffer.new zero') do
+    a = SDL2::Int32Buffer.new(4, false)
+    b = SDL2::FloatBuffer.new(4)
+    a.size == 4 && b[3] == 0.0
+  end
+  assert('SDL2::Buffer.new from Array') do
+    b = SDL2::Buffer.new([1, 2, 3])
+    b.size == 12
+  end
+  assert('SDL2::Buffer.new aligned') do
+    b = SDL2::FloatBuffer.new(16, true, 64)
+    b.size == 16 && b[15] == 0.0
+  end
+  assert('SDL2::Buffer.new bad alignment') do
+    begin
+      SDL2::Buffer.new(16, true, 24)
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+  assert('SDL2::Buffer.new lock') do
+    b = SDL2::Int16Buffer.new(256, true, 0, true)
+    b[255] = -7
+    locked = b.locked?
+    ok = (TrueClass === locked || FalseClass === locked) && b[255] == -7 && b[0] == 0
+    # storage without the lock flag, including a re-initialized locked buffer, is never pinned.
+    b.send(:initialize, 16)
+    ok && !b.locked? && !SDL2::Int16Buffer.new(256).locked?
+  end
+  assert('SDL2::Buffer.new negative size') do
+    [SDL2::Buffer, SDL2::FloatBuffer, SDL2::ByteBuffer].all? do |klass|
+      begin
+        klass.new(-1, true, 64)
+        false
+      rescue ArgumentError
+        true
+      end
+    end
+  end
+  assert('SDL2::Buffer.new non-finite size') do
+    [0.0 / 0.0, 1.0 / 0.0, -1.5, 1.0e30].all? do |size|
+      begin
+        SDL2::Int16Buffer.new(size)
+        false
+      rescue ArgumentError
+        true
+      end
+    end
+  end
+  assert('SDL2::Buffer.allocations') do
+    n = SDL2::DoubleBuffer.allocations
+    bytes = SDL2::DoubleBuffer.allocated_bytes
+    b = SDL2::DoubleBuffer.new(4)
+    SDL2::DoubleBuffer.allocations == n + 1 && SDL2::DoubleBuffer.allocated_bytes == bytes + 32
+  end
+  assert('SDL2::Buffer.map missing file') do
+    begin
+      SDL2::FloatBuffer.map('/nonexistent/mruby-sdl2.bin')
+      false
+    rescue SDL2::SDL2Error
+      true
+    end
+  end
+  assert('SDL2::Buffer.map bad mode') do
+    begin
+      SDL2::Buffer.map('/nonexistent/mruby-sdl2.bin', 0, nil, 7)
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+  assert('SDL2::Buffer.map') do
+    path = "#{ENV['TMPDIR'] || '/tmp'}/mruby-sdl2-buffer-map.bin"
+    begin
+      rw = SDL2::RWops.from_file(path, 'wb')
+      rw.write(SDL2::Int32Buffer.new([1, 2, 3, 4, 5, 6]).to_s)
+      rw.close
+      all = SDL2::Int32Buffer.map(path)
+      part = SDL2::Int32Buffer.map(path, 8, 12)
+      all.size == 6 && all[0] == 1 && all[5] == 6 && part.size == 3 && part[0] == 3 && part[2] == 5
+    ensure
+      File.delete(path) if File.exist?(path)
+    end
+  end
+  assert('SDL2::Buffer.map unaligned offset') do
+    begin
+      SDL2::Int32Buffer.map('/nonexistent/mruby-sdl2.bin', 2)
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,86 @@
+##
+# SDL2::Audio::ClipCache test
+
+# a PCM WAV file of the given format holding the 'data' bytes.
+def clipcache_test_riff(channels, freq, bits, data)
+  le16 = lambda { |v| [v & 0xff, (v >> 8) & 0xff] }
+  le32 = lambda { |v| le16.call(v & 0xffff) + le16.call((v >> 16) & 0xffff) }
+  align = channels * bits / 8
+  fmt = le16.call(1) + le16.call(channels) + le32.call(freq) + le32.call(freq * align) + le16.call(align) + le16.call(bits)
+  bytes = 'RIFF'.bytes + le32.call(4 + 8 + fmt.size + 8 + data.size) + 'WAVE'.bytes +
+          'fmt '.bytes + le32.call(fmt.size) + fmt +
+          'data'.bytes + le32.call(data.size) + data
+  SDL2::Audio::AudioData.from_rw(SDL2::RWops.from_buffer(SDL2::ByteBuffer.new(bytes)))
+end
+
+# a mono 16bit WAV file whose n-th sample is n.
+def clipcache_test_wav(frames, freq = 8000)
+  data = []
+  frames.times { |i| data.push(i & 0xff, (i >> 8) & 0xff) }
+  clipcache_test_riff(1, freq, 16, data)
+end
+
+SDL2::init
+begin
+  assert('SDL2::Audio::ClipCache.initialize') do
+    spec = SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_S16SYS, 2, 1024)
+    c = SDL2::Audio::ClipCache.new(spec)
+    c.count == 0 && c.bytes == 0 && c.spec.freq == 48000 && c.spec.channels == 2
+  end
+  assert('SDL2::Audio::ClipCache.reserve') do
+    c = SDL2::Audio::ClipCache.new(SDL2::Audio::AudioSpec.new(44100, SDL2::Audio::AUDIO_S16SYS, 2, 1024))
+    c.reserve(100000)
+    c.capacity >= 100000 && c.used == 0 && c.memory >= c.capacity
+  end
+  assert('SDL2::Audio::ClipCache.load missing file') do
+    c = SDL2::Audio::ClipCache.new(SDL2::Audio::AudioSpec.new)
+    begin
+      c.load('/nonexistent/mruby-sdl2.wav')
+      false
+    rescue SDL2::SDL2Error
+      true
+    end
+  end
+  assert('SDL2::Audio::ClipCache invalid handle') do
+    c = SDL2::Audio::ClipCache.new(SDL2::Audio::AudioSpec.new)
+    buf = SDL2::Buffer.new(16)
+    !c.loaded?(1) && c.mix(buf, 0, 1, 0, 16) == 0 && !c.unload(1)
+  end
+  assert('SDL2::Audio::ClipCache load/mix/read/unload/compact') do
+    c = SDL2::Audio::ClipCache.new(SDL2::Audio::AudioSpec.new(8000, SDL2::Audio::AUDIO_S16SYS, 1, 1024))
+    a = c.load(clipcache_test_wav(100))
+    b = c.load(clipcache_test_wav(50))
+    buf = SDL2::Int16Buffer.new(50)
+    ok = c.count == 2 && c.bytes == 300 && c.length(b) == 100
+    ok &&= c.mix(buf, 0, b, 0, 100) == 100 && buf[0] == 0 && buf[49] == 49
+    ok &&= c.read(buf, 0, a, 20, 100) == 100 && buf[0] == 10 && buf[49] == 59
+    used = c.used
+    ok &&= c.unload(a) && !c.loaded?(a) && c.count == 1 && c.bytes == 100
+    c.compact
+    # the second clip moved to the start of the arena and keeps its handle and data.
+    ok && c.used < used && c.loaded?(b) && c.read(buf, 0, b, 0, 100) == 100 && buf[0] == 0 && buf[49] == 49
+  end
+  assert('SDL2::Audio::ClipCache.load U8 stereo 22050Hz') do
+    c = SDL2::Audio::ClipCache.new(SDL2::Audio::AudioSpec.new(44100, SDL2::Audio::AUDIO_S16SYS, 2, 1024))
+    # a constant +0.5 left and -0.5 right.
+    h = c.load(clipcache_test_riff(2, 22050, 8, [192, 64] * 200))
+    frames = c.length(h) / 4  # 16bit stereo
+    buf = SDL2::Int16Buffer.new(200)
+    # away from the edges, where the resampler filter settles.
+    read = c.read(buf, 0, h, 150 * 4, 400)
+    samples = (0...100).all? { |i| (buf[i * 2] - 16384).abs <= 200 && (buf[i * 2 + 1] + 16384).abs <= 200 }
+    frames == 400 && read == 400 && samples &&
+      [c.bytes, c.used, c.capacity, c.memory].all? { |n| n.is_a?(Integer) }
+  end
+  assert('SDL2::Audio::ClipCache.load destroyed AudioData') do
+    c = SDL2::Audio::ClipCache.new(SDL2::Audio::AudioSpec.new(8000, SDL2::Audio::AUDIO_S16SYS, 1, 1024))
+    begin
+      c.load(clipcache_test_wav(10).destroy)
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,104 @@
+##
+# SDL2::Audio::EffectChain test
+
+def effectchain_test_chain(channels = 1)
+  SDL2::Audio::EffectChain.new(SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_F32SYS, channels, 1024))
+end
+
+SDL2::init
+begin
+  assert('SDL2::Audio::EffectChain.initialize') do
+    effectchain_test_chain(2).size == 0
+  end
+  assert('SDL2::Audio::EffectChain.initialize unsupported format') do
+    begin
+      SDL2::Audio::EffectChain.new(SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_U8, 2, 1024))
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+  assert('SDL2::Audio::EffectChain.set') do
+    c = effectchain_test_chain
+    i = c.add_lowpass(1000.0)
+    c.set(i, SDL2::Audio::EffectChain::FREQUENCY, 2000.0)
+    ok = c.get(i, SDL2::Audio::EffectChain::FREQUENCY) == 2000.0
+    begin
+      c.set(i, SDL2::Audio::EffectChain::FEEDBACK, 0.5)
+      false
+    rescue ArgumentError
+      ok
+    end
+  end
+  assert('SDL2::Audio::EffectChain.process gain') do
+    c = effectchain_test_chain
+    c.add_gain(0.5)
+    i = c.add_highpass(100.0)
+    c.bypass(i, true)
+    buf = SDL2::FloatBuffer.new(Array.new(1000, 0.5))
+    c.process(buf)
+    c.size == 2 && c.bypass?(i) && (buf[999] - 0.25).abs < 0.0001
+  end
+  assert('SDL2::Audio::EffectChain.process lowpass/highpass') do
+    # a biquad passes DC through a low-pass with unity gain and blocks it in a high-pass.
+    lp = effectchain_test_chain
+    lp.add_lowpass(1000.0)
+    hp = effectchain_test_chain
+    hp.add_highpass(1000.0)
+    a = SDL2::FloatBuffer.new(Array.new(4800, 0.5))
+    b = SDL2::FloatBuffer.new(Array.new(4800, 0.5))
+    lp.process(a)
+    hp.process(b)
+    (a[4799] - 0.5).abs < 0.001 && b[4799].abs < 0.001 && (b[0] - 0.5).abs < 0.25
+  end
+  assert('SDL2::Audio::EffectChain.process delay') do
+    c = effectchain_test_chain
+    c.add_delay(0.001, 0.5, 1.0)
+    buf = SDL2::FloatBuffer.new(Array.new(200, 0.0))
+    buf[0] = 1.0
+    c.process(buf)
+    # fully wet: the impulse comes back after 48 frames, then at half level after 96.
+    buf[0] == 0.0 && buf[47] == 0.0 && (buf[48] - 1.0).abs < 0.0001 && (buf[96] - 0.5).abs < 0.0001
+  end
+  assert('SDL2::Audio::EffectChain.process compressor') do
+    c = effectchain_test_chain
+    c.add_compressor(-20.0, 4.0, 0.001, 0.1, 0.0)
+    buf = SDL2::FloatBuffer.new(Array.new(48000, 0.5))
+    c.process(buf)
+    # -6.02 dBFS is 13.98 dB over the threshold; 4:1 leaves 3.49 dB, i.e. -16.51 dBFS.
+    (buf[47999] - 0.1496).abs < 0.001
+  end
+  assert('SDL2::Audio::EffectChain.clear') do
+    c = SDL2::Audio::EffectChain.new(SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_S16SYS, 2, 1024))
+    c.add_delay(0.1, 0.5, 0.5)
+    c.add_compressor
+    c.clear.size == 0
+  end
+  assert('SDL2::Audio::AudioSpec.effects=') do
+    spec = SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_F32SYS, 2, 1024)
+    c = effectchain_test_chain(2)
+    spec.effects = c
+    ok = spec.effects.equal?(c)
+    spec.effects = nil
+    other_rate = SDL2::Audio::EffectChain.new(SDL2::Audio::AudioSpec.new(44100, SDL2::Audio::AUDIO_F32SYS, 2, 1024))
+    [effectchain_test_chain(1), other_rate].all? do |chain|
+      begin
+        spec.effects = chain
+        false
+      rescue ArgumentError
+        true
+      end
+    end && ok && spec.effects.nil?
+  end
+  assert('SDL2::Audio::EffectChain.initialize twice') do
+    c = effectchain_test_chain(2)
+    begin
+      c.send(:initialize, SDL2::Audio::AudioSpec.new(48000, SDL2::Audio::AUDIO_F32SYS, 1, 1024))
+      false
+    rescue RuntimeError
+      c.size == 0
+    end
+  end
+ensure
+  SDL2::quit
+end
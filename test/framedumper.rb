@@ -0,0 +1,89 @@
+##
+# SDL2::Video::FrameDumper test
+
+# an empty directory under the system temporary directory.
+def framedumper_test_dir
+  dir = "#{ENV['TMPDIR'] || '/tmp'}/mruby-sdl2-framedumper"
+  framedumper_test_remove(dir) if Dir.exist?(dir)
+  Dir.mkdir(dir)
+  dir
+end
+
+def framedumper_test_remove(dir)
+  Dir.entries(dir).each { |e| File.delete("#{dir}/#{e}") unless e == '.' || e == '..' }
+  Dir.delete(dir)
+end
+
+def framedumper_test_surface(color)
+  s = SDL2::Video::Surface.new(0, 4, 3, 32, 0xff0000, 0xff00, 0xff, 0)
+  s.fill_rect(color)
+  s
+end
+
+SDL2::init
+begin
+  assert('SDL2::Video::FrameDumper.capture BMP') do
+    dir = framedumper_test_dir
+    begin
+      klass = SDL2::Video::FrameDumper
+      dumper = klass.new("#{dir}/frame_%d.bmp", klass::FORMAT_BMP, 2, klass::POLICY_BLOCK)
+      colors = [0xff0000, 0x00ff00, 0x0000ff, 0x123456]
+      captured = colors.all? { |c| dumper.capture(framedumper_test_surface(c)) }
+      dumper.close
+      loaded = (0...colors.size).map do |i|
+        s = SDL2::Video::Surface.load_bmp("#{dir}/frame_#{i}.bmp")
+        s.pixels { |v| c = v.rgba(3, 2); (c.r << 16) | (c.g << 8) | c.b }
+      end
+      captured && dumper.closed? && dumper.written == 4 && dumper.dropped == 0 && dumper.pending == 0 && loaded == colors
+    ensure
+      framedumper_test_remove(dir)
+    end
+  end
+  assert('SDL2::Video::FrameDumper.capture drop policy') do
+    dir = framedumper_test_dir
+    begin
+      klass = SDL2::Video::FrameDumper
+      dumper = klass.new("#{dir}/frame_%d.bmp", klass::FORMAT_BMP, 1, klass::POLICY_DROP)
+      surface = framedumper_test_surface(0x808080)
+      queued = (0...32).count { dumper.capture(surface) }
+      dumper.close
+      dumper.written == queued && dumper.dropped == 32 - queued && dumper.failed == 0
+    ensure
+      framedumper_test_remove(dir)
+    end
+  end
+  assert('SDL2::Video::FrameDumper RAW header') do
+    dir = framedumper_test_dir
+    begin
+      klass = SDL2::Video::FrameDumper
+      path = "#{dir}/frames.raw"
+      dumper = klass.new(path, klass::FORMAT_RAW, 4, klass::POLICY_BLOCK)
+      dumper.capture(framedumper_test_surface(0x010203))
+      dumper.capture(framedumper_test_surface(0x040506))
+      dumper.close
+      bytes = SDL2::ByteBuffer.map(path)
+      words = SDL2::Int32Buffer.map(path)
+      magic = (0...4).map { |i| bytes[i] }
+      # 4x3 RGB888 frames of 16-byte rows follow a 6 word header each.
+      first, second = [2, 2 + 6 + 12].map { |i| (0...6).map { |j| words[i + j] } }
+      magic == 'MSFD'.bytes && words[1] == 1 && bytes.size == 8 + (24 + 48) * 2 &&
+        [first, second].map { |h| [h[0], h[2], h[3], h[4], h[5]] } == [[0, 4, 3, 16, 0x16161804], [1, 4, 3, 16, 0x16161804]] &&
+        (words[8] & 0xffffff) == 0x010203 && (words[26] & 0xffffff) == 0x040506
+    ensure
+      framedumper_test_remove(dir)
+    end
+  end
+  assert('SDL2::Video::FrameDumper.new malformed pattern') do
+    klass = SDL2::Video::FrameDumper
+    ['frame.bmp', 'frame_%s.bmp', 'frame_%d_%d.bmp', 'frame_%'].all? do |pattern|
+      begin
+        klass.new(pattern)
+        false
+      rescue ArgumentError
+        true
+      end
+    end
+  end
+ensure
+  SDL2::quit
+end
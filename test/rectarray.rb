@@ -0,0 +1,135 @@
+##
+# SDL2::RectArray / SDL2::PointArray test
+
+SDL2::init
+begin
+  assert('SDL2::RectArray.initialize') do
+    a = SDL2::RectArray.new
+    a.size == 0
+  end
+  assert('SDL2::RectArray.initialize(capacity)') do
+    a = SDL2::RectArray.new(100)
+    a.size == 0 && a.capacity >= 100
+  end
+  assert('SDL2::RectArray.push(rect)') do
+    a = SDL2::RectArray.new
+    a << SDL2::Rect.new(1, 2, 3, 4)
+    r = a[0]
+    a.size == 1 && r.x == 1 && r.y == 2 && r.w == 3 && r.h == 4
+  end
+  assert('SDL2::RectArray.push(x, y, w, h)') do
+    a = SDL2::RectArray.new
+    a.push(1, 2, 3, 4).push(5, 6, 7, 8)
+    r = a[-1]
+    a.size == 2 && r.x == 5 && r.y == 6 && r.w == 7 && r.h == 8
+  end
+  assert('SDL2::RectArray.get') do
+    a = SDL2::RectArray.new
+    a.push(1, 2, 3, 4)
+    r = SDL2::Rect.new
+    a.get(0, r).equal?(r) && r.x == 1 && r.y == 2 && r.w == 3 && r.h == 4
+  end
+  assert('SDL2::RectArray.set') do
+    a = SDL2::RectArray.new
+    a.push(0, 0, 0, 0)
+    a.set(0, 1, 2, 3, 4)
+    r = a[0]
+    r.x == 1 && r.y == 2 && r.w == 3 && r.h == 4
+  end
+  assert('SDL2::RectArray.[] out of range') do
+    a = SDL2::RectArray.new
+    begin
+      a[0]
+      false
+    rescue IndexError
+      true
+    end
+  end
+  assert('SDL2::RectArray.pop') do
+    a = SDL2::RectArray.new
+    a.push(1, 2, 3, 4)
+    r = a.pop
+    a.size == 0 && r.x == 1 && a.pop.nil?
+  end
+  assert('SDL2::RectArray.translate') do
+    a = SDL2::RectArray.new
+    a.push(1, 2, 3, 4).translate(10, 20)
+    r = a[0]
+    r.x == 11 && r.y == 22 && r.w == 3 && r.h == 4
+  end
+  assert('SDL2::RectArray.scale') do
+    a = SDL2::RectArray.new
+    a.push(1, 2, 3, 4).scale(2.0, 0.5)
+    r = a[0]
+    r.x == 2 && r.y == 1 && r.w == 6 && r.h == 2
+  end
+  assert('SDL2::RectArray.clear') do
+    a = SDL2::RectArray.new
+    a.push(1, 2, 3, 4).clear
+    a.size == 0
+  end
+  assert('SDL2::RectArray.clip') do
+    a = SDL2::RectArray.new
+    a.push(0, 0, 10, 10).push(5, 5, 10, 10).push(50, 50, 5, 5)
+    c = a.clip(SDL2::Rect.new(0, 0, 8, 8))
+    r0 = c[0]
+    r1 = c[1]
+    r2 = c[2]
+    c.size == 3 && a[0].w == 10 &&
+      r0.x == 0 && r0.y == 0 && r0.w == 8 && r0.h == 8 &&
+      r1.x == 5 && r1.y == 5 && r1.w == 3 && r1.h == 3 &&
+      r2.w == 0 && r2.h == 0
+  end
+  assert('SDL2::RectArray.clip!') do
+    a = SDL2::RectArray.new
+    a.push(-5, -5, 10, 10).clip!(SDL2::Rect.new(0, 0, 100, 100))
+    r = a[0]
+    r.x == 0 && r.y == 0 && r.w == 5 && r.h == 5
+  end
+  assert('SDL2::RectArray.intersecting') do
+    a = SDL2::RectArray.new
+    10.times { |i| a.push(i * 10, 0, 10, 10) }
+    a.intersecting(SDL2::Rect.new(15, 5, 20, 1)) == [1, 2, 3]
+  end
+  assert('SDL2::RectArray.bounds') do
+    a = SDL2::RectArray.new
+    b0 = a.bounds
+    a.push(10, 10, 5, 5).push(-10, 0, 5, 0).push(0, -5, 3, 3)
+    b = a.bounds
+    b0.nil? && b.x == 0 && b.y == -5 && b.w == 15 && b.h == 20
+  end
+  assert('SDL2::RectArray.hit_test') do
+    a = SDL2::RectArray.new
+    a.push(0, 0, 100, 100).push(10, 10, 10, 10)
+    p = SDL2::PointArray.new
+    p.push(15, 15).push(50, 50).push(200, 200)
+    a.hit_test(15, 15) == 1 && a.hit_test(-1, 0).nil? && a.hit_test(p) == [1, 0, nil]
+  end
+  assert('SDL2::PointArray.push') do
+    a = SDL2::PointArray.new
+    a << SDL2::Point.new(1, 2)
+    a.push(3, 4)
+    p = a[1]
+    a.size == 2 && p.x == 3 && p.y == 4
+  end
+  assert('SDL2::PointArray.translate') do
+    a = SDL2::PointArray.new
+    a.push(1, 2).translate(-1, 1)
+    p = a[0]
+    p.x == 0 && p.y == 3
+  end
+  assert('SDL2::PointArray.to_a') do
+    a = SDL2::PointArray.new
+    a.push(1, 2).push(3, 4)
+    l = a.to_a
+    l.size == 2 && l[0].x == 1 && l[1].y == 4
+  end
+  assert('SDL2::Rect.enclose_points(clip, point_array)') do
+    a = SDL2::PointArray.new
+    a.push(1, 2).push(5, 8)
+    r = SDL2::Rect.enclose_points(nil, a)
+    r.x == 1 && r.y == 2 && r.w == 5 && r.h == 7
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,104 @@
+##
+# SDL2::Video::Renderer test
+
+# a surface to render into; present flushes SDL's command queue into it.
+def render_test_surface(w, h)
+  SDL2::Video::Surface.new(0, w, h, 32, 0xff0000, 0xff00, 0xff, 0)
+end
+
+SDL2::init
+begin
+  assert('SDL2::Video::Renderer.copy_ex_many') do
+    target = render_test_surface(16, 16)
+    r = SDL2::Video::Renderer.new(target)
+    src = render_test_surface(4, 4)
+    src.fill_rect(0x00ff00)
+    t = SDL2::Video::Texture.new(r, src)
+    r.clear
+    # the whole texture to (2, 2, 4, 4), then to (10, 10, 2, 2).
+    records = SDL2::FloatBuffer.new([0.0, 0.0, 0.0, 0.0, 2.0, 2.0, 4.0, 4.0, 0.0, 0.0, 0.0, 0.0,
+                                     0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 2.0, 2.0, 0.0, 0.0, 0.0, 0.0])
+    r.copy_ex_many(t, records)
+    r.present
+    px = target.pixels { |v| [[0, 0], [2, 2], [5, 5], [6, 6], [11, 11], [12, 12]].map { |x, y| v[x, y] & 0xffffff } }
+    px == [0, 0x00ff00, 0x00ff00, 0, 0x00ff00, 0]
+  end
+  assert('SDL2::Video::Renderer.copy_ex_many count') do
+    target = render_test_surface(8, 8)
+    r = SDL2::Video::Renderer.new(target)
+    src = render_test_surface(2, 2)
+    src.fill_rect(0xff0000)
+    t = SDL2::Video::Texture.new(r, src)
+    r.clear
+    records = SDL2::FloatBuffer.new([0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 2.0, 2.0, 0.0, 0.0, 0.0, 0.0,
+                                     0.0, 0.0, 0.0, 0.0, 4.0, 4.0, 2.0, 2.0, 0.0, 0.0, 0.0, 0.0])
+    r.copy_ex_many(t, records, 1)
+    r.present
+    ok = target.pixels { |v| (v[1, 1] & 0xffffff) == 0xff0000 && (v[5, 5] & 0xffffff) == 0 }
+    begin
+      r.copy_ex_many(t, records, 3)
+      false
+    rescue IndexError
+      ok
+    end
+  end
+  assert('SDL2::Video::Renderer.copy_ex_many ByteBuffer') do
+    r = SDL2::Video::Renderer.new(render_test_surface(8, 8))
+    t = SDL2::Video::Texture.new(r, render_test_surface(2, 2))
+    begin
+      r.copy_ex_many(t, SDL2::ByteBuffer.new(48))
+      false
+    rescue TypeError
+      true
+    end
+  end
+  assert('SDL2::Video::Renderer culling') do
+    target = render_test_surface(32, 32)
+    r = SDL2::Video::Renderer.new(target)
+    t = SDL2::Video::Texture.new(r, render_test_surface(4, 4))
+    r.culling = true
+    counts = []
+    # visible, partly visible and off-screen rects and copies.
+    r.fill_rect(SDL2::Rect.new(0, 0, 4, 4))
+    r.copy(t, nil, SDL2::Rect.new(30, 30, 4, 4))
+    counts << r.culled_count
+    r.fill_rect(SDL2::Rect.new(40, 0, 4, 4))
+    r.draw_rect(SDL2::Rect.new(0, -8, 4, 4))
+    r.copy(t, nil, SDL2::Rect.new(-10, -10, 4, 4))
+    counts << r.culled_count
+    # rotated around a point left of it, the rect swings into the target.
+    center = SDL2::Point.new(-2, 1)
+    r.copy_ex(t, nil, SDL2::Rect.new(33, 10, 8, 2), 90.0, center, 0)
+    counts << r.culled_count
+    r.copy_ex(t, nil, SDL2::Rect.new(33, 10, 8, 2), 0.0, center, 0)
+    r.copy_ex(t, nil, SDL2::Rect.new(100, 100, 8, 2), 45.0, center, 0)
+    counts << r.culled_count
+    rects = SDL2::RectArray.new
+    rects.push(2, 20, 4, 4).push(-20, 20, 4, 4).push(32, 32, 4, 4).push(28, 2, 8, 4)
+    r.draw_color = SDL2::RGBA.new(0, 0, 255, 255)
+    r.fill_rects(rects)
+    counts << r.culled_count
+    r.present
+    px = target.pixels { |v| [[3, 21], [31, 3]].map { |x, y| v[x, y] & 0xffffff } }
+    counts == [0, 3, 3, 5, 7] && px == [0x0000ff, 0x0000ff]
+  end
+  assert('SDL2::Video::Renderer.cull_rect') do
+    r = SDL2::Video::Renderer.new(render_test_surface(32, 24))
+    r.culling = true
+    rects = [r.cull_rect]
+    r.view_port = SDL2::Rect.new(8, 4, 16, 12)
+    rects << r.cull_rect
+    # in render coordinates, (20, 0) is now right of the view port.
+    r.fill_rect(SDL2::Rect.new(20, 0, 4, 4))
+    culled = r.culled_count
+    r.clip_rect = SDL2::Rect.new(2, 3, 4, 20)
+    rects << r.cull_rect
+    r.clip_rect = nil
+    r.view_port = nil
+    rects << r.cull_rect
+    expected = [[0, 0, 32, 24], [0, 0, 16, 12], [2, 3, 4, 9], [0, 0, 32, 24]]
+    rects.map { |c| [c.x, c.y, c.w, c.h] } == expected && culled == 1
+  end
+ensure
+  SDL2::quit
+end
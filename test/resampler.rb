@@ -0,0 +1,53 @@
+##
+# SDL2::Audio::Resampler test
+
+SDL2::init
+begin
+  assert('SDL2::Audio::Resampler.initialize') do
+    r = SDL2::Audio::Resampler.new(2, 44100, 48000)
+    r.channels == 2 && r.in_rate == 44100 && r.out_rate == 48000 &&
+      r.quality == SDL2::Audio::Resampler::MEDIUM && r.exact?
+  end
+  assert('SDL2::Audio::Resampler.initialize invalid') do
+    begin
+      SDL2::Audio::Resampler.new(2, 44100, 48000, 9)
+      false
+    rescue ArgumentError
+      true
+    end
+  end
+  assert('SDL2::Audio::Resampler.initialize rate range') do
+    [0, -44100, 0x7fffffff].all? do |rate|
+      begin
+        SDL2::Audio::Resampler.new(2, rate, 48000)
+        false
+      rescue ArgumentError
+        true
+      end
+    end
+  end
+  assert('SDL2::Audio::Resampler.output_frames') do
+    r = SDL2::Audio::Resampler.new(1, 44100, 48000)
+    r.output_frames(4410).kind_of?(Integer) && r.output_frames(4410) >= 4800
+  end
+  assert('SDL2::Audio::Resampler.process') do
+    r = SDL2::Audio::Resampler.new(1, 44100, 48000, SDL2::Audio::Resampler::HIGH)
+    src = SDL2::FloatBuffer.new(Array.new(4410, 0.5))
+    dst = SDL2::FloatBuffer.new(r.output_frames(4410))
+    consumed, produced = r.process(src, dst)
+    produced += r.drain(dst, produced)
+    consumed == 4410 && produced == 4800 && (dst[2400] - 0.5).abs < 0.001
+  end
+  assert('SDL2::Audio::Resampler.process partial') do
+    r = SDL2::Audio::Resampler.new(2, 48000, 44100)
+    src = SDL2::FloatBuffer.new(2 * 1000)
+    dst = SDL2::FloatBuffer.new(2 * 100)
+    consumed, produced = r.process(src, dst)
+    produced == 100 && consumed < 1000
+  end
+  assert('SDL2::Audio::Resampler.simd_backend') do
+    ['scalar', 'sse2', 'neon'].include?(SDL2::Audio::Resampler.simd_backend)
+  end
+ensure
+  SDL2::quit
+end
@@ -0,0 +1,59 @@
+##
+# SDL2::SpatialIndex test
+
+SDL2::init
+begin
+  assert('SDL2::SpatialIndex.initialize') do
+    s = SDL2::SpatialIndex.new(32)
+    s.size == 0 && s.cell_size == 32
+  end
+  assert('SDL2::SpatialIndex.insert') do
+    s = SDL2::SpatialIndex.new
+    s.insert(1, SDL2::Rect.new(0, 0, 10, 10))
+    s.insert(2, 100, 100, 10, 10)
+    s.size == 2 && s.include?(1) && s.include?(2) && !s.include?(3)
+  end
+  assert('SDL2::SpatialIndex.query') do
+    s = SDL2::SpatialIndex.new(16)
+    s.insert(1, 0, 0, 10, 10)
+    s.insert(2, 5, 5, 40, 40)
+    s.insert(3, 100, 100, 10, 10)
+    s.query(SDL2::Rect.new(0, 0, 8, 8)).sort == [1, 2] &&
+      s.query(SDL2::Rect.new(90, 90, 50, 50)) == [3] &&
+      s.query(SDL2::Rect.new(-50, -50, 10, 10)) == []
+  end
+  assert('SDL2::SpatialIndex.query_point') do
+    s = SDL2::SpatialIndex.new(16)
+    s.insert(1, -20, -20, 30, 30)
+    s.insert(2, 0, 0, 10, 10)
+    s.query_point(5, 5).sort == [1, 2] && s.query_point(-15, -15) == [1] && s.query_point(10, 10) == []
+  end
+  assert('SDL2::SpatialIndex.move') do
+    s = SDL2::SpatialIndex.new(16)
+    s.insert(1, 0, 0, 10, 10)
+    s.move(1, 200, 200, 10, 10)
+    r = s.rect(1)
+    s.query_point(5, 5) == [] && s.query_point(205, 205) == [1] && r.x == 200 && r.y == 200
+  end
+  assert('SDL2::SpatialIndex.remove') do
+    s = SDL2::SpatialIndex.new
+    s.insert(1, 0, 0, 10, 10)
+    s.remove(1) && !s.remove(1) && s.size == 0 && s.query_point(5, 5) == []
+  end
+  assert('SDL2::SpatialIndex.pairs') do
+    s = SDL2::SpatialIndex.new(8)
+    s.insert(1, 0, 0, 20, 20)
+    s.insert(2, 10, 10, 20, 20)
+    s.insert(3, 25, 25, 20, 20)
+    s.insert(4, 100, 100, 5, 5)
+    s.pairs.map { |a, b| [a, b].sort }.sort == [[1, 2], [2, 3]]
+  end
+  assert('SDL2::SpatialIndex.clear') do
+    s = SDL2::SpatialIndex.new
+    s.insert(1, 0, 0, 10, 10)
+    s.clear
+    s.size == 0 && s.query_point(5, 5) == []
+  end
+ensure
+  SDL2::quit
+end
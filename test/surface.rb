@@ -0,0 +1,176 @@
+##
+# SDL2::Video::Surface test
+
+SURFACE_TEST_ARGB8888 = 0x16362004
+SURFACE_TEST_RGBA8888 = 0x16462004
+
+# an ARGB8888 surface with a mix of transparent, opaque and translucent pixels.
+def surface_test_argb(w, h)
+  s = SDL2::Video::Surface.new(0, w, h, 32, 0xff0000, 0xff00, 0xff, 0xff000000)
+  s.pixels do |v|
+    h.times do |y|
+      w.times do |x|
+        a = [0, 255, (x * 37 + y * 91) % 256][(x + y) % 3]
+        v.set_rgba(x, y, SDL2::RGBA.new(x * 29 + y, 255 - x * 13, y * 53 + 7, a))
+      end
+    end
+  end
+  s
+end
+
+def surface_test_rgba(s)
+  s.pixels { |v| (0...v.height).map { |y| (0...v.width).map { |x| c = v.rgba(x, y); [c.r, c.g, c.b, c.a] } } }
+end
+
+SDL2::init
+begin
+  assert('SDL2::Video::Surface.pixels') do
+    s = SDL2::Video::Surface.new(0, 8, 8, 32, 0xff0000, 0xff00, 0xff, 0)
+    view = nil
+    s.pixels do |v|
+      view = v
+      v[3, 4] = 0x123456
+    end
+    !view.valid? && s.pixels { |v| v[3, 4] & 0xffffff } == 0x123456
+  end
+  assert('SDL2::Video::Surface.pixels raising block') do
+    s = SDL2::Video::Surface.new(0, 8, 8, 32, 0xff0000, 0xff00, 0xff, 0)
+    d = SDL2::Video::Surface.new(0, 8, 8, 32, 0xff0000, 0xff00, 0xff, 0)
+    view = nil
+    raised = begin
+      s.pixels do |v|
+        view = v
+        raise 'pixels'
+      end
+      false
+    rescue RuntimeError
+      true
+    end
+    # SDL refuses to blit from a locked surface, so this also checks the unlock.
+    raised && !view.valid? && s.blit_surface(nil, d, SDL2::Rect.new(0, 0, 8, 8)) == s
+  end
+  assert('SDL2::Video::Surface.blit_scaled native matches SDL') do
+    klass = SDL2::Video::Surface
+    src = klass.new(0, 7, 5, 32, 0xff0000, 0xff00, 0xff, 0)
+    src.pixels { |v| 5.times { |y| 7.times { |x| v[x, y] = y * 16 + x } } }
+    threads, threshold = klass.parallel_threads, klass.parallel_threshold
+    begin
+      klass.parallel_threads = 2
+      [[17, 11], [3, 2], [7, 13]].all? do |w, h|
+        results = [0, 1 << 30].map do |limit|
+          klass.parallel_threshold = limit
+          dst = klass.new(0, w, h, 32, 0xff0000, 0xff00, 0xff, 0)
+          src.blit_scaled(nil, dst, nil)
+          dst.pixels { |v| (0...h).map { |y| (0...w).map { |x| v[x, y] & 0xffffff } } }
+        end
+        results[0] == results[1]
+      end
+    ensure
+      klass.parallel_threads = threads
+      klass.parallel_threshold = threshold
+    end
+  end
+  assert('SDL2::Video::Surface.convert_format') do
+    # 24-bit with red in the low byte, RGB24 on little endian hosts.
+    src = SDL2::Video::Surface.new(0, 7, 2, 24, 0xff, 0xff00, 0xff0000, 0)
+    src.pixels { |v| 2.times { |y| 7.times { |x| v.set_rgba(x, y, SDL2::RGB.new(x * 30, y * 100 + x, 255 - x)) } } }
+    dst = src.convert_format(SURFACE_TEST_ARGB8888)
+    expected = (0...2).map { |y| (0...7).map { |x| [x * 30, y * 100 + x, 255 - x, 255] } }
+    rejected = begin
+      src.convert_format(SURFACE_TEST_ARGB8888, 1)
+      false
+    rescue ArgumentError
+      true
+    end
+    surface_test_rgba(dst) == expected && rejected
+  end
+  assert('SDL2::Video::Surface.premultiply_alpha') do
+    s = surface_test_argb(7, 3)
+    expected = surface_test_rgba(s).map { |row| row.map { |r, g, b, a| [r, g, b].map { |c| (c * a + 127) / 255 } + [a] } }
+    s.premultiply_alpha
+    surface_test_rgba(s) == expected
+  end
+  assert('SDL2::Video::Surface.blit_surface native blend matches SDL') do
+    # RGBA8888 sources have no native kernel and are blended by SDL.
+    [7, 13].all? do |w|
+      native = surface_test_argb(w, 3)
+      generic = native.convert_format(SURFACE_TEST_RGBA8888)
+      results = [native, generic].map do |src|
+        src.blend_mode = SDL2::Video::SDL_BLENDMODE_BLEND
+        dst = SDL2::Video::Surface.new(0, w, 3, 32, 0xff0000, 0xff00, 0xff, 0xff000000)
+        dst.pixels { |v| 3.times { |y| w.times { |x| v.set_rgba(x, y, SDL2::RGBA.new(x * 17, 90, 255 - y * 60, 255)) } } }
+        src.blit_surface(nil, dst, SDL2::Rect.new(0, 0, w, 3))
+        surface_test_rgba(dst).flatten
+      end
+      # SDL rounds differently from the native kernels.
+      results[0].zip(results[1]).all? { |a, b| (a - b).abs <= 2 }
+    end
+  end
+  assert('SDL2::Video::Surface.blit_premultiplied') do
+    [[7, 255], [13, 128]].all? do |w, mod|
+      src = surface_test_argb(w, 3)
+      src.premultiply_alpha
+      src.alpha_mod = mod
+      dst = surface_test_argb(w, 3)
+      s = surface_test_rgba(src).flatten(1).map { |p| p.map { |c| (c * mod + 127) / 255 } }
+      d = surface_test_rgba(dst).flatten(1)
+      expected = s.zip(d).map { |sp, dp| sp.zip(dp).map { |sc, dc| [sc + (dc * (255 - sp[3]) + 127) / 255, 255].min } }
+      src.blit_premultiplied(nil, dst, SDL2::Rect.new(0, 0, w, 3))
+      surface_test_rgba(dst).flatten(1) == expected
+    end
+  end
+  assert('SDL2::Video::Surface.build_mipmaps') do
+    src = SDL2::Video::Surface.new(0, 2, 2, 32, 0xff0000, 0xff00, 0xff, 0xff000000)
+    colors = [[10, 200, 0, 255], [21, 100, 3, 128], [30, 50, 4, 0], [41, 0, 8, 64]]
+    src.pixels { |v| colors.each_with_index { |c, i| v.set_rgba(i % 2, i / 2, SDL2::RGBA.new(*c)) } }
+    mips = src.build_mipmaps
+    # every channel of the 1x1 level is the rounded average of the 2x2 block.
+    expected = (0...4).map { |c| (colors.inject(0) { |sum, p| sum + p[c] } + 2) / 4 }
+    size = mips[0].pixels { |v| [v.width, v.height] }
+    big = surface_test_argb(13, 7).build_mipmaps
+    sizes = big.map { |m| m.pixels { |v| [v.width, v.height] } }
+    mips.size == 1 && size == [1, 1] && surface_test_rgba(mips[0]) == [[expected]] &&
+      sizes == [[6, 3], [3, 1], [1, 1]] && surface_test_argb(13, 7).build_mipmaps(2).size == 2
+  end
+  assert('SDL2::Video::Surface.scale_to') do
+    klass = SDL2::Video::Surface
+    src = klass.new(0, 2, 2, 32, 0xff0000, 0xff00, 0xff, 0xff000000)
+    corners = [[0, 0, 0, 255], [255, 0, 0, 255], [0, 255, 0, 255], [0, 0, 255, 255]]
+    src.pixels { |v| corners.each_with_index { |c, i| v.set_rgba(i % 2, i / 2, SDL2::RGBA.new(*c)) } }
+    threads, threshold = klass.parallel_threads, klass.parallel_threshold
+    begin
+      klass.parallel_threads = 2
+      results = [0, 1 << 30].map do |limit|
+        klass.parallel_threshold = limit
+        scaled = src.scale_to(9, 6)
+        size = scaled.pixels { |v| [v.width, v.height] }
+        [size, surface_test_rgba(scaled)]
+      end
+      size, rows = results[0]
+      # pixel centers at the edges map onto the source pixels exactly.
+      results[0] == results[1] && size == [9, 6] &&
+        [rows[0][0], rows[0][8], rows[5][0], rows[5][8]] == corners &&
+        rows[2][4] != rows[0][0]
+    ensure
+      klass.parallel_threads = threads
+      klass.parallel_threshold = threshold
+    end
+  end
+  assert('SDL2::Video::SurfacePool.release foreign surface') do
+    pool = SDL2::Video::SurfacePool.new
+    other = SDL2::Video::SurfacePool.new
+    s = pool.acquire(8, 8, 32, 0xff0000, 0xff00, 0xff, 0)
+    foreign = [SDL2::Video::Surface.new(0, 8, 8, 32, 0xff0000, 0xff00, 0xff, 0), s]
+    rejected = [pool, other].zip(foreign).all? do |p, f|
+      begin
+        p.release(f)
+        false
+      rescue ArgumentError
+        true
+      end
+    end
+    rejected && pool.in_use == 1 && other.in_use == 0 && pool.release(s) && pool.in_use == 0 && pool.size == 1
+  end
+ensure
+  SDL2::quit
+end